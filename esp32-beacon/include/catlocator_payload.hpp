@@ -16,7 +16,9 @@ struct BeaconReading {
     std::string beacon_id;
     std::string tag_id;
     std::int32_t rssi{0};
-    std::string timestamp;  // ISO8601 UTC string
+    std::string timestamp;  // ISO8601 UTC capture time; millisecond precision once SNTP has synced
+    std::string sent_at;    // ISO8601 UTC time handed to MQTT; empty before SNTP sync
+    std::uint32_t seq{0};   // per-boot publish sequence; 0 when absent
     Location beacon_location;
     std::map<std::string, std::string> metadata;
 };
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/time.h>
 #include <time.h>
 
 #include "config_portal.h"
@@ -31,6 +32,11 @@ static config_portal_config_t s_latest_cfg;
 static uint32_t s_reporting_interval_ms = 5000;
 static bool s_debug_logging;
 static int64_t s_last_missing_beacon_log_us;
+static uint32_t s_reading_seq;  // per-boot sequence so the server can drop retransmitted readings
+
+// The wall clock is only trusted once SNTP has set it; until then readings carry uptime-based
+// timestamps and no sent_at, and the server falls back to its own receive time.
+#define WALL_CLOCK_VALID_AFTER 1577836800  // 2020-01-01T00:00:00Z
 
 typedef struct {
     uint8_t addr[6];
@@ -66,6 +72,8 @@ static void publish_discovery(const struct ble_gap_disc_desc *desc,
                               int64_t timestamp_us);
 static void publish_task(void *param);
 static void enqueue_publish(const char *topic, const char *payload);
+static bool format_wall_time(char *out, size_t len);
+static const char *stamp_publish_time(const char *topic, const char *payload, char *out, size_t len);
 static void config_listener(const config_portal_config_t *cfg, void *ctx);
 static tag_cache_entry_t *find_cache_entry(const uint8_t *addr);
 static tag_cache_entry_t *allocate_cache_entry(const uint8_t *addr);
@@ -316,12 +324,13 @@ static void publish_reading(const struct ble_gap_disc_desc *desc)
         *ptr = '\0';
     }
 
-    time_t now = now_us / 1000000;
-    struct tm tm_info = {0};
-    gmtime_r(&now, &tm_info);
-
     char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm_info);
+    if (!format_wall_time(timestamp, sizeof(timestamp))) {
+        time_t now = now_us / 1000000;
+        struct tm tm_info = {0};
+        gmtime_r(&now, &tm_info);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm_info);
+    }
 
     if (s_latest_cfg.beacon_id[0] == '\0') {
         if (now_us - s_last_missing_beacon_log_us > 5 * 1000 * 1000) {
@@ -345,13 +354,18 @@ static void publish_reading(const struct ble_gap_disc_desc *desc)
     char topic[128];
     snprintf(topic, sizeof(topic), "beacons/%s/readings", s_latest_cfg.beacon_id);
 
+    if (++s_reading_seq == 0) {
+        s_reading_seq = 1;
+    }
+
     char payload[512];
     int written = snprintf(payload, sizeof(payload),
-                           "{\"beacon_id\":\"%s\",\"tag_id\":\"%s\",\"rssi\":%d,\"timestamp\":\"%s\",\"beacon_location\":{\"x\":%.2f,\"y\":%.2f,\"z\":%.2f}",
+                           "{\"beacon_id\":\"%s\",\"tag_id\":\"%s\",\"rssi\":%d,\"timestamp\":\"%s\",\"seq\":%" PRIu32 ",\"beacon_location\":{\"x\":%.2f,\"y\":%.2f,\"z\":%.2f}",
                            s_latest_cfg.beacon_id,
                            tag_name[0] ? tag_name : addr,
                            desc->rssi,
                            timestamp,
+                           s_reading_seq,
                            s_latest_cfg.location_x,
                            s_latest_cfg.location_y,
                            s_latest_cfg.location_z);
@@ -573,7 +587,10 @@ static void publish_task(void *param)
             continue;
         }
 
-        esp_err_t err = mqtt_service_publish(msg.topic, msg.payload);
+        // Stamp a copy so a retried message gets a fresh sent_at rather than a second one. Static
+        // because this task is the only user and its 4 KB stack already holds two messages.
+        static char stamped[sizeof(msg.payload) + 48];
+        esp_err_t err = mqtt_service_publish(msg.topic, stamp_publish_time(msg.topic, msg.payload, stamped, sizeof(stamped)));
         if (err == ESP_OK) {
             if (s_debug_logging) {
                 ESP_LOGD(TAG, "Published MQTT message topic=%s", msg.topic);
@@ -589,6 +606,46 @@ static void publish_task(void *param)
     }
 }
 
+// format_wall_time writes the current UTC time with millisecond precision, or returns false
+// while the clock has not been set by SNTP.
+static bool format_wall_time(char *out, size_t len)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec < WALL_CLOCK_VALID_AFTER) {
+        return false;
+    }
+    struct tm tm_info = {0};
+    gmtime_r(&tv.tv_sec, &tm_info);
+    size_t n = strftime(out, len, "%Y-%m-%dT%H:%M:%S", &tm_info);
+    snprintf(out + n, len - n, ".%03ldZ", (long)(tv.tv_usec / 1000));
+    return true;
+}
+
+// stamp_publish_time returns the reading payload with a "sent_at" field holding the time it is
+// handed to MQTT, so the server can split scanner queueing from network delay. Other topics, or
+// any payload while the clock is unset, are returned unchanged.
+static const char *stamp_publish_time(const char *topic, const char *payload, char *out, size_t len)
+{
+    size_t topic_len = strlen(topic);
+    size_t payload_len = strlen(payload);
+    static const char suffix[] = "/readings";
+    if (topic_len < sizeof(suffix) - 1 || strcmp(topic + topic_len - (sizeof(suffix) - 1), suffix) != 0 ||
+        payload_len == 0 || payload[payload_len - 1] != '}') {
+        return payload;
+    }
+
+    char sent_at[32];
+    if (!format_wall_time(sent_at, sizeof(sent_at))) {
+        return payload;
+    }
+    int written = snprintf(out, len, "%.*s,\"sent_at\":\"%s\"}", (int)(payload_len - 1), payload, sent_at);
+    if (written < 0 || written >= (int)len) {
+        return payload;
+    }
+    return out;
+}
+
 static void enqueue_publish(const char *topic, const char *payload)
 {
     if (!topic || !payload || !s_publish_queue) {
@@ -0,0 +1,385 @@
+// Command accuracy-bench runs the beacon simulator against an in-process server and scores the
+// published positions against the simulator's ground truth. For every scenario (solver x RSSI noise
+// x beacon count) it reports position error percentiles, room accuracy and end-to-end latency from
+// publishing a tick's readings to the first position update on catlocator/location/<tag>.
+package main
+
+import (
+	"bytes"
+	"context"
+	"encoding/json"
+	"flag"
+	"fmt"
+	"io"
+	"log"
+	"log/slog"
+	"math"
+	"math/rand"
+	"net"
+	"net/http"
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/app"
+	"catlocator/go-mqtt-server/internal/config"
+	"catlocator/go-mqtt-server/internal/localization"
+	"catlocator/go-mqtt-server/internal/model"
+	"catlocator/go-mqtt-server/internal/sim"
+
+	mqtt "github.com/eclipse/paho.mqtt.golang"
+)
+
+// Success thresholds from the PRD: a position within 2 m, available within 2 s of the readings.
+const (
+	targetError   = 2.0
+	targetLatency = 2 * time.Second
+)
+
+type options struct {
+	house     sim.House
+	beacons   []sim.Beacon
+	rooms     []model.RoomDefinition
+	steps     int
+	warmup    int
+	interval  time.Duration
+	tagStep   float64
+	particles int
+	radioStep float64
+	seed      int64
+}
+
+type scenario struct {
+	solver  string
+	noise   float64
+	beacons int
+}
+
+func main() {
+	solvers := flag.String("solvers", "lm,pf,radio", "Comma-separated solvers: lm (least squares), pf (particle filter), radio (radio map)")
+	noises := flag.String("noise", "2,4", "Comma-separated RSSI noise levels (dB)")
+	counts := flag.String("beacons", "6,12", "Comma-separated beacon counts, taken from the layout spread across floors")
+	beaconConfig := flag.String("beacon-file", "", "JSON file containing beacon definitions {id,x,y,z}[]; default is four corners per floor")
+	steps := flag.Int("steps", 40, "Ticks per scenario")
+	warmup := flag.Int("warmup", 3, "Leading ticks excluded from the statistics while the window fills")
+	interval := flag.Duration("interval", time.Second, "Time between ticks; every beacon reports once per tick")
+	tagStep := flag.Float64("tag-step", 0.3, "Per-axis tag movement per tick (m)")
+	particles := flag.Int("particles", 500, "Particle count for the pf solver")
+	radioStep := flag.Float64("radio-step", 0.25, "Cell size for the radio solver (m)")
+	roomGrid := flag.String("rooms", "2x2", "Rooms per floor as COLSxROWS")
+	seed := flag.Int64("seed", 1, "Random seed; every scenario replays the same walk")
+	flag.Parse()
+
+	opts := options{
+		house:     sim.DefaultHouse(),
+		steps:     *steps,
+		warmup:    *warmup,
+		interval:  *interval,
+		tagStep:   *tagStep,
+		particles: *particles,
+		radioStep: *radioStep,
+		seed:      *seed,
+	}
+	layout := spreadFloors(opts.house.DefaultBeacons())
+	if *beaconConfig != "" {
+		var err error
+		if layout, err = sim.LoadBeacons(*beaconConfig); err != nil {
+			log.Fatal(err)
+		}
+	}
+	var cols, rows int
+	if _, err := fmt.Sscanf(*roomGrid, "%dx%d", &cols, &rows); err != nil || cols <= 0 || rows <= 0 {
+		log.Fatalf("invalid -rooms %q", *roomGrid)
+	}
+	opts.rooms = opts.house.Rooms(cols, rows)
+
+	var scenarios []scenario
+	for _, solver := range splitList(*solvers) {
+		if solver != "lm" && solver != "pf" && solver != "radio" {
+			log.Fatalf("unknown solver %q", solver)
+		}
+		for _, n := range splitList(*noises) {
+			noise, err := strconv.ParseFloat(n, 64)
+			if err != nil {
+				log.Fatalf("invalid noise %q: %v", n, err)
+			}
+			for _, c := range splitList(*counts) {
+				count, err := strconv.Atoi(c)
+				if err != nil || count < 3 || count > len(layout) {
+					log.Fatalf("invalid beacon count %q (want 3..%d)", c, len(layout))
+				}
+				scenarios = append(scenarios, scenario{solver: solver, noise: noise, beacons: count})
+			}
+		}
+	}
+
+	fmt.Printf("%d scenarios x %d ticks every %v, %d rooms, tag step %.2fm\n", len(scenarios), opts.steps, opts.interval, len(opts.rooms), opts.tagStep)
+	for _, sc := range scenarios {
+		opts.beacons = layout[:sc.beacons]
+		res, err := run(sc, opts)
+		if err != nil {
+			log.Fatalf("%s: %v", sc, err)
+		}
+		res.report(sc)
+	}
+}
+
+func (sc scenario) String() string {
+	return fmt.Sprintf("%s noise=%.1fdB beacons=%d", sc.solver, sc.noise, sc.beacons)
+}
+
+// spreadFloors reorders the corner layout so any prefix covers every floor and opposite corners first.
+func spreadFloors(beacons []sim.Beacon) []sim.Beacon {
+	perFloor := len(beacons) / sim.Floors
+	order := []int{0, 3, 1, 2}
+	var out []sim.Beacon
+	for _, corner := range order {
+		for f := 0; f < sim.Floors; f++ {
+			if corner < perFloor {
+				out = append(out, beacons[f*perFloor+corner])
+			}
+		}
+	}
+	return out
+}
+
+type result struct {
+	errs      []float64
+	latencies []time.Duration
+	roomHits  int
+	hmmHits   int
+	scored    int
+	missed    int
+}
+
+// update is one position message and when it arrived.
+type update struct {
+	pos localization.Position
+	at  time.Time
+}
+
+// run starts a fresh server configured for sc, walks the tag for opts.steps ticks and scores every tick.
+func run(sc scenario, opts options) (*result, error) {
+	dir, err := os.MkdirTemp("", "accuracy-bench-")
+	if err != nil {
+		return nil, err
+	}
+	defer os.RemoveAll(dir)
+
+	cfg, err := config.Load()
+	if err != nil {
+		return nil, err
+	}
+	httpPort, err := freePort()
+	if err != nil {
+		return nil, err
+	}
+	mqttPort, err := freePort()
+	if err != nil {
+		return nil, err
+	}
+	cfg.HTTPPort = httpPort
+	cfg.MQTTBindAddress = fmt.Sprintf("127.0.0.1:%d", mqttPort)
+	cfg.DatabasePath = filepath.Join(dir, "catlocator.db")
+	cfg.BackupDir = filepath.Join(dir, "backups")
+	cfg.BackupInterval = 0
+	cfg.MetricsPort = 0 // leave the metrics port to a real server on this host
+	cfg.WebhookURLs = nil
+	cfg.Particles, cfg.RadioMapStep = 0, 0
+	switch sc.solver {
+	case "pf":
+		cfg.Particles = opts.particles
+	case "radio":
+		cfg.RadioMapStep = opts.radioStep
+	}
+
+	logger := slog.New(slog.NewTextHandler(os.Stderr, &slog.HandlerOptions{Level: slog.LevelError}))
+	ctx, cancel := context.WithCancel(context.Background())
+	done := make(chan error, 1)
+	go func() { done <- app.New(cfg, logger).Run(ctx) }()
+	defer func() {
+		cancel()
+		<-done
+	}()
+
+	base := fmt.Sprintf("http://127.0.0.1:%d", httpPort)
+	if err := waitReady(base, done); err != nil {
+		return nil, err
+	}
+	body, _ := json.Marshal(struct {
+		Rooms []model.RoomDefinition `json:"rooms"`
+	}{opts.rooms})
+	resp, err := http.Post(base+"/api/rooms", "application/json", bytes.NewReader(body))
+	if err != nil {
+		return nil, fmt.Errorf("save rooms: %w", err)
+	}
+	io.Copy(io.Discard, resp.Body)
+	resp.Body.Close()
+	if resp.StatusCode != http.StatusNoContent {
+		return nil, fmt.Errorf("save rooms: %s", resp.Status)
+	}
+	truthRooms := localization.NewRoomIndex(opts.rooms)
+
+	rng := rand.New(rand.NewSource(opts.seed))
+	radio := sim.Radio{TxPower: -59, PathLoss: 2, NoiseStd: sc.noise}
+	tag := &sim.Tag{ID: "bench-collar", Pos: opts.house.RandomPoint(rng), Step: opts.tagStep}
+
+	updates := make(chan update, 256)
+	client := mqtt.NewClient(mqtt.NewClientOptions().
+		AddBroker(fmt.Sprintf("tcp://127.0.0.1:%d", mqttPort)).
+		SetClientID(fmt.Sprintf("accuracy-bench-%d", time.Now().UnixNano())).
+		SetOrderMatters(false))
+	if token := client.Connect(); token.Wait() && token.Error() != nil {
+		return nil, fmt.Errorf("connect: %w", token.Error())
+	}
+	defer client.Disconnect(250)
+	token := client.Subscribe("catlocator/location/"+tag.ID, 0, func(_ mqtt.Client, msg mqtt.Message) {
+		var pos localization.Position
+		if err := json.Unmarshal(msg.Payload(), &pos); err == nil {
+			updates <- update{pos: pos, at: time.Now()}
+		}
+	})
+	if token.Wait() && token.Error() != nil {
+		return nil, fmt.Errorf("subscribe: %w", token.Error())
+	}
+
+	res := &result{}
+	tokens := make([]mqtt.Token, len(opts.beacons))
+	for step := 0; step < opts.steps; step++ {
+		tag.Move(opts.house, rng)
+		truth := tag.Location()
+
+		// Publish the whole tick pipelined so it lands inside one debounce window, as a scanner
+		// fleet reporting the same advertisement would.
+		start := time.Now()
+		for i, b := range opts.beacons {
+			data, _ := json.Marshal(sim.NewReading(b, tag, radio.RSSI(tag.Distance(b), rng), start))
+			tokens[i] = client.Publish(b.Topic(), 0, false, data)
+		}
+		for _, t := range tokens {
+			if t.Wait() && t.Error() != nil {
+				return nil, fmt.Errorf("publish: %w", t.Error())
+			}
+		}
+
+		// The first update solved after the tick started measures latency; the last one before the
+		// next tick is the settled estimate that gets scored. A previous tick's solve delivered late is
+		// skipped, or it would pass for this tick's first update. The server shares this clock.
+		var first, last *update
+		deadline := time.NewTimer(time.Until(start.Add(opts.interval)))
+	collect:
+		for {
+			select {
+			case u := <-updates:
+				if u.pos.UpdatedAt.Before(start) {
+					continue
+				}
+				if first == nil {
+					first = &u
+				}
+				last = &u
+			case <-deadline.C:
+				break collect
+			}
+		}
+		if step < opts.warmup {
+			continue
+		}
+		if last == nil || !last.pos.Valid {
+			res.missed++
+			continue
+		}
+		res.scored++
+		res.latencies = append(res.latencies, first.at.Sub(start))
+		res.errs = append(res.errs, distance(last.pos.Location, truth))
+		want, _ := truthRooms.Room(truth)
+		if len(last.pos.Rooms) > 0 && last.pos.Rooms[0].WithinRadius && last.pos.Rooms[0].Name == want {
+			res.roomHits++
+		}
+		if last.pos.Room != nil && last.pos.Room.Room == want {
+			res.hmmHits++
+		}
+	}
+	return res, nil
+}
+
+func (r *result) report(sc scenario) {
+	if r.scored == 0 {
+		fmt.Printf("%-34s no valid positions (missed=%d)\n", sc, r.missed)
+		return
+	}
+	sort.Float64s(r.errs)
+	sort.Slice(r.latencies, func(i, j int) bool { return r.latencies[i] < r.latencies[j] })
+	withinError, withinLatency := 0, 0
+	for _, e := range r.errs {
+		if e <= targetError {
+			withinError++
+		}
+	}
+	for _, l := range r.latencies {
+		if l <= targetLatency {
+			withinLatency++
+		}
+	}
+	n := float64(r.scored)
+	fmt.Printf("%-34s error p50=%.2fm p90=%.2fm p95=%.2fm <=2m=%3.0f%%  room=%3.0f%% hmm=%3.0f%%  latency p50=%v p95=%v p99=%v <=2s=%3.0f%%  missed=%d\n",
+		sc,
+		quantile(r.errs, 0.50), quantile(r.errs, 0.90), quantile(r.errs, 0.95),
+		100*float64(withinError)/n,
+		100*float64(r.roomHits)/n, 100*float64(r.hmmHits)/n,
+		quantile(r.latencies, 0.50).Round(10*time.Microsecond),
+		quantile(r.latencies, 0.95).Round(10*time.Microsecond),
+		quantile(r.latencies, 0.99).Round(10*time.Microsecond),
+		100*float64(withinLatency)/n,
+		r.missed)
+}
+
+func quantile[T any](sorted []T, q float64) T {
+	return sorted[int(q*float64(len(sorted)-1))]
+}
+
+func distance(a, b model.Location) float64 {
+	return math.Sqrt((a.X-b.X)*(a.X-b.X) + (a.Y-b.Y)*(a.Y-b.Y) + (a.Z-b.Z)*(a.Z-b.Z))
+}
+
+func waitReady(base string, done <-chan error) error {
+	deadline := time.Now().Add(10 * time.Second)
+	for time.Now().Before(deadline) {
+		select {
+		case err := <-done:
+			return fmt.Errorf("server exited: %v", err)
+		default:
+		}
+		if resp, err := http.Get(base + "/readyz"); err == nil {
+			resp.Body.Close()
+			if resp.StatusCode == http.StatusOK {
+				return nil
+			}
+		}
+		time.Sleep(20 * time.Millisecond)
+	}
+	return fmt.Errorf("server not ready")
+}
+
+// freePort asks the kernel for an unused TCP port.
+func freePort() (int, error) {
+	l, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		return 0, err
+	}
+	defer l.Close()
+	return l.Addr().(*net.TCPAddr).Port, nil
+}
+
+func splitList(s string) []string {
+	var out []string
+	for _, part := range strings.Split(s, ",") {
+		if part = strings.TrimSpace(part); part != "" {
+			out = append(out, part)
+		}
+	}
+	return out
+}
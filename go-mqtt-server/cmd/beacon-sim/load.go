@@ -0,0 +1,377 @@
+package main
+
+import (
+	"context"
+	"encoding/json"
+	"fmt"
+	"log"
+	"math"
+	"math/rand"
+	"os"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/sim"
+
+	mqtt "github.com/eclipse/paho.mqtt.golang"
+)
+
+const (
+	// motionTick is how often tags move in load mode; beacons read the latest snapshot.
+	motionTick      = 100 * time.Millisecond
+	defaultRate     = 1.0
+	defaultPipeline = 64
+)
+
+// scenario describes a load run: which tags move where, which beacons hear them and how often,
+// and what the payloads look like. Generated beacons and tags are placed from the seed.
+type scenario struct {
+	Seed     int64     `json:"seed"`
+	Duration duration  `json:"duration"` // 0 runs until interrupted
+	House    houseSpec `json:"house"`
+	Radio    radioSpec `json:"radio"`
+
+	Format   string  `json:"format"`    // "simulator" (JSON with ground truth, the default) or "firmware"
+	Batch    int     `json:"batch"`     // readings per publish; above 1 each publish is a JSON array
+	Pipeline int     `json:"pipeline"`  // unacknowledged publishes per connection
+	MaxRange float64 `json:"max_range"` // a beacon only hears tags within this many metres; 0 hears all
+
+	Beacons     []beaconSpec `json:"beacons"`
+	BeaconCount int          `json:"beacon_count"` // generated in addition to Beacons
+	Rate        float64      `json:"rate"`         // reports per second per beacon, unless the beacon sets its own
+	Unassigned  int          `json:"unassigned"`   // generated scanners with no beacon ID; they publish inventory only
+
+	Tags     []tagSpec `json:"tags"`
+	TagCount int       `json:"tag_count"` // generated in addition to Tags
+	TagStep  float64   `json:"tag_step"`  // per-axis movement per second (m)
+}
+
+type houseSpec struct {
+	Width  float64 `json:"width"`
+	Depth  float64 `json:"depth"`
+	Height float64 `json:"height"`
+}
+
+type radioSpec struct {
+	TxPower  float64 `json:"tx_power"`
+	PathLoss float64 `json:"path_loss"`
+	NoiseStd float64 `json:"noise_std"`
+}
+
+type beaconSpec struct {
+	sim.Beacon
+	Rate float64 `json:"rate"`
+}
+
+type tagSpec struct {
+	ID         string  `json:"id"`
+	X          float64 `json:"x"` // all zero places the tag randomly
+	Y          float64 `json:"y"`
+	Z          float64 `json:"z"`
+	Step       float64 `json:"step"` // overrides the scenario's tag_step
+	Stationary bool    `json:"stationary"`
+}
+
+type duration time.Duration
+
+func (d *duration) UnmarshalJSON(data []byte) error {
+	var s string
+	if err := json.Unmarshal(data, &s); err != nil {
+		return fmt.Errorf("duration must be a string like \"60s\": %w", err)
+	}
+	parsed, err := time.ParseDuration(s)
+	if err != nil {
+		return err
+	}
+	*d = duration(parsed)
+	return nil
+}
+
+func loadScenario(path string) (*scenario, error) {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return nil, fmt.Errorf("read scenario: %w", err)
+	}
+	sc := &scenario{}
+	if err := json.Unmarshal(data, sc); err != nil {
+		return nil, fmt.Errorf("parse scenario: %w", err)
+	}
+	switch sc.Format {
+	case "":
+		sc.Format = "simulator"
+	case "simulator", "firmware":
+	default:
+		return nil, fmt.Errorf("unknown scenario format %q (want simulator or firmware)", sc.Format)
+	}
+	if sc.House == (houseSpec{}) {
+		h := sim.DefaultHouse()
+		sc.House = houseSpec{Width: h.Width, Depth: h.Depth, Height: h.Height}
+	}
+	if sc.Radio == (radioSpec{}) {
+		sc.Radio = radioSpec{TxPower: -59, PathLoss: 2, NoiseStd: 2}
+	}
+	if sc.Rate <= 0 {
+		sc.Rate = defaultRate
+	}
+	if sc.Pipeline <= 0 {
+		sc.Pipeline = defaultPipeline
+	}
+	if sc.Batch <= 0 {
+		sc.Batch = 1
+	}
+	if len(sc.Beacons)+sc.BeaconCount+sc.Unassigned == 0 {
+		return nil, fmt.Errorf("scenario has no beacons")
+	}
+	if len(sc.Tags)+sc.TagCount == 0 {
+		return nil, fmt.Errorf("scenario has no tags")
+	}
+	return sc, nil
+}
+
+// scanner is one simulated device with its own MQTT connection, publishing on its own schedule.
+type scanner struct {
+	index    int
+	beacon   sim.Beacon // ID empty when unassigned
+	rate     float64
+	rng      *rand.Rand
+	seq      uint32
+	inflight []mqtt.Token
+	sent     int
+}
+
+type loadStats struct {
+	publishes atomic.Uint64
+	readings  atomic.Uint64
+	bytes     atomic.Uint64
+	errors    atomic.Uint64
+	connected atomic.Int64
+}
+
+// runLoad drives a scenario: every scanner gets its own connection and goroutine and publishes
+// asynchronously, keeping up to Pipeline publishes in flight, while one goroutine moves the tags.
+func runLoad(ctx context.Context, brokerAddr string, sc *scenario) error {
+	house := sim.House{Width: sc.House.Width, Depth: sc.House.Depth, Height: sc.House.Height}
+	radio := sim.Radio{TxPower: sc.Radio.TxPower, PathLoss: sc.Radio.PathLoss, NoiseStd: sc.Radio.NoiseStd}
+	layout := rand.New(rand.NewSource(sc.Seed))
+
+	var scanners []*scanner
+	addScanner := func(b sim.Beacon, rate float64) {
+		if rate <= 0 {
+			rate = sc.Rate
+		}
+		n := len(scanners)
+		scanners = append(scanners, &scanner{
+			index:    n,
+			beacon:   b,
+			rate:     rate,
+			rng:      rand.New(rand.NewSource(sc.Seed + 1 + int64(n))),
+			inflight: make([]mqtt.Token, sc.Pipeline),
+		})
+	}
+	for _, b := range sc.Beacons {
+		addScanner(b.Beacon, b.Rate)
+	}
+	for i := 0; i < sc.BeaconCount+sc.Unassigned; i++ {
+		// Spread generated scanners over the floors at mid-story height.
+		p := house.RandomPoint(layout)
+		b := sim.Beacon{X: p[0], Y: p[1], Z: (float64(i%sim.Floors) + 0.5) * house.FloorHeight()}
+		if i < sc.BeaconCount {
+			b.ID = fmt.Sprintf("sim-beacon-%d", len(sc.Beacons)+i+1)
+		}
+		addScanner(b, 0)
+	}
+
+	tags := make([]sim.Tag, 0, len(sc.Tags)+sc.TagCount)
+	for _, t := range sc.Tags {
+		tag := sim.Tag{ID: t.ID, Pos: [3]float64{t.X, t.Y, t.Z}, Step: t.Step, Stationary: t.Stationary}
+		if tag.Pos == [3]float64{} {
+			tag.Pos = house.RandomPoint(layout)
+		}
+		tags = append(tags, tag)
+	}
+	for i := 0; i < sc.TagCount; i++ {
+		tags = append(tags, sim.Tag{ID: fmt.Sprintf("sim-collar-%d", len(sc.Tags)+i+1), Pos: house.RandomPoint(layout)})
+	}
+	for i := range tags {
+		if tags[i].Step == 0 {
+			tags[i].Step = sc.TagStep
+		}
+		// Steps are per second; scale the per-tick deviation so the walk is independent of motionTick.
+		tags[i].Step *= math.Sqrt(motionTick.Seconds())
+	}
+
+	if sc.Duration > 0 {
+		var cancel context.CancelFunc
+		ctx, cancel = context.WithTimeout(ctx, time.Duration(sc.Duration))
+		defer cancel()
+	}
+
+	var snapshot atomic.Pointer[[]sim.Tag]
+	current := append([]sim.Tag(nil), tags...)
+	snapshot.Store(&current)
+	go func() {
+		motion := rand.New(rand.NewSource(sc.Seed - 1))
+		ticker := time.NewTicker(motionTick)
+		defer ticker.Stop()
+		for {
+			select {
+			case <-ctx.Done():
+				return
+			case <-ticker.C:
+				for i := range tags {
+					tags[i].Move(house, motion)
+				}
+				next := append([]sim.Tag(nil), tags...)
+				snapshot.Store(&next)
+			}
+		}
+	}()
+
+	log.Printf("load scenario: %d scanners (%d unassigned), %d tags, %s payloads, batch %d, pipeline %d, seed %d",
+		len(scanners), sc.Unassigned, len(tags), sc.Format, sc.Batch, sc.Pipeline, sc.Seed)
+
+	var stats loadStats
+	var wg sync.WaitGroup
+	for _, s := range scanners {
+		wg.Add(1)
+		go func(s *scanner) {
+			defer wg.Done()
+			if err := s.run(ctx, brokerAddr, sc, radio, &snapshot, &stats); err != nil {
+				log.Printf("scanner %d: %v", s.index, err)
+			}
+		}(s)
+	}
+
+	start := time.Now()
+	ticker := time.NewTicker(time.Second)
+	defer ticker.Stop()
+	var lastPublishes, lastReadings uint64
+	for {
+		select {
+		case <-ctx.Done():
+			wg.Wait()
+			elapsed := time.Since(start).Seconds()
+			log.Printf("done: %d publishes (%.0f/s), %d readings (%.0f/s), %.1f MB, %d errors",
+				stats.publishes.Load(), float64(stats.publishes.Load())/elapsed,
+				stats.readings.Load(), float64(stats.readings.Load())/elapsed,
+				float64(stats.bytes.Load())/1e6, stats.errors.Load())
+			return nil
+		case <-ticker.C:
+			publishes, readings := stats.publishes.Load(), stats.readings.Load()
+			log.Printf("%d connected, %d publishes/s, %d readings/s, %d errors",
+				stats.connected.Load(), publishes-lastPublishes, readings-lastReadings, stats.errors.Load())
+			lastPublishes, lastReadings = publishes, readings
+		}
+	}
+}
+
+func (s *scanner) run(ctx context.Context, brokerAddr string, sc *scenario, radio sim.Radio, tags *atomic.Pointer[[]sim.Tag], stats *loadStats) error {
+	opts := mqtt.NewClientOptions().
+		AddBroker(brokerAddr).
+		SetClientID(fmt.Sprintf("catlocator-sim-%d-%d", s.index, time.Now().UnixNano())).
+		SetOrderMatters(false)
+	client := mqtt.NewClient(opts)
+	if token := client.Connect(); token.Wait() && token.Error() != nil {
+		stats.errors.Add(1)
+		return fmt.Errorf("connect: %w", token.Error())
+	}
+	stats.connected.Add(1)
+	defer func() {
+		for _, t := range s.inflight {
+			if t != nil {
+				t.Wait()
+			}
+		}
+		client.Disconnect(250)
+		stats.connected.Add(-1)
+	}()
+
+	period := time.Duration(float64(time.Second) / s.rate)
+	// Random phase so scanners do not all report on the same instant.
+	select {
+	case <-ctx.Done():
+		return nil
+	case <-time.After(time.Duration(s.rng.Int63n(int64(period)))):
+	}
+	ticker := time.NewTicker(period)
+	defer ticker.Stop()
+
+	scannerID := sim.ScannerID(s.index)
+	inventoryTopic := "scanners/" + scannerID + "/inventory"
+	var batch []byte
+	pending := 0
+	flush := func() {
+		if pending == 0 {
+			return
+		}
+		payload := batch
+		if sc.Batch > 1 {
+			payload = append(payload, ']')
+		}
+		s.publish(client, s.beacon.Topic(), payload, pending, stats)
+		batch, pending = nil, 0
+	}
+
+	for {
+		now := time.Now()
+		snapshot := *tags.Load()
+		for i := range snapshot {
+			tag := &snapshot[i]
+			dist := tag.Distance(s.beacon)
+			if sc.MaxRange > 0 && dist > sc.MaxRange {
+				continue
+			}
+			rssi := radio.RSSI(dist, s.rng)
+
+			if s.beacon.ID == "" {
+				payload := sim.AppendFirmwareInventory(nil, scannerID, sim.TagAddress(i), tag.ID, int(math.Round(rssi)), now)
+				s.publish(client, inventoryTopic, payload, 1, stats)
+				continue
+			}
+
+			if sc.Batch > 1 {
+				if pending == 0 {
+					batch = append(batch, '[')
+				} else {
+					batch = append(batch, ',')
+				}
+			}
+			if s.seq++; s.seq == 0 {
+				s.seq = 1
+			}
+			if sc.Format == "firmware" {
+				batch = sim.AppendFirmwareReading(batch, s.beacon, tag.ID, int(math.Round(rssi)), now, s.seq)
+			} else {
+				data, _ := json.Marshal(sim.NewReading(s.beacon, tag, rssi, now))
+				batch = append(batch, data...)
+			}
+			if pending++; pending >= sc.Batch {
+				flush()
+			}
+		}
+		flush()
+
+		select {
+		case <-ctx.Done():
+			return nil
+		case <-ticker.C:
+		}
+	}
+}
+
+// publish sends payload without waiting for it, first reaping the publish issued Pipeline sends ago
+// so each connection has a bounded number in flight.
+func (s *scanner) publish(client mqtt.Client, topic string, payload []byte, readings int, stats *loadStats) {
+	slot := &s.inflight[s.sent%len(s.inflight)]
+	if *slot != nil {
+		if (*slot).Wait() && (*slot).Error() != nil {
+			stats.errors.Add(1)
+		}
+	}
+	*slot = client.Publish(topic, 0, false, payload)
+	s.sent++
+	stats.publishes.Add(1)
+	stats.readings.Add(uint64(readings))
+	stats.bytes.Add(uint64(len(payload)))
+}
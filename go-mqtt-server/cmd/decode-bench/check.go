@@ -0,0 +1,413 @@
+package main
+
+import (
+	"bytes"
+	"encoding/json"
+	"fmt"
+	"math/rand"
+	"reflect"
+	"strings"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/ingest"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// check decodes n generated documents per schema with both decoders and reports every document
+// where they disagree: one accepts what the other rejects, or they decode different values. The
+// documents mix valid payloads with case-folded and unknown keys, escapes, invalid UTF-8, wrong
+// types, nesting around encoding/json's depth limit and random byte damage.
+func check(n int, seed int64) int {
+	g := &generator{rng: rand.New(rand.NewSource(seed))}
+	decoder := ingest.NewDecoder(ingest.NewInterner(64))
+	schemas := []struct {
+		name    string
+		fields  []string
+		compare func(*ingest.Decoder, []byte) string
+	}{
+		{"readings", []string{"beacon_id", "tag_id", "rssi", "timestamp", "seq", "sent_at", "beacon_location", "metadata"}, compareReadings},
+		{"inventory", []string{"scanner_id", "tag_address", "tag_name", "rssi", "manufacturer_id", "manufacturer_data", "tx_power", "event_type", "timestamp"}, compareInventory},
+		{"training", []string{"room", "command", "timestamp", "source", "tag_id"}, compareTraining},
+	}
+
+	mismatches := 0
+	for _, s := range schemas {
+		for i := 0; i < n; i++ {
+			doc := g.document(s.fields, s.name == "readings")
+			if diff := s.compare(decoder, doc); diff != "" {
+				mismatches++
+				if mismatches <= 20 {
+					fmt.Printf("%s mismatch: %s\n  document: %q\n", s.name, diff, truncate(doc))
+				}
+			}
+		}
+		fmt.Printf("%-10s %d documents checked\n", s.name, n)
+	}
+	fmt.Printf("%d mismatches (seed %d)\n", mismatches, seed)
+	return mismatches
+}
+
+func truncate(doc []byte) []byte {
+	if len(doc) > 300 {
+		return append(doc[:300:300], "..."...)
+	}
+	return doc
+}
+
+func agree(stdErr, err error) string {
+	switch {
+	case stdErr == nil && err != nil:
+		return "ingest rejects: " + err.Error()
+	case stdErr != nil && err == nil:
+		return "ingest accepts, encoding/json: " + stdErr.Error()
+	}
+	return ""
+}
+
+func compareReadings(d *ingest.Decoder, doc []byte) string {
+	var want []model.BeaconReading
+	var stdErr error
+	if trimmed := bytes.TrimLeft(doc, " \t\r\n"); len(trimmed) > 0 && trimmed[0] == '[' {
+		stdErr = json.Unmarshal(doc, &want)
+	} else {
+		want = make([]model.BeaconReading, 1)
+		stdErr = json.Unmarshal(doc, &want[0])
+	}
+	got, err := d.Readings(doc)
+	if diff := agree(stdErr, err); diff != "" || err != nil {
+		return diff
+	}
+	if len(got) != len(want) {
+		return fmt.Sprintf("%d readings, encoding/json %d", len(got), len(want))
+	}
+	for i := range got {
+		g, w := got[i], want[i]
+		switch {
+		case !g.Timestamp.Equal(w.Timestamp):
+			return fmt.Sprintf("reading %d timestamp %v, encoding/json %v", i, g.Timestamp, w.Timestamp)
+		case (g.SentAt == nil) != (w.SentAt == nil) || g.SentAt != nil && !g.SentAt.Equal(*w.SentAt):
+			return fmt.Sprintf("reading %d sent_at %v, encoding/json %v", i, g.SentAt, w.SentAt)
+		}
+		g.Timestamp, w.Timestamp, g.SentAt, w.SentAt = time.Time{}, time.Time{}, nil, nil
+		if !reflect.DeepEqual(g, w) {
+			return fmt.Sprintf("reading %d %+v, encoding/json %+v", i, g, w)
+		}
+	}
+	return ""
+}
+
+// compareInventory and compareTraining hold the ingest decoder to what the server did before it:
+// encoding/json into tagged structs, then time.Parse with unparseable timestamps left zero.
+func compareInventory(d *ingest.Decoder, doc []byte) string {
+	var std struct {
+		ScannerID        string `json:"scanner_id"`
+		TagAddress       string `json:"tag_address"`
+		TagName          string `json:"tag_name"`
+		RSSI             int    `json:"rssi"`
+		ManufacturerID   *int   `json:"manufacturer_id"`
+		ManufacturerData string `json:"manufacturer_data"`
+		TxPower          *int   `json:"tx_power"`
+		EventType        string `json:"event_type"`
+		Timestamp        string `json:"timestamp"`
+	}
+	stdErr := json.Unmarshal(doc, &std)
+	var got ingest.InventoryPayload
+	err := d.Inventory(doc, &got)
+	if diff := agree(stdErr, err); diff != "" || err != nil {
+		return diff
+	}
+	want := ingest.InventoryPayload{
+		ScannerID:        std.ScannerID,
+		TagAddress:       std.TagAddress,
+		TagName:          std.TagName,
+		RSSI:             std.RSSI,
+		ManufacturerData: std.ManufacturerData,
+		EventType:        std.EventType,
+	}
+	if std.ManufacturerID != nil {
+		want.ManufacturerID, want.HasManufacturerID = *std.ManufacturerID, true
+	}
+	if std.TxPower != nil {
+		want.TxPower, want.HasTxPower = *std.TxPower, true
+	}
+	if diff := compareTime(got.Timestamp, std.Timestamp); diff != "" {
+		return diff
+	}
+	got.Timestamp = time.Time{}
+	if got != want {
+		return fmt.Sprintf("%+v, encoding/json %+v", got, want)
+	}
+	return ""
+}
+
+func compareTraining(d *ingest.Decoder, doc []byte) string {
+	var std struct {
+		Room      string `json:"room"`
+		Command   string `json:"command"`
+		Timestamp string `json:"timestamp"`
+		Source    string `json:"source"`
+		TagID     string `json:"tag_id"`
+	}
+	stdErr := json.Unmarshal(doc, &std)
+	var got ingest.TrainingPayload
+	err := d.TrainingCommand(doc, &got)
+	if diff := agree(stdErr, err); diff != "" || err != nil {
+		return diff
+	}
+	if diff := compareTime(got.Timestamp, std.Timestamp); diff != "" {
+		return diff
+	}
+	want := ingest.TrainingPayload{Room: std.Room, Command: std.Command, Source: std.Source, TagID: std.TagID}
+	got.Timestamp = time.Time{}
+	if got != want {
+		return fmt.Sprintf("%+v, encoding/json %+v", got, want)
+	}
+	return ""
+}
+
+func compareTime(got time.Time, raw string) string {
+	want, err := time.Parse(time.RFC3339Nano, raw)
+	if err != nil {
+		want, err = time.Parse(time.RFC3339, raw)
+	}
+	if err != nil {
+		want = time.Time{}
+	}
+	if !got.Equal(want) {
+		return fmt.Sprintf("timestamp %v, time.Parse %v", got, want)
+	}
+	return ""
+}
+
+// generator builds documents for one schema.
+type generator struct {
+	rng *rand.Rand
+	buf []byte
+}
+
+func (g *generator) chance(p float64) bool { return g.rng.Float64() < p }
+
+func (g *generator) document(fields []string, readings bool) []byte {
+	g.buf = g.buf[:0]
+	switch {
+	case g.chance(0.02):
+		g.deep()
+	case readings && g.chance(0.3):
+		g.buf = append(g.buf, '[')
+		for i, n := 0, g.rng.Intn(4); i < n; i++ {
+			if i > 0 {
+				g.buf = append(g.buf, ',')
+			}
+			g.object(fields)
+		}
+		g.buf = append(g.buf, ']')
+	case g.chance(0.02):
+		g.buf = append(g.buf, "null"...)
+	default:
+		g.object(fields)
+	}
+	if g.chance(0.2) {
+		g.damage()
+	}
+	return append([]byte(nil), g.buf...)
+}
+
+// deep nests an unknown member to within a few levels of encoding/json's limit of 10000.
+func (g *generator) deep() {
+	levels := 9995 + g.rng.Intn(10)
+	g.buf = append(g.buf, `{"deep":`...)
+	for i := 0; i < levels; i++ {
+		g.buf = append(g.buf, '[')
+	}
+	for i := 0; i < levels; i++ {
+		g.buf = append(g.buf, ']')
+	}
+	g.buf = append(g.buf, '}')
+}
+
+func (g *generator) object(fields []string) {
+	g.buf = append(g.buf, '{')
+	for i, n := 0, g.rng.Intn(len(fields)+3); i < n; i++ {
+		if i > 0 {
+			g.buf = append(g.buf, ',')
+		}
+		name := fields[g.rng.Intn(len(fields))]
+		if g.chance(0.1) {
+			name = []string{"unknown", "beacon", "tag", "metadata_x"}[g.rng.Intn(4)]
+		}
+		g.key(name)
+		g.buf = append(g.buf, ':')
+		g.value(name, 0)
+	}
+	g.buf = append(g.buf, '}')
+}
+
+// key writes name, sometimes case-folded, with a fold-equivalent rune, or escaped.
+func (g *generator) key(name string) {
+	if g.chance(0.2) {
+		var b strings.Builder
+		for _, r := range name {
+			switch {
+			case r == 's' && g.chance(0.3):
+				b.WriteRune('ſ')
+			case r == 'k' && g.chance(0.3):
+				b.WriteRune('K')
+			case g.chance(0.4):
+				b.WriteString(strings.ToUpper(string(r)))
+			default:
+				b.WriteRune(r)
+			}
+		}
+		name = b.String()
+	}
+	if g.chance(0.05) {
+		name = `\u00` + fmt.Sprintf("%02x", name[0]) + name[1:]
+		g.buf = append(g.buf, '"')
+		g.buf = append(g.buf, name...)
+		g.buf = append(g.buf, '"')
+		return
+	}
+	g.str(name)
+}
+
+// value writes a value of the type name expects, or occasionally any other JSON value.
+func (g *generator) value(name string, depth int) {
+	if g.chance(0.1) {
+		g.any(depth)
+		return
+	}
+	switch name {
+	case "rssi", "manufacturer_id", "tx_power", "seq":
+		g.number(true)
+	case "timestamp", "sent_at":
+		g.timestamp()
+	case "beacon_location":
+		g.buf = append(g.buf, '{')
+		for i, n := 0, g.rng.Intn(5); i < n; i++ {
+			if i > 0 {
+				g.buf = append(g.buf, ',')
+			}
+			g.key([]string{"x", "y", "z", "w"}[g.rng.Intn(4)])
+			g.buf = append(g.buf, ':')
+			g.number(false)
+		}
+		g.buf = append(g.buf, '}')
+	case "metadata":
+		g.buf = append(g.buf, '{')
+		for i, n := 0, g.rng.Intn(4); i < n; i++ {
+			if i > 0 {
+				g.buf = append(g.buf, ',')
+			}
+			g.str(g.text())
+			g.buf = append(g.buf, ':')
+			if g.chance(0.1) {
+				g.buf = append(g.buf, "null"...)
+			} else {
+				g.str(g.text())
+			}
+		}
+		g.buf = append(g.buf, '}')
+	default:
+		g.str(g.text())
+	}
+}
+
+func (g *generator) any(depth int) {
+	switch k := g.rng.Intn(8); {
+	case k == 0 && depth < 4:
+		g.buf = append(g.buf, '[')
+		for i, n := 0, g.rng.Intn(3); i < n; i++ {
+			if i > 0 {
+				g.buf = append(g.buf, ',')
+			}
+			g.any(depth + 1)
+		}
+		g.buf = append(g.buf, ']')
+	case k == 1 && depth < 4:
+		g.buf = append(g.buf, '{')
+		for i, n := 0, g.rng.Intn(3); i < n; i++ {
+			if i > 0 {
+				g.buf = append(g.buf, ',')
+			}
+			g.str(g.text())
+			g.buf = append(g.buf, ':')
+			g.any(depth + 1)
+		}
+		g.buf = append(g.buf, '}')
+	case k == 2:
+		g.buf = append(g.buf, []string{"true", "false", "null"}[g.rng.Intn(3)]...)
+	case k == 3:
+		g.number(false)
+	default:
+		g.str(g.text())
+	}
+}
+
+func (g *generator) number(integer bool) {
+	switch k := g.rng.Intn(10); {
+	case k < 5 || integer && k < 8:
+		g.buf = fmt.Appendf(g.buf, "%d", g.rng.Int63n(200)-100)
+	case k < 8:
+		g.buf = fmt.Appendf(g.buf, "%.*f", g.rng.Intn(8), g.rng.NormFloat64()*20)
+	default:
+		g.buf = append(g.buf, []string{"-0", "1e3", "2.5E-2", "4294967295", "4294967296", "9223372036854775808", "-9223372036854775808", "1.0", "1e400", "01", "-", "1."}[g.rng.Intn(12)]...)
+	}
+}
+
+func (g *generator) timestamp() {
+	at := time.Date(2000+g.rng.Intn(40), time.Month(1+g.rng.Intn(12)), 1+g.rng.Intn(31), g.rng.Intn(24), g.rng.Intn(60), g.rng.Intn(60), g.rng.Intn(1e9), time.UTC)
+	var s string
+	switch g.rng.Intn(6) {
+	case 0:
+		s = at.Format(time.RFC3339)
+	case 1:
+		s = at.In(time.FixedZone("", (g.rng.Intn(48)-24)*1800)).Format(time.RFC3339Nano)
+	case 2:
+		s = []string{"", "2024-02-30T00:00:00Z", "2024-05-01T24:00:00Z", "2024-05-01 17:20:00Z", "2024-05-01T17:20:00.Z", "2024-05-01T17:20:00,5Z", "2024-05-01t17:20:00z", "2024-05-01T17:20:00+24:00", "not a time"}[g.rng.Intn(9)]
+	default:
+		s = at.Format(time.RFC3339Nano)
+	}
+	g.str(s)
+}
+
+// text returns a short string with some escapes, multi-byte runes and invalid UTF-8.
+func (g *generator) text() string {
+	var b []byte
+	for i, n := 0, g.rng.Intn(8); i < n; i++ {
+		switch k := g.rng.Intn(12); k {
+		case 0:
+			b = append(b, []string{`\n`, `\"`, `\\`, `\/`, `é`, `😀`, `\ud800`, `\udc00x`, `\u12`, `\x`}[g.rng.Intn(10)]...)
+		case 1:
+			b = append(b, []string{"é", "ſ", "K", "😀", "�"}[g.rng.Intn(5)]...)
+		case 2:
+			b = append(b, []byte{0xff, 0xc3, 0xed, 0xa0, 0x80, 0xf0, 0x9f}[g.rng.Intn(7)])
+		default:
+			b = append(b, "abcdefxyzAB01-_:"[g.rng.Intn(16)])
+		}
+	}
+	return string(b)
+}
+
+// str writes s as a string token without escaping it, so escapes and raw bytes in s reach the
+// decoders as written.
+func (g *generator) str(s string) {
+	g.buf = append(g.buf, '"')
+	g.buf = append(g.buf, s...)
+	g.buf = append(g.buf, '"')
+}
+
+// damage inserts, removes or replaces a few bytes.
+func (g *generator) damage() {
+	const alphabet = "{}[],:\"\\ nul0-e.\x00\x1f\xff"
+	for i, n := 0, 1+g.rng.Intn(3); i < n && len(g.buf) > 0; i++ {
+		at := g.rng.Intn(len(g.buf))
+		switch g.rng.Intn(3) {
+		case 0:
+			g.buf = append(g.buf[:at], g.buf[at+1:]...)
+		case 1:
+			g.buf[at] = alphabet[g.rng.Intn(len(alphabet))]
+		default:
+			g.buf = append(g.buf[:at], append([]byte{alphabet[g.rng.Intn(len(alphabet))]}, g.buf[at:]...)...)
+		}
+	}
+}
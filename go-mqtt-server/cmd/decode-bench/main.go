@@ -0,0 +1,163 @@
+// Command decode-bench compares encoding/json with the ingest decoder on the payloads the server
+// receives: firmware and simulator readings, reading batches, scanner inventory and training
+// commands. For each it reports time, bytes and allocations per message, including the timestamp
+// parse the server does after decoding.
+//
+// With -check N it instead runs a differential check: N generated documents per payload type are
+// decoded by both, and any document they disagree on is reported.
+package main
+
+import (
+	"encoding/json"
+	"flag"
+	"fmt"
+	"log"
+	"os"
+	"testing"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/ingest"
+	"catlocator/go-mqtt-server/internal/model"
+	"catlocator/go-mqtt-server/internal/sim"
+)
+
+type payload struct {
+	name     string
+	data     []byte
+	messages int
+	std      func([]byte) error
+	decode   func(*ingest.Decoder, []byte) error
+}
+
+func main() {
+	batchSize := flag.Int("batch", 8, "Readings per batched payload")
+	checkDocs := flag.Int("check", 0, "Compare both decoders on this many generated documents per payload type instead of benchmarking")
+	seed := flag.Int64("seed", time.Now().UnixNano(), "Seed for -check")
+	flag.Parse()
+	if *batchSize < 1 {
+		log.Fatal("-batch must be at least 1")
+	}
+	if *checkDocs > 0 {
+		if check(*checkDocs, *seed) > 0 {
+			os.Exit(1)
+		}
+		return
+	}
+
+	house := sim.DefaultHouse()
+	beacons := house.DefaultBeacons()
+	tag := &sim.Tag{ID: "cat", Pos: [3]float64{3.2, 4.1, 1.5}}
+	at := time.Date(2024, 5, 1, 17, 20, 0, 125e6, time.UTC)
+
+	firmware := sim.AppendFirmwareReading(nil, beacons[0], tag.ID, -67, at, 42)
+	simulated, err := json.Marshal(sim.NewReading(beacons[0], tag, -67.4, at))
+	if err != nil {
+		log.Fatal(err)
+	}
+	batch := []byte{'['}
+	for i := 0; i < *batchSize; i++ {
+		if i > 0 {
+			batch = append(batch, ',')
+		}
+		batch = sim.AppendFirmwareReading(batch, beacons[i%len(beacons)], tag.ID, -60-i, at, uint32(43+i))
+	}
+	batch = append(batch, ']')
+	inventory := sim.AppendFirmwareInventory(nil, sim.ScannerID(1), sim.TagAddress(1), tag.ID, -71, at)
+	training := []byte(`{"room":"kitchen","command":"start","timestamp":"2024-05-01T17:20:00.125Z","source":"ios","tag_id":"cat"}`)
+
+	payloads := []payload{
+		{name: "firmware reading", data: firmware, messages: 1, std: stdReading, decode: decodeReadings},
+		{name: "simulator reading", data: simulated, messages: 1, std: stdReading, decode: decodeReadings},
+		{name: fmt.Sprintf("batch of %d", *batchSize), data: batch, messages: *batchSize, std: stdBatch, decode: decodeReadings},
+		{name: "inventory", data: inventory, messages: 1, std: stdInventory, decode: func(d *ingest.Decoder, data []byte) error {
+			var p ingest.InventoryPayload
+			return d.Inventory(data, &p)
+		}},
+		{name: "training command", data: training, messages: 1, std: stdTraining, decode: func(d *ingest.Decoder, data []byte) error {
+			var p ingest.TrainingPayload
+			return d.TrainingCommand(data, &p)
+		}},
+	}
+
+	decoder := ingest.NewDecoder(ingest.NewInterner(1024))
+	fmt.Printf("%-18s %-8s %10s %10s %12s\n", "payload", "decoder", "ns/msg", "B/msg", "allocs/msg")
+	for _, p := range payloads {
+		if err := p.std(p.data); err != nil {
+			log.Fatalf("%s: encoding/json: %v", p.name, err)
+		}
+		if err := p.decode(decoder, p.data); err != nil {
+			log.Fatalf("%s: ingest: %v", p.name, err)
+		}
+		report(p, "json", testing.Benchmark(func(b *testing.B) {
+			b.ReportAllocs()
+			for i := 0; i < b.N; i++ {
+				_ = p.std(p.data)
+			}
+		}))
+		report(p, "ingest", testing.Benchmark(func(b *testing.B) {
+			b.ReportAllocs()
+			for i := 0; i < b.N; i++ {
+				_ = p.decode(decoder, p.data)
+			}
+		}))
+	}
+}
+
+func report(p payload, decoder string, r testing.BenchmarkResult) {
+	n := float64(r.N) * float64(p.messages)
+	fmt.Printf("%-18s %-8s %10.0f %10.1f %12.2f\n", p.name, decoder,
+		float64(r.T.Nanoseconds())/n,
+		float64(r.MemBytes)/n,
+		float64(r.MemAllocs)/n)
+}
+
+func decodeReadings(d *ingest.Decoder, data []byte) error {
+	_, err := d.Readings(data)
+	return err
+}
+
+func stdReading(data []byte) error {
+	var r model.BeaconReading
+	return json.Unmarshal(data, &r)
+}
+
+func stdBatch(data []byte) error {
+	var rs []model.BeaconReading
+	return json.Unmarshal(data, &rs)
+}
+
+// stdInventory and stdTraining decode as the server did before the ingest decoder: into tagged
+// structs, then time.Parse.
+func stdInventory(data []byte) error {
+	var p struct {
+		ScannerID        string `json:"scanner_id"`
+		TagAddress       string `json:"tag_address"`
+		TagName          string `json:"tag_name"`
+		RSSI             int    `json:"rssi"`
+		ManufacturerID   *int   `json:"manufacturer_id"`
+		ManufacturerData string `json:"manufacturer_data"`
+		TxPower          *int   `json:"tx_power"`
+		EventType        string `json:"event_type"`
+		Timestamp        string `json:"timestamp"`
+	}
+	if err := json.Unmarshal(data, &p); err != nil {
+		return err
+	}
+	_, err := time.Parse(time.RFC3339Nano, p.Timestamp)
+	return err
+}
+
+func stdTraining(data []byte) error {
+	var p struct {
+		Room      string `json:"room"`
+		Command   string `json:"command"`
+		Timestamp string `json:"timestamp"`
+		Source    string `json:"source"`
+		TagID     string `json:"tag_id"`
+	}
+	if err := json.Unmarshal(data, &p); err != nil {
+		return err
+	}
+	_, err := time.Parse(time.RFC3339Nano, p.Timestamp)
+	return err
+}
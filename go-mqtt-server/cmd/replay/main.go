@@ -0,0 +1,286 @@
+// Command replay feeds a broker capture (CATLOCATOR_CAPTURE_DIR) back through the server pipeline
+// with its original timing, scaled by -speed, or as fast as possible. By default it starts a fresh
+// in-process server and publishes over MQTT/TCP. With -direct it bypasses the network and hands
+// each message straight to the ingest path, and with -broker it replays into an external server.
+package main
+
+import (
+	"context"
+	"errors"
+	"flag"
+	"fmt"
+	"io"
+	"log"
+	"log/slog"
+	"net"
+	"os"
+	"os/signal"
+	"path/filepath"
+	"strings"
+	"syscall"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/app"
+	"catlocator/go-mqtt-server/internal/config"
+	"catlocator/go-mqtt-server/internal/mqttbroker"
+
+	mqtt "github.com/eclipse/paho.mqtt.golang"
+)
+
+const (
+	pipeline = 256 // unacknowledged publishes per replay connection
+	// settleTime is how long localization must stay idle after the last message before the
+	// in-process server is stopped, so debounced solves are counted.
+	settleTime = 250 * time.Millisecond
+)
+
+func main() {
+	speed := flag.Float64("speed", 1, "Replay speed as a multiple of the captured timing; 0 replays as fast as possible")
+	direct := flag.Bool("direct", false, "Bypass MQTT/TCP and hand messages straight to the in-process ingest path")
+	brokerAddr := flag.String("broker", "", "Replay into an external broker (e.g. tcp://localhost:1883) instead of an in-process server")
+	prefix := flag.String("prefix", "", "Only replay topics with this prefix, e.g. beacons/")
+	dbPath := flag.String("db", "", "Database for the in-process server; default is a temporary file")
+	flag.Usage = func() {
+		fmt.Fprintf(flag.CommandLine.Output(), "usage: replay [flags] <capture file>\n")
+		flag.PrintDefaults()
+	}
+	flag.Parse()
+	if flag.NArg() != 1 || *speed < 0 || (*direct && *brokerAddr != "") {
+		flag.Usage()
+		os.Exit(2)
+	}
+
+	f, err := os.Open(flag.Arg(0))
+	if err != nil {
+		log.Fatal(err)
+	}
+	defer f.Close()
+	capture, err := mqttbroker.NewCaptureReader(f)
+	if err != nil {
+		log.Fatal(err)
+	}
+
+	ctx, stop := signal.NotifyContext(context.Background(), os.Interrupt, syscall.SIGTERM)
+	defer stop()
+
+	var server *inProcess
+	target := *brokerAddr
+	if target == "" {
+		if server, err = startServer(ctx, *dbPath); err != nil {
+			log.Fatal(err)
+		}
+		target = server.broker
+	}
+
+	// receivedAt is the captured receive time rebased onto the replay. Over TCP the broker stamps its
+	// own wall-clock receive time, so only -direct can honour it.
+	var send func(msg mqttbroker.PublishMessage, receivedAt time.Time)
+	var pub *publisher
+	if *direct {
+		send = func(msg mqttbroker.PublishMessage, receivedAt time.Time) { server.app.Ingest(ctx, msg, receivedAt) }
+	} else {
+		pub = &publisher{broker: target, clients: make(map[string]*connection)}
+		send = func(msg mqttbroker.PublishMessage, _ time.Time) { pub.publish(msg) }
+	}
+
+	var (
+		sent, bytes  int
+		first, last  time.Time
+		maxLag       time.Duration
+		truncatedEnd bool
+	)
+	start := time.Now()
+replay:
+	for {
+		msg, err := capture.Next()
+		if errors.Is(err, io.EOF) {
+			break
+		}
+		if errors.Is(err, io.ErrUnexpectedEOF) {
+			truncatedEnd = true
+			break
+		}
+		if err != nil {
+			log.Fatal(err)
+		}
+		if !strings.HasPrefix(msg.Topic, *prefix) {
+			continue
+		}
+		if first.IsZero() {
+			first = msg.At
+		}
+		last = msg.At
+		// With -speed 0 there is no schedule; the captured spacing is kept unscaled so dedup keys
+		// match a timed replay.
+		due := start.Add(msg.At.Sub(first))
+		if *speed > 0 {
+			due = start.Add(time.Duration(float64(msg.At.Sub(first)) / *speed))
+			if wait := time.Until(due); wait > 0 {
+				select {
+				case <-ctx.Done():
+					break replay
+				case <-time.After(wait):
+				}
+			} else if -wait > maxLag {
+				maxLag = -wait
+			}
+		} else if ctx.Err() != nil {
+			break
+		}
+		send(msg.PublishMessage, due)
+		sent++
+		bytes += len(msg.Payload)
+	}
+	if pub != nil {
+		pub.close()
+	}
+	elapsed := time.Since(start)
+
+	fmt.Printf("replayed %d messages (%.1f MB) spanning %v in %v: %.0f msg/s",
+		sent, float64(bytes)/1e6, last.Sub(first).Round(time.Millisecond), elapsed.Round(time.Millisecond), float64(sent)/elapsed.Seconds())
+	if *speed > 0 {
+		fmt.Printf(", max lag behind schedule %v", maxLag.Round(time.Microsecond))
+	}
+	fmt.Println()
+	if truncatedEnd {
+		fmt.Println("capture ends mid-record (server stopped uncleanly); the partial record was skipped")
+	}
+	if server != nil {
+		server.drain()
+	}
+}
+
+type inProcess struct {
+	app    *app.App
+	broker string
+	dir    string
+	cancel context.CancelFunc
+	done   chan error
+}
+
+func startServer(ctx context.Context, dbPath string) (*inProcess, error) {
+	cfg, err := config.Load()
+	if err != nil {
+		return nil, err
+	}
+	dir, err := os.MkdirTemp("", "catlocator-replay-")
+	if err != nil {
+		return nil, err
+	}
+	if dbPath == "" {
+		dbPath = filepath.Join(dir, "catlocator.db")
+	}
+	httpPort, err := freePort()
+	if err != nil {
+		return nil, err
+	}
+	mqttPort, err := freePort()
+	if err != nil {
+		return nil, err
+	}
+	cfg.HTTPPort = httpPort
+	cfg.MQTTBindAddress = fmt.Sprintf("127.0.0.1:%d", mqttPort)
+	cfg.DatabasePath = dbPath
+	cfg.BackupDir = filepath.Join(dir, "backups")
+	cfg.BackupInterval = 0
+	cfg.MetricsPort = 0   // leave the metrics port to a real server on this host
+	cfg.CaptureDir = ""   // never capture the replay itself
+	cfg.WebhookURLs = nil // replayed transitions must not reach real receivers
+
+	logger := slog.New(slog.NewTextHandler(os.Stderr, &slog.HandlerOptions{Level: slog.LevelWarn}))
+	runCtx, cancel := context.WithCancel(ctx)
+	s := &inProcess{
+		app:    app.New(cfg, logger),
+		broker: fmt.Sprintf("tcp://127.0.0.1:%d", mqttPort),
+		dir:    dir,
+		cancel: cancel,
+		done:   make(chan error, 1),
+	}
+	go func() { s.done <- s.app.Run(runCtx) }()
+	select {
+	case <-s.app.Ready():
+		return s, nil
+	case err := <-s.done:
+		cancel()
+		os.RemoveAll(dir)
+		return nil, fmt.Errorf("server exited: %v", err)
+	}
+}
+
+// drain waits for localization to go idle, then stops the server, which flushes pending store
+// writes, and reports how long that took.
+func (s *inProcess) drain() {
+	start := time.Now()
+	updates := s.app.LocationUpdates()
+	for {
+		time.Sleep(settleTime)
+		next := s.app.LocationUpdates()
+		if next == updates {
+			break
+		}
+		updates = next
+	}
+	s.cancel()
+	if err := <-s.done; err != nil {
+		log.Printf("server: %v", err)
+	}
+	os.RemoveAll(s.dir)
+	fmt.Printf("%d localization updates; drained in %v\n", updates, time.Since(start).Round(time.Millisecond))
+}
+
+// publisher replays each captured client on its own connection, so per-client ordering and
+// connection fan-in match the original traffic.
+type publisher struct {
+	broker  string
+	clients map[string]*connection
+}
+
+type connection struct {
+	client   mqtt.Client
+	inflight [pipeline]mqtt.Token
+	sent     int
+}
+
+func (p *publisher) publish(msg mqttbroker.PublishMessage) {
+	c, ok := p.clients[msg.ClientID]
+	if !ok {
+		opts := mqtt.NewClientOptions().
+			AddBroker(p.broker).
+			SetClientID(fmt.Sprintf("replay-%d-%s", len(p.clients), msg.ClientID)).
+			SetOrderMatters(false)
+		c = &connection{client: mqtt.NewClient(opts)}
+		if token := c.client.Connect(); token.Wait() && token.Error() != nil {
+			log.Fatalf("connect: %v", token.Error())
+		}
+		p.clients[msg.ClientID] = c
+	}
+	slot := &c.inflight[c.sent%pipeline]
+	if *slot != nil {
+		if (*slot).Wait() && (*slot).Error() != nil {
+			log.Printf("publish: %v", (*slot).Error())
+		}
+	}
+	*slot = c.client.Publish(msg.Topic, 0, msg.Retain, msg.Payload)
+	c.sent++
+}
+
+func (p *publisher) close() {
+	for _, c := range p.clients {
+		for _, t := range c.inflight {
+			if t != nil {
+				t.Wait()
+			}
+		}
+		c.client.Disconnect(250)
+	}
+}
+
+// freePort asks the kernel for an unused TCP port.
+func freePort() (int, error) {
+	l, err := net.Listen("tcp", "127.0.0.1:0")
+	if err != nil {
+		return 0, err
+	}
+	defer l.Close()
+	return l.Addr().(*net.TCPAddr).Port, nil
+}
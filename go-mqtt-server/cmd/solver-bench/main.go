@@ -0,0 +1,213 @@
+// Command solver-bench measures per-solve latency, iteration count and accuracy of the
+// localization solver, the radio-map grid search and the throughput of the particle filter, on
+// synthetic walks through the beacon-sim house layout.
+package main
+
+import (
+	"flag"
+	"fmt"
+	"math"
+	"math/rand"
+	"sort"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/localization"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+func main() {
+	walks := flag.Int("walks", 200, "Number of independent tag walks")
+	steps := flag.Int("steps", 100, "Updates per walk")
+	houseWidth := flag.Float64("house-width", 12.19, "House width (m)")
+	houseDepth := flag.Float64("house-depth", 7.62, "House depth (m)")
+	houseHeight := flag.Float64("house-height", 9.14, "House height (m)")
+	tagStep := flag.Float64("tag-step", 0.3, "Movement per update (m)")
+	noiseStd := flag.Float64("noise-std", 2.0, "Gaussian noise applied to RSSI (dB)")
+	samples := flag.Int("samples", 3, "RSSI samples averaged per beacon per update")
+	particles := flag.Int("particles", 500, "Particle filter size; 0 skips the filter run")
+	interval := flag.Duration("interval", 2*time.Second, "Simulated time between updates")
+	radioStep := flag.Float64("radio-step", 0.25, "Radio-map cell size (m); 0 skips the grid run")
+	seed := flag.Int64("seed", 1, "Random seed")
+	flag.Parse()
+
+	rng := rand.New(rand.NewSource(*seed))
+	beacons := houseBeacons(*houseWidth, *houseDepth, *houseHeight)
+
+	var cold, warm, filtered, grid, polished run
+	var solver localization.Solver
+	var filter *localization.ParticleFilter
+	var radio *localization.RadioMap
+	var radioScratch localization.RadioScratch
+	if *radioStep > 0 {
+		radio = localization.NewRadioMap(*radioStep, time.Hour)
+		// Build every layer up front so the first walk does not pay for it.
+		start := time.Now()
+		warmup := make([]localization.Observation, len(beacons))
+		for i, b := range beacons {
+			warmup[i] = localization.Observation{BeaconID: fmt.Sprintf("b%d", i), Location: b, RSSI: -70, Samples: 1}
+		}
+		radio.Locate(warmup, &radioScratch)
+		radio.Wait()
+		cells, layers := radio.Cells()
+		fmt.Printf("radio map: %d cells x %d layers built in %v\n", cells, layers, time.Since(start))
+	}
+	observations := make([]localization.Observation, len(beacons))
+
+	for w := 0; w < *walks; w++ {
+		tag := [3]float64{rng.Float64() * *houseWidth, rng.Float64() * *houseDepth, rng.Float64() * *houseHeight}
+		var prev *model.Location
+		var now int64
+		if *particles > 0 {
+			// One filter per walk, as the engine keeps one per tag.
+			filter = localization.NewParticleFilter(*particles, *seed+int64(w))
+		}
+
+		for s := 0; s < *steps; s++ {
+			for i := range tag {
+				tag[i] += rng.NormFloat64() * *tagStep
+			}
+			clamp(&tag, *houseWidth, *houseDepth, *houseHeight)
+
+			for i, b := range beacons {
+				dist := math.Sqrt(sq(b.X-tag[0]) + sq(b.Y-tag[1]) + sq(b.Z-tag[2]))
+				var sum float64
+				for k := 0; k < *samples; k++ {
+					sum += -59.0 - 20*math.Log10(math.Max(dist, 0.01)) + rng.NormFloat64()**noiseStd
+				}
+				observations[i] = localization.Observation{
+					BeaconID: fmt.Sprintf("b%d", i),
+					Location: b,
+					RSSI:     sum / float64(*samples),
+					Samples:  *samples,
+				}
+			}
+
+			coldEst := cold.measure(&solver, observations, nil, tag)
+			est := warm.measure(&solver, observations, prev, tag)
+			if est.Valid {
+				loc := est.Location
+				prev = &loc
+			}
+
+			if radio != nil {
+				start := time.Now()
+				ge := radio.Locate(observations, &radioScratch)
+				elapsed := time.Since(start)
+				if ge.Valid {
+					grid.record(elapsed, 0, ge.Location, tag)
+					// The engine polishes the grid optimum with the solver when three or more beacons are heard.
+					seed := ge.Location
+					polished.measure(&solver, observations, &seed, tag)
+				} else {
+					grid.latencies = append(grid.latencies, elapsed)
+					grid.invalid++
+				}
+			}
+
+			if filter != nil {
+				now += interval.Nanoseconds()
+				bounds := localization.GeometryBounds(observations, nil)
+				start := time.Now()
+				fe := filter.Update(observations, now, bounds, coldEst)
+				filtered.record(time.Since(start), 0, fe.Location, tag)
+			}
+		}
+	}
+
+	fmt.Printf("%d solves over %d beacons, noise %.1f dB x%d samples\n", len(cold.latencies), len(beacons), *noiseStd, *samples)
+	cold.report("cold")
+	warm.report("warm")
+	if radio != nil {
+		grid.report("grid")
+		polished.report("grid+ls")
+	}
+	if *particles > 0 {
+		filtered.report(fmt.Sprintf("pf%d", *particles))
+		var total time.Duration
+		for _, l := range filtered.latencies {
+			total += l
+		}
+		fmt.Printf("particle filter throughput: %.0f updates/sec per core\n", float64(len(filtered.latencies))/total.Seconds())
+	}
+}
+
+type run struct {
+	latencies  []time.Duration
+	iterations int
+	errSum     float64
+	errs       []float64
+	invalid    int
+}
+
+func (r *run) measure(solver *localization.Solver, obs []localization.Observation, seed *model.Location, truth [3]float64) localization.Estimate {
+	start := time.Now()
+	est := solver.Solve(obs, seed)
+	elapsed := time.Since(start)
+	if !est.Valid {
+		r.latencies = append(r.latencies, elapsed)
+		r.invalid++
+		return est
+	}
+	r.record(elapsed, est.Iterations, est.Location, truth)
+	return est
+}
+
+func (r *run) record(elapsed time.Duration, iterations int, loc model.Location, truth [3]float64) {
+	r.latencies = append(r.latencies, elapsed)
+	r.iterations += iterations
+	e := math.Sqrt(sq(loc.X-truth[0]) + sq(loc.Y-truth[1]) + sq(loc.Z-truth[2]))
+	r.errSum += e
+	r.errs = append(r.errs, e)
+}
+
+func (r *run) report(name string) {
+	sort.Slice(r.latencies, func(i, j int) bool { return r.latencies[i] < r.latencies[j] })
+	sort.Float64s(r.errs)
+	valid := len(r.errs)
+	if valid == 0 {
+		fmt.Printf("%-6s no valid solves\n", name)
+		return
+	}
+	var total time.Duration
+	for _, l := range r.latencies {
+		total += l
+	}
+	fmt.Printf("%-6s latency mean=%v p50=%v p99=%v  iterations mean=%.2f  error mean=%.2fm p50=%.2fm p90=%.2fm  invalid=%d\n",
+		name,
+		total/time.Duration(len(r.latencies)),
+		percentile(r.latencies, 0.50),
+		percentile(r.latencies, 0.99),
+		float64(r.iterations)/float64(valid),
+		r.errSum/float64(valid),
+		r.errs[valid/2],
+		r.errs[valid*9/10],
+		r.invalid)
+}
+
+func percentile(sorted []time.Duration, q float64) time.Duration {
+	idx := int(q * float64(len(sorted)-1))
+	return sorted[idx]
+}
+
+// houseBeacons mirrors beacon-sim's default layout: four corners on each of three floors.
+func houseBeacons(width, depth, height float64) []model.Location {
+	floor := height / 3
+	var out []model.Location
+	for _, z := range []float64{floor / 2, 3 * floor / 2, 5 * floor / 2} {
+		for _, c := range [][2]float64{{0, 0}, {width, 0}, {0, depth}, {width, depth}} {
+			out = append(out, model.Location{X: c[0], Y: c[1], Z: z})
+		}
+	}
+	return out
+}
+
+func clamp(p *[3]float64, width, depth, height float64) {
+	limits := [3]float64{width, depth, height}
+	for i := range p {
+		p[i] = math.Min(math.Max(p[i], 0), limits[i])
+	}
+}
+
+func sq(v float64) float64 {
+	return v * v
+}
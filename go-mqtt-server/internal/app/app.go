@@ -7,56 +7,135 @@ import (
 	"errors"
 	"fmt"
 	"log/slog"
-	"math"
 	"net"
 	"net/http"
 	"sort"
 	"strconv"
 	"strings"
+	"sync"
+	"sync/atomic"
 	"time"
 
 	"catlocator/go-mqtt-server/internal/config"
+	"catlocator/go-mqtt-server/internal/ingest"
+	"catlocator/go-mqtt-server/internal/localization"
 	"catlocator/go-mqtt-server/internal/model"
 	"catlocator/go-mqtt-server/internal/mqttbroker"
+	"catlocator/go-mqtt-server/internal/profiling"
 	"catlocator/go-mqtt-server/internal/store"
 
 	"github.com/grandcat/zeroconf"
 )
 
+// internGeneration is how many beacon, tag and scanner IDs each pooled decoder interns before its
+// oldest generation is dropped.
+const internGeneration = 4096
+
 // App wires together the CatLocator services and manages their lifecycle.
 type App struct {
 	cfg    config.Config
 	logger *slog.Logger
 	store  *store.Store
+	shards *store.Shards
 	broker *mqttbroker.Broker
 	mdns   *zeroconf.Server
+
+	runCtx       context.Context
+	backups      backupState
+	ingestErrors *ingestErrorAggregator
+	dedup        *ingest.Deduplicator
+	decoders     sync.Pool // *ingest.Decoder, each with its own interner
+	latency      *ingest.LatencyTracker
+	publishes    [topicClassCount]atomic.Uint64
+	profiler     *profiling.Continuous // nil unless the debug listener and continuous profiling are on
+	locator      *localization.Engine
+	fingerprints *localization.FingerprintIndex
+	models       modelRegistry
+	training     trainingSession
+	transitions  transitionLog
+	webhooks     []*webhook
+	announced    sync.Map // tags whose Home Assistant discovery config has been published
+	sites        siteDirectory
+	ready        chan struct{} // closed once the broker and solver workers are running
 }
 
 // New constructs a new application instance.
 func New(cfg config.Config, logger *slog.Logger) *App {
-	return &App{cfg: cfg, logger: logger}
+	locator := localization.NewEngine(localization.NewTracker(cfg.LocationWindow), cfg.LocationDebounce)
+	locator.EnableParticleFilter(cfg.Particles)
+	locator.EnableRadioMap(cfg.RadioMapStep)
+	mode, _ := localization.ParseResampleMode(cfg.ResampleMode) // validated by config.Load
+	locator.SetResampling(localization.ResampleConfig{
+		MaxAge:   cfg.ResampleMaxAge,
+		HalfLife: cfg.ResampleHalfLife,
+		Mode:     mode,
+	})
+	locator.SetTransitionPolicy(localization.TransitionPolicy{
+		MinProbability: cfg.RoomTransitionProbability,
+		MinDwell:       cfg.RoomTransitionDwell,
+	})
+	fingerprints := localization.NewFingerprintIndex()
+	locator.SetFingerprints(fingerprints)
+
+	a := &App{
+		cfg:          cfg,
+		logger:       logger,
+		ingestErrors: newIngestErrorAggregator(),
+		dedup:        ingest.NewDeduplicator(cfg.DedupWindow),
+		latency:      ingest.NewLatencyTracker(cfg.LocationWindow),
+		locator:      locator,
+		fingerprints: fingerprints,
+		webhooks:     newWebhooks(cfg.WebhookURLs, logger),
+		ready:        make(chan struct{}),
+	}
+	a.decoders.New = func() any { return ingest.NewDecoder(ingest.NewInterner(internGeneration)) }
+	a.models.training = &a.training
+	locator.SetClassifier(&a.models)
+	return a
 }
 
 // Run starts all configured services and blocks until the context is cancelled or an error occurs.
 func (a *App) Run(ctx context.Context) error {
-	db, err := store.Open(a.cfg.DatabasePath)
-	if err != nil {
-		return err
-	}
-	a.store = db
+	a.runCtx = ctx
 
-	if err := a.store.InitSchema(ctx); err != nil {
+	shards, err := store.OpenShards(ctx, a.cfg.DatabasePath, a.handleWriteError)
+	if err != nil {
 		return err
 	}
+	a.shards = shards
+	a.store = shards.Primary()
+	shards.OnCommit(a.latency.Committed)
 
 	defer func() {
-		if cerr := a.store.Close(); cerr != nil {
+		if cerr := a.shards.Close(); cerr != nil {
 			a.logger.Error("close store", "error", cerr)
 		}
 	}()
 
+	if err := a.loadSiteDirectory(ctx); err != nil {
+		return err
+	}
+
+	a.warmStart(ctx)
+	a.loadLocatorRooms(ctx)
+	if err := a.loadPathLossCalibration(ctx); err != nil {
+		a.logger.Warn("path-loss calibration not loaded", "error", err)
+	}
+	a.loadFingerprints(ctx)
+	if err := a.loadRoomModel(ctx); err != nil {
+		a.logger.Warn("room model not loaded", "error", err)
+	}
+
 	broker := mqttbroker.New(a.logger)
 	broker.SetPublishHandler(a.handleMQTTPublish)
+	if a.cfg.CaptureDir != "" {
+		if capture, err := a.startCapture(); err != nil {
+			a.logger.Warn("broker capture disabled", "error", err)
+		} else {
+			broker.SetCapture(capture)
+			defer a.stopCapture(capture)
+		}
+	}
 	brokerErrCh, err := broker.Start(a.cfg.MQTTBindAddress)
 	if err != nil {
 		return err
@@ -74,6 +153,29 @@ func (a *App) Run(ctx context.Context) error {
 		}
 	}
 
+	a.locator.OnUpdate(a.publishPosition)
+	a.locator.OnTransition(a.handleRoomTransition)
+	for _, hook := range a.webhooks {
+		go hook.run(ctx)
+	}
+	a.locator.Start(ctx)
+	a.locator.Recompute()
+	close(a.ready)
+
+	if a.cfg.MetricsPort > 0 {
+		go a.runMetricsServer(ctx)
+	}
+	if a.cfg.DebugBind != "" {
+		if a.cfg.ProfileRetention > 0 {
+			a.profiler = profiling.NewContinuous(a.cfg.ProfileRetention, a.logger)
+			go a.profiler.Run(ctx)
+		}
+		go a.runDebugServer(ctx)
+	}
+	go a.runBackupScheduler(ctx)
+	go a.runFingerprintCapture(ctx)
+	go a.runIngestErrorFlusher(ctx)
+
 	httpErrCh := make(chan error, 1)
 
 	httpServer := &http.Server{
@@ -103,6 +205,7 @@ func (a *App) Run(ctx context.Context) error {
 				return err
 			}
 			a.logger.Info("mqtt broker stopped")
+			a.flushIngestionErrors(context.Background())
 			return nil
 		case err := <-httpErrCh:
 			if err != nil {
@@ -124,66 +227,106 @@ func (a *App) Run(ctx context.Context) error {
 }
 
 func (a *App) handleMQTTPublish(ctx context.Context, msg mqttbroker.PublishMessage) {
-	switch {
-	case strings.HasPrefix(msg.Topic, "beacons/"):
+	class := classifyTopic(msg.Topic)
+	a.publishes[class].Add(1)
+	switch class {
+	case topicReadings:
 		a.handleBeaconReading(ctx, msg)
-	case strings.HasPrefix(msg.Topic, "scanners/"):
+	case topicScanners:
 		a.handleScannerMessage(ctx, msg)
-	case strings.HasPrefix(msg.Topic, "catlocator/training/commands"):
+	case topicTraining:
 		a.handleTrainingCommand(ctx, msg)
 	default:
 		// ignore for now
 	}
 }
 
+// handleBeaconReading ingests a reading payload: one JSON reading, or a JSON array of readings from
+// a scanner that buffers advertisements and publishes them together.
 func (a *App) handleBeaconReading(ctx context.Context, msg mqttbroker.PublishMessage) {
-	var reading model.BeaconReading
-	if err := json.Unmarshal(msg.Payload, &reading); err != nil {
-		a.logger.Warn("mqtt payload decode failed", "topic", msg.Topic, "error", err)
-		a.recordIngestionError(ctx, "", msg.Payload, fmt.Errorf("decode payload: %w", err))
-		return
-	}
+	decoder := a.decoders.Get().(*ingest.Decoder)
+	defer a.decoders.Put(decoder)
 
-	if reading.BeaconID == "" {
-		parts := strings.Split(msg.Topic, "/")
-		if len(parts) >= 2 {
-			reading.BeaconID = parts[1]
+	readings, err := decoder.Readings(msg.Payload)
+	if err != nil {
+		if a.recordIngestionError(topicSegment(msg.Topic, 1), errClassDecode, msg.Payload, fmt.Errorf("decode payload: %w", err)) {
+			a.logger.Warn("mqtt payload decode failed", "topic", msg.Topic, "error", err)
 		}
+		return
+	}
+	trace := model.ReadingTrace{Received: msg.ReceivedAt, Decoded: time.Now()}
+	for i := range readings {
+		readings[i].Trace = trace
+		a.ingestBeaconReading(ctx, msg, readings[i])
 	}
+}
 
-	if reading.Timestamp.IsZero() {
-		reading.Timestamp = time.Now().UTC()
+func (a *App) ingestBeaconReading(ctx context.Context, msg mqttbroker.PublishMessage, reading model.BeaconReading) {
+	if reading.BeaconID == "" {
+		reading.BeaconID = topicSegment(msg.Topic, 1)
 	}
 
 	if reading.BeaconID == "" || reading.TagID == "" {
 		err := fmt.Errorf("missing required identifiers (beacon_id=%q tag_id=%q)", reading.BeaconID, reading.TagID)
-		a.logger.Warn("mqtt payload validation failed", "topic", msg.Topic, "error", err)
-		a.recordIngestionError(ctx, reading.BeaconID, msg.Payload, err)
+		if a.recordIngestionError(reading.BeaconID, errClassValidation, msg.Payload, err) {
+			a.logger.Warn("mqtt payload validation failed", "topic", msg.Topic, "error", err)
+		}
 		return
 	}
 
+	// Fingerprint before defaulting the timestamp so retransmits of undated payloads with a seq still
+	// match. The fingerprint travels with the queued reading and is released again if the reading is
+	// not persisted (here or in handleWriteError), so the scanner's retransmit gets through.
+	fingerprint := ingest.Fingerprint(&reading)
+	if a.dedup != nil && a.dedup.Seen(fingerprint) {
+		a.logger.Debug("duplicate beacon reading dropped", "beacon", reading.BeaconID, "tag", reading.TagID, "seq", reading.Sequence)
+		return
+	}
+
+	a.latency.Decoded(&reading)
+	if reading.Timestamp.IsZero() {
+		reading.Timestamp = time.Now().UTC()
+	}
+
 	storeCtx, cancel := context.WithTimeout(ctx, 2*time.Second)
 	defer cancel()
 
-	if err := a.store.InsertBeaconReading(storeCtx, reading); err != nil {
-		a.logger.Error("failed to persist beacon reading", "beacon", reading.BeaconID, "tag", reading.TagID, "error", err)
-		a.recordIngestionError(ctx, reading.BeaconID, msg.Payload, err)
+	site := a.sites.siteFor(reading.BeaconID)
+	shard, err := a.shards.Site(storeCtx, site)
+	if err == nil {
+		err = shard.Writer.Enqueue(storeCtx, reading, fingerprint)
+	}
+	if err != nil {
+		if a.dedup != nil {
+			a.dedup.Forget(fingerprint)
+		}
+		if a.recordIngestionError(reading.BeaconID, errClassPersist, msg.Payload, err) {
+			a.logger.Error("failed to persist beacon reading", "beacon", reading.BeaconID, "tag", reading.TagID, "site", site, "error", err)
+		}
 		return
 	}
 
-	a.logger.Info("ingested beacon reading", "beacon", reading.BeaconID, "tag", reading.TagID, "rssi", reading.RSSI)
+	// The window is keyed by broker receive time, which replays rebase onto the capture's timeline.
+	// A receive time ahead of the clock would fall outside the solve instant, so it is clamped.
+	observed := time.Now()
+	received := msg.ReceivedAt
+	if received.IsZero() || received.After(observed) {
+		received = observed
+	}
+	a.locator.Observe(reading, received)
+	a.latency.Observed(&reading, observed)
+
+	a.logger.Info("ingested beacon reading", "beacon", reading.BeaconID, "tag", reading.TagID, "rssi", reading.RSSI, "site", site)
 }
 
 func (a *App) handleScannerMessage(ctx context.Context, msg mqttbroker.PublishMessage) {
-	parts := strings.Split(msg.Topic, "/")
-	if len(parts) < 3 {
+	scannerID := topicSegment(msg.Topic, 1)
+	action := topicSegment(msg.Topic, 2)
+	if action == "" && strings.Count(msg.Topic, "/") < 2 {
 		a.logger.Debug("scanner topic ignored", "topic", msg.Topic)
 		return
 	}
 
-	scannerID := parts[1]
-	action := parts[2]
-
 	switch action {
 	case "inventory":
 		a.handleScannerInventory(ctx, scannerID, msg)
@@ -194,25 +337,16 @@ func (a *App) handleScannerMessage(ctx context.Context, msg mqttbroker.PublishMe
 	}
 }
 
-type scannerInventoryPayload struct {
-	ScannerID        string `json:"scanner_id"`
-	TagAddress       string `json:"tag_address"`
-	TagName          string `json:"tag_name"`
-	RSSI             int    `json:"rssi"`
-	ManufacturerID   *int   `json:"manufacturer_id"`
-	ManufacturerData string `json:"manufacturer_data"`
-	TxPower          *int   `json:"tx_power"`
-	EventType        string `json:"event_type"`
-	Timestamp        string `json:"timestamp"`
-}
-
 func (a *App) handleScannerInventory(ctx context.Context, scannerID string, msg mqttbroker.PublishMessage) {
 	if a.store == nil {
 		return
 	}
 
-	var payload scannerInventoryPayload
-	if err := json.Unmarshal(msg.Payload, &payload); err != nil {
+	decoder := a.decoders.Get().(*ingest.Decoder)
+	var payload ingest.InventoryPayload
+	err := decoder.Inventory(msg.Payload, &payload)
+	a.decoders.Put(decoder)
+	if err != nil {
 		a.logger.Warn("scanner inventory decode failed", "scanner", scannerID, "error", err)
 		return
 	}
@@ -225,17 +359,8 @@ func (a *App) handleScannerInventory(ctx context.Context, scannerID string, msg
 		return
 	}
 
-	var lastSeen time.Time
-	if payload.Timestamp != "" {
-		var err error
-		lastSeen, err = time.Parse(time.RFC3339Nano, payload.Timestamp)
-		if err != nil {
-			lastSeen, err = time.Parse(time.RFC3339, payload.Timestamp)
-			if err != nil {
-				lastSeen = time.Now().UTC()
-			}
-		}
-	} else {
+	lastSeen := payload.Timestamp
+	if lastSeen.IsZero() {
 		lastSeen = time.Now().UTC()
 	}
 
@@ -248,12 +373,12 @@ func (a *App) handleScannerInventory(ctx context.Context, scannerID string, msg
 		EventType:        payload.EventType,
 		LastSeen:         lastSeen,
 	}
-	if payload.ManufacturerID != nil {
-		id := *payload.ManufacturerID
+	if payload.HasManufacturerID {
+		id := payload.ManufacturerID
 		beacon.ManufacturerID = &id
 	}
-	if payload.TxPower != nil {
-		p := *payload.TxPower
+	if payload.HasTxPower {
+		p := payload.TxPower
 		beacon.TxPower = &p
 	}
 
@@ -274,17 +399,14 @@ func (a *App) handleScannerInventory(ctx context.Context, scannerID string, msg
 }
 
 func (a *App) handleTrainingCommand(ctx context.Context, msg mqttbroker.PublishMessage) {
-	type payloadSchema struct {
-		Room      string `json:"room"`
-		Command   string `json:"command"`
-		Timestamp string `json:"timestamp"`
-		Source    string `json:"source"`
-	}
-
-	var payload payloadSchema
-	if err := json.Unmarshal(msg.Payload, &payload); err != nil {
-		a.logger.Warn("training command decode failed", "error", err)
-		a.recordIngestionError(ctx, "training", msg.Payload, fmt.Errorf("decode payload: %w", err))
+	decoder := a.decoders.Get().(*ingest.Decoder)
+	var payload ingest.TrainingPayload
+	err := decoder.TrainingCommand(msg.Payload, &payload)
+	a.decoders.Put(decoder)
+	if err != nil {
+		if a.recordIngestionError("training", errClassDecode, msg.Payload, fmt.Errorf("decode payload: %w", err)) {
+			a.logger.Warn("training command decode failed", "error", err)
+		}
 		return
 	}
 
@@ -292,16 +414,14 @@ func (a *App) handleTrainingCommand(ctx context.Context, msg mqttbroker.PublishM
 	command := strings.TrimSpace(strings.ToLower(payload.Command))
 	if room == "" || (command != "start" && command != "stop") {
 		err := fmt.Errorf("invalid training command (room=%q command=%q)", room, command)
-		a.logger.Warn("training command validation failed", "error", err)
-		a.recordIngestionError(ctx, "training", msg.Payload, err)
+		if a.recordIngestionError("training", errClassValidation, msg.Payload, err) {
+			a.logger.Warn("training command validation failed", "error", err)
+		}
 		return
 	}
 
-	parsedTime, err := time.Parse(time.RFC3339Nano, payload.Timestamp)
-	if err != nil {
-		parsedTime, err = time.Parse(time.RFC3339, payload.Timestamp)
-	}
-	if err != nil {
+	parsedTime := payload.Timestamp
+	if parsedTime.IsZero() {
 		parsedTime = time.Now().UTC()
 	}
 
@@ -317,11 +437,14 @@ func (a *App) handleTrainingCommand(ctx context.Context, msg mqttbroker.PublishM
 	defer cancel()
 
 	if err := a.store.InsertTrainingCommand(storeCtx, commandModel); err != nil {
-		a.logger.Error("failed to persist training command", "room", room, "command", command, "error", err)
-		a.recordIngestionError(ctx, "training", msg.Payload, err)
+		if a.recordIngestionError("training", errClassPersist, msg.Payload, err) {
+			a.logger.Error("failed to persist training command", "room", room, "command", command, "error", err)
+		}
 		return
 	}
 
+	a.training.apply(command, room, strings.TrimSpace(payload.TagID))
+
 	a.logger.Info("ingested training command", "room", room, "command", command, "source", payload.Source)
 }
 
@@ -331,12 +454,24 @@ func (a *App) routes() http.Handler {
 	mux.HandleFunc("/readyz", a.handleReadyz)
 	mux.HandleFunc("/api/readings", a.handleRecentReadings)
 	mux.HandleFunc("/api/training/commands", a.handleRecentCommands)
+	mux.HandleFunc("/api/ingestion/errors", a.handleIngestionErrors)
+	mux.HandleFunc("/api/ingestion/stats", a.handleIngestionStats)
+	mux.HandleFunc("/api/ingestion/latency", a.handleIngestionLatency)
 	mux.HandleFunc("/api/config", a.handleConfig)
 	mux.HandleFunc("/api/rooms", a.handleRooms)
+	mux.HandleFunc("/api/rooms/transitions", a.handleRoomTransitions)
+	mux.HandleFunc("/api/calibration/pathloss", a.handlePathLossCalibration)
+	mux.HandleFunc("/api/fingerprints", a.handleFingerprints)
+	mux.HandleFunc("/api/models", a.handleModels)
+	mux.HandleFunc("/api/models/", a.handleModelAction)
+	mux.HandleFunc("/api/sites", a.handleSites)
 	mux.HandleFunc("/api/beacon-control/publish", a.handleBeaconPublish)
 	mux.HandleFunc("/api/export/training", a.handleExportTraining)
 	mux.HandleFunc("/api/admin/wipe", a.handleWipeDatabase)
+	mux.HandleFunc("/api/admin/backup", a.handleBackup)
 	mux.HandleFunc("/api/location/cat", a.handleCatLocation)
+	mux.HandleFunc("/api/locations", a.handleLocations)
+	mux.HandleFunc("/api/locations/", a.handleTagLocation)
 	mux.HandleFunc("/api/scanners/discovered", a.handleDiscoveredScanners)
 	mux.HandleFunc("/api/scanners/control", a.handleScannerControl)
 	mux.HandleFunc("/api/scanners/assign", a.handleAssignScanner)
@@ -413,6 +548,32 @@ func (a *App) handleRooms(w http.ResponseWriter, r *http.Request) {
 				http.Error(w, "room name required", http.StatusBadRequest)
 				return
 			}
+			if len(room.Polygon) > 0 {
+				if len(room.Polygon) < 3 {
+					http.Error(w, "room polygon needs at least 3 vertices", http.StatusBadRequest)
+					return
+				}
+				if room.Radius < 0 {
+					http.Error(w, "room radius must not be negative", http.StatusBadRequest)
+					return
+				}
+				if !(room.ZMax > room.ZMin) {
+					// The floor a position is on is chosen by elevation, so an outline needs its band.
+					http.Error(w, "room polygon needs z_min below z_max", http.StatusBadRequest)
+					return
+				}
+				if room.Z < room.ZMin || room.Z > room.ZMax {
+					room.Z = (room.ZMin + room.ZMax) / 2
+				}
+				if room.X == 0 && room.Y == 0 {
+					// Anchor polygon rooms at their vertex centroid unless one was given.
+					for _, p := range room.Polygon {
+						room.X += p.X / float64(len(room.Polygon))
+						room.Y += p.Y / float64(len(room.Polygon))
+					}
+				}
+				continue
+			}
 			if room.Radius <= 0 {
 				http.Error(w, "room radius must be positive", http.StatusBadRequest)
 				return
@@ -425,6 +586,8 @@ func (a *App) handleRooms(w http.ResponseWriter, r *http.Request) {
 			http.Error(w, "failed to save rooms", http.StatusInternalServerError)
 			return
 		}
+		a.locator.SetRooms(payload.Rooms)
+		a.locator.Recompute()
 		w.WriteHeader(http.StatusNoContent)
 	default:
 		w.Header().Set("Allow", "GET, POST")
@@ -511,6 +674,7 @@ func (a *App) handleAssignScanner(w http.ResponseWriter, r *http.Request) {
 		ScannerID string          `json:"scanner_id"`
 		BeaconID  string          `json:"beacon_id"`
 		Location  *model.Location `json:"location,omitempty"`
+		Site      *string         `json:"site,omitempty"`
 	}
 	if err := json.NewDecoder(r.Body).Decode(&payload); err != nil {
 		http.Error(w, "invalid payload", http.StatusBadRequest)
@@ -533,6 +697,16 @@ func (a *App) handleAssignScanner(w http.ResponseWriter, r *http.Request) {
 		command["location"] = payload.Location
 	}
 
+	if payload.Site != nil {
+		ctx, cancel := context.WithTimeout(r.Context(), 2*time.Second)
+		defer cancel()
+		if err := a.assignBeaconSite(ctx, payload.BeaconID, *payload.Site); err != nil {
+			a.logger.Error("assign site failed", "scanner", payload.ScannerID, "site", *payload.Site, "error", err)
+			http.Error(w, "failed to assign site", http.StatusInternalServerError)
+			return
+		}
+	}
+
 	if err := a.publishScannerCommand(payload.ScannerID, command); err != nil {
 		a.logger.Error("assign publish failed", "scanner", payload.ScannerID, "error", err)
 		http.Error(w, "failed to publish command", http.StatusInternalServerError)
@@ -658,6 +832,9 @@ func (a *App) serveConfig(w http.ResponseWriter, r *http.Request) {
 		"metrics_port":  a.cfg.MetricsPort,
 		"database_path": a.cfg.DatabasePath,
 		"log_level":     a.cfg.LogLevel,
+		"backup_dir":    a.cfg.BackupDir,
+		"backup_every":  a.cfg.BackupInterval.String(),
+		"debug_bind":    a.cfg.DebugBind,
 	}
 
 	response := struct {
@@ -761,7 +938,20 @@ func (a *App) handleRecentReadings(w http.ResponseWriter, r *http.Request) {
 	ctx, cancel := context.WithTimeout(r.Context(), 2*time.Second)
 	defer cancel()
 
-	readings, err := a.store.RecentBeaconReadings(ctx, limit, sinceOpt)
+	var (
+		readings []model.StoredBeaconReading
+		err      error
+	)
+	if site := r.URL.Query().Get("site"); site != "" {
+		shard, ok := a.shards.Lookup(site)
+		if !ok {
+			http.Error(w, "unknown site", http.StatusNotFound)
+			return
+		}
+		readings, err = shard.Store.RecentBeaconReadings(ctx, limit, sinceOpt)
+	} else {
+		readings, err = a.shards.RecentBeaconReadings(ctx, limit, sinceOpt)
+	}
 	if err != nil {
 		a.logger.Error("failed to load recent readings", "error", err)
 		http.Error(w, "failed to load readings", http.StatusInternalServerError)
@@ -832,10 +1022,26 @@ func (a *App) handleExportTraining(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
+	resampler, err := a.exportResampler(r)
+	if err != nil {
+		http.Error(w, err.Error(), http.StatusBadRequest)
+		return
+	}
+
 	ctx, cancel := context.WithTimeout(r.Context(), 10*time.Second)
 	defer cancel()
 
-	readings, err := a.store.AllBeaconReadings(ctx)
+	var readings []model.StoredBeaconReading
+	if site := r.URL.Query().Get("site"); site != "" {
+		shard, ok := a.shards.Lookup(site)
+		if !ok {
+			http.Error(w, "unknown site", http.StatusNotFound)
+			return
+		}
+		readings, err = shard.Store.AllBeaconReadings(ctx)
+	} else {
+		readings, err = a.shards.AllBeaconReadings(ctx)
+	}
 	if err != nil {
 		a.logger.Error("export: failed to load readings", "error", err)
 		http.Error(w, "failed to load readings", http.StatusInternalServerError)
@@ -860,6 +1066,25 @@ func (a *App) handleExportTraining(w http.ResponseWriter, r *http.Request) {
 	activeRoom := ""
 	activeSource := ""
 	cmdIdx := 0
+	// labelAt applies command updates up to ts; timestamps must not go backwards.
+	labelAt := func(ts time.Time) (string, string) {
+		for cmdIdx < len(commands) && !commands[cmdIdx].Timestamp.After(ts) {
+			cmd := commands[cmdIdx]
+			cmdIdx++
+			commandValue := strings.ToLower(strings.TrimSpace(cmd.Command))
+			switch commandValue {
+			case "start":
+				activeRoom = cmd.Room
+				activeSource = cmd.Source
+			case "stop":
+				if activeRoom == "" || strings.EqualFold(activeRoom, cmd.Room) {
+					activeRoom = ""
+					activeSource = ""
+				}
+			}
+		}
+		return activeRoom, activeSource
+	}
 
 	w.Header().Set("Content-Type", "text/csv")
 	w.Header().Set("Content-Disposition", "attachment; filename=catlocator_training.csv")
@@ -883,46 +1108,66 @@ func (a *App) handleExportTraining(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
-	for _, reading := range readings {
-		ts := reading.RecordedAt
-		// apply command updates up to reading timestamp
-		for cmdIdx < len(commands) && !commands[cmdIdx].Timestamp.After(ts) {
-			cmd := commands[cmdIdx]
-			cmdIdx++
-			commandValue := strings.ToLower(strings.TrimSpace(cmd.Command))
-			switch commandValue {
-			case "start":
-				activeRoom = cmd.Room
-				activeSource = cmd.Source
-			case "stop":
-				if activeRoom == "" || strings.EqualFold(activeRoom, cmd.Room) {
-					activeRoom = ""
-					activeSource = ""
-				}
+	if resampler != nil {
+		// One row per (grid instant, tag, beacon), aligned the same way the live engine fuses readings:
+		// on the server's receive time, so skewed or unset scanner clocks resample as they do live.
+		sort.SliceStable(readings, func(i, j int) bool {
+			return readings[i].ReceivedAt.Before(readings[j].ReceivedAt)
+		})
+		emit := func(rr localization.ResampledReading) error {
+			room, source := labelAt(rr.At)
+			if room == "" {
+				return nil
 			}
+			ts := rr.At.Format(time.RFC3339Nano)
+			return csvWriter.Write([]string{
+				ts,
+				ts,
+				rr.BeaconID,
+				rr.TagID,
+				strconv.FormatFloat(rr.RSSI, 'f', 2, 64),
+				room,
+				fmt.Sprintf("%.4f", rr.Location.X),
+				fmt.Sprintf("%.4f", rr.Location.Y),
+				fmt.Sprintf("%.4f", rr.Location.Z),
+				source,
+			})
 		}
-
-		if activeRoom == "" {
-			continue
-		}
-
-		row := []string{
-			reading.RecordedAt.UTC().Format(time.RFC3339Nano),
-			reading.ReceivedAt.UTC().Format(time.RFC3339Nano),
-			reading.BeaconID,
-			reading.TagID,
-			strconv.Itoa(reading.RSSI),
-			activeRoom,
-			fmt.Sprintf("%.4f", reading.BeaconLocation.X),
-			fmt.Sprintf("%.4f", reading.BeaconLocation.Y),
-			fmt.Sprintf("%.4f", reading.BeaconLocation.Z),
-			activeSource,
+		for _, reading := range readings {
+			if err := resampler.Push(reading.BeaconReading, reading.ReceivedAt, emit); err != nil {
+				a.logger.Error("export: failed to write row", "error", err)
+				return
+			}
 		}
-
-		if err := csvWriter.Write(row); err != nil {
+		if err := resampler.Flush(emit); err != nil {
 			a.logger.Error("export: failed to write row", "error", err)
 			return
 		}
+	} else {
+		for _, reading := range readings {
+			room, source := labelAt(reading.RecordedAt)
+			if room == "" {
+				continue
+			}
+
+			row := []string{
+				reading.RecordedAt.UTC().Format(time.RFC3339Nano),
+				reading.ReceivedAt.UTC().Format(time.RFC3339Nano),
+				reading.BeaconID,
+				reading.TagID,
+				strconv.Itoa(reading.RSSI),
+				room,
+				fmt.Sprintf("%.4f", reading.BeaconLocation.X),
+				fmt.Sprintf("%.4f", reading.BeaconLocation.Y),
+				fmt.Sprintf("%.4f", reading.BeaconLocation.Z),
+				source,
+			}
+
+			if err := csvWriter.Write(row); err != nil {
+				a.logger.Error("export: failed to write row", "error", err)
+				return
+			}
+		}
 	}
 
 	if err := csvWriter.Error(); err != nil {
@@ -930,6 +1175,41 @@ func (a *App) handleExportTraining(w http.ResponseWriter, r *http.Request) {
 	}
 }
 
+// minExportResampleStep keeps ?resample= from asking for millions of grid instants per second of data.
+const minExportResampleStep = 100 * time.Millisecond
+
+// exportResampler builds the optional resampling stage for the training export from ?resample=<step>,
+// with ?max_age=, ?half_life= and ?mode= defaulting to the live engine's settings.
+func (a *App) exportResampler(r *http.Request) (*localization.Resampler, error) {
+	q := r.URL.Query()
+	if q.Get("resample") == "" {
+		return nil, nil
+	}
+	cfg := localization.ResampleConfig{MaxAge: a.cfg.ResampleMaxAge, HalfLife: a.cfg.ResampleHalfLife}
+	if cfg.MaxAge <= 0 {
+		cfg.MaxAge = a.cfg.LocationWindow
+	}
+	mode := a.cfg.ResampleMode
+	if v := q.Get("mode"); v != "" {
+		mode = v
+	}
+	var err error
+	if cfg.Mode, err = localization.ParseResampleMode(mode); err != nil {
+		return nil, err
+	}
+	for name, dst := range map[string]*time.Duration{"resample": &cfg.Step, "max_age": &cfg.MaxAge, "half_life": &cfg.HalfLife} {
+		if v := q.Get(name); v != "" {
+			if *dst, err = time.ParseDuration(v); err != nil {
+				return nil, fmt.Errorf("invalid %s: %w", name, err)
+			}
+		}
+	}
+	if cfg.Step < minExportResampleStep {
+		return nil, fmt.Errorf("resample step must be at least %s", minExportResampleStep)
+	}
+	return localization.NewResampler(cfg)
+}
+
 func (a *App) handleWipeDatabase(w http.ResponseWriter, r *http.Request) {
 	if r.Method != http.MethodPost {
 		w.Header().Set("Allow", http.MethodPost)
@@ -958,11 +1238,20 @@ func (a *App) handleWipeDatabase(w http.ResponseWriter, r *http.Request) {
 	ctx, cancel := context.WithTimeout(r.Context(), 5*time.Second)
 	defer cancel()
 
-	if err := a.store.WipeData(ctx); err != nil {
+	// Hold the model lock so no activation lands between the registry wipe and unloading its models.
+	a.models.mu.Lock()
+	err := a.shards.WipeData(ctx)
+	if err == nil {
+		a.models.active.Store(nil)
+		a.models.shadow.Store(nil)
+	}
+	a.models.mu.Unlock()
+	if err != nil {
 		a.logger.Error("wipe: failed", "error", err)
 		http.Error(w, "failed to wipe data", http.StatusInternalServerError)
 		return
 	}
+	a.fingerprints.Load(nil)
 
 	a.logger.Warn("wipe: all telemetry cleared")
 	w.WriteHeader(http.StatusNoContent)
@@ -975,50 +1264,33 @@ func (a *App) handleCatLocation(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
-	modelEstimate := stubbedInference()
-
-	ctx, cancel := context.WithTimeout(r.Context(), 2*time.Second)
-	defer cancel()
-
-	var triPayload *struct {
-		X          float64     `json:"x"`
-		Y          float64     `json:"y"`
-		Z          float64     `json:"z"`
-		Confidence float64     `json:"confidence"`
-		Residual   float64     `json:"residual"`
-		Beacons    int         `json:"beacons"`
-		Message    string      `json:"message"`
-		Rooms      []RoomMatch `json:"rooms"`
-	}
-
-	if a.store != nil {
-		rooms, err := a.store.GetRoomDefinitions(ctx)
-		if err != nil {
-			a.logger.Error("failed to load room definitions", "error", err)
-		}
-		if latest, err := a.store.LatestBeaconReadings(ctx); err == nil {
-			if tri := triangulateLocation(latest, rooms); tri != nil {
-				triPayload = &struct {
-					X          float64     `json:"x"`
-					Y          float64     `json:"y"`
-					Z          float64     `json:"z"`
-					Confidence float64     `json:"confidence"`
-					Residual   float64     `json:"residual"`
-					Beacons    int         `json:"beacons"`
-					Message    string      `json:"message"`
-					Rooms      []RoomMatch `json:"rooms"`
-				}{
-					X:          tri.Location.X,
-					Y:          tri.Location.Y,
-					Z:          tri.Location.Z,
-					Confidence: tri.Confidence,
-					Residual:   tri.Residual,
-					Beacons:    tri.BeaconCount,
-					Message:    tri.Message,
-					Rooms:      tri.Rooms,
-				}
-			}
-		}
+	// Positions are solved on ingest; serving the configured tag's cached result keeps this handler O(1).
+	pos, ok := a.locator.Position(a.cfg.CatTagID)
+	switch {
+	case !ok:
+		pos = localization.Position{Message: "At least three beacons required"}
+	case pos.Stale:
+		pos.Message = "No readings in the current window"
+	}
+
+	triPayload := &struct {
+		X          float64                  `json:"x"`
+		Y          float64                  `json:"y"`
+		Z          float64                  `json:"z"`
+		Confidence float64                  `json:"confidence"`
+		Residual   float64                  `json:"residual"`
+		Beacons    int                      `json:"beacons"`
+		Message    string                   `json:"message"`
+		Rooms      []localization.RoomMatch `json:"rooms"`
+	}{
+		X:          pos.Location.X,
+		Y:          pos.Location.Y,
+		Z:          pos.Location.Z,
+		Confidence: pos.Confidence,
+		Residual:   pos.Residual,
+		Beacons:    pos.BeaconCount,
+		Message:    pos.Message,
+		Rooms:      pos.Rooms,
 	}
 
 	response := struct {
@@ -1028,29 +1300,30 @@ func (a *App) handleCatLocation(w http.ResponseWriter, r *http.Request) {
 			Message    string  `json:"message"`
 		} `json:"model"`
 		Triangulation *struct {
-			X          float64     `json:"x"`
-			Y          float64     `json:"y"`
-			Z          float64     `json:"z"`
-			Confidence float64     `json:"confidence"`
-			Residual   float64     `json:"residual"`
-			Beacons    int         `json:"beacons"`
-			Message    string      `json:"message"`
-			Rooms      []RoomMatch `json:"rooms"`
+			X          float64                  `json:"x"`
+			Y          float64                  `json:"y"`
+			Z          float64                  `json:"z"`
+			Confidence float64                  `json:"confidence"`
+			Residual   float64                  `json:"residual"`
+			Beacons    int                      `json:"beacons"`
+			Message    string                   `json:"message"`
+			Rooms      []localization.RoomMatch `json:"rooms"`
 		} `json:"triangulation,omitempty"`
 		UpdatedAt string `json:"updated_at"`
 	}{
-		Model: struct {
-			Room       string  `json:"room"`
-			Confidence float64 `json:"confidence"`
-			Message    string  `json:"message"`
-		}{
-			Room:       modelEstimate.Room,
-			Confidence: modelEstimate.Confidence,
-			Message:    modelEstimate.Message,
-		},
 		Triangulation: triPayload,
 		UpdatedAt:     time.Now().UTC().Format(time.RFC3339Nano),
 	}
+	switch {
+	case pos.Prediction != nil && !pos.Stale:
+		response.Model.Room = pos.Prediction.Room
+		response.Model.Confidence = pos.Prediction.Probability
+		response.Model.Message = "Room classifier " + pos.Prediction.Model
+	case a.models.active.Load() == nil:
+		response.Model.Message = "No active room model"
+	default:
+		response.Model.Message = "No readings in the current window"
+	}
 
 	w.Header().Set("Content-Type", "application/json")
 	if err := json.NewEncoder(w).Encode(response); err != nil {
@@ -1058,176 +1331,19 @@ func (a *App) handleCatLocation(w http.ResponseWriter, r *http.Request) {
 	}
 }
 
-type inferenceResult struct {
-	Room       string
-	Confidence float64
-	Message    string
-}
-
-type triangulationResult struct {
-	Location    model.Location
-	Confidence  float64
-	Residual    float64
-	BeaconCount int
-	Message     string
-	Rooms       []RoomMatch
-}
-
-type RoomMatch struct {
-	Name         string  `json:"name"`
-	Distance     float64 `json:"distance"`
-	Radius       float64 `json:"radius"`
-	WithinRadius bool    `json:"within_radius"`
-}
-
-func triangulateLocation(readings []model.StoredBeaconReading, rooms []model.RoomDefinition) *triangulationResult {
-	if len(readings) < 3 {
-		return &triangulationResult{
-			BeaconCount: len(readings),
-			Message:     "At least three beacons required",
-		}
-	}
-
-	type point struct {
-		x, y, z float64
-		dist    float64
-	}
-
-	points := make([]point, 0, len(readings))
-	for _, r := range readings {
-		d := rssiToDistance(r.RSSI)
-		if !math.IsNaN(d) && d > 0 {
-			points = append(points, point{
-				x:    r.BeaconLocation.X,
-				y:    r.BeaconLocation.Y,
-				z:    r.BeaconLocation.Z,
-				dist: d,
-			})
-		}
-	}
-
-	if len(points) < 3 {
-		return &triangulationResult{
-			BeaconCount: len(points),
-			Message:     "Insufficient high-quality beacons",
-		}
-	}
-
-	ref := points[0]
-	var a11, a12, a22, b1, b2 float64
-	for i := 1; i < len(points); i++ {
-		pi := points[i]
-		ai := 2 * (pi.x - ref.x)
-		bi := 2 * (pi.y - ref.y)
-		ci := (pi.x*pi.x + pi.y*pi.y - pi.dist*pi.dist) - (ref.x*ref.x + ref.y*ref.y - ref.dist*ref.dist)
-
-		a11 += ai * ai
-		a12 += ai * bi
-		a22 += bi * bi
-		b1 += ai * ci
-		b2 += bi * ci
-	}
-
-	det := a11*a22 - a12*a12
-	if math.Abs(det) < 1e-9 {
-		return &triangulationResult{
-			BeaconCount: len(points),
-			Message:     "Triangulation unstable",
+// topicSegment returns the idx-th '/'-separated segment of topic without allocating a slice.
+func topicSegment(topic string, idx int) string {
+	for i := 0; i < idx; i++ {
+		slash := strings.IndexByte(topic, '/')
+		if slash < 0 {
+			return ""
 		}
+		topic = topic[slash+1:]
 	}
-
-	x := (b1*a22 - b2*a12) / det
-	y := (a11*b2 - a12*b1) / det
-
-	var weightSum, zSum float64
-	for _, p := range points {
-		w := 1.0 / (p.dist + 1e-6)
-		weightSum += w
-		zSum += w * p.z
-	}
-	z := 0.0
-	if weightSum > 0 {
-		z = zSum / weightSum
-	}
-
-	var residual float64
-	for _, p := range points {
-		dx := x - p.x
-		dy := y - p.y
-		dz := z - p.z
-		predicted := math.Sqrt(dx*dx + dy*dy + dz*dz)
-		diff := predicted - p.dist
-		residual += diff * diff
-	}
-	residual = math.Sqrt(residual / float64(len(points)))
-
-	confidence := math.Exp(-residual)
-	if confidence > 1 {
-		confidence = 1
-	}
-
-	matches := make([]RoomMatch, 0, len(rooms))
-	for _, room := range rooms {
-		dx := x - room.X
-		dy := y - room.Y
-		dz := z - room.Z
-		dist := math.Sqrt(dx*dx + dy*dy + dz*dz)
-		matches = append(matches, RoomMatch{
-			Name:         room.Name,
-			Distance:     dist,
-			Radius:       room.Radius,
-			WithinRadius: dist <= room.Radius,
-		})
-	}
-	sort.Slice(matches, func(i, j int) bool {
-		return matches[i].Distance < matches[j].Distance
-	})
-
-	return &triangulationResult{
-		Location:    model.Location{X: x, Y: y, Z: z},
-		Confidence:  confidence,
-		Residual:    residual,
-		BeaconCount: len(points),
-		Message:     "Distance estimates derived from RSSI via path-loss model",
-		Rooms:       matches,
-	}
-}
-
-func rssiToDistance(rssi int) float64 {
-	// Log-distance path loss model with default parameters
-	txPower := -59.0 // expected RSSI at 1 meter
-	n := 2.0         // path-loss exponent (free space)
-	exponent := (txPower - float64(rssi)) / (10 * n)
-	return math.Pow(10, exponent)
-}
-
-func stubbedInference() inferenceResult {
-	rooms := []string{"Living Room", "Kitchen", "Bedroom", "Office"}
-	idx := int(time.Now().UnixNano() % int64(len(rooms)))
-	return inferenceResult{
-		Room:       rooms[idx],
-		Confidence: 0.42,
-		Message:    "Stubbed inference – replace with ML model output",
-	}
-}
-
-func (a *App) recordIngestionError(ctx context.Context, beaconID string, payload []byte, cause error) {
-	if a.store == nil {
-		return
-	}
-
-	recCtx, cancel := context.WithTimeout(ctx, 2*time.Second)
-	defer cancel()
-
-	entry := model.IngestionError{
-		BeaconID: beaconID,
-		Payload:  truncateString(string(payload), 4096),
-		Error:    cause.Error(),
-	}
-
-	if err := a.store.InsertIngestionError(recCtx, entry); err != nil {
-		a.logger.Error("failed to persist ingestion error", "error", err)
+	if slash := strings.IndexByte(topic, '/'); slash >= 0 {
+		return topic[:slash]
 	}
+	return topic
 }
 
 func truncateString(s string, max int) string {
@@ -0,0 +1,371 @@
+package app
+
+import (
+	"compress/gzip"
+	"context"
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/store"
+)
+
+const (
+	backupPagesPerStep    = 256 // ~1 MiB with the default 4 KiB page size
+	backupStepPause       = 5 * time.Millisecond
+	backupSegmentChunk    = 5000
+	backupSegmentPause    = 10 * time.Millisecond
+	backupSegmentInterval = time.Hour
+	backupWatermarkKey    = "backup_segment_watermark"
+	backupSnapshotPrefix  = "catlocator-"
+	backupSegmentPrefix   = "readings-"
+)
+
+// segmentResult summarises an incremental export of newly ingested readings.
+type segmentResult struct {
+	Site        string    `json:"site"`
+	Path        string    `json:"path,omitempty"`
+	FromID      int64     `json:"from_id"`
+	ToID        int64     `json:"to_id"`
+	Rows        int       `json:"rows"`
+	CompletedAt time.Time `json:"completed_at"`
+}
+
+// backupState tracks the most recent backup activity for the admin API.
+type backupState struct {
+	mu            sync.Mutex
+	running       bool
+	lastSnapshots map[string]store.BackupResult
+	lastSegments  map[string]segmentResult
+	lastError     string
+	lastErrorAt   time.Time
+}
+
+func (s *backupState) begin() bool {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.running {
+		return false
+	}
+	s.running = true
+	return true
+}
+
+func (s *backupState) end(err error) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	s.running = false
+	if err != nil {
+		s.lastError = err.Error()
+		s.lastErrorAt = time.Now().UTC()
+	}
+}
+
+// runBackupScheduler cuts incremental reading segments hourly and a full snapshot every BackupInterval.
+func (a *App) runBackupScheduler(ctx context.Context) {
+	if a.cfg.BackupInterval <= 0 {
+		return
+	}
+
+	tick := backupSegmentInterval
+	if a.cfg.BackupInterval < tick {
+		tick = a.cfg.BackupInterval
+	}
+
+	ticker := time.NewTicker(tick)
+	defer ticker.Stop()
+
+	lastSnapshot := time.Now()
+
+	for {
+		select {
+		case <-ctx.Done():
+			return
+		case <-ticker.C:
+			kind := "segment"
+			if time.Since(lastSnapshot) >= a.cfg.BackupInterval {
+				kind = "snapshot"
+			}
+			if err := a.runBackup(ctx, kind); err != nil {
+				a.logger.Error("scheduled backup failed", "kind", kind, "error", err)
+				continue
+			}
+			if kind == "snapshot" {
+				lastSnapshot = time.Now()
+			}
+		}
+	}
+}
+
+// runBackup executes a snapshot (which also cuts a segment) or a segment-only backup for every site
+// shard in turn; each site's files live in its own subdirectory of BackupDir.
+func (a *App) runBackup(ctx context.Context, kind string) error {
+	if !a.backups.begin() {
+		return fmt.Errorf("backup already running")
+	}
+
+	var err error
+	defer func() { a.backups.end(err) }()
+
+	for _, shard := range a.shards.All() {
+		if kind == "snapshot" {
+			if err = a.snapshotDatabase(ctx, shard); err != nil {
+				return err
+			}
+		}
+		if err = a.exportReadingSegment(ctx, shard); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+func backupWatermarkFor(site string) string {
+	if site == store.DefaultSite {
+		return backupWatermarkKey
+	}
+	return backupWatermarkKey + ":" + site
+}
+
+func (a *App) snapshotDatabase(ctx context.Context, shard *store.Shard) error {
+	dir := filepath.Join(a.cfg.BackupDir, shard.Site)
+	name := fmt.Sprintf("%s%s.db", backupSnapshotPrefix, time.Now().UTC().Format("20060102T150405Z"))
+	dst := filepath.Join(dir, name)
+
+	result, err := shard.Store.Snapshot(ctx, dst, store.BackupOptions{
+		PagesPerStep: backupPagesPerStep,
+		Pause:        backupStepPause,
+	})
+	if err != nil {
+		return fmt.Errorf("snapshot: %w", err)
+	}
+
+	a.backups.mu.Lock()
+	if a.backups.lastSnapshots == nil {
+		a.backups.lastSnapshots = make(map[string]store.BackupResult)
+	}
+	a.backups.lastSnapshots[shard.Site] = result
+	a.backups.mu.Unlock()
+
+	a.logger.Info("database snapshot written", "site", shard.Site, "path", result.Path, "bytes", result.Bytes, "steps", result.Steps, "duration_ms", result.DurationMilli)
+	a.pruneSnapshots(dir)
+	return nil
+}
+
+// exportReadingSegment writes readings ingested since the previous segment as gzip-compressed NDJSON.
+// The id watermark lives in app_config so segments chain across restarts.
+func (a *App) exportReadingSegment(ctx context.Context, shard *store.Shard) error {
+	persisted, err := a.store.AppConfig(ctx)
+	if err != nil {
+		return fmt.Errorf("segment watermark: %w", err)
+	}
+
+	watermarkKey := backupWatermarkFor(shard.Site)
+	var watermark int64
+	if v := persisted[watermarkKey]; v != "" {
+		watermark, _ = strconv.ParseInt(v, 10, 64)
+	}
+
+	dir := filepath.Join(a.cfg.BackupDir, shard.Site)
+	if err := os.MkdirAll(dir, 0o755); err != nil {
+		return fmt.Errorf("create backup directory: %w", err)
+	}
+
+	partial := filepath.Join(dir, fmt.Sprintf("%s%d.partial", backupSegmentPrefix, watermark))
+	file, err := os.Create(partial)
+	if err != nil {
+		return fmt.Errorf("create segment: %w", err)
+	}
+
+	gz := gzip.NewWriter(file)
+	enc := json.NewEncoder(gz)
+
+	result := segmentResult{Site: shard.Site, FromID: watermark + 1, ToID: watermark}
+	cleanup := func() {
+		_ = gz.Close()
+		_ = file.Close()
+		_ = os.Remove(partial)
+	}
+
+	for {
+		batch, err := shard.Store.BeaconReadingsAfter(ctx, result.ToID, backupSegmentChunk)
+		if err != nil {
+			cleanup()
+			return fmt.Errorf("segment query: %w", err)
+		}
+		for i := range batch {
+			if err := enc.Encode(&batch[i]); err != nil {
+				cleanup()
+				return fmt.Errorf("segment encode: %w", err)
+			}
+		}
+		result.Rows += len(batch)
+		if len(batch) > 0 {
+			result.ToID = batch[len(batch)-1].ID
+		}
+		if len(batch) < backupSegmentChunk {
+			break
+		}
+
+		select {
+		case <-ctx.Done():
+			cleanup()
+			return ctx.Err()
+		case <-time.After(backupSegmentPause):
+		}
+	}
+
+	if result.Rows == 0 {
+		cleanup()
+		return nil
+	}
+
+	if err := gz.Close(); err != nil {
+		_ = file.Close()
+		_ = os.Remove(partial)
+		return fmt.Errorf("segment flush: %w", err)
+	}
+	if err := file.Close(); err != nil {
+		_ = os.Remove(partial)
+		return fmt.Errorf("segment close: %w", err)
+	}
+
+	result.Path = filepath.Join(dir, fmt.Sprintf("%s%020d-%020d.ndjson.gz", backupSegmentPrefix, result.FromID, result.ToID))
+	if err := os.Rename(partial, result.Path); err != nil {
+		return fmt.Errorf("publish segment: %w", err)
+	}
+
+	if err := a.store.UpsertAppConfig(ctx, watermarkKey, strconv.FormatInt(result.ToID, 10)); err != nil {
+		return fmt.Errorf("segment watermark: %w", err)
+	}
+
+	result.CompletedAt = time.Now().UTC()
+	a.backups.mu.Lock()
+	if a.backups.lastSegments == nil {
+		a.backups.lastSegments = make(map[string]segmentResult)
+	}
+	a.backups.lastSegments[shard.Site] = result
+	a.backups.mu.Unlock()
+
+	a.logger.Info("reading segment written", "site", shard.Site, "path", result.Path, "rows", result.Rows, "from_id", result.FromID, "to_id", result.ToID)
+	return nil
+}
+
+// pruneSnapshots keeps the newest BackupKeep snapshots; segments are retained for point-in-time restores.
+func (a *App) pruneSnapshots(dir string) {
+	if a.cfg.BackupKeep <= 0 {
+		return
+	}
+
+	entries, err := os.ReadDir(dir)
+	if err != nil {
+		return
+	}
+
+	var snapshots []string
+	for _, e := range entries {
+		name := e.Name()
+		if strings.HasPrefix(name, backupSnapshotPrefix) && strings.HasSuffix(name, ".db") {
+			snapshots = append(snapshots, name)
+		}
+	}
+	if len(snapshots) <= a.cfg.BackupKeep {
+		return
+	}
+
+	sort.Strings(snapshots)
+	for _, name := range snapshots[:len(snapshots)-a.cfg.BackupKeep] {
+		if err := os.Remove(filepath.Join(dir, name)); err != nil {
+			a.logger.Warn("prune snapshot failed", "file", name, "error", err)
+		}
+	}
+}
+
+func (a *App) handleBackup(w http.ResponseWriter, r *http.Request) {
+	if a.store == nil {
+		http.Error(w, "store not initialized", http.StatusServiceUnavailable)
+		return
+	}
+
+	switch r.Method {
+	case http.MethodGet:
+		a.backups.mu.Lock()
+		response := struct {
+			Running       bool                          `json:"running"`
+			Directory     string                        `json:"directory"`
+			Interval      string                        `json:"interval"`
+			LastSnapshots map[string]store.BackupResult `json:"last_snapshots,omitempty"`
+			LastSegments  map[string]segmentResult      `json:"last_segments,omitempty"`
+			LastError     string                        `json:"last_error,omitempty"`
+			LastErrorAt   *time.Time                    `json:"last_error_at,omitempty"`
+		}{
+			Running:       a.backups.running,
+			Directory:     a.cfg.BackupDir,
+			Interval:      a.cfg.BackupInterval.String(),
+			LastSnapshots: make(map[string]store.BackupResult, len(a.backups.lastSnapshots)),
+			LastSegments:  make(map[string]segmentResult, len(a.backups.lastSegments)),
+			LastError:     a.backups.lastError,
+		}
+		for site, result := range a.backups.lastSnapshots {
+			response.LastSnapshots[site] = result
+		}
+		for site, result := range a.backups.lastSegments {
+			response.LastSegments[site] = result
+		}
+		if !a.backups.lastErrorAt.IsZero() {
+			at := a.backups.lastErrorAt
+			response.LastErrorAt = &at
+		}
+		a.backups.mu.Unlock()
+
+		w.Header().Set("Content-Type", "application/json")
+		json.NewEncoder(w).Encode(response)
+	case http.MethodPost:
+		var body struct {
+			Kind string `json:"kind"`
+		}
+		if r.ContentLength != 0 {
+			if err := json.NewDecoder(r.Body).Decode(&body); err != nil {
+				http.Error(w, "invalid payload", http.StatusBadRequest)
+				return
+			}
+		}
+
+		kind := strings.ToLower(strings.TrimSpace(body.Kind))
+		if kind == "" {
+			kind = "snapshot"
+		}
+		if kind != "snapshot" && kind != "segment" {
+			http.Error(w, "kind must be snapshot or segment", http.StatusBadRequest)
+			return
+		}
+
+		a.backups.mu.Lock()
+		running := a.backups.running
+		a.backups.mu.Unlock()
+		if running {
+			http.Error(w, "backup already running", http.StatusConflict)
+			return
+		}
+
+		go func() {
+			if err := a.runBackup(a.runCtx, kind); err != nil {
+				a.logger.Error("on-demand backup failed", "kind", kind, "error", err)
+			}
+		}()
+
+		w.Header().Set("Content-Type", "application/json")
+		w.WriteHeader(http.StatusAccepted)
+		json.NewEncoder(w).Encode(map[string]string{"status": "started", "kind": kind})
+	default:
+		w.Header().Set("Allow", "GET, POST")
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+	}
+}
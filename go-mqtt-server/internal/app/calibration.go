@@ -0,0 +1,151 @@
+package app
+
+import (
+	"context"
+	"database/sql"
+	"encoding/json"
+	"errors"
+	"net/http"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/localization"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	defaultCalibrationLookback   = 24 * time.Hour
+	defaultCalibrationMinSamples = 30
+	calibrationSampleLimit       = 100000
+)
+
+// loadPathLossCalibration pushes the active calibration (if any) into the localization engine.
+func (a *App) loadPathLossCalibration(ctx context.Context) error {
+	cals, err := a.store.PathLossCalibrations(ctx)
+	if err != nil {
+		return err
+	}
+	for _, cal := range cals {
+		if cal.Active {
+			a.locator.SetCalibration(cal)
+			a.logger.Info("path-loss calibration loaded", "version", cal.Version, "beacons", len(cal.Beacons))
+			return nil
+		}
+	}
+	a.locator.SetCalibration(model.PathLossCalibration{})
+	return nil
+}
+
+// handlePathLossCalibration lists calibration versions (GET), fits a new one from ground-truth samples
+// (POST {"lookback":"24h","min_samples":30}) or re-activates an existing version (POST {"version":N}).
+// Activation is hot: the engine swaps tables and recomputes every tag without a restart.
+func (a *App) handlePathLossCalibration(w http.ResponseWriter, r *http.Request) {
+	if a.store == nil {
+		http.Error(w, "store not initialized", http.StatusServiceUnavailable)
+		return
+	}
+
+	switch r.Method {
+	case http.MethodGet:
+		ctx, cancel := context.WithTimeout(r.Context(), 2*time.Second)
+		defer cancel()
+
+		cals, err := a.store.PathLossCalibrations(ctx)
+		if err != nil {
+			a.logger.Error("path-loss calibrations query failed", "error", err)
+			http.Error(w, "failed to load calibrations", http.StatusInternalServerError)
+			return
+		}
+
+		w.Header().Set("Content-Type", "application/json")
+		json.NewEncoder(w).Encode(struct {
+			ActiveVersion int64                       `json:"active_version"`
+			Calibrations  []model.PathLossCalibration `json:"calibrations"`
+		}{ActiveVersion: a.locator.CalibrationVersion(), Calibrations: cals})
+	case http.MethodPost:
+		var payload struct {
+			Version    int64  `json:"version"`
+			Lookback   string `json:"lookback"`
+			MinSamples int    `json:"min_samples"`
+			Activate   *bool  `json:"activate"`
+		}
+		if r.ContentLength != 0 {
+			if err := json.NewDecoder(r.Body).Decode(&payload); err != nil {
+				http.Error(w, "invalid payload", http.StatusBadRequest)
+				return
+			}
+		}
+
+		ctx, cancel := context.WithTimeout(r.Context(), 10*time.Second)
+		defer cancel()
+
+		if payload.Version > 0 {
+			if err := a.store.ActivatePathLossCalibration(ctx, payload.Version); err != nil {
+				if errors.Is(err, sql.ErrNoRows) {
+					http.Error(w, "unknown calibration version", http.StatusNotFound)
+					return
+				}
+				a.logger.Error("path-loss activation failed", "version", payload.Version, "error", err)
+				http.Error(w, "failed to activate calibration", http.StatusInternalServerError)
+				return
+			}
+			if err := a.loadPathLossCalibration(ctx); err != nil {
+				a.logger.Error("path-loss reload failed", "error", err)
+				http.Error(w, "failed to reload calibration", http.StatusInternalServerError)
+				return
+			}
+			a.locator.Recompute()
+			w.WriteHeader(http.StatusNoContent)
+			return
+		}
+
+		lookback := defaultCalibrationLookback
+		if payload.Lookback != "" {
+			d, err := time.ParseDuration(payload.Lookback)
+			if err != nil || d <= 0 {
+				http.Error(w, "invalid lookback", http.StatusBadRequest)
+				return
+			}
+			lookback = d
+		}
+		minSamples := payload.MinSamples
+		if minSamples <= 0 {
+			minSamples = defaultCalibrationMinSamples
+		}
+		activate := payload.Activate == nil || *payload.Activate
+
+		samples, err := a.shards.CalibrationSamples(ctx, time.Now().Add(-lookback), calibrationSampleLimit)
+		if err != nil {
+			a.logger.Error("calibration samples query failed", "error", err)
+			http.Error(w, "failed to load calibration samples", http.StatusInternalServerError)
+			return
+		}
+
+		cal, err := localization.Calibrate(samples, minSamples)
+		if err != nil {
+			http.Error(w, err.Error(), http.StatusUnprocessableEntity)
+			return
+		}
+
+		version, err := a.store.SavePathLossCalibration(ctx, cal, activate)
+		if err != nil {
+			a.logger.Error("path-loss calibration save failed", "error", err)
+			http.Error(w, "failed to save calibration", http.StatusInternalServerError)
+			return
+		}
+		cal.Version = version
+		cal.Active = activate
+
+		if activate {
+			a.locator.SetCalibration(cal)
+			a.locator.Recompute()
+		}
+		a.logger.Info("path-loss calibration fitted", "version", version, "samples", len(samples), "beacons", len(cal.Beacons), "tx_power", cal.Default.TxPower, "exponent", cal.Default.Exponent, "active", activate)
+
+		w.Header().Set("Content-Type", "application/json")
+		w.WriteHeader(http.StatusCreated)
+		json.NewEncoder(w).Encode(cal)
+	default:
+		w.Header().Set("Allow", "GET, POST")
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+	}
+}
@@ -0,0 +1,323 @@
+package app
+
+import (
+	"archive/tar"
+	"bytes"
+	"compress/gzip"
+	"context"
+	"crypto/subtle"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"net/http"
+	"net/http/pprof"
+	"runtime"
+	runtimepprof "runtime/pprof"
+	"runtime/trace"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/metrics"
+	"catlocator/go-mqtt-server/internal/profiling"
+)
+
+const (
+	// Sampling rates enabled with the debug listener so mutex and block profiles have content. Both
+	// sample rather than record every event, so the steady-state cost is negligible.
+	debugMutexFraction = 100
+	debugBlockRate     = int(time.Millisecond)
+
+	defaultCaptureSeconds = 30
+	maxCaptureSeconds     = 120
+	defaultTraceSeconds   = 5
+)
+
+// runDebugServer serves pprof, execution traces, capture bundles and the continuous CPU profile on
+// DebugBind until ctx is cancelled. Every request needs DebugToken.
+func (a *App) runDebugServer(ctx context.Context) {
+	runtime.SetMutexProfileFraction(debugMutexFraction)
+	runtime.SetBlockProfileRate(debugBlockRate)
+
+	mux := http.NewServeMux()
+	mux.HandleFunc("/debug/pprof/", pprof.Index)
+	mux.HandleFunc("/debug/pprof/cmdline", pprof.Cmdline)
+	mux.HandleFunc("/debug/pprof/profile", a.handleDebugCPUProfile)
+	mux.HandleFunc("/debug/pprof/symbol", pprof.Symbol)
+	mux.HandleFunc("/debug/pprof/trace", pprof.Trace)
+	mux.HandleFunc("/debug/capture", a.handleDebugCapture)
+	mux.HandleFunc("/debug/profiles", a.handleContinuousProfiles)
+	mux.HandleFunc("/debug/profiles/", a.handleContinuousProfile)
+
+	server := &http.Server{
+		Addr:              a.cfg.DebugBind,
+		Handler:           a.requireDebugToken(mux),
+		ReadHeaderTimeout: 5 * time.Second,
+	}
+	go func() {
+		<-ctx.Done()
+		shutdownCtx, cancel := context.WithTimeout(context.Background(), 2*time.Second)
+		defer cancel()
+		_ = server.Shutdown(shutdownCtx)
+	}()
+
+	a.logger.Info("debug server started", "addr", server.Addr)
+	if err := server.ListenAndServe(); err != nil && !errors.Is(err, http.ErrServerClosed) {
+		a.logger.Error("debug server failed", "error", err)
+	}
+}
+
+// requireDebugToken accepts the token as a bearer token or as the basic-auth password, so both curl
+// and `go tool pprof http://debug:<token>@host/...` work.
+func (a *App) requireDebugToken(next http.Handler) http.Handler {
+	want := []byte(a.cfg.DebugToken)
+	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		got, ok := strings.CutPrefix(r.Header.Get("Authorization"), "Bearer ")
+		if !ok {
+			_, got, ok = r.BasicAuth()
+		}
+		if !ok || subtle.ConstantTimeCompare([]byte(got), want) != 1 {
+			w.Header().Set("WWW-Authenticate", `Basic realm="catlocator-debug"`)
+			http.Error(w, "unauthorized", http.StatusUnauthorized)
+			return
+		}
+		next.ServeHTTP(w, r)
+	})
+}
+
+// handleDebugCPUProfile serves pprof's CPU profile once the continuous profiler has released the
+// runtime's single CPU profiler slot.
+func (a *App) handleDebugCPUProfile(w http.ResponseWriter, r *http.Request) {
+	release, err := profiling.AcquireCPU(r.Context())
+	if err != nil {
+		return
+	}
+	defer release()
+	pprof.Profile(w, r)
+}
+
+// handleDebugCapture profiles the server for ?seconds= (default 30) and returns a tar.gz holding the
+// CPU profile, an execution trace of the first ?trace= seconds (default 5, 0 to skip), heap, mutex,
+// block and goroutine profiles, and the Prometheus metrics from before and after the capture.
+func (a *App) handleDebugCapture(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	seconds, err := queryInt(r, "seconds", defaultCaptureSeconds)
+	if err != nil || seconds < 1 || seconds > maxCaptureSeconds {
+		http.Error(w, fmt.Sprintf("seconds must be between 1 and %d", maxCaptureSeconds), http.StatusBadRequest)
+		return
+	}
+	traceSeconds, err := queryInt(r, "trace", defaultTraceSeconds)
+	if err != nil || traceSeconds < 0 {
+		http.Error(w, "invalid trace seconds", http.StatusBadRequest)
+		return
+	}
+	traceSeconds = min(traceSeconds, seconds)
+
+	release, err := profiling.AcquireCPU(r.Context())
+	if err != nil {
+		return
+	}
+	defer release()
+
+	started := time.Now().UTC()
+	files := []bundleFile{{name: "metrics-before.txt", data: a.metricsText()}}
+	var notes []string
+
+	var traceBuf bytes.Buffer
+	var traceDone sync.WaitGroup
+	if traceSeconds > 0 {
+		if err := trace.Start(&traceBuf); err != nil {
+			notes = append(notes, "trace: "+err.Error())
+		} else {
+			traceDone.Add(1)
+			go func() {
+				defer traceDone.Done()
+				select {
+				case <-time.After(time.Duration(traceSeconds) * time.Second):
+				case <-r.Context().Done():
+				}
+				trace.Stop()
+			}()
+		}
+	}
+	cpu, err := profiling.CPU(r.Context(), time.Duration(seconds)*time.Second)
+	traceDone.Wait()
+	if r.Context().Err() != nil {
+		return
+	}
+	if err != nil {
+		notes = append(notes, "cpu: "+err.Error())
+	} else {
+		files = append(files, bundleFile{name: "cpu.pprof", data: cpu})
+	}
+	if traceBuf.Len() > 0 {
+		files = append(files, bundleFile{name: "trace.out", data: traceBuf.Bytes()})
+	}
+	for _, name := range []string{"heap", "allocs", "mutex", "block", "goroutine"} {
+		var buf bytes.Buffer
+		if err := runtimepprof.Lookup(name).WriteTo(&buf, 0); err != nil {
+			notes = append(notes, name+": "+err.Error())
+			continue
+		}
+		files = append(files, bundleFile{name: name + ".pprof", data: buf.Bytes()})
+	}
+	var stacks bytes.Buffer
+	_ = runtimepprof.Lookup("goroutine").WriteTo(&stacks, 2)
+	files = append(files, bundleFile{name: "goroutines.txt", data: stacks.Bytes()})
+	files = append(files, bundleFile{name: "metrics-after.txt", data: a.metricsText()})
+	if len(notes) > 0 {
+		files = append(files, bundleFile{name: "errors.txt", data: []byte(strings.Join(notes, "\n") + "\n")})
+	}
+
+	name := "catlocator-capture-" + started.Format("20060102T150405Z")
+	a.writeBundle(w, name, started, files)
+}
+
+// handleContinuousProfiles lists the retained continuous CPU profiles.
+func (a *App) handleContinuousProfiles(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	if a.profiler == nil {
+		http.Error(w, "continuous profiling disabled", http.StatusNotFound)
+		return
+	}
+
+	type entry struct {
+		Start      time.Time `json:"start"`
+		DurationMS int64     `json:"duration_ms"`
+		Bytes      int       `json:"bytes"`
+		URL        string    `json:"url"`
+	}
+	profiles := a.profiler.Profiles(time.Time{})
+	response := struct {
+		Window    string  `json:"window"`
+		Period    string  `json:"period"`
+		Retention string  `json:"retention"`
+		Skipped   int     `json:"skipped"`
+		Profiles  []entry `json:"profiles"`
+	}{
+		Window:    a.profiler.Window.String(),
+		Period:    a.profiler.Period.String(),
+		Retention: a.profiler.Retention.String(),
+		Skipped:   a.profiler.Skipped(),
+		Profiles:  make([]entry, 0, len(profiles)),
+	}
+	for _, p := range profiles {
+		response.Profiles = append(response.Profiles, entry{
+			Start:      p.Start.UTC(),
+			DurationMS: p.Duration.Milliseconds(),
+			Bytes:      len(p.Data),
+			URL:        fmt.Sprintf("/debug/profiles/%d.pprof", p.Start.Unix()),
+		})
+	}
+
+	w.Header().Set("Content-Type", "application/json")
+	if err := json.NewEncoder(w).Encode(response); err != nil {
+		a.logger.Error("failed to encode profiles response", "error", err)
+	}
+}
+
+// handleContinuousProfile serves /debug/profiles/<unix>.pprof, one retained profile, and
+// /debug/profiles/archive?since=15m, every profile in the window as a tar.gz for
+// `go tool pprof` to merge.
+func (a *App) handleContinuousProfile(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	if a.profiler == nil {
+		http.Error(w, "continuous profiling disabled", http.StatusNotFound)
+		return
+	}
+
+	name := strings.TrimPrefix(r.URL.Path, "/debug/profiles/")
+	if name == "archive" {
+		since := a.profiler.Retention
+		if v := r.URL.Query().Get("since"); v != "" {
+			d, err := time.ParseDuration(v)
+			if err != nil || d <= 0 {
+				http.Error(w, "invalid since duration", http.StatusBadRequest)
+				return
+			}
+			since = d
+		}
+		now := time.Now().UTC()
+		var files []bundleFile
+		for _, p := range a.profiler.Profiles(now.Add(-since)) {
+			files = append(files, bundleFile{name: "cpu-" + p.Start.UTC().Format("20060102T150405Z") + ".pprof", data: p.Data})
+		}
+		a.writeBundle(w, "catlocator-profiles-"+now.Format("20060102T150405Z"), now, files)
+		return
+	}
+
+	unix, err := strconv.ParseInt(strings.TrimSuffix(name, ".pprof"), 10, 64)
+	if err != nil {
+		http.NotFound(w, r)
+		return
+	}
+	p, err := a.profiler.Lookup(unix)
+	if err != nil {
+		http.NotFound(w, r)
+		return
+	}
+	w.Header().Set("Content-Type", "application/octet-stream")
+	w.Header().Set("Content-Disposition", fmt.Sprintf("attachment; filename=%q", name))
+	_, _ = w.Write(p.Data)
+}
+
+type bundleFile struct {
+	name string
+	data []byte
+}
+
+// writeBundle streams files as <name>.tar.gz, each under a <name>/ directory.
+func (a *App) writeBundle(w http.ResponseWriter, name string, modTime time.Time, files []bundleFile) {
+	w.Header().Set("Content-Type", "application/gzip")
+	w.Header().Set("Content-Disposition", fmt.Sprintf("attachment; filename=%q", name+".tar.gz"))
+	gz := gzip.NewWriter(w)
+	tw := tar.NewWriter(gz)
+	for _, f := range files {
+		hdr := &tar.Header{Name: name + "/" + f.name, Mode: 0o644, Size: int64(len(f.data)), ModTime: modTime}
+		if err := tw.WriteHeader(hdr); err != nil {
+			a.logger.Debug("debug bundle write failed", "error", err)
+			return
+		}
+		if _, err := tw.Write(f.data); err != nil {
+			a.logger.Debug("debug bundle write failed", "error", err)
+			return
+		}
+	}
+	if err := tw.Close(); err != nil {
+		a.logger.Debug("debug bundle write failed", "error", err)
+		return
+	}
+	if err := gz.Close(); err != nil {
+		a.logger.Debug("debug bundle write failed", "error", err)
+	}
+}
+
+// metricsText renders the current Prometheus metrics.
+func (a *App) metricsText() []byte {
+	var buf bytes.Buffer
+	e := metrics.NewExposition(&buf)
+	a.writeMetrics(e)
+	_ = e.Flush()
+	return buf.Bytes()
+}
+
+func queryInt(r *http.Request, key string, fallback int) (int, error) {
+	v := r.URL.Query().Get(key)
+	if v == "" {
+		return fallback, nil
+	}
+	return strconv.Atoi(v)
+}
@@ -0,0 +1,155 @@
+package app
+
+import (
+	"context"
+	"encoding/json"
+	"net/http"
+	"strings"
+	"sync"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/localization"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// fingerprintCaptureInterval is how often a running training session snapshots each tag's RSSI vector.
+const fingerprintCaptureInterval = 2 * time.Second
+
+// trainingSession tracks the room currently being labelled from the iOS app's start/stop commands.
+type trainingSession struct {
+	mu    sync.Mutex
+	room  string
+	tagID string // empty labels every tag
+}
+
+func (s *trainingSession) apply(command, room, tagID string) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	switch command {
+	case "start":
+		s.room, s.tagID = room, tagID
+	case "stop":
+		if s.room == room {
+			s.room, s.tagID = "", ""
+		}
+	}
+}
+
+func (s *trainingSession) current() (room, tagID string) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	return s.room, s.tagID
+}
+
+// loadFingerprints builds the fingerprint index from the stored training captures.
+func (a *App) loadFingerprints(ctx context.Context) {
+	loadCtx, cancel := context.WithTimeout(ctx, 10*time.Second)
+	defer cancel()
+
+	fps, err := a.store.Fingerprints(loadCtx)
+	if err != nil {
+		a.logger.Warn("failed to load fingerprints", "error", err)
+		return
+	}
+	a.fingerprints.Load(fps)
+	if len(fps) > 0 {
+		a.logger.Info("fingerprint index loaded", "fingerprints", len(fps))
+	}
+}
+
+// runFingerprintCapture records a fingerprint for each labelled tag while a training session runs.
+func (a *App) runFingerprintCapture(ctx context.Context) {
+	ticker := time.NewTicker(fingerprintCaptureInterval)
+	defer ticker.Stop()
+
+	for {
+		select {
+		case <-ctx.Done():
+			return
+		case <-ticker.C:
+			if room, tagID := a.training.current(); room != "" {
+				a.captureFingerprints(ctx, room, tagID)
+			}
+		}
+	}
+}
+
+func (a *App) captureFingerprints(ctx context.Context, room, tagID string) {
+	var anchor *model.Location
+	for _, def := range a.locator.Rooms() {
+		if def.Name == room {
+			anchor = &model.Location{X: def.X, Y: def.Y, Z: def.Z}
+			break
+		}
+	}
+
+	var tags []string
+	if tagID != "" {
+		tags = []string{tagID}
+	} else {
+		for _, pos := range a.locator.Positions() {
+			tags = append(tags, pos.TagID)
+		}
+	}
+
+	storeCtx, cancel := context.WithTimeout(ctx, 2*time.Second)
+	defer cancel()
+
+	now := time.Now().UTC()
+	for _, tag := range tags {
+		rssi, ok := a.locator.Vector(tag)
+		if !ok {
+			continue
+		}
+		fp := model.Fingerprint{TagID: tag, Room: room, Location: anchor, RSSI: rssi, CreatedAt: now}
+		id, err := a.store.InsertFingerprint(storeCtx, fp)
+		if err != nil {
+			a.logger.Error("failed to persist fingerprint", "tag", tag, "room", room, "error", err)
+			continue
+		}
+		fp.ID = id
+		a.fingerprints.Add(fp)
+		a.logger.Debug("captured fingerprint", "tag", tag, "room", room, "beacons", len(rssi))
+	}
+}
+
+// handleFingerprints reports fingerprint index statistics (GET) or clears captures (DELETE, optionally ?room=).
+func (a *App) handleFingerprints(w http.ResponseWriter, r *http.Request) {
+	if a.store == nil {
+		http.Error(w, "store not initialized", http.StatusServiceUnavailable)
+		return
+	}
+
+	switch r.Method {
+	case http.MethodGet:
+		room, tagID := a.training.current()
+		w.Header().Set("Content-Type", "application/json")
+		json.NewEncoder(w).Encode(struct {
+			localization.FingerprintStats
+			TrainingRoom string `json:"training_room,omitempty"`
+			TrainingTag  string `json:"training_tag,omitempty"`
+		}{a.fingerprints.Stats(), room, tagID})
+	case http.MethodDelete:
+		ctx, cancel := context.WithTimeout(r.Context(), 5*time.Second)
+		defer cancel()
+
+		room := strings.TrimSpace(r.URL.Query().Get("room"))
+		removed, err := a.store.DeleteFingerprints(ctx, room)
+		if err != nil {
+			a.logger.Error("fingerprint delete failed", "room", room, "error", err)
+			http.Error(w, "failed to delete fingerprints", http.StatusInternalServerError)
+			return
+		}
+		a.loadFingerprints(ctx)
+		a.locator.Recompute()
+		a.logger.Info("fingerprints deleted", "room", room, "removed", removed)
+
+		w.Header().Set("Content-Type", "application/json")
+		json.NewEncoder(w).Encode(struct {
+			Removed int64 `json:"removed"`
+		}{removed})
+	default:
+		w.Header().Set("Allow", "GET, DELETE")
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+	}
+}
@@ -0,0 +1,265 @@
+package app
+
+import (
+	"context"
+	"encoding/json"
+	"net/http"
+	"sort"
+	"strconv"
+	"sync"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/ingest"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	ingestErrorFlushInterval = 10 * time.Second
+	ingestErrorMaxBuckets    = 1024
+	ingestErrorTableCap      = 10000
+	ingestErrorSampleBytes   = 4096
+	ingestErrorOverflowKey   = "*"
+	ingestErrorIdleFlushes   = 6 // flush intervals without failures before a bucket is forgotten
+)
+
+// Ingestion error classes used to aggregate failures.
+const (
+	errClassDecode     = "decode"
+	errClassValidation = "validation"
+	errClassPersist    = "persist"
+)
+
+type ingestErrorKey struct {
+	source string
+	class  string
+}
+
+// ingestErrorBucket accumulates failures for one (source, class) pair.
+// Pending counts are flushed as a single row per interval; totals stay in memory until the bucket
+// has been idle for ingestErrorIdleFlushes intervals.
+type ingestErrorBucket struct {
+	total     int64
+	pending   int64
+	firstSeen time.Time
+	lastSeen  time.Time
+	lastError string
+	sample    []byte
+}
+
+// ingestErrorAggregator bounds the cost of failure storms to O(buckets) writes per flush interval.
+type ingestErrorAggregator struct {
+	mu      sync.Mutex
+	buckets map[ingestErrorKey]*ingestErrorBucket
+	dropped int64
+}
+
+func newIngestErrorAggregator() *ingestErrorAggregator {
+	return &ingestErrorAggregator{buckets: make(map[ingestErrorKey]*ingestErrorBucket)}
+}
+
+// observe counts a failure and reports whether it is the first for its bucket in the current interval.
+func (g *ingestErrorAggregator) observe(source, class string, payload []byte, cause error) bool {
+	now := time.Now().UTC()
+	key := ingestErrorKey{source: source, class: class}
+
+	g.mu.Lock()
+	defer g.mu.Unlock()
+
+	b, ok := g.buckets[key]
+	if !ok {
+		if len(g.buckets) >= ingestErrorMaxBuckets {
+			key.source = ingestErrorOverflowKey
+			g.dropped++
+			b, ok = g.buckets[key]
+		}
+		if !ok {
+			b = &ingestErrorBucket{}
+			g.buckets[key] = b
+		}
+	}
+
+	b.total++
+	b.pending++
+	b.lastSeen = now
+	b.lastError = cause.Error()
+
+	first := b.pending == 1
+	if first {
+		b.firstSeen = now
+		n := len(payload)
+		if n > ingestErrorSampleBytes {
+			n = ingestErrorSampleBytes
+		}
+		b.sample = append(b.sample[:0], payload[:n]...)
+	}
+	return first
+}
+
+// drain returns one aggregated row per bucket with pending failures and resets the interval.
+// Buckets idle for ingestErrorIdleFlushes intervals are dropped, so sources that stopped failing
+// do not hold map entries forever.
+func (g *ingestErrorAggregator) drain(now time.Time) []model.IngestionError {
+	g.mu.Lock()
+	defer g.mu.Unlock()
+
+	var entries []model.IngestionError
+	for key, b := range g.buckets {
+		if b.pending == 0 {
+			if now.Sub(b.lastSeen) >= ingestErrorIdleFlushes*ingestErrorFlushInterval {
+				delete(g.buckets, key)
+			}
+			continue
+		}
+		entries = append(entries, model.IngestionError{
+			BeaconID:    key.source,
+			Payload:     truncateString(string(b.sample), ingestErrorSampleBytes),
+			Error:       b.lastError,
+			Class:       key.class,
+			Occurrences: b.pending,
+			FirstSeen:   b.firstSeen,
+			LastSeen:    b.lastSeen,
+		})
+		b.pending = 0
+	}
+	return entries
+}
+
+type ingestErrorSummary struct {
+	Source    string    `json:"source"`
+	Class     string    `json:"class"`
+	Total     int64     `json:"total"`
+	Pending   int64     `json:"pending"`
+	LastSeen  time.Time `json:"last_seen"`
+	LastError string    `json:"last_error"`
+}
+
+func (g *ingestErrorAggregator) summary() ([]ingestErrorSummary, int64) {
+	g.mu.Lock()
+	defer g.mu.Unlock()
+
+	out := make([]ingestErrorSummary, 0, len(g.buckets))
+	for key, b := range g.buckets {
+		out = append(out, ingestErrorSummary{
+			Source:    key.source,
+			Class:     key.class,
+			Total:     b.total,
+			Pending:   b.pending,
+			LastSeen:  b.lastSeen,
+			LastError: b.lastError,
+		})
+	}
+	sort.Slice(out, func(i, j int) bool {
+		return out[i].Total > out[j].Total
+	})
+	return out, g.dropped
+}
+
+// recordIngestionError aggregates a failed message in memory. It returns true for the first
+// failure of a (source, class) bucket in the current flush interval so callers can rate-limit logs.
+func (a *App) recordIngestionError(source, class string, payload []byte, cause error) bool {
+	if a.ingestErrors == nil {
+		return true
+	}
+	return a.ingestErrors.observe(source, class, payload, cause)
+}
+
+func (a *App) runIngestErrorFlusher(ctx context.Context) {
+	ticker := time.NewTicker(ingestErrorFlushInterval)
+	defer ticker.Stop()
+
+	for {
+		select {
+		case <-ctx.Done():
+			return
+		case <-ticker.C:
+			a.flushIngestionErrors(ctx)
+		}
+	}
+}
+
+func (a *App) flushIngestionErrors(ctx context.Context) {
+	if a.store == nil || a.ingestErrors == nil {
+		return
+	}
+
+	entries := a.ingestErrors.drain(time.Now())
+	if len(entries) == 0 {
+		return
+	}
+
+	flushCtx, cancel := context.WithTimeout(ctx, 2*time.Second)
+	defer cancel()
+
+	if err := a.store.InsertIngestionErrors(flushCtx, entries, ingestErrorTableCap); err != nil {
+		a.logger.Error("failed to persist ingestion errors", "buckets", len(entries), "error", err)
+	}
+}
+
+func (a *App) handleIngestionErrors(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+
+	if a.store == nil {
+		http.Error(w, "store not initialized", http.StatusServiceUnavailable)
+		return
+	}
+
+	limit := 50
+	if v := r.URL.Query().Get("limit"); v != "" {
+		if parsed, err := strconv.Atoi(v); err == nil {
+			if parsed > 0 && parsed <= 500 {
+				limit = parsed
+			}
+		}
+	}
+
+	ctx, cancel := context.WithTimeout(r.Context(), 2*time.Second)
+	defer cancel()
+
+	recent, err := a.store.RecentIngestionErrors(ctx, limit)
+	if err != nil {
+		a.logger.Error("failed to load ingestion errors", "error", err)
+		http.Error(w, "failed to load ingestion errors", http.StatusInternalServerError)
+		return
+	}
+
+	summary, overflow := a.ingestErrors.summary()
+
+	response := struct {
+		Summary  []ingestErrorSummary   `json:"summary"`
+		Overflow int64                  `json:"overflow"`
+		Recent   []model.IngestionError `json:"recent"`
+	}{
+		Summary:  summary,
+		Overflow: overflow,
+		Recent:   recent,
+	}
+
+	w.Header().Set("Content-Type", "application/json")
+	if err := json.NewEncoder(w).Encode(response); err != nil {
+		a.logger.Error("failed to encode ingestion errors response", "error", err)
+	}
+}
+
+func (a *App) handleIngestionStats(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+
+	response := struct {
+		Dedup ingest.DedupStats `json:"dedup"`
+	}{}
+	if a.dedup != nil {
+		response.Dedup = a.dedup.Stats()
+	}
+
+	w.Header().Set("Content-Type", "application/json")
+	if err := json.NewEncoder(w).Encode(response); err != nil {
+		a.logger.Error("failed to encode ingestion stats response", "error", err)
+	}
+}
@@ -0,0 +1,83 @@
+package app
+
+import (
+	"encoding/json"
+	"net/http"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/ingest"
+	"catlocator/go-mqtt-server/internal/metrics"
+)
+
+// stageLatency summarises one stage's histogram in milliseconds.
+type stageLatency struct {
+	Count  uint64  `json:"count"`
+	MeanMS float64 `json:"mean_ms"`
+	P50MS  float64 `json:"p50_ms"`
+	P90MS  float64 `json:"p90_ms"`
+	P99MS  float64 `json:"p99_ms"`
+}
+
+type scannerLatencyReport struct {
+	Scanner  string                  `json:"scanner,omitempty"`
+	Readings uint64                  `json:"readings"`
+	Unsynced uint64                  `json:"unsynced_clock"`
+	Skewed   uint64                  `json:"clock_skewed"`
+	Stages   map[string]stageLatency `json:"stages"`
+}
+
+func newStageLatency(s metrics.HistogramSnapshot) stageLatency {
+	ms := func(d time.Duration) float64 { return float64(d) / float64(time.Millisecond) }
+	return stageLatency{
+		Count:  s.Count,
+		MeanMS: ms(s.Mean()),
+		P50MS:  ms(s.Quantile(0.50)),
+		P90MS:  ms(s.Quantile(0.90)),
+		P99MS:  ms(s.Quantile(0.99)),
+	}
+}
+
+func newScannerLatencyReport(s ingest.ScannerLatency) scannerLatencyReport {
+	report := scannerLatencyReport{
+		Scanner:  s.Scanner,
+		Readings: s.Readings,
+		Unsynced: s.Unsynced,
+		Skewed:   s.Skewed,
+		Stages:   make(map[string]stageLatency, len(s.Stages)),
+	}
+	for _, stage := range ingest.Stages() {
+		report.Stages[stage.String()] = newStageLatency(s.Stages[stage])
+	}
+	return report
+}
+
+// handleIngestionLatency reports per-stage reading latency since startup, overall and per scanner.
+func (a *App) handleIngestionLatency(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+
+	scanners := a.latency.Snapshot()
+	var total ingest.ScannerLatency
+	response := struct {
+		Overall  scannerLatencyReport   `json:"overall"`
+		Scanners []scannerLatencyReport `json:"scanners"`
+	}{Scanners: make([]scannerLatencyReport, 0, len(scanners))}
+	for _, s := range scanners {
+		total.Readings += s.Readings
+		total.Unsynced += s.Unsynced
+		total.Skewed += s.Skewed
+		for i := range s.Stages {
+			total.Stages[i].Merge(s.Stages[i])
+		}
+		response.Scanners = append(response.Scanners, newScannerLatencyReport(s))
+	}
+	response.Overall = newScannerLatencyReport(total)
+
+	w.Header().Set("Content-Type", "application/json")
+	if err := json.NewEncoder(w).Encode(response); err != nil {
+		a.logger.Error("failed to encode ingestion latency response", "error", err)
+	}
+}
@@ -0,0 +1,94 @@
+package app
+
+import (
+	"context"
+	"encoding/json"
+	"net/http"
+	"strings"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/localization"
+)
+
+// locationTopicPrefix is where freshly solved positions are published, one topic per tag.
+const locationTopicPrefix = "catlocator/location/"
+
+// loadLocatorRooms seeds the localization engine with the saved room definitions.
+func (a *App) loadLocatorRooms(ctx context.Context) {
+	loadCtx, cancel := context.WithTimeout(ctx, 2*time.Second)
+	defer cancel()
+
+	rooms, err := a.store.GetRoomDefinitions(loadCtx)
+	if err != nil {
+		a.logger.Warn("failed to load room definitions", "error", err)
+		return
+	}
+	for _, room := range rooms {
+		if len(room.Polygon) >= 3 && !(room.ZMax > room.ZMin) {
+			a.logger.Warn("room outline has no elevation band and is ignored; save it again with z_min and z_max", "room", room.Name)
+		}
+	}
+	a.locator.SetRooms(rooms)
+}
+
+// publishPosition pushes each recomputed position to MQTT so dashboards need not poll the HTTP API.
+func (a *App) publishPosition(pos localization.Position) {
+	a.latency.Located(pos.TagID, pos.UpdatedAt, time.Now())
+	if a.broker == nil {
+		return
+	}
+	data, err := json.Marshal(pos)
+	if err != nil {
+		a.logger.Warn("position encode failed", "tag", pos.TagID, "error", err)
+		return
+	}
+	if err := a.broker.Publish(locationTopicPrefix+pos.TagID, data); err != nil {
+		a.logger.Debug("position publish failed", "tag", pos.TagID, "error", err)
+	}
+}
+
+// handleTagLocation serves /api/locations/{tag} from the engine's cached per-tag position.
+func (a *App) handleTagLocation(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+
+	tagID := strings.TrimPrefix(r.URL.Path, "/api/locations/")
+	if tagID == "" || strings.Contains(tagID, "/") {
+		http.NotFound(w, r)
+		return
+	}
+
+	pos, ok := a.locator.Position(tagID)
+	if !ok {
+		http.Error(w, "unknown tag", http.StatusNotFound)
+		return
+	}
+
+	w.Header().Set("Content-Type", "application/json")
+	if err := json.NewEncoder(w).Encode(pos); err != nil {
+		a.logger.Error("tag location encode failed", "tag", tagID, "error", err)
+	}
+}
+
+// handleLocations returns the cached position of every tracked tag.
+func (a *App) handleLocations(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+
+	w.Header().Set("Content-Type", "application/json")
+	if err := json.NewEncoder(w).Encode(struct {
+		Locations []localization.Position `json:"locations"`
+		UpdatedAt string                  `json:"updated_at"`
+	}{
+		Locations: a.locator.Positions(),
+		UpdatedAt: time.Now().UTC().Format(time.RFC3339Nano),
+	}); err != nil {
+		a.logger.Error("locations encode failed", "error", err)
+	}
+}
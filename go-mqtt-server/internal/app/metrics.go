@@ -0,0 +1,169 @@
+package app
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"net/http"
+	"strings"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/ingest"
+	"catlocator/go-mqtt-server/internal/metrics"
+	"catlocator/go-mqtt-server/internal/store"
+)
+
+// topicClass groups inbound publishes for the per-class traffic counters.
+type topicClass int
+
+const (
+	topicReadings topicClass = iota
+	topicScanners
+	topicTraining
+	topicOther
+	topicClassCount
+)
+
+var topicClassNames = [topicClassCount]string{"readings", "scanners", "training", "other"}
+
+func classifyTopic(topic string) topicClass {
+	switch {
+	case strings.HasPrefix(topic, "beacons/"):
+		return topicReadings
+	case strings.HasPrefix(topic, "scanners/"):
+		return topicScanners
+	case strings.HasPrefix(topic, "catlocator/training/commands"):
+		return topicTraining
+	default:
+		return topicOther
+	}
+}
+
+// runMetricsServer serves /metrics on MetricsPort until ctx is cancelled. Metrics are optional, so
+// a listener failure is logged rather than stopping the server.
+func (a *App) runMetricsServer(ctx context.Context) {
+	mux := http.NewServeMux()
+	mux.HandleFunc("/metrics", a.handleMetrics)
+	server := &http.Server{
+		Addr:              fmt.Sprintf(":%d", a.cfg.MetricsPort),
+		Handler:           mux,
+		ReadHeaderTimeout: 5 * time.Second,
+	}
+	go func() {
+		<-ctx.Done()
+		shutdownCtx, cancel := context.WithTimeout(context.Background(), 2*time.Second)
+		defer cancel()
+		_ = server.Shutdown(shutdownCtx)
+	}()
+
+	a.logger.Info("metrics server started", "addr", server.Addr)
+	if err := server.ListenAndServe(); err != nil && !errors.Is(err, http.ErrServerClosed) {
+		a.logger.Error("metrics server failed", "error", err)
+	}
+}
+
+// handleMetrics writes every counter in the Prometheus text format. All sources are atomics or
+// short read locks, so a scrape never blocks ingest.
+func (a *App) handleMetrics(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	w.Header().Set("Content-Type", metrics.ContentType)
+	e := metrics.NewExposition(w)
+	a.writeMetrics(e)
+	if err := e.Flush(); err != nil {
+		a.logger.Debug("metrics write failed", "error", err)
+	}
+}
+
+func (a *App) writeMetrics(e *metrics.Exposition) {
+	if a.broker != nil {
+		stats := a.broker.Stats()
+		e.Family("catlocator_mqtt_clients", "gauge", "MQTT connections currently open.")
+		e.Sample("catlocator_mqtt_clients", float64(stats.Clients))
+		e.Family("catlocator_mqtt_connections_total", "counter", "MQTT connections accepted.")
+		e.Uint("catlocator_mqtt_connections_total", stats.Accepted)
+		e.Family("catlocator_mqtt_received_bytes_total", "counter", "Payload bytes received in MQTT publishes.")
+		e.Uint("catlocator_mqtt_received_bytes_total", stats.ReceivedBytes)
+		e.Family("catlocator_mqtt_forwarded_total", "counter", "Publishes delivered to MQTT subscribers.")
+		e.Uint("catlocator_mqtt_forwarded_total", stats.Forwarded)
+		e.Family("catlocator_mqtt_dropped_total", "counter", "Publishes not delivered because a subscriber's send queue was full.")
+		e.Uint("catlocator_mqtt_dropped_total", stats.Dropped)
+		e.Family("catlocator_mqtt_retained_topics", "gauge", "Retained MQTT messages held in memory.")
+		e.Sample("catlocator_mqtt_retained_topics", float64(stats.Retained))
+		e.Family("catlocator_mqtt_retained_refused_total", "counter", "Retained messages refused because the retained-topic cap was reached.")
+		e.Uint("catlocator_mqtt_retained_refused_total", stats.Refused)
+	}
+	e.Family("catlocator_mqtt_publishes_total", "counter", "MQTT publishes received, by topic class.")
+	for i := range a.publishes {
+		e.Uint("catlocator_mqtt_publishes_total", a.publishes[i].Load(), "class", topicClassNames[i])
+	}
+
+	if a.dedup != nil {
+		stats := a.dedup.Stats()
+		e.Family("catlocator_ingest_duplicates_total", "counter", "Readings dropped as duplicates.")
+		e.Uint("catlocator_ingest_duplicates_total", stats.Duplicates)
+	}
+
+	if a.shards != nil {
+		shards := a.shards.All()
+		stats := make([]struct {
+			site string
+			s    store.WriterStats
+		}, len(shards))
+		for i, shard := range shards {
+			stats[i].site, stats[i].s = shard.Site, shard.Writer.Stats()
+		}
+		e.Family("catlocator_ingest_queue_depth", "gauge", "Readings waiting for the store writer, by site.")
+		for _, s := range stats {
+			e.Sample("catlocator_ingest_queue_depth", float64(s.s.QueueDepth), "site", s.site)
+		}
+		e.Family("catlocator_store_readings_committed_total", "counter", "Readings committed to SQLite, by site.")
+		for _, s := range stats {
+			e.Uint("catlocator_store_readings_committed_total", s.s.Committed, "site", s.site)
+		}
+		e.Family("catlocator_store_readings_failed_total", "counter", "Readings in batches that failed to commit, by site.")
+		for _, s := range stats {
+			e.Uint("catlocator_store_readings_failed_total", s.s.Failed, "site", s.site)
+		}
+		e.Family("catlocator_store_batch_size", "histogram", "Readings per store transaction, by site.")
+		for _, s := range stats {
+			e.Sizes("catlocator_store_batch_size", s.s.Batches, "site", s.site)
+		}
+		e.Family("catlocator_store_commit_seconds", "histogram", "Store transaction commit time, by site.")
+		for _, s := range stats {
+			e.Histogram("catlocator_store_commit_seconds", s.s.CommitTime, "site", s.site)
+		}
+	}
+
+	e.Family("catlocator_localization_updates_total", "counter", "Positions computed by the localization engine.")
+	e.Uint("catlocator_localization_updates_total", a.locator.Updates())
+	e.Family("catlocator_localization_solve_seconds", "histogram", "Time to compute one position.")
+	e.Histogram("catlocator_localization_solve_seconds", a.locator.SolveTimes())
+
+	scanners := a.latency.Snapshot()
+	e.Family("catlocator_scanner_readings_total", "counter", "Readings accepted from each scanner.")
+	for _, s := range scanners {
+		e.Uint("catlocator_scanner_readings_total", s.Readings, "scanner", s.Scanner)
+	}
+	e.Family("catlocator_scanner_last_heard_timestamp_seconds", "gauge", "Unix time of each scanner's newest reading.")
+	for _, s := range scanners {
+		e.Sample("catlocator_scanner_last_heard_timestamp_seconds", float64(s.LastHeard.UnixNano())/1e9, "scanner", s.Scanner)
+	}
+	e.Family("catlocator_scanner_unsynced_readings_total", "counter", "Readings whose scanner clock was not set, so clock-dependent stages were skipped.")
+	for _, s := range scanners {
+		e.Uint("catlocator_scanner_unsynced_readings_total", s.Unsynced, "scanner", s.Scanner)
+	}
+	e.Family("catlocator_scanner_clock_skewed_total", "counter", "Clock-dependent latency samples dropped because they came out negative.")
+	for _, s := range scanners {
+		e.Uint("catlocator_scanner_clock_skewed_total", s.Skewed, "scanner", s.Scanner)
+	}
+	e.Family("catlocator_reading_latency_seconds", "histogram", "Reading latency per pipeline stage, by scanner.")
+	for _, s := range scanners {
+		for _, stage := range ingest.Stages() {
+			e.Histogram("catlocator_reading_latency_seconds", s.Stages[stage], "scanner", s.Scanner, "stage", stage.String())
+		}
+	}
+}
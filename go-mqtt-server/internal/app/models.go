@@ -0,0 +1,497 @@
+package app
+
+import (
+	"bytes"
+	"context"
+	"database/sql"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"io/fs"
+	"net/http"
+	"os"
+	"path/filepath"
+	"regexp"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/classifier"
+	"catlocator/go-mqtt-server/internal/localization"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// maxModelUpload bounds the size of an uploaded artifact.
+const maxModelUpload = 64 << 20
+
+var modelVersionPattern = regexp.MustCompile(`^[A-Za-z0-9._-]{1,64}$`)
+
+// roomModel is a loaded room-classifier artifact and the registry row it came from.
+type roomModel struct {
+	meta     model.RoomModel
+	forest   *classifier.Forest
+	loadTime time.Duration
+}
+
+// classifierRows recycles the per-window row buffers handed to the forest.
+var classifierRows = sync.Pool{New: func() any { return new([]classifier.Row) }}
+
+// Classify evaluates the forest on one tag's window, one row per beacon mean. Probabilities reuses
+// probs' storage when it is large enough.
+func (m *roomModel) Classify(tagID string, window []localization.Observation, probs []float64) (localization.RoomPrediction, bool) {
+	buf := classifierRows.Get().(*[]classifier.Row)
+	rows := (*buf)[:0]
+	for _, o := range window {
+		rows = append(rows, classifier.Row{BeaconID: o.BeaconID, TagID: tagID, RSSI: o.RSSI, Beacon: o.Location})
+	}
+	pred, ok := m.forest.Predict(rows, probs)
+	*buf = rows
+	classifierRows.Put(buf)
+	if !ok {
+		return localization.RoomPrediction{}, false
+	}
+	return localization.RoomPrediction{
+		Room:          pred.Room,
+		Probability:   pred.Probability,
+		Model:         m.meta.Version,
+		LatencyUS:     float64(pred.Latency.Nanoseconds()) / 1e3,
+		Classes:       m.forest.Classes(),
+		Probabilities: pred.Probabilities,
+	}, true
+}
+
+// shadowRun compares a candidate model with the active one on every live window.
+type shadowRun struct {
+	candidate *roomModel
+	activeID  int64
+	startedAt time.Time
+
+	predictions      atomic.Int64
+	agreements       atomic.Int64
+	labelled         atomic.Int64
+	activeCorrect    atomic.Int64
+	candidateCorrect atomic.Int64
+	activeNanos      atomic.Int64
+	candidateNanos   atomic.Int64
+}
+
+func (s *shadowRun) summary(endedAt time.Time) model.ModelEvaluation {
+	e := model.ModelEvaluation{
+		ActiveModelID:    s.activeID,
+		CandidateModelID: s.candidate.meta.ID,
+		StartedAt:        s.startedAt,
+		EndedAt:          endedAt,
+		Predictions:      s.predictions.Load(),
+		Agreements:       s.agreements.Load(),
+		Labelled:         s.labelled.Load(),
+		ActiveCorrect:    s.activeCorrect.Load(),
+		CandidateCorrect: s.candidateCorrect.Load(),
+	}
+	if e.Predictions > 0 {
+		e.ActiveLatencyUS = float64(s.activeNanos.Load()) / float64(e.Predictions) / 1e3
+		e.CandidateLatencyUS = float64(s.candidateNanos.Load()) / float64(e.Predictions) / 1e3
+	}
+	return e
+}
+
+// modelRegistry is the engine's room classifier. The active and shadow models are swapped through
+// atomic pointers, so deploys never pause the solver workers; loading happens on the caller's goroutine.
+type modelRegistry struct {
+	mu       sync.Mutex // serialises swaps
+	active   atomic.Pointer[roomModel]
+	shadow   atomic.Pointer[shadowRun]
+	training *trainingSession
+}
+
+// Classify runs the active model and, when a shadow run is in progress, the candidate alongside it.
+func (r *modelRegistry) Classify(tagID string, window []localization.Observation, probs []float64) (localization.RoomPrediction, bool) {
+	active := r.active.Load()
+	var (
+		pred localization.RoomPrediction
+		ok   bool
+	)
+	if active != nil {
+		pred, ok = active.Classify(tagID, window, probs)
+	}
+
+	if run := r.shadow.Load(); run != nil && len(window) > 0 {
+		// Only the candidate's top room is compared, so its distribution gets a fresh buffer.
+		cand, candOK := run.candidate.Classify(tagID, window, nil)
+		if candOK {
+			run.predictions.Add(1)
+			run.candidateNanos.Add(int64(cand.LatencyUS * 1e3))
+			if ok {
+				run.activeNanos.Add(int64(pred.LatencyUS * 1e3))
+				if cand.Room == pred.Room {
+					run.agreements.Add(1)
+				}
+			}
+			if room, tag := r.training.current(); room != "" && (tag == "" || tag == tagID) {
+				run.labelled.Add(1)
+				if ok && pred.Room == room {
+					run.activeCorrect.Add(1)
+				}
+				if cand.Room == room {
+					run.candidateCorrect.Add(1)
+				}
+			}
+		}
+	}
+	return pred, ok
+}
+
+// loadModel reads and validates a registered artifact.
+func loadModel(meta model.RoomModel) (*roomModel, error) {
+	start := time.Now()
+	forest, err := classifier.LoadFile(meta.ArtifactPath)
+	if err != nil {
+		return nil, err
+	}
+	return &roomModel{meta: meta, forest: forest, loadTime: time.Since(start)}, nil
+}
+
+// loadRoomModel loads the room_models row marked active at startup.
+func (a *App) loadRoomModel(ctx context.Context) error {
+	meta, err := a.store.ActiveRoomModel(ctx)
+	if errors.Is(err, sql.ErrNoRows) {
+		a.logger.Info("no active room model; room classification disabled")
+		return nil
+	}
+	if err != nil {
+		return err
+	}
+
+	m, err := loadModel(meta)
+	if err != nil {
+		return err
+	}
+	a.models.active.Store(m)
+
+	size := m.forest.Size()
+	a.logger.Info("room model loaded", "version", meta.Version, "trees", size.Trees, "nodes", size.Nodes, "bytes", size.Bytes, "load", m.loadTime)
+	return nil
+}
+
+// activateModel loads model id (reusing the shadow candidate when it is the same model), persists the
+// choice and swaps it in. A shadow run of that model ends, since it has been promoted.
+func (a *App) activateModel(ctx context.Context, id int64) (*roomModel, error) {
+	a.models.mu.Lock()
+	defer a.models.mu.Unlock()
+
+	var m *roomModel
+	run := a.models.shadow.Load()
+	if run != nil && run.candidate.meta.ID == id {
+		// Status handlers may still be reading the candidate; promote a copy sharing its forest.
+		promoted := *run.candidate
+		m = &promoted
+	} else {
+		meta, err := a.store.RoomModel(ctx, id)
+		if err != nil {
+			return nil, err
+		}
+		if m, err = loadModel(meta); err != nil {
+			return nil, err
+		}
+	}
+
+	if err := a.store.ActivateRoomModel(ctx, id); err != nil {
+		return nil, err
+	}
+	m.meta.Active = true // m is not yet visible to other goroutines
+	if prev := a.models.active.Swap(m); prev != nil {
+		a.logger.Info("room model replaced", "from", prev.meta.Version, "to", m.meta.Version)
+	}
+	if run != nil && run.candidate.meta.ID == id {
+		a.endShadowLocked(ctx)
+	}
+	return m, nil
+}
+
+// startShadow loads model id as a candidate to run alongside the active model, ending any previous run.
+func (a *App) startShadow(ctx context.Context, id int64) (*roomModel, error) {
+	meta, err := a.store.RoomModel(ctx, id)
+	if err != nil {
+		return nil, err
+	}
+	m, err := loadModel(meta)
+	if err != nil {
+		return nil, err
+	}
+
+	a.models.mu.Lock()
+	defer a.models.mu.Unlock()
+	a.endShadowLocked(ctx)
+	run := &shadowRun{candidate: m, startedAt: time.Now().UTC()}
+	if active := a.models.active.Load(); active != nil {
+		run.activeID = active.meta.ID
+	}
+	a.models.shadow.Store(run)
+	a.logger.Info("shadow evaluation started", "candidate", meta.Version)
+	return m, nil
+}
+
+// endShadowLocked stops the shadow run, if any, and records its comparison.
+func (a *App) endShadowLocked(ctx context.Context) *model.ModelEvaluation {
+	run := a.models.shadow.Swap(nil)
+	if run == nil {
+		return nil
+	}
+	summary := run.summary(time.Now().UTC())
+	id, err := a.store.InsertModelEvaluation(ctx, summary)
+	if err != nil {
+		a.logger.Error("failed to record shadow evaluation", "candidate", run.candidate.meta.Version, "error", err)
+	}
+	summary.ID = id
+	a.logger.Info("shadow evaluation ended", "candidate", run.candidate.meta.Version, "predictions", summary.Predictions,
+		"agreements", summary.Agreements, "labelled", summary.Labelled, "active_correct", summary.ActiveCorrect,
+		"candidate_correct", summary.CandidateCorrect)
+	return &summary
+}
+
+type roomModelStatus struct {
+	model.RoomModel
+	Size   classifier.Size  `json:"size"`
+	Stats  classifier.Stats `json:"stats"`
+	LoadMS float64          `json:"load_ms"`
+}
+
+func (m *roomModel) status() *roomModelStatus {
+	if m == nil {
+		return nil
+	}
+	return &roomModelStatus{
+		RoomModel: m.meta,
+		Size:      m.forest.Size(),
+		Stats:     m.forest.Stats(),
+		LoadMS:    float64(m.loadTime.Microseconds()) / 1e3,
+	}
+}
+
+// handleModels lists the registry (GET) or uploads an artifact (POST, body = exported forest JSON,
+// query: version, notes, trained_on, accuracy, activate=true|shadow=true).
+func (a *App) handleModels(w http.ResponseWriter, r *http.Request) {
+	if a.store == nil {
+		http.Error(w, "store not initialized", http.StatusServiceUnavailable)
+		return
+	}
+
+	switch r.Method {
+	case http.MethodGet:
+		ctx, cancel := context.WithTimeout(r.Context(), 2*time.Second)
+		defer cancel()
+
+		models, err := a.store.RoomModels(ctx)
+		if err != nil {
+			a.logger.Error("room models query failed", "error", err)
+			http.Error(w, "failed to load models", http.StatusInternalServerError)
+			return
+		}
+		evaluations, err := a.store.ModelEvaluations(ctx, 20)
+		if err != nil {
+			a.logger.Error("model evaluations query failed", "error", err)
+			http.Error(w, "failed to load evaluations", http.StatusInternalServerError)
+			return
+		}
+
+		var shadow *model.ModelEvaluation
+		if run := a.models.shadow.Load(); run != nil {
+			summary := run.summary(time.Now().UTC())
+			shadow = &summary
+		}
+
+		w.Header().Set("Content-Type", "application/json")
+		json.NewEncoder(w).Encode(struct {
+			Active      *roomModelStatus        `json:"active"`
+			Shadow      *model.ModelEvaluation  `json:"shadow"`
+			Models      []model.RoomModel       `json:"models"`
+			Evaluations []model.ModelEvaluation `json:"evaluations"`
+		}{a.models.active.Load().status(), shadow, models, evaluations})
+	case http.MethodPost:
+		a.uploadModel(w, r)
+	default:
+		w.Header().Set("Allow", "GET, POST")
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+	}
+}
+
+func (a *App) uploadModel(w http.ResponseWriter, r *http.Request) {
+	q := r.URL.Query()
+	version := strings.TrimSpace(q.Get("version"))
+	if version == "" {
+		version = time.Now().UTC().Format("20060102T150405Z")
+	}
+	if !modelVersionPattern.MatchString(version) {
+		http.Error(w, "invalid version", http.StatusBadRequest)
+		return
+	}
+	meta := model.RoomModel{
+		Version:   version,
+		TrainedOn: strings.TrimSpace(q.Get("trained_on")),
+		Notes:     strings.TrimSpace(q.Get("notes")),
+	}
+	if meta.TrainedOn == "" {
+		meta.TrainedOn = "upload"
+	}
+	if v := q.Get("accuracy"); v != "" {
+		acc, err := strconv.ParseFloat(v, 64)
+		if err != nil {
+			http.Error(w, "invalid accuracy", http.StatusBadRequest)
+			return
+		}
+		meta.Accuracy = &acc
+	}
+	activate := q.Get("activate") == "true"
+	shadow := q.Get("shadow") == "true"
+	if activate && shadow {
+		http.Error(w, "activate and shadow are exclusive", http.StatusBadRequest)
+		return
+	}
+
+	body, err := io.ReadAll(http.MaxBytesReader(w, r.Body, maxModelUpload))
+	if err != nil {
+		http.Error(w, "failed to read artifact", http.StatusRequestEntityTooLarge)
+		return
+	}
+	// Validate before anything is written: the artifact must decode and match the feature schema.
+	if _, err := classifier.Load(bytes.NewReader(body)); err != nil {
+		http.Error(w, err.Error(), http.StatusUnprocessableEntity)
+		return
+	}
+
+	dir := filepath.Join(filepath.Dir(a.cfg.DatabasePath), "models")
+	if err := os.MkdirAll(dir, 0o755); err != nil {
+		a.logger.Error("model dir create failed", "dir", dir, "error", err)
+		http.Error(w, "failed to store artifact", http.StatusInternalServerError)
+		return
+	}
+	path := filepath.Join(dir, version+".forest.json")
+	// O_EXCL makes the existence check and the create one step, so concurrent uploads of a version
+	// cannot overwrite each other.
+	f, err := os.OpenFile(path, os.O_WRONLY|os.O_CREATE|os.O_EXCL, 0o644)
+	if errors.Is(err, fs.ErrExist) {
+		http.Error(w, "version already exists", http.StatusConflict)
+		return
+	}
+	if err == nil {
+		_, err = f.Write(body)
+		if closeErr := f.Close(); err == nil {
+			err = closeErr
+		}
+		if err != nil {
+			_ = os.Remove(path)
+		}
+	}
+	if err != nil {
+		a.logger.Error("model write failed", "path", path, "error", err)
+		http.Error(w, "failed to store artifact", http.StatusInternalServerError)
+		return
+	}
+	meta.ArtifactPath = path
+
+	ctx, cancel := context.WithTimeout(r.Context(), 10*time.Second)
+	defer cancel()
+
+	id, err := a.store.InsertRoomModel(ctx, meta)
+	if err != nil {
+		_ = os.Remove(path)
+		a.logger.Error("room model insert failed", "version", version, "error", err)
+		http.Error(w, "failed to register model", http.StatusInternalServerError)
+		return
+	}
+	meta.ID = id
+	a.logger.Info("room model uploaded", "id", id, "version", version, "bytes", len(body))
+
+	var loaded *roomModel
+	switch {
+	case activate:
+		loaded, err = a.activateModel(ctx, id)
+	case shadow:
+		loaded, err = a.startShadow(ctx, id)
+	}
+	if err != nil {
+		a.logger.Error("room model deploy failed", "version", version, "error", err)
+		http.Error(w, "model registered but failed to deploy", http.StatusInternalServerError)
+		return
+	}
+
+	w.Header().Set("Content-Type", "application/json")
+	w.WriteHeader(http.StatusCreated)
+	if loaded != nil {
+		json.NewEncoder(w).Encode(loaded.status())
+		return
+	}
+	json.NewEncoder(w).Encode(meta)
+}
+
+// handleModelAction serves POST /api/models/activate and POST|DELETE /api/models/shadow, each taking
+// {"id": N} where a model is named.
+func (a *App) handleModelAction(w http.ResponseWriter, r *http.Request) {
+	if a.store == nil {
+		http.Error(w, "store not initialized", http.StatusServiceUnavailable)
+		return
+	}
+
+	action := strings.TrimPrefix(r.URL.Path, "/api/models/")
+	ctx, cancel := context.WithTimeout(r.Context(), 10*time.Second)
+	defer cancel()
+
+	if action == "shadow" && r.Method == http.MethodDelete {
+		a.models.mu.Lock()
+		summary := a.endShadowLocked(ctx)
+		a.models.mu.Unlock()
+		if summary == nil {
+			http.Error(w, "no shadow evaluation running", http.StatusNotFound)
+			return
+		}
+		w.Header().Set("Content-Type", "application/json")
+		json.NewEncoder(w).Encode(summary)
+		return
+	}
+
+	switch {
+	case action != "activate" && action != "shadow":
+		http.NotFound(w, r)
+		return
+	case r.Method != http.MethodPost:
+		allow := http.MethodPost
+		if action == "shadow" {
+			allow = "POST, DELETE"
+		}
+		w.Header().Set("Allow", allow)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+
+	var payload struct {
+		ID int64 `json:"id"`
+	}
+	if err := json.NewDecoder(r.Body).Decode(&payload); err != nil || payload.ID <= 0 {
+		http.Error(w, "invalid payload", http.StatusBadRequest)
+		return
+	}
+
+	var (
+		m   *roomModel
+		err error
+	)
+	if action == "activate" {
+		m, err = a.activateModel(ctx, payload.ID)
+	} else {
+		m, err = a.startShadow(ctx, payload.ID)
+	}
+	if errors.Is(err, sql.ErrNoRows) {
+		http.Error(w, "unknown model", http.StatusNotFound)
+		return
+	}
+	if err != nil {
+		a.logger.Error("room model "+action+" failed", "id", payload.ID, "error", err)
+		http.Error(w, fmt.Sprintf("failed to %s model", action), http.StatusInternalServerError)
+		return
+	}
+
+	w.Header().Set("Content-Type", "application/json")
+	json.NewEncoder(w).Encode(m.status())
+}
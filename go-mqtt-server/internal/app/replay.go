@@ -0,0 +1,52 @@
+package app
+
+import (
+	"context"
+	"fmt"
+	"os"
+	"path/filepath"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/mqttbroker"
+)
+
+// startCapture opens a new capture file in CaptureDir, named by start time so restarts never
+// overwrite an earlier capture.
+func (a *App) startCapture() (*mqttbroker.CaptureWriter, error) {
+	if err := os.MkdirAll(a.cfg.CaptureDir, 0o755); err != nil {
+		return nil, fmt.Errorf("create capture dir: %w", err)
+	}
+	path := filepath.Join(a.cfg.CaptureDir, "capture-"+time.Now().UTC().Format("20060102T150405Z")+".clcap")
+	capture, err := mqttbroker.CreateCapture(path)
+	if err != nil {
+		return nil, err
+	}
+	a.logger.Info("capturing broker publishes", "path", path)
+	return capture, nil
+}
+
+func (a *App) stopCapture(capture *mqttbroker.CaptureWriter) {
+	if err := capture.Close(); err != nil {
+		a.logger.Error("close capture", "error", err)
+		return
+	}
+	a.logger.Info("broker capture closed", "messages", capture.Count(), "dropped", capture.Dropped())
+}
+
+// Ready is closed once Run has started the broker and the solver workers.
+func (a *App) Ready() <-chan struct{} {
+	return a.ready
+}
+
+// Ingest handles msg exactly as a publish the broker received at receivedAt, without the network
+// hop. Replays pass the captured receive time rebased onto the replay, so dedup keys and the
+// localization window see the captured spacing. It must not be called before Ready is closed.
+func (a *App) Ingest(ctx context.Context, msg mqttbroker.PublishMessage, receivedAt time.Time) {
+	msg.ReceivedAt = receivedAt
+	a.handleMQTTPublish(ctx, msg)
+}
+
+// LocationUpdates returns how many positions the localization engine has computed.
+func (a *App) LocationUpdates() uint64 {
+	return a.locator.Updates()
+}
@@ -0,0 +1,158 @@
+package app
+
+import (
+	"context"
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"strings"
+	"sync"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+	"catlocator/go-mqtt-server/internal/store"
+)
+
+const beaconSitesKey = "beacon_sites"
+
+// siteDirectory maps beacon IDs to the site (building) whose shard stores their readings.
+// It is loaded once from app_config and consulted on every ingest without touching SQLite.
+type siteDirectory struct {
+	mu      sync.RWMutex
+	beacons map[string]string
+}
+
+func (d *siteDirectory) siteFor(beaconID string) string {
+	d.mu.RLock()
+	defer d.mu.RUnlock()
+	if site, ok := d.beacons[beaconID]; ok {
+		return site
+	}
+	return store.DefaultSite
+}
+
+func (d *siteDirectory) snapshot() map[string]string {
+	d.mu.RLock()
+	defer d.mu.RUnlock()
+	out := make(map[string]string, len(d.beacons))
+	for k, v := range d.beacons {
+		out[k] = v
+	}
+	return out
+}
+
+func (a *App) loadSiteDirectory(ctx context.Context) error {
+	persisted, err := a.store.AppConfig(ctx)
+	if err != nil {
+		return fmt.Errorf("load beacon sites: %w", err)
+	}
+
+	beacons := make(map[string]string)
+	if raw := persisted[beaconSitesKey]; raw != "" {
+		if err := json.Unmarshal([]byte(raw), &beacons); err != nil {
+			return fmt.Errorf("decode beacon sites: %w", err)
+		}
+	}
+
+	a.sites.mu.Lock()
+	a.sites.beacons = beacons
+	a.sites.mu.Unlock()
+	return nil
+}
+
+// assignBeaconSite records which site a beacon belongs to. Readings already stored stay in their
+// original shard; new readings are routed to the assigned site.
+func (a *App) assignBeaconSite(ctx context.Context, beaconID, site string) error {
+	site = store.NormalizeSite(site)
+
+	a.sites.mu.Lock()
+	defer a.sites.mu.Unlock()
+
+	next := make(map[string]string, len(a.sites.beacons)+1)
+	for k, v := range a.sites.beacons {
+		next[k] = v
+	}
+	if site == store.DefaultSite {
+		delete(next, beaconID)
+	} else {
+		next[beaconID] = site
+	}
+
+	data, err := json.Marshal(next)
+	if err != nil {
+		return fmt.Errorf("encode beacon sites: %w", err)
+	}
+	if err := a.store.UpsertAppConfig(ctx, beaconSitesKey, string(data)); err != nil {
+		return err
+	}
+	if _, err := a.shards.Site(ctx, site); err != nil {
+		return err
+	}
+
+	a.sites.beacons = next
+	return nil
+}
+
+// handleWriteError is invoked by shard writers when a batch fails to commit. It releases the
+// reading's dedup fingerprint so the scanner's retransmit is accepted.
+func (a *App) handleWriteError(r model.BeaconReading, fingerprint uint64, err error) {
+	if a.dedup != nil {
+		a.dedup.Forget(fingerprint)
+	}
+	if a.recordIngestionError(r.BeaconID, errClassPersist, nil, err) {
+		a.logger.Error("failed to persist beacon reading", "beacon", r.BeaconID, "tag", r.TagID, "error", err)
+	}
+}
+
+func (a *App) handleSites(w http.ResponseWriter, r *http.Request) {
+	if a.shards == nil {
+		http.Error(w, "store not initialized", http.StatusServiceUnavailable)
+		return
+	}
+
+	switch r.Method {
+	case http.MethodGet:
+		type siteInfo struct {
+			Site       string `json:"site"`
+			Path       string `json:"path"`
+			QueueDepth int    `json:"queue_depth"`
+		}
+		var sites []siteInfo
+		for _, shard := range a.shards.All() {
+			sites = append(sites, siteInfo{Site: shard.Site, Path: shard.Path, QueueDepth: shard.Writer.QueueDepth()})
+		}
+
+		w.Header().Set("Content-Type", "application/json")
+		json.NewEncoder(w).Encode(struct {
+			Sites   []siteInfo        `json:"sites"`
+			Beacons map[string]string `json:"beacons"`
+		}{Sites: sites, Beacons: a.sites.snapshot()})
+	case http.MethodPost:
+		var payload struct {
+			BeaconID string `json:"beacon_id"`
+			Site     string `json:"site"`
+		}
+		if err := json.NewDecoder(r.Body).Decode(&payload); err != nil {
+			http.Error(w, "invalid payload", http.StatusBadRequest)
+			return
+		}
+		payload.BeaconID = strings.TrimSpace(payload.BeaconID)
+		if payload.BeaconID == "" {
+			http.Error(w, "beacon_id required", http.StatusBadRequest)
+			return
+		}
+
+		ctx, cancel := context.WithTimeout(r.Context(), 2*time.Second)
+		defer cancel()
+
+		if err := a.assignBeaconSite(ctx, payload.BeaconID, payload.Site); err != nil {
+			a.logger.Error("site assignment failed", "beacon", payload.BeaconID, "site", payload.Site, "error", err)
+			http.Error(w, "failed to assign site", http.StatusInternalServerError)
+			return
+		}
+		w.WriteHeader(http.StatusNoContent)
+	default:
+		w.Header().Set("Allow", "GET, POST")
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+	}
+}
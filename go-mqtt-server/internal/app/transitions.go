@@ -0,0 +1,185 @@
+package app
+
+import (
+	"encoding/json"
+	"net/http"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/localization"
+)
+
+const (
+	// transitionHistoryCap bounds the in-memory room transition history served by the API.
+	transitionHistoryCap = 256
+	// roomTopicPrefix carries each tag's retained current room (…/state) and transition events (…/transition).
+	roomTopicPrefix = "catlocator/rooms/"
+)
+
+// transitionLog is a fixed-size ring of the most recent room transitions across all tags.
+type transitionLog struct {
+	mu    sync.Mutex
+	ring  [transitionHistoryCap]localization.RoomTransition
+	next  int
+	count int
+}
+
+func (l *transitionLog) add(t localization.RoomTransition) {
+	l.mu.Lock()
+	defer l.mu.Unlock()
+	l.ring[l.next] = t
+	l.next = (l.next + 1) % len(l.ring)
+	l.count = min(l.count+1, len(l.ring))
+}
+
+// recent returns up to limit transitions, newest first, optionally for one tag.
+func (l *transitionLog) recent(tagID string, limit int) []localization.RoomTransition {
+	l.mu.Lock()
+	defer l.mu.Unlock()
+	out := make([]localization.RoomTransition, 0, min(limit, l.count))
+	for i := 0; i < l.count && len(out) < limit; i++ {
+		t := l.ring[(l.next-1-i+len(l.ring))%len(l.ring)]
+		if tagID == "" || t.TagID == tagID {
+			out = append(out, t)
+		}
+	}
+	return out
+}
+
+// roomEvent is the transition payload published to MQTT and webhooks.
+type roomEvent struct {
+	Event string `json:"event"`
+	localization.RoomTransition
+}
+
+// roomState is the retained per-tag state Home Assistant's sensor reads.
+type roomState struct {
+	Room        string    `json:"room"`
+	Previous    string    `json:"previous,omitempty"`
+	Probability float64   `json:"probability"`
+	Since       time.Time `json:"since"`
+}
+
+// handleRoomTransition fans a debounced room change out to the history, MQTT and webhooks. It runs
+// on a localization worker, so nothing here waits on a network peer: webhooks and MQTT subscribers
+// each have a bounded queue drained by their own goroutine, and events are dropped when one is full.
+func (a *App) handleRoomTransition(t localization.RoomTransition) {
+	a.transitions.add(t)
+	a.logger.Info("room transition", "tag", t.TagID, "from", t.From, "to", t.To,
+		"probability", t.Probability, "dwell_s", t.DwellS)
+
+	event, err := json.Marshal(roomEvent{Event: "room_transition", RoomTransition: t})
+	if err != nil {
+		a.logger.Warn("room transition encode failed", "tag", t.TagID, "error", err)
+		return
+	}
+	for _, hook := range a.webhooks {
+		hook.enqueue(event)
+	}
+
+	if a.broker == nil {
+		return
+	}
+	a.announceRoomSensor(t.TagID)
+	state, _ := json.Marshal(roomState{Room: t.To, Previous: t.From, Probability: t.Probability, Since: t.At})
+	if err := a.broker.PublishRetained(roomTopicPrefix+t.TagID+"/state", state); err != nil {
+		a.logger.Debug("room state publish failed", "tag", t.TagID, "error", err)
+	}
+	if err := a.broker.Publish(roomTopicPrefix+t.TagID+"/transition", event); err != nil {
+		a.logger.Debug("room transition publish failed", "tag", t.TagID, "error", err)
+	}
+}
+
+// announceRoomSensor publishes, once per tag, a retained Home Assistant MQTT discovery config for a
+// sensor whose state is the tag's current room.
+func (a *App) announceRoomSensor(tagID string) {
+	prefix := a.cfg.HADiscoveryPrefix
+	if prefix == "" {
+		return
+	}
+	if _, seen := a.announced.LoadOrStore(tagID, true); seen {
+		return
+	}
+
+	id := "catlocator_" + haObjectID(tagID)
+	stateTopic := roomTopicPrefix + tagID + "/state"
+	config, _ := json.Marshal(struct {
+		Name                string `json:"name"`
+		UniqueID            string `json:"unique_id"`
+		StateTopic          string `json:"state_topic"`
+		ValueTemplate       string `json:"value_template"`
+		JSONAttributesTopic string `json:"json_attributes_topic"`
+		Icon                string `json:"icon"`
+		Device              struct {
+			Identifiers  []string `json:"identifiers"`
+			Name         string   `json:"name"`
+			Manufacturer string   `json:"manufacturer"`
+			Model        string   `json:"model"`
+		} `json:"device"`
+	}{
+		Name:                "Room",
+		UniqueID:            id + "_room",
+		StateTopic:          stateTopic,
+		ValueTemplate:       "{{ value_json.room }}",
+		JSONAttributesTopic: stateTopic,
+		Icon:                "mdi:cat",
+		Device: struct {
+			Identifiers  []string `json:"identifiers"`
+			Name         string   `json:"name"`
+			Manufacturer string   `json:"manufacturer"`
+			Model        string   `json:"model"`
+		}{[]string{id}, "CatLocator " + tagID, "CatLocator", "Collar tag"},
+	})
+	topic := prefix + "/sensor/" + id + "/room/config"
+	if err := a.broker.PublishRetained(topic, config); err != nil {
+		a.logger.Debug("home assistant discovery publish failed", "tag", tagID, "error", err)
+	}
+}
+
+// haObjectID reduces a tag id to the characters Home Assistant accepts in discovery topics.
+func haObjectID(tagID string) string {
+	return strings.Map(func(r rune) rune {
+		switch {
+		case r >= 'a' && r <= 'z', r >= '0' && r <= '9', r == '_', r == '-':
+			return r
+		case r >= 'A' && r <= 'Z':
+			return r + ('a' - 'A')
+		default:
+			return '_'
+		}
+	}, tagID)
+}
+
+// handleRoomTransitions lists recent room transitions (?tag= filters, ?limit= caps) with learned dwell times.
+func (a *App) handleRoomTransitions(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		w.Header().Set("Allow", http.MethodGet)
+		http.Error(w, "method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+
+	limit := 50
+	if v := r.URL.Query().Get("limit"); v != "" {
+		if parsed, err := strconv.Atoi(v); err == nil {
+			if parsed > 0 && parsed <= transitionHistoryCap {
+				limit = parsed
+			}
+		}
+	}
+
+	hooks := make([]webhookStats, 0, len(a.webhooks))
+	for _, hook := range a.webhooks {
+		hooks = append(hooks, hook.stats())
+	}
+
+	w.Header().Set("Content-Type", "application/json")
+	if err := json.NewEncoder(w).Encode(struct {
+		Transitions []localization.RoomTransition `json:"transitions"`
+		DwellS      map[string]float64            `json:"dwell_s"`
+		Webhooks    []webhookStats                `json:"webhooks"`
+	}{a.transitions.recent(r.URL.Query().Get("tag"), limit), a.locator.RoomDwell(), hooks}); err != nil {
+		a.logger.Error("room transitions encode failed", "error", err)
+	}
+}
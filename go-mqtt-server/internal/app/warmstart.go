@@ -0,0 +1,34 @@
+package app
+
+import (
+	"context"
+	"time"
+)
+
+// warmStartRowLimit caps how many rows are replayed on startup; at typical rates the rolling window
+// holds far fewer, so this only guards against pathological bursts.
+const warmStartRowLimit = 50000
+
+// warmStart rebuilds the in-memory tag windows from the trailing LocationWindow of stored readings.
+// Every site shard is queried in parallel via its received_at index, so restart cost is proportional to the window, not history.
+func (a *App) warmStart(ctx context.Context) {
+	started := time.Now()
+
+	loadCtx, cancel := context.WithTimeout(ctx, 5*time.Second)
+	defer cancel()
+
+	since := started.Add(-a.locator.Tracker().Window())
+	readings, err := a.shards.BeaconReadingsReceivedSince(loadCtx, since, warmStartRowLimit)
+	if err != nil {
+		a.logger.Warn("warm start skipped", "error", err)
+		return
+	}
+
+	a.locator.Tracker().Restore(readings)
+
+	a.logger.Info("warm start complete",
+		"readings", len(readings),
+		"tags", a.locator.Tracker().Tags(),
+		"window", a.locator.Tracker().Window().String(),
+		"duration_ms", time.Since(started).Milliseconds())
+}
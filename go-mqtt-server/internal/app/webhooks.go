@@ -0,0 +1,154 @@
+package app
+
+import (
+	"bytes"
+	"context"
+	"errors"
+	"fmt"
+	"io"
+	"log/slog"
+	"net/http"
+	"net/url"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	// webhookQueueSize bounds pending deliveries per endpoint; when full, new events are dropped
+	// rather than stalling the localization workers that emit them.
+	webhookQueueSize   = 256
+	webhookTimeout     = 5 * time.Second
+	webhookAttempts    = 4
+	webhookBackoffBase = 500 * time.Millisecond
+	// webhookDropWarnInterval rate-limits the queue-full warning per endpoint.
+	webhookDropWarnInterval = time.Minute
+)
+
+// webhook delivers JSON events to one endpoint from its own goroutine, so a slow or failing receiver
+// delays only its own queue.
+type webhook struct {
+	url    string
+	label  string // url without credentials or query, safe to log and report
+	client *http.Client
+	logger *slog.Logger
+	queue  chan []byte
+
+	delivered atomic.Uint64
+	failed    atomic.Uint64
+	dropped   atomic.Uint64
+	retries   atomic.Uint64
+
+	lastDropWarn atomic.Int64 // unix nanos of the last queue-full warning
+}
+
+// webhookStats reports one endpoint's delivery counters.
+type webhookStats struct {
+	URL       string `json:"url"`
+	Queued    int    `json:"queued"`
+	Delivered uint64 `json:"delivered"`
+	Retries   uint64 `json:"retries"`
+	Failed    uint64 `json:"failed"`
+	Dropped   uint64 `json:"dropped"`
+}
+
+func newWebhooks(urls []string, logger *slog.Logger) []*webhook {
+	hooks := make([]*webhook, 0, len(urls))
+	client := &http.Client{Timeout: webhookTimeout}
+	for _, u := range urls {
+		label := u
+		if parsed, err := url.Parse(u); err == nil {
+			label = parsed.Scheme + "://" + parsed.Host + parsed.Path
+		}
+		hooks = append(hooks, &webhook{url: u, label: label, client: client, logger: logger, queue: make(chan []byte, webhookQueueSize)})
+	}
+	return hooks
+}
+
+// enqueue schedules body for delivery without blocking.
+func (h *webhook) enqueue(body []byte) {
+	select {
+	case h.queue <- body:
+	default:
+		dropped := h.dropped.Add(1)
+		now := time.Now().UnixNano()
+		if last := h.lastDropWarn.Load(); now-last >= int64(webhookDropWarnInterval) && h.lastDropWarn.CompareAndSwap(last, now) {
+			h.logger.Warn("webhook queue full, dropping events", "url", h.label, "dropped", dropped)
+		}
+	}
+}
+
+func (h *webhook) run(ctx context.Context) {
+	for {
+		select {
+		case <-ctx.Done():
+			return
+		case body := <-h.queue:
+			h.deliver(ctx, body)
+		}
+	}
+}
+
+// deliver posts body, retrying transport errors, 429 and 5xx responses with exponential backoff.
+func (h *webhook) deliver(ctx context.Context, body []byte) {
+	backoff := webhookBackoffBase
+	for attempt := 1; ; attempt++ {
+		retry, err := h.post(ctx, body)
+		if err == nil {
+			h.delivered.Add(1)
+			return
+		}
+		if !retry || attempt == webhookAttempts || ctx.Err() != nil {
+			h.failed.Add(1)
+			h.logger.Warn("webhook delivery failed", "url", h.label, "attempts", attempt, "error", err)
+			return
+		}
+		h.retries.Add(1)
+		select {
+		case <-ctx.Done():
+			h.failed.Add(1)
+			return
+		case <-time.After(backoff):
+		}
+		backoff *= 2
+	}
+}
+
+func (h *webhook) post(ctx context.Context, body []byte) (retry bool, err error) {
+	req, err := http.NewRequestWithContext(ctx, http.MethodPost, h.url, bytes.NewReader(body))
+	if err != nil {
+		return false, fmt.Errorf("build request: %w", err)
+	}
+	req.Header.Set("Content-Type", "application/json")
+	req.Header.Set("User-Agent", "catlocator-server")
+
+	resp, err := h.client.Do(req)
+	if err != nil {
+		var uerr *url.Error
+		if errors.As(err, &uerr) {
+			err = uerr.Err // drop the URL, which may carry a token
+		}
+		return true, err
+	}
+	io.Copy(io.Discard, io.LimitReader(resp.Body, 64<<10))
+	resp.Body.Close()
+
+	switch {
+	case resp.StatusCode >= 200 && resp.StatusCode < 300:
+		return false, nil
+	case resp.StatusCode == http.StatusTooManyRequests || resp.StatusCode >= 500:
+		return true, fmt.Errorf("status %s", resp.Status)
+	default:
+		return false, fmt.Errorf("status %s", resp.Status)
+	}
+}
+
+func (h *webhook) stats() webhookStats {
+	return webhookStats{
+		URL:       h.label,
+		Queued:    len(h.queue),
+		Delivered: h.delivered.Load(),
+		Retries:   h.retries.Load(),
+		Failed:    h.failed.Load(),
+		Dropped:   h.dropped.Load(),
+	}
+}
@@ -0,0 +1,376 @@
+// Package classifier evaluates room-classification models exported by ml-training/train.py.
+package classifier
+
+import (
+	"encoding/json"
+	"fmt"
+	"io"
+	"math"
+	"os"
+	"sync"
+	"sync/atomic"
+	"time"
+	"unsafe"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// Format is the artifact format written by train.py's export_forest.
+const Format = "catlocator-room-forest/v1"
+
+// Columns the server can supply for each reading; artifacts referencing anything else are rejected.
+var (
+	categoricalColumns = map[string]bool{"beacon_id": true, "tag_id": true}
+	numericColumns     = map[string]bool{"rssi": true, "beacon_x": true, "beacon_y": true, "beacon_z": true, "beacon_xy_mag": true}
+)
+
+// Row is one reading as seen by the model: the same columns the training export provides.
+type Row struct {
+	BeaconID string
+	TagID    string
+	RSSI     float64
+	Beacon   model.Location
+}
+
+// Prediction is the forest's vote over a window of rows.
+type Prediction struct {
+	Room          string
+	Probability   float64
+	Probabilities []float64 // per class, in Classes() order
+	Latency       time.Duration
+}
+
+// Size describes the flattened model.
+type Size struct {
+	Classes  int   `json:"classes"`
+	Features int   `json:"features"`
+	Trees    int   `json:"trees"`
+	Nodes    int   `json:"nodes"`
+	Leaves   int   `json:"leaves"`
+	Bytes    int64 `json:"bytes"`
+}
+
+// Stats are the running inference counters of a loaded forest.
+type Stats struct {
+	Predictions   uint64  `json:"predictions"`
+	MeanLatencyUS float64 `json:"mean_latency_us"`
+	MaxLatencyUS  float64 `json:"max_latency_us"`
+}
+
+// node is one split or leaf. Trees are laid out in depth-first preorder, so the left child of node i
+// is always i+1 and only the right child is stored; a traversal walks forward through one array.
+type node struct {
+	threshold float32 // split in raw (unscaled) feature units
+	feature   int32   // index into the input vector, or -1 for a leaf
+	right     int32   // right child, or for a leaf the offset of its class probabilities
+}
+
+// Forest is an immutable, flattened random forest plus the preprocessing it was trained with.
+// It is safe for concurrent use.
+type Forest struct {
+	classes []string
+	width   int
+
+	beaconSlot map[string]int32 // one-hot slot per known beacon id
+	tagSlot    map[string]int32 // one-hot slot per known tag id
+	numeric    []numericInput
+
+	nodes  []node
+	roots  []int32
+	leaves []float32 // per-leaf class probabilities, len(classes) each
+
+	scratch sync.Pool
+
+	predictions atomic.Uint64
+	totalNanos  atomic.Int64
+	maxNanos    atomic.Int64
+}
+
+type numericInput struct {
+	column string
+	slot   int32
+}
+
+type scratch struct {
+	x     []float32
+	votes []float64
+}
+
+type artifact struct {
+	Format      string   `json:"format"`
+	Classes     []string `json:"classes"`
+	Categorical []struct {
+		Name       string   `json:"name"`
+		Categories []string `json:"categories"`
+	} `json:"categorical"`
+	Numeric []struct {
+		Name  string  `json:"name"`
+		Mean  float64 `json:"mean"`
+		Scale float64 `json:"scale"`
+	} `json:"numeric"`
+	Trees []struct {
+		Left      []int32     `json:"children_left"`
+		Right     []int32     `json:"children_right"`
+		Feature   []int32     `json:"feature"`
+		Threshold []float64   `json:"threshold"`
+		Value     [][]float64 `json:"value"`
+	} `json:"trees"`
+}
+
+// LoadFile reads an exported forest from path.
+func LoadFile(path string) (*Forest, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, fmt.Errorf("open model: %w", err)
+	}
+	defer f.Close()
+	return Load(f)
+}
+
+// Load decodes an exported forest, validates it against the feature schema the server can provide and
+// flattens its trees.
+func Load(r io.Reader) (*Forest, error) {
+	var a artifact
+	if err := json.NewDecoder(r).Decode(&a); err != nil {
+		return nil, fmt.Errorf("decode model: %w", err)
+	}
+	if a.Format != Format {
+		return nil, fmt.Errorf("unsupported model format %q (want %q)", a.Format, Format)
+	}
+	if len(a.Classes) == 0 || len(a.Trees) == 0 {
+		return nil, fmt.Errorf("model has no classes or trees")
+	}
+
+	f := &Forest{
+		classes:    a.Classes,
+		beaconSlot: make(map[string]int32),
+		tagSlot:    make(map[string]int32),
+	}
+
+	// Transformed feature order matches the ColumnTransformer: one-hot blocks, then numeric columns.
+	var scale, mean []float64
+	for _, c := range a.Categorical {
+		if !categoricalColumns[c.Name] {
+			return nil, fmt.Errorf("model uses unsupported categorical feature %q", c.Name)
+		}
+		slots := f.beaconSlot
+		if c.Name == "tag_id" {
+			slots = f.tagSlot
+		}
+		for _, cat := range c.Categories {
+			slots[cat] = int32(f.width)
+			scale = append(scale, 1)
+			mean = append(mean, 0)
+			f.width++
+		}
+	}
+	for _, c := range a.Numeric {
+		if !numericColumns[c.Name] {
+			return nil, fmt.Errorf("model uses unsupported numeric feature %q", c.Name)
+		}
+		s := c.Scale
+		if s == 0 {
+			s = 1 // StandardScaler leaves constant columns unscaled
+		}
+		f.numeric = append(f.numeric, numericInput{column: c.Name, slot: int32(f.width)})
+		scale = append(scale, s)
+		mean = append(mean, c.Mean)
+		f.width++
+	}
+
+	classes := len(a.Classes)
+	for i, t := range a.Trees {
+		n := len(t.Left)
+		if n == 0 || len(t.Right) != n || len(t.Feature) != n || len(t.Threshold) != n || len(t.Value) != n {
+			return nil, fmt.Errorf("tree %d: inconsistent array lengths", i)
+		}
+		root, err := f.flatten(t.Left, t.Right, t.Feature, t.Threshold, t.Value, scale, mean, classes)
+		if err != nil {
+			return nil, fmt.Errorf("tree %d: %w", i, err)
+		}
+		f.roots = append(f.roots, root)
+	}
+
+	f.scratch.New = func() any {
+		return &scratch{x: make([]float32, f.width), votes: make([]float64, classes)}
+	}
+	return f, nil
+}
+
+// flatten appends one sklearn tree in depth-first preorder, folding the scaler into thresholds.
+func (f *Forest) flatten(left, right, feature []int32, threshold []float64, value [][]float64, scale, mean []float64, classes int) (int32, error) {
+	root := int32(len(f.nodes))
+	type frame struct {
+		src    int32
+		parent int32 // node whose right pointer to patch, or -1
+	}
+	stack := []frame{{0, -1}}
+	for len(stack) > 0 {
+		fr := stack[len(stack)-1]
+		stack = stack[:len(stack)-1]
+		src := fr.src
+		if src < 0 || int(src) >= len(left) {
+			return 0, fmt.Errorf("child index %d out of range", src)
+		}
+		if len(f.nodes)-int(root) > len(left) {
+			return 0, fmt.Errorf("tree is not acyclic")
+		}
+		idx := int32(len(f.nodes))
+		if fr.parent >= 0 {
+			f.nodes[fr.parent].right = idx
+		}
+
+		if left[src] < 0 {
+			if len(value[src]) != classes {
+				return 0, fmt.Errorf("leaf %d has %d class values, want %d", src, len(value[src]), classes)
+			}
+			offset := int32(len(f.leaves))
+			for _, p := range value[src] {
+				f.leaves = append(f.leaves, float32(p))
+			}
+			f.nodes = append(f.nodes, node{feature: -1, right: offset})
+			continue
+		}
+
+		feat := feature[src]
+		if feat < 0 || int(feat) >= f.width {
+			return 0, fmt.Errorf("node %d splits on feature %d of %d", src, feat, f.width)
+		}
+		f.nodes = append(f.nodes, node{
+			threshold: float32(threshold[src]*scale[feat] + mean[feat]),
+			feature:   feat,
+		})
+		// Push right first so the left subtree is emitted immediately after its parent.
+		stack = append(stack, frame{right[src], idx}, frame{left[src], -1})
+	}
+	return root, nil
+}
+
+// Classes returns the room labels in model order.
+func (f *Forest) Classes() []string {
+	return f.classes
+}
+
+// Size reports the flattened model footprint.
+func (f *Forest) Size() Size {
+	leaves := len(f.leaves) / len(f.classes)
+	bytes := int64(len(f.nodes))*int64(unsafe.Sizeof(node{})) + int64(len(f.leaves))*4 + int64(len(f.roots))*4
+	return Size{
+		Classes:  len(f.classes),
+		Features: f.width,
+		Trees:    len(f.roots),
+		Nodes:    len(f.nodes),
+		Leaves:   leaves,
+		Bytes:    bytes,
+	}
+}
+
+// Stats reports inference counters since the forest was loaded.
+func (f *Forest) Stats() Stats {
+	n := f.predictions.Load()
+	s := Stats{Predictions: n, MaxLatencyUS: float64(f.maxNanos.Load()) / 1e3}
+	if n > 0 {
+		s.MeanLatencyUS = float64(f.totalNanos.Load()) / float64(n) / 1e3
+	}
+	return s
+}
+
+// Predict averages the forest's class probabilities over every row of a window (one per beacon, as
+// the model was trained on individual readings) and returns the most probable room. Probabilities is
+// written into probs when it has the capacity, so a caller that keeps the buffer predicts without
+// allocating.
+func (f *Forest) Predict(rows []Row, probs []float64) (Prediction, bool) {
+	if len(rows) == 0 {
+		return Prediction{}, false
+	}
+	start := time.Now()
+
+	s := f.scratch.Get().(*scratch)
+	defer f.scratch.Put(s)
+	clear(s.votes)
+
+	classes := len(f.classes)
+	for i := range rows {
+		f.encode(&rows[i], s.x)
+		for _, root := range f.roots {
+			n := root
+			for {
+				nd := &f.nodes[n]
+				if nd.feature < 0 {
+					probs := f.leaves[nd.right : int(nd.right)+classes]
+					for c, p := range probs {
+						s.votes[c] += float64(p)
+					}
+					break
+				}
+				if s.x[nd.feature] <= nd.threshold {
+					n++
+				} else {
+					n = nd.right
+				}
+			}
+		}
+	}
+
+	best := 0
+	var total float64
+	for c, v := range s.votes {
+		total += v
+		if v > s.votes[best] {
+			best = c
+		}
+	}
+	if cap(probs) < classes {
+		probs = make([]float64, classes)
+	}
+	pred := Prediction{Room: f.classes[best], Probabilities: probs[:classes]}
+	clear(pred.Probabilities)
+	if total > 0 {
+		for c, v := range s.votes {
+			pred.Probabilities[c] = v / total
+		}
+		pred.Probability = pred.Probabilities[best]
+	}
+	pred.Latency = time.Since(start)
+	f.record(pred.Latency)
+	return pred, true
+}
+
+// encode writes the model's input vector for one row: one-hot slots for known ids (unknown ids stay
+// all-zero, as with handle_unknown='ignore') followed by the raw numeric columns.
+func (f *Forest) encode(r *Row, x []float32) {
+	clear(x)
+	if slot, ok := f.beaconSlot[r.BeaconID]; ok {
+		x[slot] = 1
+	}
+	if slot, ok := f.tagSlot[r.TagID]; ok {
+		x[slot] = 1
+	}
+	for _, in := range f.numeric {
+		var v float64
+		switch in.column {
+		case "rssi":
+			v = r.RSSI
+		case "beacon_x":
+			v = r.Beacon.X
+		case "beacon_y":
+			v = r.Beacon.Y
+		case "beacon_z":
+			v = r.Beacon.Z
+		case "beacon_xy_mag":
+			v = math.Sqrt(r.Beacon.X*r.Beacon.X + r.Beacon.Y*r.Beacon.Y)
+		}
+		x[in.slot] = float32(v)
+	}
+}
+
+func (f *Forest) record(latency time.Duration) {
+	f.predictions.Add(1)
+	f.totalNanos.Add(int64(latency))
+	for {
+		cur := f.maxNanos.Load()
+		if int64(latency) <= cur || f.maxNanos.CompareAndSwap(cur, int64(latency)) {
+			return
+		}
+	}
+}
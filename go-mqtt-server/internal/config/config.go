@@ -2,35 +2,85 @@ package config
 
 import (
 	"fmt"
+	"net/url"
 	"os"
 	"strconv"
+	"strings"
+	"time"
 )
 
 // Config lists the tunable parameters for the CatLocator server.
 type Config struct {
-	HTTPPort        int
-	MQTTBindAddress string
-	MetricsPort     int
-	DatabasePath    string
-	LogLevel        string
+	HTTPPort         int
+	MQTTBindAddress  string
+	MetricsPort      int
+	DatabasePath     string
+	LogLevel         string
+	BackupDir        string
+	BackupInterval   time.Duration
+	BackupKeep       int
+	DedupWindow      time.Duration
+	LocationWindow   time.Duration
+	LocationDebounce time.Duration
+	CatTagID         string // tag served by /api/location/cat
+	Particles        int
+	RadioMapStep     float64
+
+	ResampleMaxAge   time.Duration // 0 uses LocationWindow
+	ResampleHalfLife time.Duration
+	ResampleMode     string // "hold" or "linear"
+
+	RoomTransitionProbability float64
+	RoomTransitionDwell       time.Duration
+	WebhookURLs               []string
+	HADiscoveryPrefix         string // empty disables Home Assistant discovery
+
+	CaptureDir string // empty disables broker capture
+
+	DebugBind        string        // empty disables the pprof/trace debug listener
+	DebugToken       string        // required with DebugBind
+	ProfileRetention time.Duration // continuous CPU profiling history; 0 disables it
 }
 
 const (
-	defaultHTTPPort        = 8080
-	defaultMQTTBindAddress = ":1883"
-	defaultMetricsPort     = 9090
-	defaultDatabasePath    = "data/catlocator.db"
-	defaultLogLevel        = "info"
+	defaultHTTPPort         = 8080
+	defaultMQTTBindAddress  = ":1883"
+	defaultMetricsPort      = 9090
+	defaultDatabasePath     = "data/catlocator.db"
+	defaultLogLevel         = "info"
+	defaultBackupDir        = "data/backups"
+	defaultBackupInterval   = 24 * time.Hour
+	defaultBackupKeep       = 7
+	defaultDedupWindow      = 2 * time.Minute
+	defaultLocationWindow   = 30 * time.Second
+	defaultLocationDebounce = 25 * time.Millisecond
+	defaultCatTagID         = "cat"
+	defaultResampleHalfLife = 10 * time.Second
+	defaultResampleMode     = "hold"
+	defaultHADiscovery      = "homeassistant"
+	defaultProfileRetention = time.Hour
 )
 
 // Load derives configuration values from environment variables, falling back to defaults.
 func Load() (Config, error) {
 	cfg := Config{
-		HTTPPort:        defaultHTTPPort,
-		MQTTBindAddress: defaultMQTTBindAddress,
-		MetricsPort:     defaultMetricsPort,
-		DatabasePath:    defaultDatabasePath,
-		LogLevel:        defaultLogLevel,
+		HTTPPort:         defaultHTTPPort,
+		MQTTBindAddress:  defaultMQTTBindAddress,
+		MetricsPort:      defaultMetricsPort,
+		DatabasePath:     defaultDatabasePath,
+		LogLevel:         defaultLogLevel,
+		BackupDir:        defaultBackupDir,
+		BackupInterval:   defaultBackupInterval,
+		BackupKeep:       defaultBackupKeep,
+		DedupWindow:      defaultDedupWindow,
+		LocationWindow:   defaultLocationWindow,
+		LocationDebounce: defaultLocationDebounce,
+		CatTagID:         defaultCatTagID,
+		ResampleHalfLife: defaultResampleHalfLife,
+		ResampleMode:     defaultResampleMode,
+
+		HADiscoveryPrefix: defaultHADiscovery,
+		ProfileRetention:  defaultProfileRetention,
 	}
 
 	if v := os.Getenv("CATLOCATOR_HTTP_PORT"); v != "" {
@@ -61,5 +111,160 @@ func Load() (Config, error) {
 		cfg.LogLevel = v
 	}
 
+	if v := os.Getenv("CATLOCATOR_BACKUP_DIR"); v != "" {
+		cfg.BackupDir = v
+	}
+
+	if v := os.Getenv("CATLOCATOR_BACKUP_INTERVAL"); v != "" {
+		interval, err := time.ParseDuration(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_BACKUP_INTERVAL: %w", err)
+		}
+		cfg.BackupInterval = interval
+	}
+
+	if v := os.Getenv("CATLOCATOR_BACKUP_KEEP"); v != "" {
+		keep, err := strconv.Atoi(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_BACKUP_KEEP: %w", err)
+		}
+		cfg.BackupKeep = keep
+	}
+
+	if v := os.Getenv("CATLOCATOR_DEDUP_WINDOW"); v != "" {
+		window, err := time.ParseDuration(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_DEDUP_WINDOW: %w", err)
+		}
+		cfg.DedupWindow = window
+	}
+
+	if v := os.Getenv("CATLOCATOR_LOCATION_WINDOW"); v != "" {
+		window, err := time.ParseDuration(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_LOCATION_WINDOW: %w", err)
+		}
+		cfg.LocationWindow = window
+	}
+
+	if v := os.Getenv("CATLOCATOR_LOCATION_DEBOUNCE"); v != "" {
+		debounce, err := time.ParseDuration(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_LOCATION_DEBOUNCE: %w", err)
+		}
+		cfg.LocationDebounce = debounce
+	}
+
+	if v := os.Getenv("CATLOCATOR_CAT_TAG_ID"); v != "" {
+		cfg.CatTagID = v
+	}
+
+	if v := os.Getenv("CATLOCATOR_PARTICLES"); v != "" {
+		particles, err := strconv.Atoi(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_PARTICLES: %w", err)
+		}
+		cfg.Particles = particles
+	}
+
+	if v := os.Getenv("CATLOCATOR_RADIO_MAP_STEP"); v != "" {
+		step, err := strconv.ParseFloat(v, 64)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_RADIO_MAP_STEP: %w", err)
+		}
+		cfg.RadioMapStep = step
+	}
+
+	if v := os.Getenv("CATLOCATOR_RESAMPLE_MAX_AGE"); v != "" {
+		age, err := time.ParseDuration(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_RESAMPLE_MAX_AGE: %w", err)
+		}
+		cfg.ResampleMaxAge = age
+	}
+
+	if v := os.Getenv("CATLOCATOR_RESAMPLE_HALF_LIFE"); v != "" {
+		halfLife, err := time.ParseDuration(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_RESAMPLE_HALF_LIFE: %w", err)
+		}
+		cfg.ResampleHalfLife = halfLife
+	}
+
+	if v := os.Getenv("CATLOCATOR_RESAMPLE_MODE"); v != "" {
+		mode := strings.ToLower(strings.TrimSpace(v))
+		if mode != "hold" && mode != "linear" {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_RESAMPLE_MODE: %q (want hold or linear)", v)
+		}
+		cfg.ResampleMode = mode
+	}
+
+	if v := os.Getenv("CATLOCATOR_ROOM_TRANSITION_PROBABILITY"); v != "" {
+		p, err := strconv.ParseFloat(v, 64)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_ROOM_TRANSITION_PROBABILITY: %w", err)
+		}
+		if p <= 0 || p >= 1 {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_ROOM_TRANSITION_PROBABILITY: %v not in (0, 1)", p)
+		}
+		cfg.RoomTransitionProbability = p
+	}
+
+	if v := os.Getenv("CATLOCATOR_ROOM_TRANSITION_DWELL"); v != "" {
+		dwell, err := time.ParseDuration(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_ROOM_TRANSITION_DWELL: %w", err)
+		}
+		cfg.RoomTransitionDwell = dwell
+	}
+
+	if v := os.Getenv("CATLOCATOR_WEBHOOK_URLS"); v != "" {
+		for _, raw := range strings.Split(v, ",") {
+			raw = strings.TrimSpace(raw)
+			if raw == "" {
+				continue
+			}
+			u, err := url.Parse(raw)
+			if err != nil {
+				return Config{}, fmt.Errorf("invalid CATLOCATOR_WEBHOOK_URLS: %w", err)
+			}
+			if u.Scheme != "http" && u.Scheme != "https" {
+				return Config{}, fmt.Errorf("invalid CATLOCATOR_WEBHOOK_URLS: %q is not an http(s) URL", raw)
+			}
+			cfg.WebhookURLs = append(cfg.WebhookURLs, raw)
+		}
+	}
+
+	if v, ok := os.LookupEnv("CATLOCATOR_HA_DISCOVERY_PREFIX"); ok {
+		cfg.HADiscoveryPrefix = strings.Trim(strings.TrimSpace(v), "/")
+	}
+
+	if v := os.Getenv("CATLOCATOR_CAPTURE_DIR"); v != "" {
+		cfg.CaptureDir = v
+	}
+
+	if v := os.Getenv("CATLOCATOR_DEBUG_BIND"); v != "" {
+		cfg.DebugBind = v
+	}
+
+	if v := os.Getenv("CATLOCATOR_DEBUG_TOKEN"); v != "" {
+		cfg.DebugToken = v
+	}
+
+	if cfg.DebugBind != "" && cfg.DebugToken == "" {
+		return Config{}, fmt.Errorf("invalid CATLOCATOR_DEBUG_BIND: CATLOCATOR_DEBUG_TOKEN is required")
+	}
+
+	if v := os.Getenv("CATLOCATOR_PROFILE_RETENTION"); v != "" {
+		d, err := time.ParseDuration(v)
+		if err != nil {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_PROFILE_RETENTION: %w", err)
+		}
+		if d < 0 {
+			return Config{}, fmt.Errorf("invalid CATLOCATOR_PROFILE_RETENTION: %v is negative", d)
+		}
+		cfg.ProfileRetention = d
+	}
+
 	return cfg, nil
 }
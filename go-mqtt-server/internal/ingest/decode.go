@@ -0,0 +1,1120 @@
+package ingest
+
+import (
+	"fmt"
+	"strconv"
+	"time"
+	"unicode"
+	"unicode/utf16"
+	"unicode/utf8"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// Decoder parses the reading, inventory and training-command payloads without reflection. It follows
+// encoding/json's rules for these schemas: case-folded keys, escapes, invalid UTF-8 replaced with
+// U+FFFD, null fields, unknown fields and the same nesting limit; cmd/decode-bench -check compares
+// the two on generated documents. Beacon, tag and scanner IDs go through the decoder's Interner,
+// timestamps are parsed in place and SentAt pointers come from a slab, so a firmware reading
+// decodes without allocating.
+//
+// A Decoder reuses its buffers and interner between calls and is not safe for concurrent use; pool
+// them.
+type Decoder struct {
+	intern  *Interner
+	scratch []byte                // unescaped string bytes
+	batch   []model.BeaconReading // returned by Readings, reused by the next call
+	times   []time.Time           // slab backing SentAt pointers
+}
+
+const (
+	maxDecodeDepth = 10000 // nested objects and arrays, encoding/json's limit
+	timeSlabSize   = 256   // SentAt values allocated together
+)
+
+// NewDecoder returns a decoder interning IDs in intern, which it then owns.
+func NewDecoder(intern *Interner) *Decoder {
+	return &Decoder{intern: intern}
+}
+
+// SyntaxError reports a payload the decoder rejected.
+type SyntaxError struct {
+	Offset int
+	msg    string
+}
+
+func (e *SyntaxError) Error() string {
+	return fmt.Sprintf("%s at offset %d", e.msg, e.Offset)
+}
+
+// cursor walks one payload.
+type cursor struct {
+	data  []byte
+	pos   int
+	depth int // open objects and arrays
+}
+
+func (c *cursor) fail(msg string) error {
+	return &SyntaxError{Offset: c.pos, msg: msg}
+}
+
+// enter counts one more open object or array.
+func (c *cursor) enter() error {
+	c.depth++
+	if c.depth > maxDecodeDepth {
+		return c.fail("exceeded max depth")
+	}
+	return nil
+}
+
+func (c *cursor) skipSpace() {
+	for c.pos < len(c.data) {
+		switch c.data[c.pos] {
+		case ' ', '\t', '\r', '\n':
+			c.pos++
+		default:
+			return
+		}
+	}
+}
+
+// peek returns the next non-space byte, or 0 at the end of input.
+func (c *cursor) peek() byte {
+	c.skipSpace()
+	if c.pos < len(c.data) {
+		return c.data[c.pos]
+	}
+	return 0
+}
+
+func (c *cursor) literal(word string) bool {
+	if len(c.data)-c.pos >= len(word) && string(c.data[c.pos:c.pos+len(word)]) == word {
+		c.pos += len(word)
+		return true
+	}
+	return false
+}
+
+// null consumes a JSON null if one is next.
+func (c *cursor) null() bool {
+	return c.peek() == 'n' && c.literal("null")
+}
+
+func (c *cursor) end() error {
+	if c.skipSpace(); c.pos < len(c.data) {
+		return c.fail("invalid character after top-level value")
+	}
+	return nil
+}
+
+// Readings decodes a beacons/<id>/readings payload: one reading object or an array of them. The
+// returned slice is reused by the next call.
+func (d *Decoder) Readings(data []byte) ([]model.BeaconReading, error) {
+	c := cursor{data: data}
+	d.batch = d.batch[:0]
+	if c.peek() != '[' {
+		d.batch = append(d.batch, model.BeaconReading{})
+		if err := d.reading(&c, &d.batch[0]); err != nil {
+			return nil, err
+		}
+		return d.batch, c.end()
+	}
+
+	c.pos++
+	c.depth++
+	if c.peek() == ']' {
+		c.pos++
+		return d.batch, c.end()
+	}
+	for {
+		d.batch = append(d.batch, model.BeaconReading{})
+		if err := d.reading(&c, &d.batch[len(d.batch)-1]); err != nil {
+			return nil, err
+		}
+		switch c.peek() {
+		case ',':
+			c.pos++
+		case ']':
+			c.pos++
+			return d.batch, c.end()
+		default:
+			return nil, c.fail("expected , or ] in reading array")
+		}
+	}
+}
+
+// Reading field keys.
+const (
+	fieldUnknown = iota
+	fieldBeaconID
+	fieldTagID
+	fieldRSSI
+	fieldTimestamp
+	fieldSeq
+	fieldSentAt
+	fieldLocation
+	fieldMetadata
+	fieldX
+	fieldY
+	fieldZ
+	fieldScannerID
+	fieldTagAddress
+	fieldTagName
+	fieldManufacturerID
+	fieldManufacturerData
+	fieldTxPower
+	fieldEventType
+	fieldRoom
+	fieldCommand
+	fieldSource
+)
+
+// fieldOf maps a key to its field. Without an exact match it compares case-folded, as encoding/json
+// does with bytes.EqualFold, so "RSSI" and "ſeq" (long s) match too. The switch on string(key)
+// does not allocate.
+func fieldOf(key []byte) int {
+	switch string(key) {
+	case "beacon_id":
+		return fieldBeaconID
+	case "tag_id":
+		return fieldTagID
+	case "rssi":
+		return fieldRSSI
+	case "timestamp":
+		return fieldTimestamp
+	case "seq":
+		return fieldSeq
+	case "sent_at":
+		return fieldSentAt
+	case "beacon_location":
+		return fieldLocation
+	case "metadata":
+		return fieldMetadata
+	case "x":
+		return fieldX
+	case "y":
+		return fieldY
+	case "z":
+		return fieldZ
+	case "scanner_id":
+		return fieldScannerID
+	case "tag_address":
+		return fieldTagAddress
+	case "tag_name":
+		return fieldTagName
+	case "manufacturer_id":
+		return fieldManufacturerID
+	case "manufacturer_data":
+		return fieldManufacturerData
+	case "tx_power":
+		return fieldTxPower
+	case "event_type":
+		return fieldEventType
+	case "room":
+		return fieldRoom
+	case "command":
+		return fieldCommand
+	case "source":
+		return fieldSource
+	}
+	var lower [32]byte
+	n, folded := 0, false
+	for i := 0; i < len(key); n++ {
+		b := key[i]
+		switch {
+		case b >= utf8.RuneSelf:
+			r, size := utf8.DecodeRune(key[i:])
+			if b = asciiFold(r); b == 0 {
+				return fieldUnknown
+			}
+			i += size
+			folded = true
+		case 'A' <= b && b <= 'Z':
+			b += 'a' - 'A'
+			i++
+			folded = true
+		default:
+			i++
+		}
+		if n == len(lower) {
+			return fieldUnknown
+		}
+		lower[n] = b
+	}
+	if !folded {
+		return fieldUnknown
+	}
+	return fieldOf(lower[:n])
+}
+
+// asciiFold returns the lower-case ASCII letter r is equal to under Unicode simple case folding,
+// or 0 if there is none. Only ſ (s) and the Kelvin sign (k) fold onto ASCII.
+func asciiFold(r rune) byte {
+	for f := unicode.SimpleFold(r); f != r; f = unicode.SimpleFold(f) {
+		if f < utf8.RuneSelf {
+			return byte(f) | ('a' - 'A')
+		}
+	}
+	return 0
+}
+
+// openObject consumes the opening brace of an object. Schema decoders then loop over nextKey with a
+// switch per field rather than taking a callback, so nothing escapes to the heap.
+func (c *cursor) openObject() error {
+	if c.peek() != '{' {
+		return c.fail("expected object")
+	}
+	c.pos++
+	return c.enter()
+}
+
+// nextKey returns the next member's field, or done at the closing brace.
+func (d *Decoder) nextKey(c *cursor, first bool) (field int, done bool, err error) {
+	switch c.peek() {
+	case '}':
+		c.pos++
+		c.depth--
+		return 0, true, nil
+	case ',':
+		if first {
+			return 0, false, c.fail("unexpected , in object")
+		}
+		c.pos++
+		c.skipSpace()
+	default:
+		if !first {
+			return 0, false, c.fail("expected , or } in object")
+		}
+	}
+	key, ok, err := d.stringBytes(c)
+	if err != nil {
+		return 0, false, err
+	}
+	if !ok {
+		return 0, false, c.fail("expected object key")
+	}
+	if c.peek() != ':' {
+		return 0, false, c.fail("expected : after object key")
+	}
+	c.pos++
+	return fieldOf(key), false, nil
+}
+
+func (d *Decoder) reading(c *cursor, r *model.BeaconReading) error {
+	if c.null() {
+		return nil
+	}
+	if err := c.openObject(); err != nil {
+		return err
+	}
+	for first := true; ; first = false {
+		field, done, err := d.nextKey(c, first)
+		if err != nil {
+			return err
+		}
+		if done {
+			return nil
+		}
+		switch field {
+		case fieldBeaconID:
+			err = d.stringTo(c, &r.BeaconID, true)
+		case fieldTagID:
+			err = d.stringTo(c, &r.TagID, true)
+		case fieldRSSI:
+			err = intTo(c, &r.RSSI)
+		case fieldTimestamp:
+			err = d.timeTo(c, &r.Timestamp)
+		case fieldSeq:
+			err = uint32To(c, &r.Sequence)
+		case fieldSentAt:
+			err = d.timePtrTo(c, &r.SentAt)
+		case fieldLocation:
+			err = d.location(c, &r.BeaconLocation)
+		case fieldMetadata:
+			err = d.metadata(c, &r.Metadata)
+		default:
+			err = skipValue(c)
+		}
+		if err != nil {
+			return err
+		}
+	}
+}
+
+func (d *Decoder) location(c *cursor, loc *model.Location) error {
+	if c.null() {
+		return nil
+	}
+	if err := c.openObject(); err != nil {
+		return err
+	}
+	for first := true; ; first = false {
+		field, done, err := d.nextKey(c, first)
+		if err != nil {
+			return err
+		}
+		if done {
+			return nil
+		}
+		switch field {
+		case fieldX:
+			err = floatTo(c, &loc.X)
+		case fieldY:
+			err = floatTo(c, &loc.Y)
+		case fieldZ:
+			err = floatTo(c, &loc.Z)
+		default:
+			err = skipValue(c)
+		}
+		if err != nil {
+			return err
+		}
+	}
+}
+
+// metadata decodes a string map, merging into an existing map as encoding/json does.
+func (d *Decoder) metadata(c *cursor, m *map[string]string) error {
+	if c.null() {
+		*m = nil
+		return nil
+	}
+	if err := c.openObject(); err != nil {
+		return err
+	}
+	if *m == nil {
+		*m = make(map[string]string, 8)
+	}
+	for first := true; ; first = false {
+		switch c.peek() {
+		case '}':
+			c.pos++
+			c.depth--
+			return nil
+		case ',':
+			if first {
+				return c.fail("unexpected , in object")
+			}
+			c.pos++
+			c.skipSpace()
+		default:
+			if !first {
+				return c.fail("expected , or } in object")
+			}
+		}
+		keyBytes, ok, err := d.stringBytes(c)
+		if err != nil {
+			return err
+		}
+		if !ok {
+			return c.fail("expected object key")
+		}
+		key := string(keyBytes)
+		if c.peek() != ':' {
+			return c.fail("expected : after object key")
+		}
+		c.pos++
+		value, ok, err := d.stringBytes(c)
+		if err != nil {
+			return err
+		}
+		if !ok {
+			if !c.null() {
+				return c.fail("metadata values must be strings")
+			}
+			(*m)[key] = ""
+			continue
+		}
+		(*m)[key] = string(value)
+	}
+}
+
+// InventoryPayload is a scanners/<id>/inventory advertisement report.
+type InventoryPayload struct {
+	ScannerID         string
+	TagAddress        string
+	TagName           string
+	RSSI              int
+	ManufacturerID    int
+	HasManufacturerID bool
+	ManufacturerData  string
+	TxPower           int
+	HasTxPower        bool
+	EventType         string
+	Timestamp         time.Time // zero when absent or unparseable
+}
+
+// Inventory decodes a scanner inventory payload into p.
+func (d *Decoder) Inventory(data []byte, p *InventoryPayload) error {
+	c := cursor{data: data}
+	*p = InventoryPayload{}
+	if c.null() {
+		return c.end()
+	}
+	if err := c.openObject(); err != nil {
+		return err
+	}
+	for first := true; ; first = false {
+		field, done, err := d.nextKey(&c, first)
+		if err != nil {
+			return err
+		}
+		if done {
+			return c.end()
+		}
+		switch field {
+		case fieldScannerID:
+			err = d.stringTo(&c, &p.ScannerID, true)
+		case fieldTagAddress:
+			err = d.stringTo(&c, &p.TagAddress, false)
+		case fieldTagName:
+			err = d.stringTo(&c, &p.TagName, false)
+		case fieldRSSI:
+			err = intTo(&c, &p.RSSI)
+		case fieldManufacturerID:
+			if c.null() {
+				p.ManufacturerID, p.HasManufacturerID = 0, false
+				break
+			}
+			err = intTo(&c, &p.ManufacturerID)
+			p.HasManufacturerID = err == nil
+		case fieldManufacturerData:
+			err = d.stringTo(&c, &p.ManufacturerData, false)
+		case fieldTxPower:
+			if c.null() {
+				p.TxPower, p.HasTxPower = 0, false
+				break
+			}
+			err = intTo(&c, &p.TxPower)
+			p.HasTxPower = err == nil
+		case fieldEventType:
+			err = d.stringTo(&c, &p.EventType, false)
+		case fieldTimestamp:
+			err = d.lenientTimeTo(&c, &p.Timestamp)
+		default:
+			err = skipValue(&c)
+		}
+		if err != nil {
+			return err
+		}
+	}
+}
+
+// TrainingPayload is a catlocator/training/commands labeling command.
+type TrainingPayload struct {
+	Room      string
+	Command   string
+	Source    string
+	TagID     string
+	Timestamp time.Time // zero when absent or unparseable
+}
+
+// TrainingCommand decodes a training command payload into p.
+func (d *Decoder) TrainingCommand(data []byte, p *TrainingPayload) error {
+	c := cursor{data: data}
+	*p = TrainingPayload{}
+	if c.null() {
+		return c.end()
+	}
+	if err := c.openObject(); err != nil {
+		return err
+	}
+	for first := true; ; first = false {
+		field, done, err := d.nextKey(&c, first)
+		if err != nil {
+			return err
+		}
+		if done {
+			return c.end()
+		}
+		switch field {
+		case fieldRoom:
+			err = d.stringTo(&c, &p.Room, false)
+		case fieldCommand:
+			err = d.stringTo(&c, &p.Command, false)
+		case fieldSource:
+			err = d.stringTo(&c, &p.Source, false)
+		case fieldTagID:
+			err = d.stringTo(&c, &p.TagID, true)
+		case fieldTimestamp:
+			err = d.lenientTimeTo(&c, &p.Timestamp)
+		default:
+			err = skipValue(&c)
+		}
+		if err != nil {
+			return err
+		}
+	}
+}
+
+// stringBytes reads a string token. The bytes alias the payload, or the decoder's scratch buffer
+// when the string has escapes or invalid UTF-8, and are valid until the next string is read. ok is
+// false, with nothing consumed, when the next token is not a string.
+func (d *Decoder) stringBytes(c *cursor) (s []byte, ok bool, err error) {
+	if c.peek() != '"' {
+		return nil, false, nil
+	}
+	c.pos++
+	start := c.pos
+	for c.pos < len(c.data) {
+		switch b := c.data[c.pos]; {
+		case b == '"':
+			s = c.data[start:c.pos]
+			c.pos++
+			return s, true, nil
+		case b == '\\':
+			return d.unescape(c, start)
+		case b < 0x20:
+			return nil, false, c.fail("control character in string")
+		case b < utf8.RuneSelf:
+			c.pos++
+		default:
+			r, size := utf8.DecodeRune(c.data[c.pos:])
+			if r == utf8.RuneError && size == 1 {
+				return d.unescape(c, start)
+			}
+			c.pos += size
+		}
+	}
+	return nil, false, c.fail("unterminated string")
+}
+
+// unescape finishes a string that contains escapes or invalid UTF-8, copying it into scratch. Each
+// byte that is not part of a valid UTF-8 sequence becomes U+FFFD, as in encoding/json.
+func (d *Decoder) unescape(c *cursor, start int) ([]byte, bool, error) {
+	d.scratch = append(d.scratch[:0], c.data[start:c.pos]...)
+	for c.pos < len(c.data) {
+		b := c.data[c.pos]
+		switch {
+		case b == '"':
+			c.pos++
+			return d.scratch, true, nil
+		case b < 0x20:
+			return nil, false, c.fail("control character in string")
+		case b >= utf8.RuneSelf:
+			r, size := utf8.DecodeRune(c.data[c.pos:])
+			if r == utf8.RuneError && size == 1 {
+				d.scratch = utf8.AppendRune(d.scratch, r)
+			} else {
+				d.scratch = append(d.scratch, c.data[c.pos:c.pos+size]...)
+			}
+			c.pos += size
+			continue
+		case b != '\\':
+			d.scratch = append(d.scratch, b)
+			c.pos++
+			continue
+		}
+		if c.pos+1 >= len(c.data) {
+			break
+		}
+		c.pos += 2
+		switch c.data[c.pos-1] {
+		case '"', '\\', '/':
+			d.scratch = append(d.scratch, c.data[c.pos-1])
+		case 'b':
+			d.scratch = append(d.scratch, '\b')
+		case 'f':
+			d.scratch = append(d.scratch, '\f')
+		case 'n':
+			d.scratch = append(d.scratch, '\n')
+		case 'r':
+			d.scratch = append(d.scratch, '\r')
+		case 't':
+			d.scratch = append(d.scratch, '\t')
+		case 'u':
+			r, ok := hex4(c)
+			if !ok {
+				return nil, false, c.fail("invalid \\u escape")
+			}
+			if utf16.IsSurrogate(r) {
+				// A high surrogate pairs with a following \u low surrogate; anything else is U+FFFD.
+				save := c.pos
+				if c.pos+1 < len(c.data) && c.data[c.pos] == '\\' && c.data[c.pos+1] == 'u' {
+					c.pos += 2
+					if r2, ok := hex4(c); ok {
+						if dec := utf16.DecodeRune(r, r2); dec != utf8.RuneError {
+							d.scratch = utf8.AppendRune(d.scratch, dec)
+							continue
+						}
+					}
+				}
+				c.pos = save
+				r = utf8.RuneError
+			}
+			d.scratch = utf8.AppendRune(d.scratch, r)
+		default:
+			return nil, false, c.fail("invalid escape in string")
+		}
+	}
+	return nil, false, c.fail("unterminated string")
+}
+
+func hex4(c *cursor) (rune, bool) {
+	if len(c.data)-c.pos < 4 {
+		return 0, false
+	}
+	var r rune
+	for _, b := range c.data[c.pos : c.pos+4] {
+		switch {
+		case '0' <= b && b <= '9':
+			b -= '0'
+		case 'a' <= b && b <= 'f':
+			b -= 'a' - 10
+		case 'A' <= b && b <= 'F':
+			b -= 'A' - 10
+		default:
+			return 0, false
+		}
+		r = r<<4 | rune(b)
+	}
+	c.pos += 4
+	return r, true
+}
+
+// stringTo decodes a string (or null, leaving dst unchanged) into dst. IDs are interned; other
+// strings are copied.
+func (d *Decoder) stringTo(c *cursor, dst *string, intern bool) error {
+	s, ok, err := d.stringBytes(c)
+	if err != nil {
+		return err
+	}
+	if !ok {
+		if c.null() {
+			return nil
+		}
+		return c.fail("expected string")
+	}
+	if intern {
+		*dst = d.intern.Bytes(s)
+	} else {
+		*dst = string(s)
+	}
+	return nil
+}
+
+// timeTo decodes an RFC 3339 timestamp as encoding/json decodes time.Time: null leaves dst
+// unchanged, anything else must parse.
+func (d *Decoder) timeTo(c *cursor, dst *time.Time) error {
+	s, ok, err := d.stringBytes(c)
+	if err != nil {
+		return err
+	}
+	if !ok {
+		if c.null() {
+			return nil
+		}
+		return c.fail("expected timestamp string")
+	}
+	t, ok := ParseTimestamp(s)
+	if !ok {
+		return c.fail(fmt.Sprintf("invalid timestamp %q", s))
+	}
+	*dst = t
+	return nil
+}
+
+func (d *Decoder) timePtrTo(c *cursor, dst **time.Time) error {
+	if c.null() {
+		*dst = nil
+		return nil
+	}
+	var t time.Time
+	if err := d.timeTo(c, &t); err != nil {
+		return err
+	}
+	if len(d.times) == cap(d.times) {
+		d.times = make([]time.Time, 0, timeSlabSize)
+	}
+	d.times = append(d.times, t)
+	*dst = &d.times[len(d.times)-1]
+	return nil
+}
+
+// lenientTimeTo decodes a timestamp string, leaving dst zero when it does not parse; inventory and
+// training commands fall back to the receive time rather than rejecting the message.
+func (d *Decoder) lenientTimeTo(c *cursor, dst *time.Time) error {
+	s, ok, err := d.stringBytes(c)
+	if err != nil {
+		return err
+	}
+	if !ok {
+		if c.null() {
+			return nil
+		}
+		return c.fail("expected timestamp string")
+	}
+	*dst, _ = ParseTimestamp(s)
+	return nil
+}
+
+// numberToken returns the bytes of the number at c.
+func numberToken(c *cursor) ([]byte, error) {
+	c.skipSpace()
+	start := c.pos
+	if c.pos < len(c.data) && c.data[c.pos] == '-' {
+		c.pos++
+	}
+	digits := c.pos
+	for c.pos < len(c.data) && '0' <= c.data[c.pos] && c.data[c.pos] <= '9' {
+		c.pos++
+	}
+	if c.pos == digits || (c.data[digits] == '0' && c.pos-digits > 1) {
+		return nil, c.fail("invalid number")
+	}
+	if c.pos < len(c.data) && c.data[c.pos] == '.' {
+		c.pos++
+		frac := c.pos
+		for c.pos < len(c.data) && '0' <= c.data[c.pos] && c.data[c.pos] <= '9' {
+			c.pos++
+		}
+		if c.pos == frac {
+			return nil, c.fail("invalid number")
+		}
+	}
+	if c.pos < len(c.data) && (c.data[c.pos] == 'e' || c.data[c.pos] == 'E') {
+		c.pos++
+		if c.pos < len(c.data) && (c.data[c.pos] == '+' || c.data[c.pos] == '-') {
+			c.pos++
+		}
+		exp := c.pos
+		for c.pos < len(c.data) && '0' <= c.data[c.pos] && c.data[c.pos] <= '9' {
+			c.pos++
+		}
+		if c.pos == exp {
+			return nil, c.fail("invalid number")
+		}
+	}
+	return c.data[start:c.pos], nil
+}
+
+// parseInt parses an integer token; fractions and exponents are rejected, as encoding/json does
+// for integer fields.
+func parseInt(c *cursor, tok []byte, bits int) (int64, error) {
+	neg := tok[0] == '-'
+	if neg {
+		tok = tok[1:]
+	}
+	limit := uint64(1)<<(bits-1) - 1
+	if neg {
+		limit++
+	}
+	var n uint64
+	for _, b := range tok {
+		if b < '0' || b > '9' {
+			return 0, c.fail("number is not an integer")
+		}
+		digit := uint64(b - '0')
+		if n > (limit-digit)/10 {
+			return 0, c.fail("integer out of range")
+		}
+		n = n*10 + digit
+	}
+	if neg {
+		return -int64(n), nil
+	}
+	return int64(n), nil
+}
+
+// intTo decodes an integer (or null, leaving dst unchanged) into dst.
+func intTo(c *cursor, dst *int) error {
+	if c.null() {
+		return nil
+	}
+	tok, err := numberToken(c)
+	if err != nil {
+		return err
+	}
+	n, err := parseInt(c, tok, strconv.IntSize)
+	if err != nil {
+		return err
+	}
+	*dst = int(n)
+	return nil
+}
+
+func uint32To(c *cursor, dst *uint32) error {
+	if c.null() {
+		return nil
+	}
+	tok, err := numberToken(c)
+	if err != nil {
+		return err
+	}
+	if tok[0] == '-' {
+		return c.fail("integer out of range")
+	}
+	n, err := parseInt(c, tok, 33)
+	if err != nil {
+		return err
+	}
+	*dst = uint32(n)
+	return nil
+}
+
+// float64pow10 holds the powers of ten float64 represents exactly.
+var float64pow10 = [...]float64{1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22}
+
+// floatTo decodes a number (or null, leaving dst unchanged) into dst. Plain decimals with at most 15
+// significant digits, which covers every coordinate the scanners send, take the exact fast path:
+// an integer mantissa below 2^53 divided by an exactly representable power of ten rounds correctly.
+func floatTo(c *cursor, dst *float64) error {
+	if c.null() {
+		return nil
+	}
+	tok, err := numberToken(c)
+	if err != nil {
+		return err
+	}
+	var mantissa uint64
+	digits, scale := 0, -1
+	neg := tok[0] == '-'
+	i := 0
+	if neg {
+		i = 1
+	}
+	for ; i < len(tok); i++ {
+		b := tok[i]
+		if b == '.' {
+			scale = 0
+			continue
+		}
+		if b < '0' || b > '9' || digits >= 15 {
+			scale = -2 // exponent or too many digits
+			break
+		}
+		mantissa = mantissa*10 + uint64(b-'0')
+		if mantissa != 0 {
+			digits++
+		}
+		if scale >= 0 {
+			scale++
+		}
+	}
+	if scale != -2 && scale < len(float64pow10) {
+		f := float64(mantissa)
+		if scale > 0 {
+			f /= float64pow10[scale]
+		}
+		if neg {
+			f = -f
+		}
+		*dst = f
+		return nil
+	}
+	f, err := strconv.ParseFloat(string(tok), 64)
+	if err != nil {
+		return c.fail("number out of range")
+	}
+	*dst = f
+	return nil
+}
+
+// skipValue consumes any JSON value.
+func skipValue(c *cursor) error {
+	switch c.peek() {
+	case '"':
+		return skipString(c)
+	case '{', '[':
+		open := c.data[c.pos]
+		closing := byte('}')
+		if open == '[' {
+			closing = ']'
+		}
+		c.pos++
+		if err := c.enter(); err != nil {
+			return err
+		}
+		if c.peek() == closing {
+			c.pos++
+			c.depth--
+			return nil
+		}
+		for {
+			if open == '{' {
+				if c.peek() != '"' {
+					return c.fail("expected object key")
+				}
+				if err := skipValue(c); err != nil {
+					return err
+				}
+				if c.peek() != ':' {
+					return c.fail("expected : after object key")
+				}
+				c.pos++
+			}
+			if err := skipValue(c); err != nil {
+				return err
+			}
+			switch c.peek() {
+			case ',':
+				c.pos++
+			case closing:
+				c.pos++
+				c.depth--
+				return nil
+			default:
+				return c.fail("expected , or closing bracket")
+			}
+		}
+	case 't':
+		if c.literal("true") {
+			return nil
+		}
+	case 'f':
+		if c.literal("false") {
+			return nil
+		}
+	case 'n':
+		if c.literal("null") {
+			return nil
+		}
+	default:
+		_, err := numberToken(c)
+		return err
+	}
+	return c.fail("invalid literal")
+}
+
+// skipString consumes a string, checking its escapes without decoding them.
+func skipString(c *cursor) error {
+	c.pos++
+	for c.pos < len(c.data) {
+		switch b := c.data[c.pos]; {
+		case b == '"':
+			c.pos++
+			return nil
+		case b < 0x20:
+			return c.fail("control character in string")
+		case b != '\\':
+			c.pos++
+			continue
+		}
+		if c.pos+1 >= len(c.data) {
+			break
+		}
+		c.pos += 2
+		switch c.data[c.pos-1] {
+		case '"', '\\', '/', 'b', 'f', 'n', 'r', 't':
+		case 'u':
+			if _, ok := hex4(c); !ok {
+				return c.fail("invalid \\u escape")
+			}
+		default:
+			return c.fail("invalid escape in string")
+		}
+	}
+	return c.fail("unterminated string")
+}
+
+// ParseTimestamp parses an RFC 3339 timestamp without allocating. Offsets are applied and the
+// result is in UTC; it names the same instant encoding/json would decode. Forms outside the common
+// layout fall back to time.Parse.
+func ParseTimestamp(b []byte) (time.Time, bool) {
+	if t, ok := parseRFC3339(b); ok {
+		return t, true
+	}
+	t, err := time.Parse(time.RFC3339Nano, string(b))
+	if err != nil {
+		return time.Time{}, false
+	}
+	return t.UTC(), true
+}
+
+// parseRFC3339 handles YYYY-MM-DDTHH:MM:SS[.fraction](Z|±HH:MM).
+func parseRFC3339(b []byte) (time.Time, bool) {
+	if len(b) < len("2006-01-02T15:04:05Z") || b[4] != '-' || b[7] != '-' || b[10] != 'T' || b[13] != ':' || b[16] != ':' {
+		return time.Time{}, false
+	}
+	year, ok1 := digitsAt(b, 0, 4)
+	month, ok2 := digitsAt(b, 5, 2)
+	day, ok3 := digitsAt(b, 8, 2)
+	hour, ok4 := digitsAt(b, 11, 2)
+	minute, ok5 := digitsAt(b, 14, 2)
+	second, ok6 := digitsAt(b, 17, 2)
+	if !(ok1 && ok2 && ok3 && ok4 && ok5 && ok6) || month < 1 || month > 12 || day < 1 || hour > 23 || minute > 59 || second > 59 {
+		return time.Time{}, false
+	}
+
+	rest := b[19:]
+	nanos := 0
+	if rest[0] == '.' {
+		i := 1
+		for ; i < len(rest) && '0' <= rest[i] && rest[i] <= '9'; i++ {
+			if i <= 9 {
+				nanos = nanos*10 + int(rest[i]-'0')
+			}
+		}
+		if i == 1 {
+			return time.Time{}, false
+		}
+		for n := i - 1; n < 9; n++ {
+			nanos *= 10
+		}
+		rest = rest[i:]
+	}
+
+	offset := 0
+	switch {
+	case len(rest) == 1 && rest[0] == 'Z':
+	case len(rest) == 6 && (rest[0] == '+' || rest[0] == '-') && rest[3] == ':':
+		oh, ok1 := digitsAt(rest, 1, 2)
+		om, ok2 := digitsAt(rest, 4, 2)
+		if !ok1 || !ok2 || oh > 23 || om > 59 {
+			return time.Time{}, false
+		}
+		offset = (oh*60 + om) * 60
+		if rest[0] == '-' {
+			offset = -offset
+		}
+	default:
+		return time.Time{}, false
+	}
+
+	t := time.Date(year, time.Month(month), day, hour, minute, second, nanos, time.UTC)
+	if t.Day() != day {
+		return time.Time{}, false // e.g. February 30th
+	}
+	return t.Add(-time.Duration(offset) * time.Second), true
+}
+
+func digitsAt(b []byte, at, n int) (int, bool) {
+	v := 0
+	for _, c := range b[at : at+n] {
+		if c < '0' || c > '9' {
+			return 0, false
+		}
+		v = v*10 + int(c-'0')
+	}
+	return v, true
+}
+
+// Interner deduplicates the IDs that repeat on every message (beacon, tag and scanner IDs), so
+// decoding them allocates only the first time. It keeps two generations of up to size strings each:
+// when the current one fills it becomes the previous one and the old previous one is dropped. IDs
+// still in use are carried forward on their next lookup, so stale ones age out instead of filling
+// the table for good. An Interner belongs to one Decoder and is not safe for concurrent use.
+type Interner struct {
+	cur, prev map[string]string
+	size      int
+}
+
+// NewInterner returns an interner whose generations hold up to size strings.
+func NewInterner(size int) *Interner {
+	return &Interner{cur: make(map[string]string, size), size: size}
+}
+
+// Bytes returns b as a string, shared with earlier calls for the same bytes.
+func (in *Interner) Bytes(b []byte) string {
+	if s, ok := in.cur[string(b)]; ok {
+		return s
+	}
+	s, ok := in.prev[string(b)]
+	if !ok {
+		s = string(b)
+	}
+	if len(in.cur) >= in.size {
+		in.prev, in.cur = in.cur, make(map[string]string, in.size)
+	}
+	in.cur[s] = s
+	return s
+}
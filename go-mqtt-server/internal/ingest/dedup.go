@@ -0,0 +1,150 @@
+// Package ingest holds the hot-path helpers that sit between the MQTT broker and the store.
+package ingest
+
+import (
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// Deduplicator drops readings already seen within a sliding time window.
+//
+// Each reading is reduced to a 64-bit Fingerprint of (beacon, tag, timestamp, rssi, seq). Fingerprints
+// live in two generations of hash sets; the older generation is discarded every half window, so
+// memory is bounded by the message rate over one window and lookups stay O(1).
+type Deduplicator struct {
+	mu       sync.Mutex
+	current  map[uint64]struct{}
+	previous map[uint64]struct{}
+	rotated  time.Time
+	half     time.Duration
+
+	checked    atomic.Uint64
+	duplicates atomic.Uint64
+}
+
+// DedupStats reports dedup counters.
+type DedupStats struct {
+	Window     string `json:"window"`
+	Checked    uint64 `json:"checked"`
+	Duplicates uint64 `json:"duplicates"`
+	Tracked    int    `json:"tracked"`
+}
+
+// NewDeduplicator constructs a deduplicator remembering fingerprints for at least window.
+func NewDeduplicator(window time.Duration) *Deduplicator {
+	if window <= 0 {
+		window = 2 * time.Minute
+	}
+	return &Deduplicator{
+		current:  make(map[uint64]struct{}),
+		previous: make(map[uint64]struct{}),
+		rotated:  time.Now(),
+		half:     window / 2,
+	}
+}
+
+// Seen records a reading's fingerprint and reports whether it was already recorded within the
+// window. A reading that is then not persisted must be released with Forget so its retransmit is
+// accepted.
+func (d *Deduplicator) Seen(fp uint64) bool {
+	now := time.Now()
+
+	d.checked.Add(1)
+
+	d.mu.Lock()
+	defer d.mu.Unlock()
+
+	if now.Sub(d.rotated) >= d.half {
+		// Reuse the expired generation's buckets instead of reallocating.
+		for k := range d.previous {
+			delete(d.previous, k)
+		}
+		d.previous, d.current = d.current, d.previous
+		d.rotated = now
+	}
+
+	if _, ok := d.current[fp]; ok {
+		d.duplicates.Add(1)
+		return true
+	}
+	if _, ok := d.previous[fp]; ok {
+		d.duplicates.Add(1)
+		d.current[fp] = struct{}{}
+		return true
+	}
+
+	d.current[fp] = struct{}{}
+	return false
+}
+
+// Forget removes a fingerprint recorded by Seen.
+func (d *Deduplicator) Forget(fp uint64) {
+	d.mu.Lock()
+	delete(d.current, fp)
+	delete(d.previous, fp)
+	d.mu.Unlock()
+}
+
+// Stats returns a snapshot of dedup counters.
+func (d *Deduplicator) Stats() DedupStats {
+	d.mu.Lock()
+	tracked := len(d.current) + len(d.previous)
+	d.mu.Unlock()
+
+	return DedupStats{
+		Window:     (2 * d.half).String(),
+		Checked:    d.checked.Load(),
+		Duplicates: d.duplicates.Load(),
+		Tracked:    tracked,
+	}
+}
+
+const (
+	fnvOffset64 = 14695981039346656037
+	fnvPrime64  = 1099511628211
+)
+
+// Fingerprint hashes the identifying fields of a reading with FNV-1a without allocating. A reading
+// with neither a timestamp nor a seq has nothing that tells a retransmit from a new reading with the
+// same RSSI, so its receive time (Trace.Received) stands in for the timestamp.
+func Fingerprint(r *model.BeaconReading) uint64 {
+	at := r.Timestamp
+	if at.IsZero() && r.Sequence == 0 {
+		at = r.Trace.Received
+	}
+	h := uint64(fnvOffset64)
+	h = fnvString(h, r.BeaconID)
+	h = fnvByte(h, 0)
+	h = fnvString(h, r.TagID)
+	h = fnvByte(h, 0)
+	h = fnvUint64(h, uint64(at.UnixNano()))
+	h = fnvUint64(h, uint64(int64(r.RSSI)))
+	h = fnvUint64(h, uint64(r.Sequence))
+	return h
+}
+
+func fnvString(h uint64, s string) uint64 {
+	for i := 0; i < len(s); i++ {
+		h ^= uint64(s[i])
+		h *= fnvPrime64
+	}
+	return h
+}
+
+func fnvByte(h uint64, b byte) uint64 {
+	h ^= uint64(b)
+	h *= fnvPrime64
+	return h
+}
+
+func fnvUint64(h uint64, v uint64) uint64 {
+	for i := 0; i < 8; i++ {
+		h ^= v & 0xFF
+		h *= fnvPrime64
+		v >>= 8
+	}
+	return h
+}
@@ -0,0 +1,303 @@
+package ingest
+
+import (
+	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/metrics"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// Stage is one hop of a reading's path from scanner capture to an available position.
+type Stage int
+
+const (
+	StageQueue    Stage = iota // scanner capture to MQTT publish (sent_at - timestamp), scanner clock only
+	StageNetwork               // publish to broker receive; needs synced clocks
+	StageDecode                // broker receive to parsed and validated
+	StageStore                 // parsed to committed in SQLite
+	StageLocate                // parsed to a position covering the reading
+	StageEndToEnd              // scanner capture to a position covering the reading; needs synced clocks
+	stageCount
+)
+
+var stageNames = [stageCount]string{"queue", "network", "decode", "store", "locate", "end_to_end"}
+
+func (s Stage) String() string {
+	return stageNames[s]
+}
+
+// Stages lists every stage in pipeline order.
+func Stages() []Stage {
+	out := make([]Stage, stageCount)
+	for i := range out {
+		out[i] = Stage(i)
+	}
+	return out
+}
+
+const (
+	// clockValidAfter rejects capture stamps from a scanner whose clock SNTP has not set yet.
+	clockValidAfter = 1577836800 // 2020-01-01T00:00:00Z
+	// maxPendingPerTag bounds readings waiting for a position; the oldest is overwritten beyond it.
+	maxPendingPerTag = 1024
+	// pendingStripes is the number of lock stripes pending readings are spread across by tag.
+	pendingStripes = 16
+)
+
+// LatencyTracker aggregates per-scanner, per-stage latency histograms. Recording is atomic adds on
+// pre-bucketed histograms behind a read-locked map lookup, so it adds no measurable ingest cost.
+//
+// Readings waiting for a position are striped by tag hash, like the localization tracker, so ingest
+// and solves for different tags rarely share a lock. They expire after the localization window,
+// when the engine no longer uses them, so tags that never solve or stop being heard do not keep
+// entries.
+type LatencyTracker struct {
+	mu       sync.RWMutex
+	scanners map[string]*scannerLatency
+
+	window  time.Duration
+	pending [pendingStripes]pendingStripe
+}
+
+// pendingStripe is one lock stripe of the pending readings.
+type pendingStripe struct {
+	mu    sync.Mutex
+	tags  map[string]*pendingRing
+	swept time.Time // last expiry pass over the stripe's tags
+}
+
+type scannerLatency struct {
+	stages    [stageCount]metrics.Histogram
+	readings  atomic.Uint64
+	lastHeard atomic.Int64  // Unix nanos of the newest reading
+	unsynced  atomic.Uint64 // capture stamp missing or before the clock was set
+	skewed    atomic.Uint64 // a clock-dependent stage came out negative
+}
+
+// pendingReading is a reading observed by the localization engine and not yet covered by a solve.
+type pendingReading struct {
+	scanner  *scannerLatency
+	captured time.Time // zero when the scanner clock is not trusted
+	decoded  time.Time
+	observed time.Time
+}
+
+// pendingRing holds one tag's pending readings in observe order. It grows up to maxPendingPerTag
+// and then overwrites its oldest entry.
+type pendingRing struct {
+	buf  []pendingReading
+	head int // oldest entry
+	n    int
+}
+
+func (q *pendingRing) oldest() *pendingReading {
+	return &q.buf[q.head]
+}
+
+func (q *pendingRing) push(p pendingReading) {
+	if q.n == len(q.buf) {
+		if len(q.buf) == maxPendingPerTag {
+			q.buf[q.head] = p
+			q.head = (q.head + 1) % len(q.buf)
+			return
+		}
+		grown := make([]pendingReading, min(max(8, 2*len(q.buf)), maxPendingPerTag))
+		for i := 0; i < q.n; i++ {
+			grown[i] = q.buf[(q.head+i)%len(q.buf)]
+		}
+		q.buf, q.head = grown, 0
+	}
+	q.buf[(q.head+q.n)%len(q.buf)] = p
+	q.n++
+}
+
+func (q *pendingRing) pop() {
+	q.buf[q.head] = pendingReading{}
+	q.head = (q.head + 1) % len(q.buf)
+	q.n--
+}
+
+// expire drops readings observed before cutoff.
+func (q *pendingRing) expire(cutoff time.Time) {
+	for q.n > 0 && q.oldest().observed.Before(cutoff) {
+		q.pop()
+	}
+}
+
+// NewLatencyTracker returns an empty tracker whose pending readings expire after window.
+func NewLatencyTracker(window time.Duration) *LatencyTracker {
+	if window <= 0 {
+		window = 30 * time.Second
+	}
+	t := &LatencyTracker{
+		scanners: make(map[string]*scannerLatency),
+		window:   window,
+	}
+	now := time.Now()
+	for i := range t.pending {
+		t.pending[i].tags = make(map[string]*pendingRing)
+		t.pending[i].swept = now
+	}
+	return t
+}
+
+// stripe returns the pending stripe owning tagID.
+func (t *LatencyTracker) stripe(tagID string) *pendingStripe {
+	return &t.pending[fnvString(fnvOffset64, tagID)%pendingStripes]
+}
+
+func (t *LatencyTracker) scanner(id string) *scannerLatency {
+	t.mu.RLock()
+	s, ok := t.scanners[id]
+	t.mu.RUnlock()
+	if ok {
+		return s
+	}
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	if s, ok = t.scanners[id]; !ok {
+		s = &scannerLatency{}
+		t.scanners[id] = s
+	}
+	return s
+}
+
+// Decoded records the scanner and decode stages of a parsed reading and sets r.Trace.Captured when
+// the scanner's clock can be trusted. Call it before the server defaults a missing timestamp, with
+// r.Trace.Received and Decoded filled in.
+func (t *LatencyTracker) Decoded(r *model.BeaconReading) {
+	s := t.scanner(r.BeaconID)
+	s.readings.Add(1)
+	s.lastHeard.Store(r.Trace.Decoded.UnixNano())
+	if !r.Trace.Received.IsZero() {
+		s.stages[StageDecode].Observe(r.Trace.Decoded.Sub(r.Trace.Received))
+	}
+	if !trusted(r.Timestamp) {
+		s.unsynced.Add(1)
+		return
+	}
+	r.Trace.Captured = r.Timestamp
+	if r.SentAt != nil && trusted(*r.SentAt) {
+		s.observe(StageQueue, r.SentAt.Sub(r.Timestamp))
+		if !r.Trace.Received.IsZero() {
+			s.observe(StageNetwork, r.Trace.Received.Sub(*r.SentAt))
+		}
+	}
+}
+
+// Committed records the store stage for a batch the writer committed at at.
+func (t *LatencyTracker) Committed(batch []model.BeaconReading, at time.Time) {
+	for i := range batch {
+		if r := &batch[i]; !r.Trace.Decoded.IsZero() {
+			t.scanner(r.BeaconID).stages[StageStore].Observe(at.Sub(r.Trace.Decoded))
+		}
+	}
+}
+
+// Observed notes that the engine took r into its window at observed; the next position for the tag
+// computed at or after observed covers it.
+func (t *LatencyTracker) Observed(r *model.BeaconReading, observed time.Time) {
+	p := pendingReading{
+		scanner:  t.scanner(r.BeaconID),
+		captured: r.Trace.Captured,
+		decoded:  r.Trace.Decoded,
+		observed: observed,
+	}
+	st := t.stripe(r.TagID)
+	st.mu.Lock()
+	if observed.Sub(st.swept) >= t.window {
+		st.expireLocked(observed.Add(-t.window))
+		st.swept = observed
+	}
+	queue, ok := st.tags[r.TagID]
+	if !ok {
+		queue = &pendingRing{}
+		st.tags[r.TagID] = queue
+	}
+	queue.push(p)
+	st.mu.Unlock()
+}
+
+// expireLocked drops the stripe's pending readings observed before cutoff, and tags left empty.
+// Observed runs it once per window.
+func (st *pendingStripe) expireLocked(cutoff time.Time) {
+	for tagID, queue := range st.tags {
+		if queue.expire(cutoff); queue.n == 0 {
+			delete(st.tags, tagID)
+		}
+	}
+}
+
+// Located records the locate and end-to-end stages for every pending reading of tagID that the
+// position solved at solvedAt covers; the position became available at at.
+func (t *LatencyTracker) Located(tagID string, solvedAt, at time.Time) {
+	st := t.stripe(tagID)
+	st.mu.Lock()
+	defer st.mu.Unlock()
+	queue, ok := st.tags[tagID]
+	if !ok {
+		return
+	}
+	// Recording is atomic histogram adds, cheap enough to do under the stripe lock.
+	for queue.n > 0 && !queue.oldest().observed.After(solvedAt) {
+		p := queue.oldest()
+		if !p.decoded.IsZero() {
+			p.scanner.stages[StageLocate].Observe(at.Sub(p.decoded))
+		}
+		if !p.captured.IsZero() {
+			p.scanner.observe(StageEndToEnd, at.Sub(p.captured))
+		}
+		queue.pop()
+	}
+	if queue.n == 0 {
+		delete(st.tags, tagID)
+	}
+}
+
+// observe records a clock-dependent stage, counting negative results as skew instead.
+func (s *scannerLatency) observe(stage Stage, d time.Duration) {
+	if d < 0 {
+		s.skewed.Add(1)
+		return
+	}
+	s.stages[stage].Observe(d)
+}
+
+func trusted(t time.Time) bool {
+	return t.Unix() >= clockValidAfter
+}
+
+// ScannerLatency is one scanner's latency histograms.
+type ScannerLatency struct {
+	Scanner   string
+	Readings  uint64
+	LastHeard time.Time
+	Unsynced  uint64
+	Skewed    uint64
+	Stages    [stageCount]metrics.HistogramSnapshot
+}
+
+// Snapshot returns every scanner's histograms ordered by scanner ID.
+func (t *LatencyTracker) Snapshot() []ScannerLatency {
+	t.mu.RLock()
+	out := make([]ScannerLatency, 0, len(t.scanners))
+	for id, s := range t.scanners {
+		entry := ScannerLatency{
+			Scanner:   id,
+			Readings:  s.readings.Load(),
+			LastHeard: time.Unix(0, s.lastHeard.Load()),
+			Unsynced:  s.unsynced.Load(),
+			Skewed:    s.skewed.Load(),
+		}
+		for i := range s.stages {
+			entry.Stages[i] = s.stages[i].Snapshot()
+		}
+		out = append(out, entry)
+	}
+	t.mu.RUnlock()
+	sort.Slice(out, func(i, j int) bool { return out[i].Scanner < out[j].Scanner })
+	return out
+}
@@ -0,0 +1,481 @@
+package localization
+
+import (
+	"context"
+	"math"
+	"sort"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/metrics"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// Position is the latest localization result for a tag.
+type Position struct {
+	TagID       string            `json:"tag_id"`
+	Location    model.Location    `json:"location"`
+	Confidence  float64           `json:"confidence"`
+	Residual    float64           `json:"residual"`
+	Uncertainty float64           `json:"uncertainty"`
+	BeaconCount int               `json:"beacons"`
+	Outliers    int               `json:"outliers"`
+	Iterations  int               `json:"iterations"`
+	Message     string            `json:"message"`
+	Valid       bool              `json:"valid"`
+	Filtered    bool              `json:"filtered"`
+	Raw         *model.Location   `json:"raw,omitempty"`         // snapshot solve when Location is filtered
+	Velocity    *model.Location   `json:"velocity,omitempty"`    // m/s, particle filter only
+	Fingerprint *FingerprintMatch `json:"fingerprint,omitempty"` // RSSI fingerprint kNN, when trained
+	Prediction  *RoomPrediction   `json:"prediction,omitempty"`  // room classifier, when a model is active
+	Room        *RoomState        `json:"room,omitempty"`        // HMM-smoothed room (classifier, else geometry)
+	Rooms       []RoomMatch       `json:"rooms"`
+	UpdatedAt   time.Time         `json:"updated_at"`
+	Stale       bool              `json:"stale,omitempty"` // not recomputed within the location window
+}
+
+// RoomPrediction is a room classifier's answer for a tag's current window.
+type RoomPrediction struct {
+	Room        string  `json:"room"`
+	Probability float64 `json:"probability"`
+	Model       string  `json:"model"` // model version
+	LatencyUS   float64 `json:"latency_us"`
+
+	// Full distribution for the room smoother; Classes is shared with the model and must not be modified.
+	Classes       []string  `json:"-"`
+	Probabilities []float64 `json:"-"`
+}
+
+// RoomClassifier predicts a tag's room from its per-beacon window means. Implementations are called
+// concurrently from every shard worker; probs is the worker's buffer for Probabilities, which stays
+// valid only until the worker's next call.
+type RoomClassifier interface {
+	Classify(tagID string, window []Observation, probs []float64) (RoomPrediction, bool)
+}
+
+// PositionHandler receives each freshly computed position (e.g. to publish it over MQTT).
+type PositionHandler func(Position)
+
+// Engine turns the ingest stream into per-tag positions. Each reading updates the tag's rolling
+// window and schedules a debounced recompute, so bursts from several scanners collapse into one solve.
+// Results are cached on the tag state so API reads are O(1). Each tracker shard has its own worker,
+// so a tag is always solved by the same goroutine and tags on different shards solve in parallel.
+type Engine struct {
+	tracker   *Tracker
+	debounce  time.Duration
+	particles int
+	radio     *RadioMap
+	policy    TransitionPolicy
+	resample  ResampleConfig
+	work      [tagShardCount]chan *TagState
+
+	rooms    atomic.Pointer[RoomIndex]
+	pathLoss atomic.Pointer[pathLossTable]
+	prints   atomic.Pointer[FingerprintIndex]
+	classify atomic.Pointer[RoomClassifier]
+	onUpdate atomic.Pointer[PositionHandler]
+	onMove   atomic.Pointer[TransitionHandler]
+	smoother roomModels
+
+	updates   atomic.Uint64
+	solveTime metrics.Histogram
+	stopped   atomic.Bool // set once Start's context is cancelled; ends enqueue retries
+}
+
+// NewEngine constructs an engine over tracker. Call Start to launch the solver workers.
+func NewEngine(tracker *Tracker, debounce time.Duration) *Engine {
+	if debounce < 0 {
+		debounce = 0
+	}
+	e := &Engine{
+		tracker:  tracker,
+		debounce: debounce,
+		policy:   TransitionPolicy{MinProbability: DefaultTransitionProbability, MinDwell: DefaultTransitionDwell},
+		resample: ResampleConfig{MaxAge: tracker.window},
+	}
+	for i := range e.work {
+		e.work[i] = make(chan *TagState, 64)
+	}
+	e.rooms.Store(NewRoomIndex(nil))
+	e.pathLoss.Store(newPathLossTable(model.PathLossCalibration{}))
+	return e
+}
+
+// Tracker exposes the underlying rolling-window state.
+func (e *Engine) Tracker() *Tracker {
+	return e.tracker
+}
+
+// SetRooms replaces the room definitions used to annotate positions and rebuilds the room index.
+func (e *Engine) SetRooms(rooms []model.RoomDefinition) {
+	index := NewRoomIndex(rooms)
+	e.rooms.Store(index)
+	if e.radio != nil {
+		e.radio.SetRooms(index.Rooms())
+	}
+	e.smoother.setRooms(index.Rooms())
+}
+
+// Rooms returns the room definitions currently in use.
+func (e *Engine) Rooms() []model.RoomDefinition {
+	return e.rooms.Load().Rooms()
+}
+
+// SetCalibration swaps in a path-loss calibration table; subsequent solves use it immediately.
+func (e *Engine) SetCalibration(cal model.PathLossCalibration) {
+	e.pathLoss.Store(newPathLossTable(cal))
+}
+
+// CalibrationVersion reports the active calibration version (0 for the built-in defaults).
+func (e *Engine) CalibrationVersion() int64 {
+	return e.pathLoss.Load().version
+}
+
+// SetFingerprints installs the fingerprint index matched against each tag's window; nil disables it.
+func (e *Engine) SetFingerprints(index *FingerprintIndex) {
+	e.prints.Store(index)
+}
+
+// SetClassifier installs the room classifier evaluated on each recompute; nil disables it.
+func (e *Engine) SetClassifier(c RoomClassifier) {
+	if c == nil {
+		e.classify.Store(nil)
+		return
+	}
+	e.classify.Store(&c)
+}
+
+// EnableParticleFilter smooths each tag's track with an n-particle filter. Call before Start; n <= 0
+// leaves positions as independent snapshot solves.
+func (e *Engine) EnableParticleFilter(n int) {
+	e.particles = n
+}
+
+// EnableRadioMap localizes by scoring a precomputed grid of expected RSSI with the given cell size
+// (metres) rather than warm-starting the solver from the previous fix. Call before Start; step <= 0
+// keeps the solver alone.
+func (e *Engine) EnableRadioMap(step float64) {
+	if step <= 0 {
+		e.radio = nil
+		return
+	}
+	e.radio = NewRadioMap(step, e.tracker.window)
+	e.radio.SetRooms(e.rooms.Load().Rooms())
+}
+
+// RadioMap returns the engine's radio map, or nil when the solver is used.
+func (e *Engine) RadioMap() *RadioMap {
+	return e.radio
+}
+
+// OnUpdate installs the handler invoked after each recompute.
+func (e *Engine) OnUpdate(h PositionHandler) {
+	e.onUpdate.Store(&h)
+}
+
+// SetResampling changes how each beacon's samples are read at solve time. Call before Start; a zero
+// MaxAge (or one beyond the tracker window) uses the window.
+func (e *Engine) SetResampling(cfg ResampleConfig) {
+	if cfg.MaxAge <= 0 || cfg.MaxAge > e.tracker.window {
+		cfg.MaxAge = e.tracker.window
+	}
+	e.resample = cfg
+}
+
+// SetTransitionPolicy changes the hysteresis applied to room transitions. Call before Start; zero
+// fields keep their defaults.
+func (e *Engine) SetTransitionPolicy(p TransitionPolicy) {
+	if p.MinProbability > 0 {
+		e.policy.MinProbability = p.MinProbability
+	}
+	if p.MinDwell > 0 {
+		e.policy.MinDwell = p.MinDwell
+	}
+}
+
+// OnTransition installs the handler invoked when a tag's smoothed room changes.
+func (e *Engine) OnTransition(h TransitionHandler) {
+	e.onMove.Store(&h)
+}
+
+// RoomDwell returns the mean time (seconds) tags have been observed to stay in each room.
+func (e *Engine) RoomDwell() map[string]float64 {
+	return e.smoother.Dwell()
+}
+
+// Start launches one solver worker per tracker shard, and the sweep that evicts silent tags, until
+// ctx is cancelled.
+func (e *Engine) Start(ctx context.Context) {
+	// Once per window, drop tags that went silent; they are at most two windows old when removed.
+	go func() {
+		ticker := time.NewTicker(e.tracker.window)
+		defer ticker.Stop()
+		for {
+			select {
+			case <-ctx.Done():
+				e.stopped.Store(true)
+				return
+			case now := <-ticker.C:
+				e.tracker.Evict(now)
+			}
+		}
+	}()
+	for i := range e.work {
+		go func(work <-chan *TagState) {
+			var scratch workerScratch
+			for {
+				select {
+				case <-ctx.Done():
+					return
+				case state := <-work:
+					e.recompute(state, &scratch)
+				}
+			}
+		}(e.work[i])
+	}
+}
+
+// Observe records a reading and schedules a recompute for its tag.
+func (e *Engine) Observe(r model.BeaconReading, receivedAt time.Time) {
+	state := e.tracker.Observe(r, receivedAt)
+	e.schedule(state)
+}
+
+// Recompute schedules every tracked tag for a fresh solve, e.g. after rooms change or a warm start.
+func (e *Engine) Recompute() {
+	for _, state := range e.tracker.states() {
+		e.schedule(state)
+	}
+}
+
+func (e *Engine) schedule(state *TagState) {
+	if !state.pending.CompareAndSwap(false, true) {
+		return
+	}
+	if e.debounce == 0 {
+		e.enqueue(state)
+		return
+	}
+	time.AfterFunc(e.debounce, func() { e.enqueue(state) })
+}
+
+// enqueueRetry is how long a wakeup waits before retrying a full shard queue when there is no
+// debounce delay to reuse.
+const enqueueRetry = 5 * time.Millisecond
+
+func (e *Engine) enqueue(state *TagState) {
+	select {
+	case e.work[state.shard] <- state:
+	default:
+		if e.stopped.Load() {
+			return
+		}
+		// The shard worker is saturated. Keep the tag pending and retry later: dropping the wakeup
+		// would strand its last readings if the tag then goes silent.
+		delay := e.debounce
+		if delay <= 0 {
+			delay = enqueueRetry
+		}
+		time.AfterFunc(delay, func() { e.enqueue(state) })
+	}
+}
+
+// workerScratch is per-worker state reused across recomputes.
+type workerScratch struct {
+	solver Solver
+	radio  RadioScratch
+	probs  []float64
+	votes  []float64 // classifier distribution
+	window []Observation
+	fresh  []Observation
+}
+
+func (e *Engine) recompute(state *TagState, scratch *workerScratch) {
+	// Clear before reading so readings that land mid-solve schedule another pass.
+	state.pending.Store(false)
+
+	now := time.Now()
+	pathLoss := e.pathLoss.Load()
+	scratch.window = state.resampled(now.UnixNano(), &e.resample, int64(e.resample.MaxAge), scratch.window[:0])
+	pathLoss.apply(scratch.window)
+
+	rooms := e.rooms.Load()
+	var est Estimate
+	if e.radio != nil {
+		// The grid finds the global optimum; with enough beacons the solver then polishes it off-lattice.
+		est = e.radio.Locate(scratch.window, &scratch.radio)
+		if est.Valid && est.BeaconCount >= 3 {
+			seed := est.Location
+			if polished := scratch.solver.Solve(scratch.window, &seed); polished.Valid {
+				polished.Message = "Radio-map grid search refined by weighted least squares"
+				est = polished
+			}
+		}
+	} else {
+		// Warm-start from the previous fix; a cat moves little between updates.
+		var seed *model.Location
+		if prev := state.result.Load(); prev != nil && prev.Valid {
+			loc := prev.Location
+			if prev.Raw != nil {
+				loc = *prev.Raw
+			}
+			seed = &loc
+		}
+		est = scratch.solver.Solve(scratch.window, seed)
+	}
+	pos := Position{
+		TagID:       state.tagID,
+		Location:    est.Location,
+		Confidence:  est.Confidence,
+		Residual:    est.Residual,
+		Uncertainty: est.Uncertainty,
+		BeaconCount: est.BeaconCount,
+		Outliers:    est.Outliers,
+		Iterations:  est.Iterations,
+		Message:     est.Message,
+		Valid:       est.Valid,
+		UpdatedAt:   now.UTC(),
+	}
+
+	if e.particles > 0 && (est.Valid || state.filter != nil) {
+		if state.filter == nil {
+			state.filter = NewParticleFilter(e.particles, now.UnixNano()^int64(state.shard))
+		}
+		// The filter consumes only samples that arrived since its previous update; the window mean
+		// the snapshot solver uses would count each sample many times over.
+		scratch.fresh = state.observations(state.filteredAt+1, scratch.fresh[:0])
+		pathLoss.apply(scratch.fresh)
+		state.filteredAt = now.UnixNano()
+
+		fe := state.filter.Update(scratch.fresh, now.UnixNano(), GeometryBounds(scratch.window, rooms.Rooms()), est)
+		raw := est.Location
+		velocity := fe.Velocity
+		pos.Location = fe.Location
+		pos.Uncertainty = fe.Uncertainty
+		pos.Confidence = math.Exp(-fe.Uncertainty / confidenceScale)
+		pos.Raw = &raw
+		pos.Velocity = &velocity
+		pos.Filtered = true
+		pos.Valid = true
+		pos.Message = "Particle filter over RSSI path-loss likelihood"
+	}
+
+	if pos.Valid {
+		pos.Rooms = rooms.Match(pos.Location)
+	}
+	if c := e.classify.Load(); c != nil {
+		if pred, ok := (*c).Classify(state.tagID, scratch.window, scratch.votes); ok {
+			scratch.votes = pred.Probabilities
+			pos.Prediction = &pred
+		}
+	}
+	// Room transitions come from the classifier when one is active, otherwise from the room geometry.
+	var transition *RoomTransition
+	var classes []string
+	var probs []float64
+	switch pred := pos.Prediction; {
+	case pred != nil && len(pred.Classes) > 0 && len(pred.Probabilities) == len(pred.Classes):
+		classes, probs = pred.Classes, pred.Probabilities
+	case pos.Valid && len(rooms.names) > 0:
+		scratch.probs = geometryEmission(rooms, pos.Rooms, pos.Confidence, scratch.probs)
+		classes, probs = rooms.names, scratch.probs
+	}
+	if classes != nil {
+		room, moved, ok := state.smoother.update(e.smoother.forClasses(classes), probs, e.policy, now)
+		if ok {
+			pos.Room = &room
+		}
+		if moved != nil {
+			moved.TagID = state.tagID
+			if moved.From != "" {
+				e.smoother.learnDwell(moved.From, moved.DwellS)
+			}
+			transition = moved
+		}
+	}
+	if pos.Prediction != nil {
+		// The distribution lives in the worker's scratch buffer; don't publish it with the position.
+		pos.Prediction.Probabilities = nil
+	}
+	if index := e.prints.Load(); index != nil {
+		if match, ok := index.Match(scratch.window); ok {
+			pos.Fingerprint = &match
+		}
+	}
+
+	e.solveTime.Observe(time.Since(now))
+	state.result.Store(&pos)
+	e.updates.Add(1)
+
+	if h := e.onUpdate.Load(); h != nil {
+		(*h)(pos)
+	}
+	if h := e.onMove.Load(); h != nil && transition != nil {
+		(*h)(*transition)
+	}
+}
+
+// Vector returns tagID's current per-beacon RSSI, resampled as for solving.
+func (e *Engine) Vector(tagID string) (map[string]float64, bool) {
+	state, ok := e.tracker.lookup(tagID)
+	if !ok {
+		return nil, false
+	}
+	obs := state.resampled(time.Now().UnixNano(), &e.resample, int64(e.resample.MaxAge), nil)
+	if len(obs) == 0 {
+		return nil, false
+	}
+	out := make(map[string]float64, len(obs))
+	for _, o := range obs {
+		out[o.BeaconID] = o.RSSI
+	}
+	return out, true
+}
+
+// Position returns the cached position for tagID, marked Stale when the tag has not been solved
+// within the location window.
+func (e *Engine) Position(tagID string) (Position, bool) {
+	state, ok := e.tracker.lookup(tagID)
+	if !ok {
+		return Position{}, false
+	}
+	pos := state.result.Load()
+	if pos == nil {
+		return Position{}, false
+	}
+	return e.aged(*pos, time.Now()), true
+}
+
+// Positions returns every cached position ordered by tag, marked Stale as for Position.
+func (e *Engine) Positions() []Position {
+	states := e.tracker.states()
+	out := make([]Position, 0, len(states))
+	now := time.Now()
+	for _, state := range states {
+		if pos := state.result.Load(); pos != nil {
+			out = append(out, e.aged(*pos, now))
+		}
+	}
+	sort.Slice(out, func(i, j int) bool {
+		return out[i].TagID < out[j].TagID
+	})
+	return out
+}
+
+// aged flags pos as stale once it is older than the tracker window: a silent tag keeps its last
+// fix, but callers can tell it is no longer current.
+func (e *Engine) aged(pos Position, now time.Time) Position {
+	pos.Stale = now.Sub(pos.UpdatedAt) > e.tracker.window
+	return pos
+}
+
+// Updates reports the number of recomputes performed.
+func (e *Engine) Updates() uint64 {
+	return e.updates.Load()
+}
+
+// SolveTimes returns the distribution of recompute durations, from reading the window to caching
+// the position.
+func (e *Engine) SolveTimes() metrics.HistogramSnapshot {
+	return e.solveTime.Snapshot()
+}
@@ -0,0 +1,232 @@
+package localization
+
+import (
+	"math"
+	"sort"
+	"sync"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	// fingerprintFloorRSSI stands in for beacons a fingerprint or query did not hear.
+	fingerprintFloorRSSI = -100.0
+	// fingerprintK is the neighbour count for weighted kNN.
+	fingerprintK = 5
+)
+
+// FingerprintMatch is the weighted-kNN answer for one RSSI vector.
+type FingerprintMatch struct {
+	Room       string          `json:"room"`
+	Confidence float64         `json:"confidence"` // share of neighbour weight voting for Room
+	Location   *model.Location `json:"location,omitempty"`
+	Distance   float64         `json:"distance_db"` // RSSI-space distance to the nearest fingerprint
+	Neighbors  int             `json:"neighbors"`
+}
+
+// FingerprintStats summarises the index.
+type FingerprintStats struct {
+	Fingerprints int            `json:"fingerprints"`
+	Beacons      int            `json:"beacons"`
+	Rooms        map[string]int `json:"rooms"`
+	TreeHeight   int            `json:"tree_height"`
+}
+
+type fingerprintEntry struct {
+	room     string
+	location *model.Location
+	rssi     map[string]float64
+}
+
+// FingerprintIndex answers "which labelled RSSI vectors look most like this one" with a k-d tree over
+// the beacon vocabulary. New fingerprints are inserted in place; the tree is rebuilt when inserts
+// unbalance it or a previously unseen beacon adds a dimension.
+type FingerprintIndex struct {
+	mu      sync.RWMutex
+	beacons map[string]int // beacon id -> dimension
+	entries []fingerprintEntry
+	tree    *kdTree
+}
+
+// NewFingerprintIndex returns an empty index.
+func NewFingerprintIndex() *FingerprintIndex {
+	return &FingerprintIndex{beacons: make(map[string]int), tree: newKDTree(0)}
+}
+
+// Load replaces the index contents with fps and builds a balanced tree.
+func (x *FingerprintIndex) Load(fps []model.Fingerprint) {
+	x.mu.Lock()
+	defer x.mu.Unlock()
+
+	x.beacons = make(map[string]int)
+	x.entries = x.entries[:0]
+	for _, fp := range fps {
+		if len(fp.RSSI) == 0 {
+			continue
+		}
+		x.entries = append(x.entries, entryFrom(fp))
+		x.learnBeacons(fp.RSSI)
+	}
+	x.rebuildLocked()
+}
+
+// Add inserts one fingerprint. Fingerprints without readings are ignored.
+func (x *FingerprintIndex) Add(fp model.Fingerprint) {
+	if len(fp.RSSI) == 0 {
+		return
+	}
+	x.mu.Lock()
+	defer x.mu.Unlock()
+
+	x.entries = append(x.entries, entryFrom(fp))
+	if x.learnBeacons(fp.RSSI) {
+		x.rebuildLocked()
+		return
+	}
+	x.tree.insert(x.vector(fp.RSSI, nil))
+	if x.tree.unbalanced() {
+		x.rebuildLocked()
+	}
+}
+
+// Len reports the number of fingerprints.
+func (x *FingerprintIndex) Len() int {
+	x.mu.RLock()
+	defer x.mu.RUnlock()
+	return len(x.entries)
+}
+
+// Stats summarises the index contents.
+func (x *FingerprintIndex) Stats() FingerprintStats {
+	x.mu.RLock()
+	defer x.mu.RUnlock()
+	rooms := make(map[string]int)
+	for _, e := range x.entries {
+		rooms[e.room]++
+	}
+	return FingerprintStats{
+		Fingerprints: len(x.entries),
+		Beacons:      len(x.beacons),
+		Rooms:        rooms,
+		TreeHeight:   x.tree.height,
+	}
+}
+
+func entryFrom(fp model.Fingerprint) fingerprintEntry {
+	return fingerprintEntry{room: fp.Room, location: fp.Location, rssi: fp.RSSI}
+}
+
+// learnBeacons extends the vocabulary; it reports whether any dimension was added.
+func (x *FingerprintIndex) learnBeacons(rssi map[string]float64) bool {
+	added := false
+	for id := range rssi {
+		if _, ok := x.beacons[id]; !ok {
+			added = true
+			x.beacons[id] = -1
+		}
+	}
+	if !added {
+		return false
+	}
+	// Renumber in sorted order so dimensions are stable across restarts.
+	ids := make([]string, 0, len(x.beacons))
+	for id := range x.beacons {
+		ids = append(ids, id)
+	}
+	sort.Strings(ids)
+	for i, id := range ids {
+		x.beacons[id] = i
+	}
+	return true
+}
+
+func (x *FingerprintIndex) vector(rssi map[string]float64, dst []float64) []float64 {
+	dst = dst[:0]
+	for i := 0; i < len(x.beacons); i++ {
+		dst = append(dst, fingerprintFloorRSSI)
+	}
+	for id, v := range rssi {
+		if dim, ok := x.beacons[id]; ok {
+			dst[dim] = v
+		}
+	}
+	return dst
+}
+
+func (x *FingerprintIndex) rebuildLocked() {
+	tree := newKDTree(len(x.beacons))
+	tree.points = make([]float64, 0, len(x.entries)*len(x.beacons))
+	var vec []float64
+	for _, e := range x.entries {
+		vec = x.vector(e.rssi, vec)
+		tree.points = append(tree.points, vec...)
+	}
+	tree.rebuild()
+	x.tree = tree
+}
+
+// Match runs weighted kNN for the given observations. Observations from beacons no fingerprint has
+// heard are ignored; beacons the query did not hear count as the floor RSSI.
+func (x *FingerprintIndex) Match(observations []Observation) (FingerprintMatch, bool) {
+	x.mu.RLock()
+	defer x.mu.RUnlock()
+
+	if len(x.entries) == 0 || len(observations) == 0 {
+		return FingerprintMatch{}, false
+	}
+
+	query := make([]float64, len(x.beacons))
+	for i := range query {
+		query[i] = fingerprintFloorRSSI
+	}
+	heard := 0
+	for _, o := range observations {
+		if dim, ok := x.beacons[o.BeaconID]; ok {
+			query[dim] = o.RSSI
+			heard++
+		}
+	}
+	if heard == 0 {
+		return FingerprintMatch{}, false
+	}
+
+	var buf [fingerprintK]kdNeighbor
+	neighbors := x.tree.nearest(query, fingerprintK, buf[:0])
+	if len(neighbors) == 0 {
+		return FingerprintMatch{}, false
+	}
+
+	votes := make(map[string]float64, len(neighbors))
+	var total, locWeight float64
+	var loc model.Location
+	for _, n := range neighbors {
+		w := 1 / (math.Sqrt(n.dist2) + 1)
+		e := x.entries[n.point]
+		votes[e.room] += w
+		total += w
+		if e.location != nil {
+			loc.X += w * e.location.X
+			loc.Y += w * e.location.Y
+			loc.Z += w * e.location.Z
+			locWeight += w
+		}
+	}
+
+	match := FingerprintMatch{
+		Distance:  math.Sqrt(neighbors[0].dist2),
+		Neighbors: len(neighbors),
+	}
+	for room, w := range votes {
+		if w > match.Confidence || (w == match.Confidence && room < match.Room) {
+			match.Room, match.Confidence = room, w
+		}
+	}
+	match.Confidence /= total
+	if locWeight > 0 {
+		loc.X /= locWeight
+		loc.Y /= locWeight
+		loc.Z /= locWeight
+		match.Location = &loc
+	}
+	return match, true
+}
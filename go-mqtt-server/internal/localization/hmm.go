@@ -0,0 +1,386 @@
+package localization
+
+import (
+	"math"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	// hmmDefaultDwell is the assumed mean stay (seconds) in a room before any have been observed.
+	hmmDefaultDwell = 120.0
+	// hmmMinDwell and hmmMaxDwell bound learned dwell times so one odd stay cannot freeze or unpin a room.
+	hmmMinDwell = 10.0
+	hmmMaxDwell = 3600.0
+	// hmmDwellAlpha is the EMA weight of each completed stay in the learned dwell time.
+	hmmDwellAlpha = 0.1
+	// hmmDwellRebuild is the relative drift of a learned dwell time from the one in the shared model
+	// that triggers a rebuild. Rebuilding makes every tag's smoother rebase on its next update, so
+	// small drifts accumulate instead.
+	hmmDwellRebuild = 0.2
+	// hmmTeleport is the share of leaving probability assigned to non-adjacent rooms, covering gaps in
+	// the room geometry and silent stretches where the tag moved through a room unseen.
+	hmmTeleport = 0.05
+	// hmmEmissionFloor keeps a class the classifier gave zero votes from zeroing the belief.
+	hmmEmissionFloor = 0.02
+	// hmmAdjacencyMargin (metres) is the gap between room spheres still treated as a doorway.
+	hmmAdjacencyMargin = 1.0
+	// DefaultTransitionProbability and DefaultTransitionDwell debounce transitions: the new room must
+	// lead the belief with at least this probability for at least this long before a transition is emitted.
+	DefaultTransitionProbability = 0.7
+	DefaultTransitionDwell       = 3 * time.Second
+	// hmmGeometryHit is the emission weight of the room containing the position when no classifier runs.
+	hmmGeometryHit = 0.6
+)
+
+// TransitionPolicy is the hysteresis applied before a room change is reported.
+type TransitionPolicy struct {
+	MinProbability float64       // belief the new room must reach
+	MinDwell       time.Duration // how long it must stay the most likely room
+}
+
+// RoomState is the smoothed room of a tag.
+type RoomState struct {
+	Room        string    `json:"room"`
+	Probability float64   `json:"probability"`
+	Since       time.Time `json:"since"`
+}
+
+// RoomTransition is emitted when a tag's smoothed room changes. From is empty for the first room.
+type RoomTransition struct {
+	TagID       string    `json:"tag_id"`
+	From        string    `json:"from,omitempty"`
+	To          string    `json:"to"`
+	Probability float64   `json:"probability"`
+	DwellS      float64   `json:"dwell_s,omitempty"` // time spent in From
+	At          time.Time `json:"at"`
+}
+
+// TransitionHandler receives debounced room transitions.
+type TransitionHandler func(RoomTransition)
+
+// roomHMM is an immutable transition model over the classifier's classes. It is rebuilt when the
+// classes or the room geometry change, or a learned dwell time drifts by more than hmmDwellRebuild.
+type roomHMM struct {
+	rooms     []string
+	index     map[string]int
+	neighbors [][]int   // adjacent room indices
+	dwell     []float64 // mean stay, seconds
+}
+
+func newRoomHMM(classes []string, defs []model.RoomDefinition, dwell map[string]float64) *roomHMM {
+	h := &roomHMM{
+		rooms:     append([]string(nil), classes...),
+		index:     make(map[string]int, len(classes)),
+		neighbors: make([][]int, len(classes)),
+		dwell:     make([]float64, len(classes)),
+	}
+	geometry := make(map[string]model.RoomDefinition, len(defs))
+	for _, d := range defs {
+		geometry[d.Name] = d
+	}
+	for i, name := range classes {
+		h.index[name] = i
+		h.dwell[i] = hmmDefaultDwell
+		if d, ok := dwell[name]; ok {
+			h.dwell[i] = d
+		}
+	}
+	for i, a := range classes {
+		ga, okA := geometry[a]
+		for j, b := range classes {
+			if i == j {
+				continue
+			}
+			gb, okB := geometry[b]
+			// Rooms without geometry are assumed reachable from anywhere.
+			if !okA || !okB || roomsAdjacent(ga, gb) {
+				h.neighbors[i] = append(h.neighbors[i], j)
+			}
+		}
+	}
+	return h
+}
+
+// roomsAdjacent treats two sphere rooms as connected when the spheres come within hmmAdjacencyMargin
+// of each other. An outline room connects to outline rooms on its floor, and to sphere rooms whose
+// anchor lies in its elevation band, when their footprint boxes come that close.
+func roomsAdjacent(a, b model.RoomDefinition) bool {
+	aSphere, bSphere := len(a.Polygon) < 3, len(b.Polygon) < 3
+	switch {
+	case aSphere && bSphere:
+		dx, dy, dz := a.X-b.X, a.Y-b.Y, a.Z-b.Z
+		return math.Sqrt(dx*dx+dy*dy+dz*dz) <= a.Radius+b.Radius+hmmAdjacencyMargin
+	case aSphere:
+		if a.Z < b.ZMin-hmmAdjacencyMargin || a.Z > b.ZMax+hmmAdjacencyMargin {
+			return false
+		}
+	case bSphere:
+		if b.Z < a.ZMin-hmmAdjacencyMargin || b.Z > a.ZMax+hmmAdjacencyMargin {
+			return false
+		}
+	case a.Floor != b.Floor:
+		return false
+	}
+	ax0, ay0, ax1, ay1 := roomFootprint(&a)
+	bx0, by0, bx1, by1 := roomFootprint(&b)
+	gapX := math.Max(ax0-bx1, bx0-ax1)
+	gapY := math.Max(ay0-by1, by0-ay1)
+	return math.Max(gapX, gapY) <= hmmAdjacencyMargin
+}
+
+func (h *roomHMM) sameClasses(classes []string) bool {
+	if len(classes) != len(h.rooms) {
+		return false
+	}
+	for i, c := range classes {
+		if h.rooms[i] != c {
+			return false
+		}
+	}
+	return true
+}
+
+// roomModels owns the shared transition model and the dwell times learned from committed stays.
+type roomModels struct {
+	mu    sync.Mutex
+	rooms []model.RoomDefinition
+	dwell map[string]float64
+	hmm   atomic.Pointer[roomHMM]
+}
+
+// forClasses returns the transition model for the classifier's classes, rebuilding it if they changed.
+func (m *roomModels) forClasses(classes []string) *roomHMM {
+	if h := m.hmm.Load(); h != nil && h.sameClasses(classes) {
+		return h
+	}
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if h := m.hmm.Load(); h != nil && h.sameClasses(classes) {
+		return h
+	}
+	h := newRoomHMM(classes, m.rooms, m.dwell)
+	m.hmm.Store(h)
+	return h
+}
+
+func (m *roomModels) setRooms(rooms []model.RoomDefinition) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	m.rooms = rooms
+	if h := m.hmm.Load(); h != nil {
+		m.hmm.Store(newRoomHMM(h.rooms, m.rooms, m.dwell))
+	}
+}
+
+// learnDwell folds one completed stay into the room's mean dwell time. The transition model is only
+// rebuilt once the learned value has drifted materially from the one it was built with.
+func (m *roomModels) learnDwell(room string, seconds float64) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.dwell == nil {
+		m.dwell = make(map[string]float64)
+	}
+	prev, ok := m.dwell[room]
+	if !ok {
+		prev = hmmDefaultDwell
+	}
+	learned := math.Min(math.Max(prev+hmmDwellAlpha*(seconds-prev), hmmMinDwell), hmmMaxDwell)
+	m.dwell[room] = learned
+	h := m.hmm.Load()
+	if h == nil {
+		return
+	}
+	if i, ok := h.index[room]; ok && math.Abs(learned-h.dwell[i]) > hmmDwellRebuild*h.dwell[i] {
+		m.hmm.Store(newRoomHMM(h.rooms, m.rooms, m.dwell))
+	}
+}
+
+// Dwell returns the learned mean dwell time per room in seconds.
+func (m *roomModels) Dwell() map[string]float64 {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	out := make(map[string]float64, len(m.dwell))
+	for k, v := range m.dwell {
+		out[k] = v
+	}
+	return out
+}
+
+// geometryEmission spreads a position's room match into per-room probabilities in index order, for
+// tags with no classifier output. A position outside every room carries no evidence.
+func geometryEmission(index *RoomIndex, matches []RoomMatch, confidence float64, probs []float64) []float64 {
+	probs = probs[:0]
+	n := len(index.names)
+	inside := ""
+	if len(matches) > 0 && matches[0].WithinRadius {
+		inside = matches[0].Name
+	}
+	hit := 1 / float64(n)
+	if inside != "" && n > 1 {
+		hit = math.Max(hit, hmmGeometryHit*math.Min(1, math.Max(confidence, 0.5)))
+	}
+	miss := 1 / float64(n)
+	if inside != "" && n > 1 {
+		miss = (1 - hit) / float64(n-1)
+	}
+	for _, name := range index.names {
+		if name == inside {
+			probs = append(probs, hit)
+		} else {
+			probs = append(probs, miss)
+		}
+	}
+	return probs
+}
+
+// roomSmoother is a tag's forward-filtered belief over rooms. Like the particle filter it is owned
+// by the tag's shard worker.
+type roomSmoother struct {
+	hmm     *roomHMM
+	belief  []float64
+	next    []float64
+	last    time.Time
+	current int // committed room index, -1 before the first commit
+	since   time.Time
+
+	candidate      int
+	candidateSince time.Time
+}
+
+// update folds one classifier output into the belief in O(rooms^2) and returns the committed state
+// plus a transition when the debounced room changed.
+func (s *roomSmoother) update(h *roomHMM, probs []float64, policy TransitionPolicy, now time.Time) (RoomState, *RoomTransition, bool) {
+	n := len(h.rooms)
+	if s.hmm != h {
+		s.rebase(h)
+	}
+
+	if !s.last.IsZero() {
+		dt := now.Sub(s.last).Seconds()
+		if dt < 0 {
+			dt = 0
+		}
+		clear(s.next)
+		for i, b := range s.belief {
+			if b == 0 {
+				continue
+			}
+			stay := math.Exp(-dt / h.dwell[i])
+			s.next[i] += b * stay
+			leave := b * (1 - stay)
+			near := h.neighbors[i]
+			far := n - 1 - len(near)
+			if far == 0 {
+				for _, j := range near {
+					s.next[j] += leave / float64(len(near))
+				}
+				continue
+			}
+			if len(near) > 0 {
+				for _, j := range near {
+					s.next[j] += leave * (1 - hmmTeleport) / float64(len(near))
+				}
+				leave *= hmmTeleport
+			}
+			// Spread the rest over every other room, then take back what went to self and neighbours.
+			share := leave / float64(n-1-len(near))
+			for j := range s.next {
+				s.next[j] += share
+			}
+			s.next[i] -= share
+			for _, j := range near {
+				s.next[j] -= share
+			}
+		}
+		s.belief, s.next = s.next, s.belief
+	}
+	s.last = now
+
+	var total float64
+	for i := range s.belief {
+		s.belief[i] *= math.Max(probs[i], hmmEmissionFloor)
+		total += s.belief[i]
+	}
+	if total <= 0 || math.IsNaN(total) {
+		s.reset(n)
+		return RoomState{}, nil, false
+	}
+	best := 0
+	for i := range s.belief {
+		s.belief[i] /= total
+		if s.belief[i] > s.belief[best] {
+			best = i
+		}
+	}
+
+	var transition *RoomTransition
+	switch {
+	case best == s.current:
+		s.candidate = -1
+	case best != s.candidate:
+		s.candidate, s.candidateSince = best, now
+	}
+	if s.candidate >= 0 && s.belief[s.candidate] >= policy.MinProbability && now.Sub(s.candidateSince) >= policy.MinDwell {
+		transition = &RoomTransition{To: h.rooms[s.candidate], Probability: s.belief[s.candidate], At: now.UTC()}
+		if s.current >= 0 {
+			transition.From = h.rooms[s.current]
+			transition.DwellS = now.Sub(s.since).Seconds()
+		}
+		s.current, s.since, s.candidate = s.candidate, now, -1
+	}
+
+	if s.current < 0 {
+		return RoomState{}, transition, false
+	}
+	return RoomState{Room: h.rooms[s.current], Probability: s.belief[s.current], Since: s.since.UTC()}, transition, true
+}
+
+// rebase carries the belief over to a new transition model, matching rooms by name.
+func (s *roomSmoother) rebase(h *roomHMM) {
+	prev, prevBelief, prevCurrent, prevCandidate := s.hmm, s.belief, s.current, s.candidate
+	s.hmm = h
+	s.reset(len(h.rooms))
+	if prev == nil {
+		return
+	}
+	var total float64
+	for i, name := range prev.rooms {
+		if j, ok := h.index[name]; ok {
+			s.belief[j] = prevBelief[i]
+			total += prevBelief[i]
+		}
+	}
+	if total <= 0 {
+		s.reset(len(h.rooms))
+		return
+	}
+	for j := range s.belief {
+		s.belief[j] /= total
+	}
+	if prevCurrent >= 0 {
+		if j, ok := h.index[prev.rooms[prevCurrent]]; ok {
+			s.current = j
+		}
+	}
+	if prevCandidate >= 0 {
+		if j, ok := h.index[prev.rooms[prevCandidate]]; ok {
+			s.candidate = j
+		}
+	}
+}
+
+func (s *roomSmoother) reset(n int) {
+	if cap(s.belief) < n {
+		s.belief = make([]float64, n)
+		s.next = make([]float64, n)
+	}
+	s.belief, s.next = s.belief[:n], s.next[:n]
+	for i := range s.belief {
+		s.belief[i] = 1 / float64(n)
+	}
+	s.current, s.candidate = -1, -1
+}
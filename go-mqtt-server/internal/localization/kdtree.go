@@ -0,0 +1,188 @@
+package localization
+
+import (
+	"math"
+	"sort"
+)
+
+// kdTree indexes fixed-dimension points stored flattened in points (n*dims). Nodes live in a slice
+// and reference children by index, so the tree is a handful of contiguous arrays rather than a
+// pointer graph. Points can be inserted incrementally; Rebuild restores balance.
+type kdTree struct {
+	dims   int
+	points []float64
+	nodes  []kdNode
+	root   int32
+	height int
+}
+
+type kdNode struct {
+	point       int32
+	left, right int32
+	axis        int32
+}
+
+type kdNeighbor struct {
+	point int
+	dist2 float64
+}
+
+func newKDTree(dims int) *kdTree {
+	return &kdTree{dims: dims, root: -1}
+}
+
+func (t *kdTree) len() int {
+	if t.dims == 0 {
+		return 0
+	}
+	return len(t.points) / t.dims
+}
+
+func (t *kdTree) coord(point int, axis int) float64 {
+	return t.points[point*t.dims+axis]
+}
+
+// rebuild builds a balanced tree over every stored point, splitting each node on the axis of
+// widest spread at the median.
+func (t *kdTree) rebuild() {
+	n := t.len()
+	t.nodes = t.nodes[:0]
+	t.height = 0
+	if n == 0 {
+		t.root = -1
+		return
+	}
+	idx := make([]int32, n)
+	for i := range idx {
+		idx[i] = int32(i)
+	}
+	t.root = t.build(idx, 1)
+}
+
+func (t *kdTree) build(idx []int32, depth int) int32 {
+	if len(idx) == 0 {
+		return -1
+	}
+	if depth > t.height {
+		t.height = depth
+	}
+
+	axis := 0
+	widest := -1.0
+	for a := 0; a < t.dims; a++ {
+		lo, hi := math.Inf(1), math.Inf(-1)
+		for _, p := range idx {
+			v := t.coord(int(p), a)
+			lo = math.Min(lo, v)
+			hi = math.Max(hi, v)
+		}
+		if hi-lo > widest {
+			widest, axis = hi-lo, a
+		}
+	}
+
+	sort.Slice(idx, func(i, j int) bool {
+		return t.coord(int(idx[i]), axis) < t.coord(int(idx[j]), axis)
+	})
+	mid := len(idx) / 2
+
+	node := int32(len(t.nodes))
+	t.nodes = append(t.nodes, kdNode{point: idx[mid], axis: int32(axis)})
+	left := t.build(idx[:mid], depth+1)
+	right := t.build(idx[mid+1:], depth+1)
+	t.nodes[node].left, t.nodes[node].right = left, right
+	return node
+}
+
+// insert appends a point and links it in as a leaf; the caller rebuilds once the tree grows too deep.
+func (t *kdTree) insert(vec []float64) {
+	point := int32(t.len())
+	t.points = append(t.points, vec...)
+	node := int32(len(t.nodes))
+
+	if t.root < 0 {
+		t.nodes = append(t.nodes, kdNode{point: point, left: -1, right: -1})
+		t.root, t.height = node, 1
+		return
+	}
+
+	cur, depth := t.root, 1
+	for {
+		depth++
+		n := &t.nodes[cur]
+		next := &n.right
+		if vec[n.axis] < t.coord(int(n.point), int(n.axis)) {
+			next = &n.left
+		}
+		if *next < 0 {
+			axis := (n.axis + 1) % int32(t.dims)
+			*next = node
+			t.nodes = append(t.nodes, kdNode{point: point, left: -1, right: -1, axis: axis})
+			break
+		}
+		cur = *next
+	}
+	if depth > t.height {
+		t.height = depth
+	}
+}
+
+// unbalanced reports whether incremental inserts have made the tree much deeper than a balanced one.
+func (t *kdTree) unbalanced() bool {
+	n := t.len()
+	if n < 64 {
+		return false
+	}
+	return float64(t.height) > 3*math.Log2(float64(n))
+}
+
+// nearest fills dst (reset to length 0) with up to k nearest points ordered by distance.
+func (t *kdTree) nearest(q []float64, k int, dst []kdNeighbor) []kdNeighbor {
+	dst = dst[:0]
+	if t.root < 0 || k <= 0 {
+		return dst
+	}
+	return t.search(t.root, q, k, dst)
+}
+
+func (t *kdTree) search(node int32, q []float64, k int, best []kdNeighbor) []kdNeighbor {
+	if node < 0 {
+		return best
+	}
+	n := t.nodes[node]
+
+	base := int(n.point) * t.dims
+	var d2 float64
+	for a := 0; a < t.dims; a++ {
+		diff := q[a] - t.points[base+a]
+		d2 += diff * diff
+	}
+	best = insertNeighbor(best, kdNeighbor{point: int(n.point), dist2: d2}, k)
+
+	diff := q[n.axis] - t.points[base+int(n.axis)]
+	near, far := n.left, n.right
+	if diff >= 0 {
+		near, far = n.right, n.left
+	}
+	best = t.search(near, q, k, best)
+	if len(best) < k || diff*diff < best[len(best)-1].dist2 {
+		best = t.search(far, q, k, best)
+	}
+	return best
+}
+
+// insertNeighbor keeps best sorted ascending and capped at k entries.
+func insertNeighbor(best []kdNeighbor, n kdNeighbor, k int) []kdNeighbor {
+	if len(best) == k && n.dist2 >= best[k-1].dist2 {
+		return best
+	}
+	if len(best) < k {
+		best = append(best, n)
+	} else {
+		best[k-1] = n
+	}
+	for i := len(best) - 1; i > 0 && best[i].dist2 < best[i-1].dist2; i-- {
+		best[i], best[i-1] = best[i-1], best[i]
+	}
+	return best
+}
@@ -0,0 +1,288 @@
+package localization
+
+import (
+	"math"
+	"math/rand"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	// particleAccelStd is the random acceleration (m/s^2) driving the constant-velocity model.
+	particleAccelStd = 0.8
+	// particleVelocityTau is the time constant (s) with which velocity decays toward rest.
+	particleVelocityTau = 2.0
+	// particleJitter is the per-sqrt(second) position diffusion (m) that keeps the cloud from collapsing.
+	particleJitter = 0.15
+	// particleMaxGap caps the prediction interval; longer silences only widen the cloud to this extent.
+	particleMaxGap = 10.0
+	// boundsMargin pads the geometry bounding box so tags near an outer wall are not clipped.
+	boundsMargin = 1.0
+)
+
+// Bounds is an axis-aligned box particles are confined to.
+type Bounds struct {
+	Min, Max [3]float64
+}
+
+// GeometryBounds returns the box spanning the observed beacons and the configured rooms, padded by boundsMargin.
+func GeometryBounds(observations []Observation, rooms []model.RoomDefinition) Bounds {
+	b := Bounds{
+		Min: [3]float64{math.Inf(1), math.Inf(1), math.Inf(1)},
+		Max: [3]float64{math.Inf(-1), math.Inf(-1), math.Inf(-1)},
+	}
+	extend := func(p [3]float64, r float64) {
+		for i := 0; i < 3; i++ {
+			b.Min[i] = math.Min(b.Min[i], p[i]-r)
+			b.Max[i] = math.Max(b.Max[i], p[i]+r)
+		}
+	}
+	for _, o := range observations {
+		extend([3]float64{o.Location.X, o.Location.Y, o.Location.Z}, boundsMargin)
+	}
+	for _, room := range rooms {
+		extend([3]float64{room.X, room.Y, room.Z}, room.Radius)
+		for _, p := range room.Polygon {
+			extend([3]float64{p.X, p.Y, room.ZMin}, 0)
+			extend([3]float64{p.X, p.Y, room.ZMax}, 0)
+		}
+	}
+	return b
+}
+
+// ParticleFilter tracks one tag with a constant-velocity motion model and an RSSI likelihood from the
+// path-loss model. State is kept as parallel arrays that are allocated once and reused, so an update
+// allocates nothing. A filter is owned by a single engine worker and is not safe for concurrent use.
+type ParticleFilter struct {
+	n int
+
+	x, y, z, vx, vy, vz []float64
+	w                   []float64 // normalised weights
+	ll                  []float64 // per-update log-likelihood scratch
+	// back buffers for resampling; swapped with the live arrays instead of copied
+	bx, by, bz, bvx, bvy, bvz []float64
+
+	rng         *rand.Rand
+	last        int64 // unix nanos of the previous update
+	initialized bool
+}
+
+// NewParticleFilter allocates a filter with n particles.
+func NewParticleFilter(n int, seed int64) *ParticleFilter {
+	if n < 16 {
+		n = 16
+	}
+	buf := make([]float64, 14*n)
+	slice := func(i int) []float64 { return buf[i*n : (i+1)*n : (i+1)*n] }
+	return &ParticleFilter{
+		n:   n,
+		x:   slice(0),
+		y:   slice(1),
+		z:   slice(2),
+		vx:  slice(3),
+		vy:  slice(4),
+		vz:  slice(5),
+		w:   slice(6),
+		ll:  slice(7),
+		bx:  slice(8),
+		by:  slice(9),
+		bz:  slice(10),
+		bvx: slice(11),
+		bvy: slice(12),
+		bvz: slice(13),
+		rng: rand.New(rand.NewSource(seed)),
+	}
+}
+
+// FilterEstimate is the weighted mean of the particle cloud after an update.
+type FilterEstimate struct {
+	Location    model.Location
+	Velocity    model.Location
+	Uncertainty float64 // sqrt of the trace of the particle covariance, metres
+	ESS         float64 // effective sample size before resampling
+}
+
+// Update predicts every particle forward to now, weights them by the likelihood of the new
+// observations, resamples when the effective sample size drops below half, and returns the mean.
+// init seeds the cloud on the first update (or after the estimate diverged) from a snapshot solve.
+func (f *ParticleFilter) Update(observations []Observation, now int64, bounds Bounds, init Estimate) FilterEstimate {
+	if !f.initialized {
+		f.initialize(bounds, init)
+		f.last = now
+	}
+
+	dt := float64(now-f.last) / 1e9
+	if dt < 0 {
+		dt = 0
+	} else if dt > particleMaxGap {
+		dt = particleMaxGap
+	}
+	f.last = now
+
+	f.predict(dt, bounds)
+	ess, bestFit := f.weigh(observations)
+
+	// If even the best particle misses the observations by more than three sigma on average the cloud
+	// has lost the tag (e.g. the cat was carried between floors while the scanners were silent);
+	// reseed from the snapshot solve.
+	if ess == 0 || bestFit < -4.5 {
+		f.initialize(bounds, init)
+		if ess, _ = f.weigh(observations); ess == 0 {
+			f.initialized = false
+			return FilterEstimate{Location: init.Location, Uncertainty: init.Uncertainty}
+		}
+	}
+
+	est := f.estimate()
+	est.ESS = ess
+	if ess < float64(f.n)/2 {
+		f.resample()
+	}
+	return est
+}
+
+func (f *ParticleFilter) initialize(bounds Bounds, init Estimate) {
+	spread := init.Uncertainty
+	if spread <= 0 || spread > 5 {
+		spread = 5
+	}
+	for i := 0; i < f.n; i++ {
+		if init.Valid {
+			f.x[i] = init.Location.X + f.rng.NormFloat64()*spread
+			f.y[i] = init.Location.Y + f.rng.NormFloat64()*spread
+			f.z[i] = init.Location.Z + f.rng.NormFloat64()*spread
+		} else {
+			f.x[i] = bounds.Min[0] + f.rng.Float64()*(bounds.Max[0]-bounds.Min[0])
+			f.y[i] = bounds.Min[1] + f.rng.Float64()*(bounds.Max[1]-bounds.Min[1])
+			f.z[i] = bounds.Min[2] + f.rng.Float64()*(bounds.Max[2]-bounds.Min[2])
+		}
+		f.vx[i], f.vy[i], f.vz[i] = 0, 0, 0
+		f.w[i] = 1 / float64(f.n)
+	}
+	f.initialized = true
+}
+
+func (f *ParticleFilter) predict(dt float64, bounds Bounds) {
+	if dt == 0 {
+		return
+	}
+	decay := math.Exp(-dt / particleVelocityTau)
+	accel := particleAccelStd * dt
+	jitter := particleJitter * math.Sqrt(dt)
+	for i := 0; i < f.n; i++ {
+		f.vx[i] = f.vx[i]*decay + f.rng.NormFloat64()*accel
+		f.vy[i] = f.vy[i]*decay + f.rng.NormFloat64()*accel
+		f.vz[i] = f.vz[i]*decay + f.rng.NormFloat64()*accel
+		f.x[i] += f.vx[i]*dt + f.rng.NormFloat64()*jitter
+		f.y[i] += f.vy[i]*dt + f.rng.NormFloat64()*jitter
+		f.z[i] += f.vz[i]*dt + f.rng.NormFloat64()*jitter
+		f.x[i], f.vx[i] = reflect(f.x[i], f.vx[i], bounds.Min[0], bounds.Max[0])
+		f.y[i], f.vy[i] = reflect(f.y[i], f.vy[i], bounds.Min[1], bounds.Max[1])
+		f.z[i], f.vz[i] = reflect(f.z[i], f.vz[i], bounds.Min[2], bounds.Max[2])
+	}
+}
+
+// reflect keeps a coordinate inside [lo, hi], bouncing it off the wall and reversing its velocity.
+func reflect(p, v, lo, hi float64) (float64, float64) {
+	if hi <= lo {
+		return p, v
+	}
+	if p < lo {
+		p = math.Min(2*lo-p, hi)
+		v = -v
+	} else if p > hi {
+		p = math.Max(2*hi-p, lo)
+		v = -v
+	}
+	return p, v
+}
+
+// weigh multiplies in the RSSI likelihood and normalises. It returns the effective sample size and
+// the mean per-observation log-likelihood of the best particle, which flags divergence.
+func (f *ParticleFilter) weigh(observations []Observation) (ess, bestFit float64) {
+	maxLL := math.Inf(-1)
+	for i := 0; i < f.n; i++ {
+		var ll float64
+		for j := range observations {
+			o := &observations[j]
+			dx := f.x[i] - o.Location.X
+			dy := f.y[i] - o.Location.Y
+			dz := f.z[i] - o.Location.Z
+			d := math.Max(math.Sqrt(dx*dx+dy*dy+dz*dz), 0.1)
+			resid := o.RSSI - o.pathLoss().Expected(d)
+			ll -= 0.5 * resid * resid * o.weight() / (rssiNoiseDB * rssiNoiseDB)
+		}
+		f.ll[i] = ll
+		if ll > maxLL {
+			maxLL = ll
+		}
+	}
+
+	var sum float64
+	for i := 0; i < f.n; i++ {
+		f.w[i] *= math.Exp(f.ll[i] - maxLL)
+		sum += f.w[i]
+	}
+	if sum == 0 || math.IsNaN(sum) {
+		return 0, maxLL
+	}
+	var sumSq float64
+	for i := 0; i < f.n; i++ {
+		f.w[i] /= sum
+		sumSq += f.w[i] * f.w[i]
+	}
+	if len(observations) > 0 {
+		maxLL /= float64(len(observations))
+	}
+	return 1 / sumSq, maxLL
+}
+
+func (f *ParticleFilter) estimate() FilterEstimate {
+	var mx, my, mz, mvx, mvy, mvz float64
+	for i := 0; i < f.n; i++ {
+		w := f.w[i]
+		mx += w * f.x[i]
+		my += w * f.y[i]
+		mz += w * f.z[i]
+		mvx += w * f.vx[i]
+		mvy += w * f.vy[i]
+		mvz += w * f.vz[i]
+	}
+	var variance float64
+	for i := 0; i < f.n; i++ {
+		w := f.w[i]
+		dx, dy, dz := f.x[i]-mx, f.y[i]-my, f.z[i]-mz
+		variance += w * (dx*dx + dy*dy + dz*dz)
+	}
+	return FilterEstimate{
+		Location:    model.Location{X: mx, Y: my, Z: mz},
+		Velocity:    model.Location{X: mvx, Y: mvy, Z: mvz},
+		Uncertainty: math.Sqrt(variance),
+	}
+}
+
+// resample draws a new equally weighted cloud with systematic resampling into the back buffers.
+func (f *ParticleFilter) resample() {
+	step := 1 / float64(f.n)
+	u := f.rng.Float64() * step
+	cumulative := f.w[0]
+	j := 0
+	for i := 0; i < f.n; i++ {
+		for u > cumulative && j < f.n-1 {
+			j++
+			cumulative += f.w[j]
+		}
+		f.bx[i], f.by[i], f.bz[i] = f.x[j], f.y[j], f.z[j]
+		f.bvx[i], f.bvy[i], f.bvz[i] = f.vx[j], f.vy[j], f.vz[j]
+		u += step
+	}
+	f.x, f.bx = f.bx, f.x
+	f.y, f.by = f.by, f.y
+	f.z, f.bz = f.bz, f.z
+	f.vx, f.bvx = f.bvx, f.vx
+	f.vy, f.bvy = f.bvy, f.vy
+	f.vz, f.bvz = f.bvz, f.vz
+	for i := 0; i < f.n; i++ {
+		f.w[i] = step
+	}
+}
@@ -0,0 +1,158 @@
+package localization
+
+import (
+	"fmt"
+	"math"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	minPathLossExponent = 1.2
+	maxPathLossExponent = 6.0
+	// minLogSpread is the minimum spread of log10(distance) needed to fit the exponent; with less the
+	// slope is unidentifiable and only TxPower is fitted.
+	minLogSpread = 0.15
+)
+
+// PathLoss is the log-distance model RSSI = TxPower - 10*Exponent*log10(d).
+type PathLoss struct {
+	TxPower  float64
+	Exponent float64
+}
+
+// DefaultPathLoss applies when no calibration covers a beacon: -59 dBm at 1 m, free-space exponent.
+var DefaultPathLoss = PathLoss{TxPower: -59.0, Exponent: 2.0}
+
+// Distance converts RSSI to metres.
+func (m PathLoss) Distance(rssi float64) float64 {
+	return math.Pow(10, (m.TxPower-rssi)/(10*m.Exponent))
+}
+
+// Expected returns the RSSI the model predicts at d metres.
+func (m PathLoss) Expected(d float64) float64 {
+	return m.TxPower - 10*m.Exponent*math.Log10(d)
+}
+
+// RSSIToDistance converts RSSI to meters with the default path-loss model.
+func RSSIToDistance(rssi float64) float64 {
+	return DefaultPathLoss.Distance(rssi)
+}
+
+// pathLossTable is the engine's read-only view of the active calibration.
+type pathLossTable struct {
+	version int64
+	def     PathLoss
+	beacons map[string]PathLoss
+}
+
+func newPathLossTable(cal model.PathLossCalibration) *pathLossTable {
+	t := &pathLossTable{
+		version: cal.Version,
+		def:     DefaultPathLoss,
+		beacons: make(map[string]PathLoss, len(cal.Beacons)),
+	}
+	if cal.Default.Exponent > 0 {
+		t.def = PathLoss{TxPower: cal.Default.TxPower, Exponent: cal.Default.Exponent}
+	}
+	for id, p := range cal.Beacons {
+		if p.Exponent > 0 {
+			t.beacons[id] = PathLoss{TxPower: p.TxPower, Exponent: p.Exponent}
+		}
+	}
+	return t
+}
+
+// apply stamps each observation with its beacon's model.
+func (t *pathLossTable) apply(observations []Observation) {
+	for i := range observations {
+		if m, ok := t.beacons[observations[i].BeaconID]; ok {
+			observations[i].Model = m
+		} else {
+			observations[i].Model = t.def
+		}
+	}
+}
+
+// FitPathLoss regresses RSSI on -10*log10(true distance). When the samples span too narrow a range
+// of distances to identify the exponent, the exponent falls back to fallback and only TxPower is fitted.
+func FitPathLoss(samples []model.CalibrationSample, fallback PathLoss) model.PathLossParams {
+	n := float64(len(samples))
+	if n == 0 {
+		return model.PathLossParams{TxPower: fallback.TxPower, Exponent: fallback.Exponent}
+	}
+
+	xs := make([]float64, len(samples))
+	var sumX, sumY float64
+	for i, s := range samples {
+		dx := s.TagLocation.X - s.BeaconLocation.X
+		dy := s.TagLocation.Y - s.BeaconLocation.Y
+		dz := s.TagLocation.Z - s.BeaconLocation.Z
+		d := math.Max(math.Sqrt(dx*dx+dy*dy+dz*dz), 0.1)
+		xs[i] = -10 * math.Log10(d)
+		sumX += xs[i]
+		sumY += float64(s.RSSI)
+	}
+	meanX, meanY := sumX/n, sumY/n
+
+	var sxx, sxy float64
+	for i, s := range samples {
+		dx := xs[i] - meanX
+		sxx += dx * dx
+		sxy += dx * (float64(s.RSSI) - meanY)
+	}
+
+	exponent := fallback.Exponent
+	// xs are in units of 10*log10(d), so the spread test is scaled to match.
+	if spread := math.Sqrt(sxx/n) / 10; spread >= minLogSpread {
+		exponent = math.Min(math.Max(sxy/sxx, minPathLossExponent), maxPathLossExponent)
+	}
+	txPower := meanY - exponent*meanX
+
+	var sse float64
+	for i, s := range samples {
+		r := float64(s.RSSI) - (txPower + exponent*xs[i])
+		sse += r * r
+	}
+
+	return model.PathLossParams{
+		TxPower:  txPower,
+		Exponent: exponent,
+		Samples:  len(samples),
+		RMSE:     math.Sqrt(sse / n),
+	}
+}
+
+// Calibrate fits a site-wide default and a per-beacon model for every beacon with at least
+// minSamples ground-truth samples; sparser beacons use the default.
+func Calibrate(samples []model.CalibrationSample, minSamples int) (model.PathLossCalibration, error) {
+	if minSamples < 2 {
+		minSamples = 2
+	}
+	if len(samples) < minSamples {
+		return model.PathLossCalibration{}, fmt.Errorf("need at least %d ground-truth samples, have %d", minSamples, len(samples))
+	}
+
+	byBeacon := make(map[string][]model.CalibrationSample)
+	for _, s := range samples {
+		byBeacon[s.BeaconID] = append(byBeacon[s.BeaconID], s)
+	}
+
+	def := FitPathLoss(samples, DefaultPathLoss)
+	fallback := PathLoss{TxPower: def.TxPower, Exponent: def.Exponent}
+
+	beacons := make(map[string]model.PathLossParams, len(byBeacon))
+	for id, group := range byBeacon {
+		if len(group) < minSamples {
+			continue
+		}
+		beacons[id] = FitPathLoss(group, fallback)
+	}
+
+	return model.PathLossCalibration{
+		CreatedAt: time.Now().UTC(),
+		Default:   def,
+		Beacons:   beacons,
+	}, nil
+}
@@ -0,0 +1,621 @@
+package localization
+
+import (
+	"math"
+	"runtime"
+	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	// radioMaxCells caps the fine grid; a finer step is coarsened until the grid fits.
+	radioMaxCells = 2 << 20
+	// radioCoarseCells is the target size of the coarse pass; its stride is derived from it.
+	radioCoarseCells = 4096
+	// radioCandidates is how many cells each level keeps for refinement.
+	radioCandidates = 6
+	// radioPosteriorCut drops fine cells whose negative log-likelihood exceeds the best by more than
+	// this from the posterior mean (their weight is below e^-12).
+	radioPosteriorCut = 12.0
+	// radioResidualCap caps each beacon's residual (in sigmas) so one reflected signal cannot veto a cell.
+	radioResidualCap = 3.0
+	// radioParallelWork is the cells x beacons product above which the coarse pass is split across slices.
+	radioParallelWork = 1 << 16
+)
+
+// radioGrid is a regular 3D lattice of cell centres.
+type radioGrid struct {
+	origin     [3]float64
+	step       float64
+	nx, ny, nz int
+}
+
+func (g radioGrid) cells() int {
+	return g.nx * g.ny * g.nz
+}
+
+func (g radioGrid) index(ix, iy, iz int) int {
+	return (iz*g.ny+iy)*g.nx + ix
+}
+
+func (g radioGrid) center(ix, iy, iz int) [3]float64 {
+	return [3]float64{
+		g.origin[0] + (float64(ix)+0.5)*g.step,
+		g.origin[1] + (float64(iy)+0.5)*g.step,
+		g.origin[2] + (float64(iz)+0.5)*g.step,
+	}
+}
+
+func (g radioGrid) contains(b Bounds) bool {
+	for i, n := range [3]int{g.nx, g.ny, g.nz} {
+		if b.Min[i] < g.origin[i] || b.Max[i] > g.origin[i]+float64(n)*g.step {
+			return false
+		}
+	}
+	return true
+}
+
+func newRadioGrid(b Bounds, step float64) radioGrid {
+	for {
+		g := radioGrid{step: step}
+		dims := [3]*int{&g.nx, &g.ny, &g.nz}
+		for i := 0; i < 3; i++ {
+			g.origin[i] = math.Floor(b.Min[i]/step) * step
+			*dims[i] = int(math.Ceil((b.Max[i]-g.origin[i])/step)) + 1
+		}
+		if g.cells() <= radioMaxCells {
+			return g
+		}
+		step *= 1.25
+	}
+}
+
+// radioLayer is one beacon's expected RSSI at every cell. Layers are immutable once built, apart
+// from seen, which solves bump so unused layers can be aged out.
+type radioLayer struct {
+	location model.Location
+	model    PathLoss
+	rssi     []float32
+	seen     atomic.Int64 // unix nanos of the last solve that used the layer
+}
+
+func buildRadioLayer(g radioGrid, loc model.Location, pl PathLoss) *radioLayer {
+	layer := &radioLayer{location: loc, model: pl, rssi: make([]float32, g.cells())}
+	parallelSlices(g.nz, func(lo, hi int) {
+		for iz := lo; iz < hi; iz++ {
+			for iy := 0; iy < g.ny; iy++ {
+				for ix := 0; ix < g.nx; ix++ {
+					c := g.center(ix, iy, iz)
+					dx, dy, dz := c[0]-loc.X, c[1]-loc.Y, c[2]-loc.Z
+					d := math.Max(math.Sqrt(dx*dx+dy*dy+dz*dz), 0.1)
+					layer.rssi[g.index(ix, iy, iz)] = float32(pl.Expected(d))
+				}
+			}
+		}
+	})
+	return layer
+}
+
+// parallelSlices runs fn over [0, n) split into one contiguous range per available CPU.
+func parallelSlices(n int, fn func(lo, hi int)) {
+	workers := runtime.GOMAXPROCS(0)
+	if workers > n {
+		workers = n
+	}
+	if workers <= 1 {
+		fn(0, n)
+		return
+	}
+	chunk := (n + workers - 1) / workers
+	var wg sync.WaitGroup
+	for lo := 0; lo < n; lo += chunk {
+		wg.Add(1)
+		go func(lo, hi int) {
+			defer wg.Done()
+			fn(lo, hi)
+		}(lo, min(lo+chunk, n))
+	}
+	wg.Wait()
+}
+
+// radioSnapshot is an immutable grid plus its layers; readers never lock.
+type radioSnapshot struct {
+	grid   radioGrid
+	stride int
+	layers map[string]*radioLayer
+	built  int64 // unix nanos
+}
+
+// radioBeacon is what a layer is computed from.
+type radioBeacon struct {
+	loc model.Location
+	pl  PathLoss
+}
+
+// RadioMap is a precomputed 3D grid of expected RSSI per beacon, derived from the calibrated
+// path-loss model. Localization scores grid cells by likelihood instead of iterating a solver, so it
+// has no local minima and still answers with only two beacons. Layers are rebuilt individually when
+// a beacon moves or its calibration changes, and dropped once no solve has used them for maxAge; the
+// grid is rebuilt when its extent has to grow or can shrink back to the configured step.
+//
+// Rebuilds run on a background goroutine that publishes a new snapshot. Solves keep scoring against
+// the previous snapshot until then, skipping beacons it has no layer for.
+type RadioMap struct {
+	step   float64
+	maxAge time.Duration
+
+	mu       sync.Mutex // guards the rebuild requests below
+	idle     *sync.Cond // broadcast when the rebuild goroutine exits
+	rooms    []model.RoomDefinition
+	pending  map[string]radioBeacon // beacons solves saw that the snapshot lacks or has outdated
+	dirty    bool                   // rooms changed or layers are due to age out
+	building bool
+
+	snap atomic.Pointer[radioSnapshot]
+
+	rebuilds atomic.Uint64 // layers built, for diagnostics
+}
+
+// NewRadioMap returns an empty map with the given cell size in metres. Beacon layers unused for
+// maxAge (30s when <= 0) are dropped.
+func NewRadioMap(step float64, maxAge time.Duration) *RadioMap {
+	if maxAge <= 0 {
+		maxAge = 30 * time.Second
+	}
+	m := &RadioMap{step: step, maxAge: maxAge}
+	m.idle = sync.NewCond(&m.mu)
+	return m
+}
+
+// SetRooms widens the grid to cover the room geometry.
+func (m *RadioMap) SetRooms(rooms []model.RoomDefinition) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	m.rooms = append([]model.RoomDefinition(nil), rooms...)
+	if m.snap.Load() != nil {
+		m.dirty = true
+		m.startLocked()
+	}
+}
+
+// Cells reports the fine grid size and number of beacon layers.
+func (m *RadioMap) Cells() (cells, layers int) {
+	snap := m.snap.Load()
+	if snap == nil {
+		return 0, 0
+	}
+	return snap.grid.cells(), len(snap.layers)
+}
+
+// LayerBuilds reports how many beacon layers have been computed since start.
+func (m *RadioMap) LayerBuilds() uint64 {
+	return m.rebuilds.Load()
+}
+
+// Wait blocks until no rebuild is scheduled or running, e.g. to warm the map before timing solves.
+func (m *RadioMap) Wait() {
+	m.mu.Lock()
+	for m.building {
+		m.idle.Wait()
+	}
+	m.mu.Unlock()
+}
+
+// sync returns the snapshot to score against. When it lacks a current layer for an observed beacon,
+// or its layers are due to age out, a background rebuild is scheduled.
+func (m *RadioMap) sync(observations []Observation, now int64) *radioSnapshot {
+	snap := m.snap.Load()
+	expired := snap != nil && now-snap.built >= int64(m.maxAge)
+	if snap != nil && !expired && snap.current(observations) {
+		return snap
+	}
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	for i := range observations {
+		o := &observations[i]
+		if snap != nil {
+			if layer, ok := snap.layers[o.BeaconID]; ok && layer.location == o.Location && layer.model == o.pathLoss() {
+				continue
+			}
+		}
+		if m.pending == nil {
+			m.pending = make(map[string]radioBeacon)
+		}
+		m.pending[o.BeaconID] = radioBeacon{o.Location, o.pathLoss()}
+	}
+	if expired {
+		m.dirty = true
+	}
+	m.startLocked()
+	return snap
+}
+
+func (s *radioSnapshot) current(observations []Observation) bool {
+	for i := range observations {
+		o := &observations[i]
+		layer, ok := s.layers[o.BeaconID]
+		if !ok || layer.location != o.Location || layer.model != o.pathLoss() {
+			return false
+		}
+	}
+	return true
+}
+
+// startLocked launches the rebuild goroutine if there is work and it is not already running.
+func (m *RadioMap) startLocked() {
+	if m.building || (len(m.pending) == 0 && !m.dirty) {
+		return
+	}
+	m.building = true
+	go m.rebuildLoop()
+}
+
+// rebuildLoop publishes snapshots until no rebuild request is outstanding.
+func (m *RadioMap) rebuildLoop() {
+	m.mu.Lock()
+	for len(m.pending) > 0 || m.dirty {
+		pending, rooms := m.pending, m.rooms
+		m.pending, m.dirty = nil, false
+		m.mu.Unlock()
+		m.snap.Store(m.rebuild(m.snap.Load(), pending, rooms, time.Now().UnixNano()))
+		m.mu.Lock()
+	}
+	m.building = false
+	m.idle.Broadcast()
+	m.mu.Unlock()
+}
+
+// rebuild derives the next snapshot from prev. Layers no solve has used for maxAge are dropped, and
+// only layers whose beacon is new, moved or was recalibrated are computed, unless the grid changes.
+func (m *RadioMap) rebuild(prev *radioSnapshot, pending map[string]radioBeacon, rooms []model.RoomDefinition, now int64) *radioSnapshot {
+	beacons := make(map[string]radioBeacon, len(pending))
+	if prev != nil {
+		for id, layer := range prev.layers {
+			if now-layer.seen.Load() < int64(m.maxAge) {
+				beacons[id] = radioBeacon{layer.location, layer.model}
+			}
+		}
+	}
+	for id, b := range pending {
+		beacons[id] = b
+	}
+	if len(beacons) == 0 && len(rooms) == 0 {
+		return nil
+	}
+
+	anchors := make([]Observation, 0, len(beacons))
+	for _, b := range beacons {
+		anchors = append(anchors, Observation{Location: b.loc})
+	}
+	bounds := GeometryBounds(anchors, rooms)
+
+	next := &radioSnapshot{layers: make(map[string]*radioLayer, len(beacons)), built: now}
+	grid := newRadioGrid(bounds, m.step)
+	// Keep the lattice while it covers the geometry at no coarser a step than a fresh one would use;
+	// once a far-off beacon ages out, this lets the grid return to its finer step.
+	if prev != nil && prev.grid.contains(bounds) && prev.grid.step <= grid.step {
+		next.grid, next.stride = prev.grid, prev.stride
+	} else {
+		next.grid = grid
+		next.stride = int(math.Max(1, math.Round(math.Cbrt(float64(grid.cells())/radioCoarseCells))))
+		prev = nil // every layer must be rebuilt on the new lattice
+	}
+
+	for id, b := range beacons {
+		if prev != nil {
+			if layer, ok := prev.layers[id]; ok && layer.location == b.loc && layer.model == b.pl {
+				next.layers[id] = layer
+				continue
+			}
+		}
+		layer := buildRadioLayer(next.grid, b.loc, b.pl)
+		layer.seen.Store(now)
+		next.layers[id] = layer
+		m.rebuilds.Add(1)
+	}
+	return next
+}
+
+// RadioScratch holds per-caller buffers for Locate; each engine worker owns one.
+type RadioScratch struct {
+	terms   []radioTerm
+	stamp   []uint32
+	gen     uint32
+	scored  []radioCell
+	buckets [][]radioCell
+}
+
+type radioTerm struct {
+	rssi   []float32
+	value  float32
+	weight float32 // samples / (2 sigma^2)
+	cap    float32 // weight * capped residual^2
+	obs    *Observation
+}
+
+type radioCell struct {
+	index int
+	nll   float32
+}
+
+// Locate scores the grid against the observations: a strided coarse pass (split across z slices when
+// large) keeps the best few cells, which are refined level by level at half the stride until the
+// neighbourhood of each is scored at full resolution. Beacons
+// are scored strongest first and a cell is abandoned as soon as its partial cost cannot beat the
+// cells already kept, since every term is non-negative. The result is the posterior mean over the
+// refined cells.
+func (m *RadioMap) Locate(observations []Observation, scratch *RadioScratch) Estimate {
+	if len(observations) < 2 {
+		return Estimate{BeaconCount: len(observations), Message: "At least two beacons required"}
+	}
+	now := time.Now().UnixNano()
+	snap := m.sync(observations, now)
+	if snap == nil {
+		return Estimate{BeaconCount: len(observations), Message: "Radio map is being built"}
+	}
+	g := snap.grid
+
+	scratch.terms = scratch.terms[:0]
+	for i := range observations {
+		o := &observations[i]
+		layer, ok := snap.layers[o.BeaconID]
+		if !ok {
+			continue // its layer is still being built
+		}
+		if now-layer.seen.Load() >= int64(m.maxAge)/4 {
+			layer.seen.Store(now) // coarse, so solves rarely write the shared layer
+		}
+		samples := o.weight()
+		w := float32(samples / (2 * rssiNoiseDB * rssiNoiseDB))
+		scratch.terms = append(scratch.terms, radioTerm{
+			rssi:   layer.rssi,
+			value:  float32(o.RSSI),
+			weight: w,
+			cap:    w * float32(radioResidualCap*radioResidualCap*rssiNoiseDB*rssiNoiseDB/samples),
+			obs:    o,
+		})
+	}
+	if len(scratch.terms) < 2 {
+		return Estimate{BeaconCount: len(observations), Message: "Radio map is being built"}
+	}
+	// Near beacons vary fastest across the grid, so they reject cells earliest.
+	sort.Slice(scratch.terms, func(i, j int) bool { return scratch.terms[i].value > scratch.terms[j].value })
+	terms := scratch.terms
+
+	// Coarse pass.
+	s := snap.stride
+	coarseZ := (g.nz + s - 1) / s
+	workers := 1
+	if coarse := g.cells() / (s * s * s); coarse*len(terms) >= radioParallelWork {
+		workers = min(runtime.GOMAXPROCS(0), coarseZ)
+	}
+	if cap(scratch.buckets) < workers {
+		scratch.buckets = make([][]radioCell, workers)
+	}
+	buckets := scratch.buckets[:workers]
+	chunk := (coarseZ + workers - 1) / workers
+	coarsePass := func(w int) {
+		top := buckets[w][:0]
+		for cz := w * chunk; cz < min((w+1)*chunk, coarseZ); cz++ {
+			iz := cz * s
+			for iy := 0; iy < g.ny; iy += s {
+				for ix := 0; ix < g.nx; ix += s {
+					limit := float32(math.MaxFloat32)
+					if len(top) == radioCandidates {
+						limit = top[len(top)-1].nll
+					}
+					idx := g.index(ix, iy, iz)
+					if nll, ok := cellCost(terms, idx, limit); ok {
+						top = keepBest(top, radioCell{idx, nll})
+					}
+				}
+			}
+		}
+		buckets[w] = top
+	}
+	if workers == 1 {
+		coarsePass(0)
+	} else {
+		var wg sync.WaitGroup
+		for w := 0; w < workers; w++ {
+			wg.Add(1)
+			go func(w int) {
+				defer wg.Done()
+				coarsePass(w)
+			}(w)
+		}
+		wg.Wait()
+	}
+	var seeds [radioCandidates]radioCell
+	top := seeds[:0]
+	for _, bucket := range buckets {
+		for _, c := range bucket {
+			top = keepBest(top, c)
+		}
+	}
+	if len(top) == 0 {
+		return Estimate{BeaconCount: len(terms), Message: "Radio map has no cells"}
+	}
+
+	if len(scratch.stamp) != g.cells() {
+		scratch.stamp = make([]uint32, g.cells())
+		scratch.gen = 0
+	}
+
+	// Refine by halving the stride, searching +-stride around the kept cells at each level.
+	var refined [radioCandidates]radioCell
+	for s > 2 {
+		half := (s + 1) / 2
+		scratch.nextGeneration()
+		next := refined[:0]
+		for _, seed := range top {
+			scratch.visit(g, seed.index, s, half, func(idx int) {
+				limit := float32(math.MaxFloat32)
+				if len(next) == radioCandidates {
+					limit = next[len(next)-1].nll
+				}
+				if nll, ok := cellCost(terms, idx, limit); ok {
+					next = keepBest(next, radioCell{idx, nll})
+				}
+			})
+		}
+		top = append(seeds[:0], next...)
+		s = half
+	}
+
+	// Final level: every cell near a candidate, scored for the posterior.
+	scratch.nextGeneration()
+	scored := scratch.scored[:0]
+	best := top[0].nll
+	for _, seed := range top {
+		scratch.visit(g, seed.index, max(s, 2), 1, func(idx int) {
+			if nll, ok := cellCost(terms, idx, best+radioPosteriorCut); ok {
+				scored = append(scored, radioCell{idx, nll})
+				if nll < best {
+					best = nll
+				}
+			}
+		})
+	}
+	scratch.scored = scored
+
+	// Posterior mean and spread over the refined cells.
+	var mean [3]float64
+	var total float64
+	bestNLL := float64(best)
+	bestIdx := top[0].index
+	for _, c := range scored {
+		if float64(c.nll) > bestNLL+radioPosteriorCut {
+			continue
+		}
+		if c.nll == best {
+			bestIdx = c.index
+		}
+		w := math.Exp(bestNLL - float64(c.nll))
+		p := g.center(c.index%g.nx, (c.index/g.nx)%g.ny, c.index/(g.nx*g.ny))
+		for i := 0; i < 3; i++ {
+			mean[i] += w * p[i]
+		}
+		total += w
+	}
+	for i := 0; i < 3; i++ {
+		mean[i] /= total
+	}
+	var variance float64
+	for _, c := range scored {
+		if float64(c.nll) > bestNLL+radioPosteriorCut {
+			continue
+		}
+		w := math.Exp(bestNLL - float64(c.nll))
+		p := g.center(c.index%g.nx, (c.index/g.nx)%g.ny, c.index/(g.nx*g.ny))
+		for i := 0; i < 3; i++ {
+			d := p[i] - mean[i]
+			variance += w * d * d
+		}
+	}
+	// Add the quantisation variance of a uniform cell so a peaked posterior is not overconfident.
+	variance = variance/total + 3*g.step*g.step/12
+	uncertainty := math.Sqrt(variance)
+
+	var sumSq float64
+	outliers := 0
+	for i := range terms {
+		o := terms[i].obs
+		pl := o.pathLoss()
+		dx, dy, dz := mean[0]-o.Location.X, mean[1]-o.Location.Y, mean[2]-o.Location.Z
+		r := math.Sqrt(dx*dx+dy*dy+dz*dz) - pl.Distance(o.RSSI)
+		sumSq += r * r
+		if diff := float64(terms[i].value - terms[i].rssi[bestIdx]); diff*diff*float64(terms[i].weight) > 0.5*huberK*huberK {
+			outliers++
+		}
+	}
+
+	return Estimate{
+		Location:    model.Location{X: mean[0], Y: mean[1], Z: mean[2]},
+		Confidence:  math.Exp(-uncertainty / confidenceScale),
+		Residual:    math.Sqrt(sumSq / float64(len(terms))),
+		Uncertainty: uncertainty,
+		BeaconCount: len(terms),
+		Outliers:    outliers,
+		Message:     "Radio-map grid likelihood",
+		Valid:       true,
+	}
+}
+
+func (s *RadioScratch) nextGeneration() {
+	s.gen++
+	if s.gen == 0 {
+		clear(s.stamp)
+		s.gen = 1
+	}
+}
+
+// visit calls fn for each cell not yet seen this generation on a lattice of the given step within
+// radius cells of centre.
+func (s *RadioScratch) visit(g radioGrid, centre, radius, step int, fn func(idx int)) {
+	cx := centre % g.nx
+	cy := (centre / g.nx) % g.ny
+	cz := centre / (g.nx * g.ny)
+	for dz := -radius; dz <= radius; dz += step {
+		iz := cz + dz
+		if iz < 0 || iz >= g.nz {
+			continue
+		}
+		for dy := -radius; dy <= radius; dy += step {
+			iy := cy + dy
+			if iy < 0 || iy >= g.ny {
+				continue
+			}
+			for dx := -radius; dx <= radius; dx += step {
+				ix := cx + dx
+				if ix < 0 || ix >= g.nx {
+					continue
+				}
+				idx := g.index(ix, iy, iz)
+				if s.stamp[idx] == s.gen {
+					continue
+				}
+				s.stamp[idx] = s.gen
+				fn(idx)
+			}
+		}
+	}
+}
+
+// cellCost is the robust negative log-likelihood of cell idx, or false once it exceeds limit.
+func cellCost(terms []radioTerm, idx int, limit float32) (float32, bool) {
+	var nll float32
+	for i := range terms {
+		t := &terms[i]
+		d := t.value - t.rssi[idx]
+		c := t.weight * d * d
+		if c > t.cap {
+			c = t.cap
+		}
+		nll += c
+		if nll >= limit {
+			return 0, false
+		}
+	}
+	return nll, true
+}
+
+// keepBest inserts c into top (sorted ascending, at most radioCandidates long).
+func keepBest(top []radioCell, c radioCell) []radioCell {
+	if len(top) == radioCandidates {
+		if c.nll >= top[len(top)-1].nll {
+			return top
+		}
+		top[len(top)-1] = c
+	} else {
+		top = append(top, c)
+	}
+	for i := len(top) - 1; i > 0 && top[i].nll < top[i-1].nll; i-- {
+		top[i], top[i-1] = top[i-1], top[i]
+	}
+	return top
+}
@@ -0,0 +1,255 @@
+package localization
+
+import (
+	"fmt"
+	"math"
+	"sort"
+	"strings"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// minSampleWeight keeps a beacon whose only sample has decayed away from vanishing from the fit.
+const minSampleWeight = 0.05
+
+// ResampleMode selects how a beacon's RSSI is read off its samples at a grid instant.
+type ResampleMode int
+
+const (
+	// ResampleHold uses the samples at or before the instant, each weighted by its decay.
+	ResampleHold ResampleMode = iota
+	// ResampleLinear interpolates between the samples either side of the instant and holds the newest
+	// sample, with its decayed weight, at the live edge where no later sample exists yet.
+	ResampleLinear
+)
+
+// ParseResampleMode accepts "hold" or "linear".
+func ParseResampleMode(s string) (ResampleMode, error) {
+	switch strings.ToLower(strings.TrimSpace(s)) {
+	case "", "hold":
+		return ResampleHold, nil
+	case "linear":
+		return ResampleLinear, nil
+	default:
+		return 0, fmt.Errorf("unknown resample mode %q (want hold or linear)", s)
+	}
+}
+
+func (m ResampleMode) String() string {
+	if m == ResampleLinear {
+		return "linear"
+	}
+	return "hold"
+}
+
+// ResampleConfig aligns per-beacon RSSI streams onto common instants before fusion.
+type ResampleConfig struct {
+	MaxAge   time.Duration // samples older than this at the instant are ignored; 0 means the tracker window
+	HalfLife time.Duration // each sample's weight halves per half-life of age; 0 weighs the window equally
+	Mode     ResampleMode
+	Step     time.Duration // grid spacing for the streaming Resampler; the live engine resamples at each solve
+}
+
+// resampled is one beacon's value at an instant: RSSI plus the decay-weighted sample count backing it.
+type resampled struct {
+	rssi   float64
+	weight float64
+	n      int
+}
+
+// valueAt reads the series at t (Unix nanos) using the samples' At timestamps.
+func (s *beaconSeries) valueAt(t int64, cfg *ResampleConfig, maxAge int64) (resampled, bool) {
+	cutoff := t - maxAge
+	var (
+		sum, wsum float64
+		n         int
+		before    Sample
+		after     Sample
+		hasAfter  bool
+	)
+	start := (s.head - s.n + seriesCapacity) % seriesCapacity
+	for i := 0; i < s.n; i++ {
+		sample := s.samples[(start+i)%seriesCapacity]
+		if sample.At < cutoff {
+			continue
+		}
+		if sample.At > t {
+			if !hasAfter && sample.At-t <= maxAge {
+				after, hasAfter = sample, true
+			}
+			continue
+		}
+		w := 1.0
+		if cfg.HalfLife > 0 {
+			w = math.Exp2(-float64(t-sample.At) / float64(cfg.HalfLife))
+		}
+		sum += w * sample.RSSI
+		wsum += w
+		n++
+		before = sample
+	}
+	if n == 0 {
+		return resampled{}, false
+	}
+	out := resampled{rssi: sum / wsum, weight: math.Max(wsum, minSampleWeight), n: n}
+	if cfg.Mode == ResampleLinear {
+		switch {
+		case hasAfter && after.At > before.At:
+			frac := float64(t-before.At) / float64(after.At-before.At)
+			out.rssi = before.RSSI + frac*(after.RSSI-before.RSSI)
+			out.weight = 1
+		default:
+			out.rssi = before.RSSI
+			out.weight = 1
+			if cfg.HalfLife > 0 {
+				out.weight = math.Max(math.Exp2(-float64(t-before.At)/float64(cfg.HalfLife)), minSampleWeight)
+			}
+		}
+	}
+	return out, true
+}
+
+// ResampledReading is one (tag, beacon) stream's value at a grid instant.
+type ResampledReading struct {
+	At       time.Time
+	TagID    string
+	BeaconID string
+	Location model.Location
+	RSSI     float64
+	Weight   float64 // decay-weighted sample count
+	Samples  int
+}
+
+type resampleKey struct {
+	tagID, beaconID string
+}
+
+// Resampler is a streaming operator that aligns time-ordered readings from many (tag, beacon) streams
+// onto a common grid of Step-spaced instants, using the same per-beacon evaluation as the live engine.
+// Feed readings in time order with Push; every grid instant that can no longer change is emitted.
+type Resampler struct {
+	cfg    ResampleConfig
+	maxAge int64
+	lag    int64 // how far the stream must run past an instant before it is final
+
+	streams map[resampleKey]*beaconSeries
+	keys    []resampleKey // sorted, for deterministic output
+	next    int64         // next grid instant, 0 before the first reading
+	clock   int64         // newest sample time pushed
+}
+
+// NewResampler returns an operator for cfg. Step and MaxAge must be positive.
+func NewResampler(cfg ResampleConfig) (*Resampler, error) {
+	if cfg.Step <= 0 || cfg.MaxAge <= 0 {
+		return nil, fmt.Errorf("resample step and max age must be positive")
+	}
+	r := &Resampler{cfg: cfg, maxAge: int64(cfg.MaxAge), streams: make(map[resampleKey]*beaconSeries)}
+	if cfg.Mode == ResampleLinear {
+		r.lag = r.maxAge
+	}
+	return r, nil
+}
+
+// Push adds one reading observed at at and emits the grid instants it completes.
+func (r *Resampler) Push(reading model.BeaconReading, at time.Time, emit func(ResampledReading) error) error {
+	t := at.UnixNano()
+	if err := r.advance(t, emit); err != nil {
+		return err
+	}
+	if r.next == 0 {
+		r.next = r.align(t)
+	}
+
+	key := resampleKey{reading.TagID, reading.BeaconID}
+	series, ok := r.streams[key]
+	if !ok {
+		series = &beaconSeries{}
+		r.streams[key] = series
+		i := sort.Search(len(r.keys), func(i int) bool { return !keyLess(r.keys[i], key) })
+		r.keys = append(r.keys, resampleKey{})
+		copy(r.keys[i+1:], r.keys[i:])
+		r.keys[i] = key
+	}
+	series.location = reading.BeaconLocation
+	series.push(Sample{At: t, Captured: t, RSSI: float64(reading.RSSI)})
+	r.clock = max(r.clock, t)
+	return nil
+}
+
+// Flush emits the instants still pending up to the newest reading.
+func (r *Resampler) Flush(emit func(ResampledReading) error) error {
+	if r.next == 0 {
+		return nil
+	}
+	return r.advance(r.clock+r.lag+1, emit)
+}
+
+// advance emits every grid instant t with t+lag < now: readings arrive in time order, so nothing
+// pushed later can change them. Streams that can no longer contribute are dropped, and a gap with no
+// live streams skips straight to the next reading's instant.
+func (r *Resampler) advance(now int64, emit func(ResampledReading) error) error {
+	if r.next == 0 {
+		return nil
+	}
+	for r.next+r.lag < now {
+		if err := r.emit(r.next, emit); err != nil {
+			return err
+		}
+		r.next += int64(r.cfg.Step)
+		if r.evict(r.next) && now-r.lag > r.next {
+			r.next = r.align(now - r.lag)
+		}
+	}
+	return nil
+}
+
+func (r *Resampler) emit(t int64, emit func(ResampledReading) error) error {
+	at := time.Unix(0, t).UTC()
+	for _, key := range r.keys {
+		series := r.streams[key]
+		v, ok := series.valueAt(t, &r.cfg, r.maxAge)
+		if !ok {
+			continue
+		}
+		if err := emit(ResampledReading{
+			At:       at,
+			TagID:    key.tagID,
+			BeaconID: key.beaconID,
+			Location: series.location,
+			RSSI:     v.rssi,
+			Weight:   v.weight,
+			Samples:  v.n,
+		}); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// evict removes streams whose newest sample is too old to be read at t and reports whether none remain.
+func (r *Resampler) evict(t int64) bool {
+	kept := r.keys[:0]
+	for _, key := range r.keys {
+		series := r.streams[key]
+		if latest, ok := series.latest(); ok && latest.At >= t-r.maxAge {
+			kept = append(kept, key)
+			continue
+		}
+		delete(r.streams, key)
+	}
+	r.keys = kept
+	return len(r.keys) == 0
+}
+
+func (r *Resampler) align(t int64) int64 {
+	step := int64(r.cfg.Step)
+	return (t + step - 1) / step * step
+}
+
+func keyLess(a, b resampleKey) bool {
+	if a.tagID != b.tagID {
+		return a.tagID < b.tagID
+	}
+	return a.beaconID < b.beaconID
+}
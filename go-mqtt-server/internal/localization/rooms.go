@@ -0,0 +1,367 @@
+package localization
+
+import (
+	"math"
+	"sort"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	// roomCellSize is the floor-plan raster resolution (metres); it doubles until a floor fits roomMaxCells.
+	roomCellSize = 0.1
+	roomMaxCells = 1 << 21
+	// roomMatchLimit caps the ranked room list attached to each position.
+	roomMatchLimit = 5
+	// roomNearCell is the size (metres) of the coarse cells that precompute which rooms can rank.
+	roomNearCell = 1.0
+)
+
+// RoomIndex maps positions to rooms. Outline rooms are grouped into floors by their elevation band
+// and each floor's outlines are rasterized once into a grid of room ids, so finding the outline
+// containing a point is a single array read. Sphere rooms keep their 3D distance test. An index is
+// immutable; SetRooms builds a new one.
+type RoomIndex struct {
+	rooms   []model.RoomDefinition
+	names   []string     // distinct room names in definition order
+	boxes   [][4]float64 // plan footprint boxes, for pruning distance checks
+	floors  []roomFloor
+	spheres []int32 // sphere rooms, checked by 3D distance on every lookup
+}
+
+type roomFloor struct {
+	floor      int
+	zMin, zMax float64 // elevation band spanned by the floor's rooms, used to pick the floor for a position
+	members    []int32 // outline rooms, as indices into RoomIndex.rooms
+
+	minX, minY float64
+	cell       float64
+	nx, ny     int
+	cells      []int16 // room index + 1, or 0 outside every room
+
+	// Coarse grid over the same origin: the only rooms that can be among the nearest roomMatchLimit
+	// for any point in the cell. Points off the grid fall back to every member.
+	near       [][]int32
+	nnx, nny   int
+	nearStride float64
+}
+
+// NewRoomIndex rasterizes outline rooms per floor. Where rooms overlap the smaller one wins, so a
+// closet drawn inside a bedroom keeps its own cells. Outline rooms without an elevation band cannot
+// be placed on a floor and are left out of the index; the rooms API rejects them.
+func NewRoomIndex(rooms []model.RoomDefinition) *RoomIndex {
+	idx := &RoomIndex{rooms: append([]model.RoomDefinition(nil), rooms...)}
+
+	byFloor := make(map[int][]int32)
+	idx.boxes = make([][4]float64, len(idx.rooms))
+	seen := make(map[string]bool, len(idx.rooms))
+	for i := range idx.rooms {
+		r := &idx.rooms[i]
+		if !seen[r.Name] {
+			seen[r.Name] = true
+			idx.names = append(idx.names, r.Name)
+		}
+		x0, y0, x1, y1 := roomFootprint(r)
+		idx.boxes[i] = [4]float64{x0, y0, x1, y1}
+		switch {
+		case len(r.Polygon) < 3:
+			idx.spheres = append(idx.spheres, int32(i))
+		case r.ZMax > r.ZMin:
+			byFloor[r.Floor] = append(byFloor[r.Floor], int32(i))
+		}
+	}
+	for floor, members := range byFloor {
+		idx.floors = append(idx.floors, idx.buildFloor(floor, members))
+	}
+	sort.Slice(idx.floors, func(i, j int) bool { return idx.floors[i].floor < idx.floors[j].floor })
+	return idx
+}
+
+func (idx *RoomIndex) buildFloor(floor int, members []int32) roomFloor {
+	f := roomFloor{floor: floor, members: members, cell: roomCellSize, zMin: math.Inf(1), zMax: math.Inf(-1)}
+
+	minX, minY := math.Inf(1), math.Inf(1)
+	maxX, maxY := math.Inf(-1), math.Inf(-1)
+	for _, i := range members {
+		f.zMin, f.zMax = math.Min(f.zMin, idx.rooms[i].ZMin), math.Max(f.zMax, idx.rooms[i].ZMax)
+		b := idx.boxes[i]
+		minX, minY = math.Min(minX, b[0]), math.Min(minY, b[1])
+		maxX, maxY = math.Max(maxX, b[2]), math.Max(maxY, b[3])
+	}
+	if !(maxX > minX && maxY > minY) {
+		return f
+	}
+
+	for {
+		f.nx = int(math.Ceil((maxX-minX)/f.cell)) + 1
+		f.ny = int(math.Ceil((maxY-minY)/f.cell)) + 1
+		if f.nx*f.ny <= roomMaxCells {
+			break
+		}
+		f.cell *= 2
+	}
+	f.minX, f.minY = minX, minY
+	f.cells = make([]int16, f.nx*f.ny)
+
+	order := append([]int32(nil), members...)
+	sort.SliceStable(order, func(a, b int) bool {
+		return roomArea(&idx.rooms[order[a]]) > roomArea(&idx.rooms[order[b]])
+	})
+	var crossings []float64
+	for _, i := range order {
+		r := &idx.rooms[i]
+		id := int16(i + 1)
+		for row := 0; row < f.ny; row++ {
+			y := f.minY + (float64(row)+0.5)*f.cell
+			crossings = scanline(r, y, crossings[:0])
+			for k := 0; k+1 < len(crossings); k += 2 {
+				c0 := max(0, int(math.Ceil((crossings[k]-f.minX)/f.cell-0.5)))
+				c1 := min(f.nx-1, int(math.Floor((crossings[k+1]-f.minX)/f.cell-0.5)))
+				for c := c0; c <= c1; c++ {
+					f.cells[row*f.nx+c] = id
+				}
+			}
+		}
+	}
+	idx.buildNear(&f, maxX, maxY)
+	return f
+}
+
+// buildNear keeps, per coarse cell, the rooms whose distance lower bound over the cell does not
+// exceed the roomMatchLimit-th smallest upper bound. Distances are 1-Lipschitz, so a room's upper
+// bound is its distance from the cell centre plus the half diagonal.
+func (idx *RoomIndex) buildNear(f *roomFloor, maxX, maxY float64) {
+	f.nearStride = math.Max(roomNearCell, f.cell)
+	f.nnx = int(math.Ceil((maxX-f.minX)/f.nearStride)) + 1
+	f.nny = int(math.Ceil((maxY-f.minY)/f.nearStride)) + 1
+	f.near = make([][]int32, f.nnx*f.nny)
+	if len(f.members) <= roomMatchLimit {
+		for i := range f.near {
+			f.near[i] = f.members
+		}
+		return
+	}
+
+	halfDiag := f.nearStride * math.Sqrt2 / 2
+	upper := make([]float64, len(f.members))
+	sorted := make([]float64, len(f.members))
+	for row := 0; row < f.nny; row++ {
+		for col := 0; col < f.nnx; col++ {
+			x0 := f.minX + float64(col)*f.nearStride
+			y0 := f.minY + float64(row)*f.nearStride
+			centre := model.Location{X: x0 + f.nearStride/2, Y: y0 + f.nearStride/2}
+			for k, i := range f.members {
+				upper[k] = idx.planDistance(int(i), centre) + halfDiag
+			}
+			copy(sorted, upper)
+			sort.Float64s(sorted)
+			bound := sorted[roomMatchLimit-1]
+
+			var cand []int32
+			for _, i := range f.members {
+				if idx.cellDistance(int(i), x0, y0, x0+f.nearStride, y0+f.nearStride) <= bound {
+					cand = append(cand, i)
+				}
+			}
+			f.near[row*f.nnx+col] = cand
+		}
+	}
+}
+
+// Rooms returns the definitions the index was built from.
+func (idx *RoomIndex) Rooms() []model.RoomDefinition {
+	return idx.rooms
+}
+
+// floorFor picks the floor whose elevation band contains z, or the nearest band when z is outside
+// all of them, so a fix that drifts below the ground floor still lands on it. Where bands overlap
+// the lower floor wins.
+func (idx *RoomIndex) floorFor(z float64) *roomFloor {
+	var best *roomFloor
+	bestGap := math.Inf(1)
+	for i := range idx.floors {
+		f := &idx.floors[i]
+		if gap := math.Max(0, math.Max(f.zMin-z, z-f.zMax)); gap < bestGap {
+			best, bestGap = f, gap
+		}
+	}
+	return best
+}
+
+// lookup returns the floor for loc and the index of the room containing it, or -1: the outline
+// under loc on that floor, or a sphere around it, whichever is smaller.
+func (idx *RoomIndex) lookup(loc model.Location) (*roomFloor, int) {
+	f := idx.floorFor(loc.Z)
+	inside := -1
+	if f != nil && f.cells != nil {
+		c := int(math.Floor((loc.X - f.minX) / f.cell))
+		r := int(math.Floor((loc.Y - f.minY) / f.cell))
+		if c >= 0 && r >= 0 && c < f.nx && r < f.ny {
+			inside = int(f.cells[r*f.nx+c]) - 1
+		}
+	}
+	for _, i := range idx.spheres {
+		r := &idx.rooms[i]
+		if sphereDistance(r, loc) <= r.Radius && (inside < 0 || roomArea(r) < roomArea(&idx.rooms[inside])) {
+			inside = int(i)
+		}
+	}
+	return f, inside
+}
+
+// Room returns the name of the room containing loc.
+func (idx *RoomIndex) Room(loc model.Location) (string, bool) {
+	if _, i := idx.lookup(loc); i >= 0 {
+		return idx.rooms[i].Name, true
+	}
+	return "", false
+}
+
+// Match lists the room containing loc first, then the nearest other outline rooms on the same floor
+// and sphere rooms, up to roomMatchLimit. Distance to an outline room is in plan; to a sphere room it
+// is the 3D distance to its anchor.
+func (idx *RoomIndex) Match(loc model.Location) []RoomMatch {
+	f, inside := idx.lookup(loc)
+	var candidates []int32
+	if f != nil {
+		candidates = f.members
+		if col, row := int(math.Floor((loc.X-f.minX)/f.nearStride)), int(math.Floor((loc.Y-f.minY)/f.nearStride)); f.near != nil &&
+			col >= 0 && row >= 0 && col < f.nnx && row < f.nny {
+			candidates = f.near[row*f.nnx+col]
+		}
+	}
+	if len(candidates) == 0 && len(idx.spheres) == 0 {
+		return nil
+	}
+	matches := make([]RoomMatch, 0, min(len(candidates)+len(idx.spheres), roomMatchLimit))
+	if inside >= 0 {
+		matches = append(matches, idx.roomMatch(inside, loc, true))
+	}
+	for _, i := range candidates {
+		matches = idx.rank(matches, int(i), inside, loc)
+	}
+	for _, i := range idx.spheres {
+		matches = idx.rank(matches, int(i), inside, loc)
+	}
+	return matches
+}
+
+// rank inserts room i into matches, a partial insertion sort that keeps only the closest few instead
+// of ranking every candidate.
+func (idx *RoomIndex) rank(matches []RoomMatch, i, inside int, loc model.Location) []RoomMatch {
+	if i == inside {
+		return matches
+	}
+	full := len(matches) == roomMatchLimit
+	if full && len(idx.rooms[i].Polygon) >= 3 && idx.cellDistance(i, loc.X, loc.Y, loc.X, loc.Y) >= matches[len(matches)-1].Distance {
+		return matches
+	}
+	m := idx.roomMatch(i, loc, false)
+	if full {
+		if m.Distance >= matches[len(matches)-1].Distance {
+			return matches
+		}
+		matches = matches[:len(matches)-1]
+	}
+	pos := len(matches)
+	for pos > 0 && !matches[pos-1].WithinRadius && matches[pos-1].Distance > m.Distance {
+		pos--
+	}
+	matches = append(matches, RoomMatch{})
+	copy(matches[pos+1:], matches[pos:])
+	matches[pos] = m
+	return matches
+}
+
+func (idx *RoomIndex) roomMatch(i int, loc model.Location, inside bool) RoomMatch {
+	r := &idx.rooms[i]
+	m := RoomMatch{Name: r.Name, Radius: r.Radius, Floor: r.Floor, WithinRadius: inside}
+	switch {
+	case len(r.Polygon) < 3:
+		m.Distance = sphereDistance(r, loc)
+	case !inside:
+		m.Distance = idx.planDistance(i, loc)
+	}
+	return m
+}
+
+// planDistance is the floor-plan distance from loc to an outline room's outline, or 0 inside it.
+func (idx *RoomIndex) planDistance(i int, loc model.Location) float64 {
+	return polygonDistance(idx.rooms[i].Polygon, loc.X, loc.Y)
+}
+
+// sphereDistance is the 3D distance from loc to a room's anchor.
+func sphereDistance(r *model.RoomDefinition, loc model.Location) float64 {
+	dx, dy, dz := loc.X-r.X, loc.Y-r.Y, loc.Z-r.Z
+	return math.Sqrt(dx*dx + dy*dy + dz*dz)
+}
+
+// cellDistance is a lower bound on planDistance for any point in the box [x0,x1]×[y0,y1].
+func (idx *RoomIndex) cellDistance(i int, x0, y0, x1, y1 float64) float64 {
+	bx0, by0, bx1, by1 := idx.boxes[i][0], idx.boxes[i][1], idx.boxes[i][2], idx.boxes[i][3]
+	dx := math.Max(0, math.Max(bx0-x1, x0-bx1))
+	dy := math.Max(0, math.Max(by0-y1, y0-by1))
+	return math.Sqrt(dx*dx + dy*dy)
+}
+
+// roomFootprint is the plan bounding box of a room.
+func roomFootprint(r *model.RoomDefinition) (minX, minY, maxX, maxY float64) {
+	if len(r.Polygon) < 3 {
+		return r.X - r.Radius, r.Y - r.Radius, r.X + r.Radius, r.Y + r.Radius
+	}
+	minX, minY = math.Inf(1), math.Inf(1)
+	maxX, maxY = math.Inf(-1), math.Inf(-1)
+	for _, p := range r.Polygon {
+		minX, minY = math.Min(minX, p.X), math.Min(minY, p.Y)
+		maxX, maxY = math.Max(maxX, p.X), math.Max(maxY, p.Y)
+	}
+	return minX, minY, maxX, maxY
+}
+
+func roomArea(r *model.RoomDefinition) float64 {
+	if len(r.Polygon) < 3 {
+		return math.Pi * r.Radius * r.Radius
+	}
+	var a float64
+	for i, p := range r.Polygon {
+		q := r.Polygon[(i+1)%len(r.Polygon)]
+		a += p.X*q.Y - q.X*p.Y
+	}
+	return math.Abs(a) / 2
+}
+
+// scanline appends the sorted x coordinates where the horizontal line at y enters and leaves an
+// outline room.
+func scanline(r *model.RoomDefinition, y float64, xs []float64) []float64 {
+	for i, p := range r.Polygon {
+		q := r.Polygon[(i+1)%len(r.Polygon)]
+		if (p.Y <= y) != (q.Y <= y) {
+			xs = append(xs, p.X+(y-p.Y)*(q.X-p.X)/(q.Y-p.Y))
+		}
+	}
+	sort.Float64s(xs)
+	return xs
+}
+
+// polygonDistance is the plan distance from (x, y) to the polygon outline, or 0 inside it.
+func polygonDistance(poly []model.Point2D, x, y float64) float64 {
+	inside := false
+	best := math.Inf(1)
+	for i, p := range poly {
+		q := poly[(i+1)%len(poly)]
+		if (p.Y <= y) != (q.Y <= y) && x < p.X+(y-p.Y)*(q.X-p.X)/(q.Y-p.Y) {
+			inside = !inside
+		}
+		ex, ey := q.X-p.X, q.Y-p.Y
+		t := 0.0
+		if l := ex*ex + ey*ey; l > 0 {
+			t = math.Max(0, math.Min(1, ((x-p.X)*ex+(y-p.Y)*ey)/l))
+		}
+		dx, dy := x-(p.X+t*ex), y-(p.Y+t*ey)
+		best = math.Min(best, dx*dx+dy*dy)
+	}
+	if inside {
+		return 0
+	}
+	return math.Sqrt(best)
+}
@@ -0,0 +1,344 @@
+package localization
+
+import (
+	"math"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	solverMaxIterations = 30
+	solverTolerance     = 1e-3 // metres; stop once a step moves less than this
+	solverInitialLambda = 1e-3
+	solverMaxLambda     = 1e7
+
+	// rssiNoiseDB is the assumed per-sample RSSI standard deviation; with the log-distance model it
+	// maps to a range error proportional to distance, so far beacons are down-weighted.
+	rssiNoiseDB = 4.0
+	// huberK is the Huber threshold in standard deviations; residuals beyond it get linear loss.
+	huberK = 1.345
+	// confidenceScale converts the 1-sigma position uncertainty (metres) to a 0..1 confidence.
+	confidenceScale = 2.0
+)
+
+// Observation is the per-beacon input to a solver: where the beacon is and how strongly it hears the tag.
+type Observation struct {
+	BeaconID string
+	Location model.Location
+	RSSI     float64
+	Samples  int
+	Weight   float64  // decay-weighted sample count from resampling; 0 means Samples
+	Model    PathLoss // zero value means DefaultPathLoss
+}
+
+// weight is how many independent samples the observation's RSSI is worth in the likelihood.
+func (o *Observation) weight() float64 {
+	if o.Weight > 0 {
+		return o.Weight
+	}
+	return math.Max(float64(o.Samples), 1)
+}
+
+func (o *Observation) pathLoss() PathLoss {
+	if o.Model.Exponent <= 0 {
+		return DefaultPathLoss
+	}
+	return o.Model
+}
+
+// RoomMatch reports how far an estimate lies from a configured room anchor.
+type RoomMatch struct {
+	Name         string  `json:"name"`
+	Distance     float64 `json:"distance"`
+	Radius       float64 `json:"radius"`
+	Floor        int     `json:"floor,omitempty"`
+	WithinRadius bool    `json:"within_radius"` // position lies inside the room's footprint
+}
+
+// Estimate is the output of a solver for one tag.
+type Estimate struct {
+	Location    model.Location
+	Confidence  float64
+	Residual    float64 // RMS range residual in metres
+	Uncertainty float64 // 1-sigma position error in metres from the solution covariance
+	BeaconCount int
+	Outliers    int // beacons down-weighted by the Huber loss at the solution
+	Iterations  int
+	Message     string
+	Valid       bool
+}
+
+type solverPoint struct {
+	pos    [3]float64
+	dist   float64
+	weight float64 // 1/sigma^2 of the range measurement
+}
+
+// Solver is a weighted 3D Levenberg-Marquardt range solver with Huber loss. It keeps scratch buffers
+// between calls, so each worker should own one.
+type Solver struct {
+	points []solverPoint
+}
+
+// Solve estimates a position from RSSI-derived ranges, using each observation's path-loss model. When seed is non-nil (typically the tag's
+// previous position) the solver starts there and usually converges in two or three iterations.
+func (s *Solver) Solve(observations []Observation, seed *model.Location) Estimate {
+	if len(observations) < 3 {
+		return Estimate{
+			BeaconCount: len(observations),
+			Message:     "At least three beacons required",
+		}
+	}
+
+	s.points = s.points[:0]
+	for i := range observations {
+		o := &observations[i]
+		pl := o.pathLoss()
+		d := pl.Distance(o.RSSI)
+		if math.IsNaN(d) || math.IsInf(d, 0) || d <= 0 {
+			continue
+		}
+		sigma := d * math.Ln10 / (10 * pl.Exponent) * rssiNoiseDB / math.Sqrt(o.weight())
+		s.points = append(s.points, solverPoint{
+			pos:    [3]float64{o.Location.X, o.Location.Y, o.Location.Z},
+			dist:   d,
+			weight: 1 / (sigma*sigma + 1e-6),
+		})
+	}
+	points := s.points
+
+	if len(points) < 3 {
+		return Estimate{
+			BeaconCount: len(points),
+			Message:     "Insufficient high-quality beacons",
+		}
+	}
+
+	var p [3]float64
+	if seed != nil {
+		p = [3]float64{seed.X, seed.Y, seed.Z}
+	} else {
+		p = weightedCentroid(points)
+	}
+
+	lambda := solverInitialLambda
+	cost := huberCost(points, p)
+	iterations := 0
+	for iterations < solverMaxIterations {
+		iterations++
+		h, c, g := normalEquations(points, p)
+		fixZ := zUnobservable(h)
+
+		var step [3]float64
+		accepted := false
+		for lambda <= solverMaxLambda {
+			var a [3][3]float64
+			for i := 0; i < 3; i++ {
+				for j := 0; j < 3; j++ {
+					a[i][j] = h[i][j] + c[i][j]
+				}
+				a[i][i] += lambda * (h[i][i] + 1e-9)
+			}
+			delta, ok := solveDamped(a, g, fixZ)
+			if !ok {
+				lambda *= 10
+				continue
+			}
+			candidate := [3]float64{p[0] + delta[0], p[1] + delta[1], p[2] + delta[2]}
+			if c := huberCost(points, candidate); c <= cost {
+				p, cost, step = candidate, c, delta
+				lambda = math.Max(lambda/10, 1e-9)
+				accepted = true
+				break
+			}
+			lambda *= 10
+		}
+		if !accepted || math.Sqrt(step[0]*step[0]+step[1]*step[1]+step[2]*step[2]) < solverTolerance {
+			break
+		}
+	}
+
+	// Covariance of the weighted solution, scaled by the reduced chi-square when there are spare
+	// degrees of freedom (never below 1 so a lucky fit with few beacons does not look overly certain).
+	h, _, _ := normalEquations(points, p)
+	fixZ := zUnobservable(h)
+	var sumSq, chi2 float64
+	outliers := 0
+	for i := range points {
+		f := rangeResidual(points[i], p)
+		sumSq += f * f
+		r := f * math.Sqrt(points[i].weight)
+		chi2 += r * r
+		if math.Abs(r) > huberK {
+			outliers++
+		}
+	}
+	dims := 3
+	if fixZ {
+		dims = 2
+	}
+	scale := 1.0
+	if dof := len(points) - dims; dof > 0 {
+		scale = math.Max(1, chi2/float64(dof))
+	}
+	variance, ok := covarianceTrace(h, fixZ)
+	if !ok {
+		return Estimate{
+			BeaconCount: len(points),
+			Iterations:  iterations,
+			Message:     "Triangulation unstable",
+		}
+	}
+	uncertainty := math.Sqrt(variance * scale)
+
+	return Estimate{
+		Location:    model.Location{X: p[0], Y: p[1], Z: p[2]},
+		Confidence:  math.Exp(-uncertainty / confidenceScale),
+		Residual:    math.Sqrt(sumSq / float64(len(points))),
+		Uncertainty: uncertainty,
+		BeaconCount: len(points),
+		Outliers:    outliers,
+		Iterations:  iterations,
+		Message:     "Weighted 3D least-squares fit of RSSI path-loss ranges",
+		Valid:       true,
+	}
+}
+
+func weightedCentroid(points []solverPoint) [3]float64 {
+	var c [3]float64
+	var total float64
+	for _, pt := range points {
+		w := 1 / (pt.dist*pt.dist + 1e-6)
+		for i := 0; i < 3; i++ {
+			c[i] += w * pt.pos[i]
+		}
+		total += w
+	}
+	for i := 0; i < 3; i++ {
+		c[i] /= total
+	}
+	return c
+}
+
+func rangeResidual(pt solverPoint, p [3]float64) float64 {
+	dx, dy, dz := p[0]-pt.pos[0], p[1]-pt.pos[1], p[2]-pt.pos[2]
+	return math.Sqrt(dx*dx+dy*dy+dz*dz) - pt.dist
+}
+
+// huberWeight is the IRLS weight psi(r)/r for a normalised residual r.
+func huberWeight(r float64) float64 {
+	if a := math.Abs(r); a > huberK {
+		return huberK / a
+	}
+	return 1
+}
+
+func huberCost(points []solverPoint, p [3]float64) float64 {
+	var cost float64
+	for _, pt := range points {
+		r := math.Abs(rangeResidual(pt, p) * math.Sqrt(pt.weight))
+		if r <= huberK {
+			cost += 0.5 * r * r
+		} else {
+			cost += huberK*r - 0.5*huberK*huberK
+		}
+	}
+	return cost
+}
+
+// normalEquations builds the Gauss-Newton matrix J^T W J, the second-order range term
+// sum w*f*(I - j j^T)/r and the gradient J^T W f at p, with W the measurement weights times the
+// Huber IRLS weights. RSSI ranges never fit exactly, so dropping the second-order term (plain
+// Gauss-Newton) leaves the weakly constrained axis, usually z, converging only linearly.
+func normalEquations(points []solverPoint, p [3]float64) (h, c [3][3]float64, g [3]float64) {
+	for _, pt := range points {
+		dx, dy, dz := p[0]-pt.pos[0], p[1]-pt.pos[1], p[2]-pt.pos[2]
+		r := math.Sqrt(dx*dx + dy*dy + dz*dz)
+		if r < 1e-9 {
+			continue
+		}
+		j := [3]float64{dx / r, dy / r, dz / r}
+		f := r - pt.dist
+		w := pt.weight * huberWeight(f*math.Sqrt(pt.weight))
+		for a := 0; a < 3; a++ {
+			g[a] += w * j[a] * f
+			for b := 0; b < 3; b++ {
+				h[a][b] += w * j[a] * j[b]
+				identity := 0.0
+				if a == b {
+					identity = 1
+				}
+				c[a][b] += w * f * (identity - j[a]*j[b]) / r
+			}
+		}
+	}
+	return h, c, g
+}
+
+// zUnobservable reports whether the geometry carries no height information (e.g. every beacon on
+// one floor and the estimate in their plane); z is then held at its current value.
+func zUnobservable(h [3][3]float64) bool {
+	return h[2][2] < 1e-6*(h[0][0]+h[1][1])
+}
+
+// solveDamped solves a*delta = -g, optionally restricted to the x/y block.
+func solveDamped(a [3][3]float64, g [3]float64, fixZ bool) ([3]float64, bool) {
+	if fixZ {
+		det := a[0][0]*a[1][1] - a[0][1]*a[1][0]
+		if math.Abs(det) < 1e-12 {
+			return [3]float64{}, false
+		}
+		return [3]float64{
+			(-g[0]*a[1][1] + g[1]*a[0][1]) / det,
+			(-g[1]*a[0][0] + g[0]*a[1][0]) / det,
+			0,
+		}, true
+	}
+	inv, ok := invert3(a)
+	if !ok {
+		return [3]float64{}, false
+	}
+	var delta [3]float64
+	for i := 0; i < 3; i++ {
+		delta[i] = -(inv[i][0]*g[0] + inv[i][1]*g[1] + inv[i][2]*g[2])
+	}
+	return delta, true
+}
+
+// covarianceTrace returns trace((J^T W J)^-1), over x/y only when z is fixed.
+func covarianceTrace(h [3][3]float64, fixZ bool) (float64, bool) {
+	if fixZ {
+		det := h[0][0]*h[1][1] - h[0][1]*h[1][0]
+		if det < 1e-12 {
+			return 0, false
+		}
+		return (h[0][0] + h[1][1]) / det, true
+	}
+	inv, ok := invert3(h)
+	if !ok {
+		return 0, false
+	}
+	t := inv[0][0] + inv[1][1] + inv[2][2]
+	return t, t > 0
+}
+
+func invert3(m [3][3]float64) ([3][3]float64, bool) {
+	c00 := m[1][1]*m[2][2] - m[1][2]*m[2][1]
+	c01 := m[1][2]*m[2][0] - m[1][0]*m[2][2]
+	c02 := m[1][0]*m[2][1] - m[1][1]*m[2][0]
+	det := m[0][0]*c00 + m[0][1]*c01 + m[0][2]*c02
+	if math.Abs(det) < 1e-12 {
+		return [3][3]float64{}, false
+	}
+	inv := [3][3]float64{
+		{c00, m[0][2]*m[2][1] - m[0][1]*m[2][2], m[0][1]*m[1][2] - m[0][2]*m[1][1]},
+		{c01, m[0][0]*m[2][2] - m[0][2]*m[2][0], m[0][2]*m[1][0] - m[0][0]*m[1][2]},
+		{c02, m[0][1]*m[2][0] - m[0][0]*m[2][1], m[0][0]*m[1][1] - m[0][1]*m[1][0]},
+	}
+	for i := 0; i < 3; i++ {
+		for j := 0; j < 3; j++ {
+			inv[i][j] /= det
+		}
+	}
+	return inv, true
+}
@@ -0,0 +1,308 @@
+// Package localization keeps per-tag RSSI state and derives positions from it.
+package localization
+
+import (
+	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// seriesCapacity bounds the samples retained per (tag, beacon) pair; older samples are overwritten.
+const seriesCapacity = 32
+
+// Sample is a single RSSI observation. At is the server receive time in Unix nanoseconds, which keeps
+// windows consistent even when scanner clocks drift.
+type Sample struct {
+	At       int64
+	Captured int64
+	RSSI     float64
+}
+
+// beaconSeries is a fixed-size ring of recent samples from one beacon for one tag.
+type beaconSeries struct {
+	location model.Location
+	samples  [seriesCapacity]Sample
+	head     int // index of the next write
+	n        int
+}
+
+func (s *beaconSeries) push(sample Sample) {
+	s.samples[s.head] = sample
+	s.head = (s.head + 1) % seriesCapacity
+	if s.n < seriesCapacity {
+		s.n++
+	}
+}
+
+func (s *beaconSeries) latest() (Sample, bool) {
+	if s.n == 0 {
+		return Sample{}, false
+	}
+	return s.samples[(s.head-1+seriesCapacity)%seriesCapacity], true
+}
+
+// appendSince appends samples received at or after cutoff to dst in arrival order.
+func (s *beaconSeries) appendSince(dst []Sample, cutoff int64) []Sample {
+	start := (s.head - s.n + seriesCapacity) % seriesCapacity
+	for i := 0; i < s.n; i++ {
+		sample := s.samples[(start+i)%seriesCapacity]
+		if sample.At >= cutoff {
+			dst = append(dst, sample)
+		}
+	}
+	return dst
+}
+
+// meanSince averages the RSSI of samples received at or after cutoff.
+func (s *beaconSeries) meanSince(cutoff int64) (float64, int) {
+	var sum float64
+	var n int
+	start := (s.head - s.n + seriesCapacity) % seriesCapacity
+	for i := 0; i < s.n; i++ {
+		sample := s.samples[(start+i)%seriesCapacity]
+		if sample.At >= cutoff {
+			sum += sample.RSSI
+			n++
+		}
+	}
+	if n == 0 {
+		return 0, 0
+	}
+	return sum / float64(n), n
+}
+
+// TagState holds the rolling window of readings for one tag across beacons.
+type TagState struct {
+	mu       sync.Mutex
+	tagID    string
+	shard    int
+	beacons  map[string]*beaconSeries
+	lastSeen int64
+
+	pending atomic.Bool              // a recompute is scheduled
+	result  atomic.Pointer[Position] // latest solved position
+
+	// owned by the shard's engine worker
+	filter     *ParticleFilter
+	filteredAt int64
+	smoother   roomSmoother
+}
+
+func newTagState(tagID string) *TagState {
+	return &TagState{tagID: tagID, shard: shardIndex(tagID), beacons: make(map[string]*beaconSeries)}
+}
+
+// TagID reports which tag the state belongs to.
+func (t *TagState) TagID() string {
+	return t.tagID
+}
+
+func (t *TagState) observe(beaconID string, loc model.Location, sample Sample) {
+	t.mu.Lock()
+	series, ok := t.beacons[beaconID]
+	if !ok {
+		series = &beaconSeries{}
+		t.beacons[beaconID] = series
+	}
+	series.location = loc
+	series.push(sample)
+	if sample.At > t.lastSeen {
+		t.lastSeen = sample.At
+	}
+	t.mu.Unlock()
+}
+
+// observations appends one Observation per beacon heard since cutoff to dst, averaging the
+// in-window RSSI samples to damp multipath jitter.
+func (t *TagState) observations(cutoff int64, dst []Observation) []Observation {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	for beaconID, series := range t.beacons {
+		mean, n := series.meanSince(cutoff)
+		if n == 0 {
+			continue
+		}
+		dst = append(dst, Observation{
+			BeaconID: beaconID,
+			Location: series.location,
+			RSSI:     mean,
+			Samples:  n,
+		})
+	}
+	// Map iteration order is random; keep the solver's reference beacon stable.
+	sort.Slice(dst, func(i, j int) bool {
+		return dst[i].BeaconID < dst[j].BeaconID
+	})
+	return dst
+}
+
+// resampled appends one Observation per beacon readable at now under cfg to dst, each aligned to now
+// so beacons heard at different instants fuse consistently.
+func (t *TagState) resampled(now int64, cfg *ResampleConfig, maxAge int64, dst []Observation) []Observation {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	for beaconID, series := range t.beacons {
+		v, ok := series.valueAt(now, cfg, maxAge)
+		if !ok {
+			continue
+		}
+		dst = append(dst, Observation{
+			BeaconID: beaconID,
+			Location: series.location,
+			RSSI:     v.rssi,
+			Samples:  v.n,
+			Weight:   v.weight,
+		})
+	}
+	sort.Slice(dst, func(i, j int) bool {
+		return dst[i].BeaconID < dst[j].BeaconID
+	})
+	return dst
+}
+
+// tagShardCount is the number of lock stripes (and engine workers) tags are spread across.
+const tagShardCount = 16
+
+// tagShard is one lock stripe of the tracker's tag map.
+type tagShard struct {
+	mu   sync.RWMutex
+	tags map[string]*TagState
+}
+
+// Tracker maintains per-tag rolling windows fed from the ingest path. Tags are striped across
+// shards by FNV-1a hash so concurrent collars rarely contend on the same lock.
+type Tracker struct {
+	window time.Duration
+	shards [tagShardCount]tagShard
+}
+
+// NewTracker constructs a tracker that considers readings received within window as live.
+func NewTracker(window time.Duration) *Tracker {
+	if window <= 0 {
+		window = 30 * time.Second
+	}
+	t := &Tracker{window: window}
+	for i := range t.shards {
+		t.shards[i].tags = make(map[string]*TagState)
+	}
+	return t
+}
+
+// shardIndex returns the stripe owning tagID.
+func shardIndex(tagID string) int {
+	const (
+		offset32 = 2166136261
+		prime32  = 16777619
+	)
+	h := uint32(offset32)
+	for i := 0; i < len(tagID); i++ {
+		h ^= uint32(tagID[i])
+		h *= prime32
+	}
+	return int(h % tagShardCount)
+}
+
+// Window reports the rolling window duration.
+func (t *Tracker) Window() time.Duration {
+	return t.window
+}
+
+// Observe records a reading received at receivedAt and returns the tag's state. The sample is added
+// under the shard lock, so Evict cannot drop the state between the lookup and the write.
+func (t *Tracker) Observe(r model.BeaconReading, receivedAt time.Time) *TagState {
+	shard := &t.shards[shardIndex(r.TagID)]
+	sample := Sample{
+		At:       receivedAt.UnixNano(),
+		Captured: r.Timestamp.UnixNano(),
+		RSSI:     float64(r.RSSI),
+	}
+
+	shard.mu.RLock()
+	state, ok := shard.tags[r.TagID]
+	if ok {
+		state.observe(r.BeaconID, r.BeaconLocation, sample)
+	}
+	shard.mu.RUnlock()
+	if ok {
+		return state
+	}
+
+	shard.mu.Lock()
+	state, ok = shard.tags[r.TagID]
+	if !ok {
+		state = newTagState(r.TagID)
+		shard.tags[r.TagID] = state
+	}
+	state.observe(r.BeaconID, r.BeaconLocation, sample)
+	shard.mu.Unlock()
+	return state
+}
+
+// Evict drops every tag with no sample received within the window, with its ring buffers and cached
+// position, so rotating BLE addresses do not accumulate. It returns how many tags were dropped.
+func (t *Tracker) Evict(now time.Time) int {
+	cutoff := now.Add(-t.window).UnixNano()
+	evicted := 0
+	for i := range t.shards {
+		shard := &t.shards[i]
+		shard.mu.Lock()
+		for tagID, state := range shard.tags {
+			state.mu.Lock()
+			idle := state.lastSeen < cutoff
+			state.mu.Unlock()
+			if idle {
+				delete(shard.tags, tagID)
+				evicted++
+			}
+		}
+		shard.mu.Unlock()
+	}
+	return evicted
+}
+
+// Restore replays stored readings into the tracker, typically at startup.
+func (t *Tracker) Restore(readings []model.StoredBeaconReading) {
+	for _, r := range readings {
+		received := r.ReceivedAt
+		if received.IsZero() {
+			received = r.RecordedAt
+		}
+		t.Observe(r.BeaconReading, received)
+	}
+}
+
+// Tags returns the number of tags with state.
+func (t *Tracker) Tags() int {
+	n := 0
+	for i := range t.shards {
+		shard := &t.shards[i]
+		shard.mu.RLock()
+		n += len(shard.tags)
+		shard.mu.RUnlock()
+	}
+	return n
+}
+
+func (t *Tracker) lookup(tagID string) (*TagState, bool) {
+	shard := &t.shards[shardIndex(tagID)]
+	shard.mu.RLock()
+	defer shard.mu.RUnlock()
+	state, ok := shard.tags[tagID]
+	return state, ok
+}
+
+func (t *Tracker) states() []*TagState {
+	var states []*TagState
+	for i := range t.shards {
+		shard := &t.shards[i]
+		shard.mu.RLock()
+		for _, s := range shard.tags {
+			states = append(states, s)
+		}
+		shard.mu.RUnlock()
+	}
+	return states
+}
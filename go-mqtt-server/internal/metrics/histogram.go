@@ -0,0 +1,109 @@
+// Package metrics holds the server's low-overhead instrumentation primitives and their Prometheus
+// text exposition.
+package metrics
+
+import (
+	"math/bits"
+	"sync/atomic"
+	"time"
+)
+
+const (
+	// HistogramBuckets is the number of finite buckets; bucket i counts durations up to
+	// HistogramBase<<i, so the top finite bound is about 52 s. Longer durations land in an
+	// overflow bucket.
+	HistogramBuckets = 20
+	HistogramBase    = 100 * time.Microsecond
+)
+
+// Histogram counts durations into fixed exponential buckets. Observe is a few atomic adds with no
+// locks or allocation, so it is safe on the ingest hot path; the zero value is ready to use.
+type Histogram struct {
+	counts [HistogramBuckets + 1]atomic.Uint64
+	sum    atomic.Int64 // nanoseconds
+}
+
+// Observe records one duration; negative durations count as zero.
+func (h *Histogram) Observe(d time.Duration) {
+	if d < 0 {
+		d = 0
+	}
+	h.counts[bucketFor(d)].Add(1)
+	h.sum.Add(int64(d))
+}
+
+func bucketFor(d time.Duration) int {
+	if d <= HistogramBase {
+		return 0
+	}
+	return min(bits.Len64(uint64((d-1)/HistogramBase)), HistogramBuckets)
+}
+
+// BucketBound returns the inclusive upper bound of finite bucket i.
+func BucketBound(i int) time.Duration {
+	return HistogramBase << i
+}
+
+// HistogramSnapshot is a point-in-time copy of a histogram's buckets.
+type HistogramSnapshot struct {
+	Counts [HistogramBuckets + 1]uint64 // per bucket, not cumulative; the last is overflow
+	Count  uint64
+	Sum    time.Duration
+}
+
+// Snapshot copies the histogram. Concurrent observations may land between bucket reads, so Count
+// can briefly disagree with Sum by an observation or two.
+func (h *Histogram) Snapshot() HistogramSnapshot {
+	var s HistogramSnapshot
+	for i := range h.counts {
+		s.Counts[i] = h.counts[i].Load()
+		s.Count += s.Counts[i]
+	}
+	s.Sum = time.Duration(h.sum.Load())
+	return s
+}
+
+// Merge adds o's counts into s.
+func (s *HistogramSnapshot) Merge(o HistogramSnapshot) {
+	for i := range s.Counts {
+		s.Counts[i] += o.Counts[i]
+	}
+	s.Count += o.Count
+	s.Sum += o.Sum
+}
+
+// Mean returns the average observed duration.
+func (s HistogramSnapshot) Mean() time.Duration {
+	if s.Count == 0 {
+		return 0
+	}
+	return s.Sum / time.Duration(s.Count)
+}
+
+// Quantile estimates the q-quantile by interpolating within the bucket that contains it. Values in
+// the overflow bucket are reported as the top finite bound.
+func (s HistogramSnapshot) Quantile(q float64) time.Duration {
+	if s.Count == 0 {
+		return 0
+	}
+	rank := q * float64(s.Count)
+	var seen float64
+	for i, c := range s.Counts {
+		if c == 0 {
+			continue
+		}
+		if seen+float64(c) >= rank {
+			if i == HistogramBuckets {
+				return BucketBound(HistogramBuckets - 1)
+			}
+			lower := time.Duration(0)
+			if i > 0 {
+				lower = BucketBound(i - 1)
+			}
+			frac := (rank - seen) / float64(c)
+			return lower + time.Duration(frac*float64(BucketBound(i)-lower))
+		}
+		seen += float64(c)
+	}
+	return BucketBound(HistogramBuckets - 1)
+}
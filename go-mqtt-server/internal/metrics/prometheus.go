@@ -0,0 +1,190 @@
+package metrics
+
+import (
+	"bufio"
+	"io"
+	"math"
+	"math/bits"
+	"strconv"
+	"strings"
+	"sync/atomic"
+)
+
+// SizeBuckets is the number of finite buckets of a SizeHistogram; bucket i counts sizes up to 1<<i.
+const SizeBuckets = 12
+
+// SizeHistogram counts non-negative sizes (batch lengths, payload counts) into power-of-two buckets.
+// Like Histogram it is lock-free and the zero value is ready to use.
+type SizeHistogram struct {
+	counts [SizeBuckets + 1]atomic.Uint64
+	sum    atomic.Uint64
+}
+
+// Observe records one size.
+func (h *SizeHistogram) Observe(n int) {
+	if n < 0 {
+		n = 0
+	}
+	bucket := 0
+	if n > 1 {
+		bucket = min(bits.Len64(uint64(n-1)), SizeBuckets)
+	}
+	h.counts[bucket].Add(1)
+	h.sum.Add(uint64(n))
+}
+
+// SizeSnapshot is a point-in-time copy of a size histogram's buckets.
+type SizeSnapshot struct {
+	Counts [SizeBuckets + 1]uint64 // per bucket, not cumulative; the last is overflow
+	Count  uint64
+	Sum    uint64
+}
+
+// Snapshot copies the histogram.
+func (h *SizeHistogram) Snapshot() SizeSnapshot {
+	var s SizeSnapshot
+	for i := range h.counts {
+		s.Counts[i] = h.counts[i].Load()
+		s.Count += s.Counts[i]
+	}
+	s.Sum = h.sum.Load()
+	return s
+}
+
+// Exposition writes metrics in the Prometheus text format (version 0.0.4). Call Family once before
+// the samples of each metric family; errors are sticky and reported by Flush.
+type Exposition struct {
+	w *bufio.Writer
+}
+
+// ContentType is the media type of the text exposition format.
+const ContentType = "text/plain; version=0.0.4; charset=utf-8"
+
+var helpEscaper = strings.NewReplacer(`\`, `\\`, "\n", `\n`)
+
+// NewExposition returns an exposition writing to w.
+func NewExposition(w io.Writer) *Exposition {
+	return &Exposition{w: bufio.NewWriterSize(w, 32<<10)}
+}
+
+// Family writes the HELP and TYPE lines for a metric family; kind is counter, gauge or histogram.
+func (e *Exposition) Family(name, kind, help string) {
+	e.w.WriteString("# HELP ")
+	e.w.WriteString(name)
+	e.w.WriteByte(' ')
+	e.w.WriteString(helpEscaper.Replace(help))
+	e.w.WriteString("\n# TYPE ")
+	e.w.WriteString(name)
+	e.w.WriteByte(' ')
+	e.w.WriteString(kind)
+	e.w.WriteByte('\n')
+}
+
+// Sample writes one sample. labels alternate names and values.
+func (e *Exposition) Sample(name string, value float64, labels ...string) {
+	e.w.WriteString(name)
+	e.writeLabels(labels, "")
+	e.w.WriteByte(' ')
+	e.writeFloat(value)
+	e.w.WriteByte('\n')
+}
+
+// Uint writes one integer sample, exact beyond float64's 53-bit mantissa.
+func (e *Exposition) Uint(name string, value uint64, labels ...string) {
+	e.w.WriteString(name)
+	e.writeLabels(labels, "")
+	e.w.WriteByte(' ')
+	e.w.WriteString(strconv.FormatUint(value, 10))
+	e.w.WriteByte('\n')
+}
+
+// Histogram writes a duration histogram's cumulative buckets, sum and count, in seconds.
+func (e *Exposition) Histogram(name string, s HistogramSnapshot, labels ...string) {
+	var cumulative uint64
+	for i := 0; i < HistogramBuckets; i++ {
+		cumulative += s.Counts[i]
+		e.bucket(name, strconv.FormatFloat(float64(BucketBound(i))/1e9, 'g', -1, 64), cumulative, labels)
+	}
+	e.bucket(name, "+Inf", s.Count, labels)
+	e.Sample(name+"_sum", s.Sum.Seconds(), labels...)
+	e.Uint(name+"_count", s.Count, labels...)
+}
+
+// Sizes writes a size histogram's cumulative buckets, sum and count.
+func (e *Exposition) Sizes(name string, s SizeSnapshot, labels ...string) {
+	var cumulative uint64
+	for i := 0; i < SizeBuckets; i++ {
+		cumulative += s.Counts[i]
+		e.bucket(name, strconv.Itoa(1<<i), cumulative, labels)
+	}
+	e.bucket(name, "+Inf", s.Count, labels)
+	e.Uint(name+"_sum", s.Sum, labels...)
+	e.Uint(name+"_count", s.Count, labels...)
+}
+
+func (e *Exposition) bucket(name, le string, count uint64, labels []string) {
+	e.w.WriteString(name)
+	e.w.WriteString("_bucket")
+	e.writeLabels(labels, le)
+	e.w.WriteByte(' ')
+	e.w.WriteString(strconv.FormatUint(count, 10))
+	e.w.WriteByte('\n')
+}
+
+func (e *Exposition) writeLabels(labels []string, le string) {
+	if len(labels) < 2 && le == "" {
+		return
+	}
+	e.w.WriteByte('{')
+	for i := 0; i+1 < len(labels); i += 2 {
+		if i > 0 {
+			e.w.WriteByte(',')
+		}
+		e.w.WriteString(labels[i])
+		e.w.WriteString(`="`)
+		writeLabelValue(e.w, labels[i+1])
+		e.w.WriteByte('"')
+	}
+	if le != "" {
+		if len(labels) >= 2 {
+			e.w.WriteByte(',')
+		}
+		e.w.WriteString(`le="`)
+		e.w.WriteString(le)
+		e.w.WriteByte('"')
+	}
+	e.w.WriteByte('}')
+}
+
+func writeLabelValue(w *bufio.Writer, v string) {
+	for i := 0; i < len(v); i++ {
+		switch c := v[i]; c {
+		case '\\':
+			w.WriteString(`\\`)
+		case '"':
+			w.WriteString(`\"`)
+		case '\n':
+			w.WriteString(`\n`)
+		default:
+			w.WriteByte(c)
+		}
+	}
+}
+
+func (e *Exposition) writeFloat(v float64) {
+	switch {
+	case math.IsInf(v, 1):
+		e.w.WriteString("+Inf")
+	case math.IsInf(v, -1):
+		e.w.WriteString("-Inf")
+	case math.IsNaN(v):
+		e.w.WriteString("NaN")
+	default:
+		e.w.WriteString(strconv.FormatFloat(v, 'g', -1, 64))
+	}
+}
+
+// Flush writes any buffered output and returns the first write error.
+func (e *Exposition) Flush() error {
+	return e.w.Flush()
+}
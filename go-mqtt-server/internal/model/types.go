@@ -1,6 +1,9 @@
 package model
 
-import "time"
+import (
+	"strconv"
+	"time"
+)
 
 // Location describes the fixed coordinates of a beacon in meters.
 type Location struct {
@@ -15,22 +18,63 @@ type BeaconReading struct {
 	TagID          string            `json:"tag_id"`
 	RSSI           int               `json:"rssi"`
 	Timestamp      time.Time         `json:"timestamp"`
+	Sequence       uint32            `json:"seq,omitempty"`
+	SentAt         *time.Time        `json:"sent_at,omitempty"` // when the scanner handed the reading to MQTT
 	BeaconLocation Location          `json:"beacon_location"`
 	Metadata       map[string]string `json:"metadata,omitempty"`
+
+	Trace ReadingTrace `json:"-"`
+}
+
+// ReadingTrace carries a reading's server-side pipeline timestamps for latency accounting.
+type ReadingTrace struct {
+	Captured time.Time // the scanner's capture stamp, zero when the scanner clock was not set
+	Received time.Time // the broker finished reading the publish
+	Decoded  time.Time // the payload was parsed and validated
+}
+
+// GroundTruth returns the tag's true position when the publisher supplied it in metadata
+// (tag_x/tag_y/tag_z, as beacon-sim and surveyed calibration walks do).
+func (r BeaconReading) GroundTruth() (Location, bool) {
+	if r.Metadata == nil {
+		return Location{}, false
+	}
+	var loc Location
+	for _, f := range []struct {
+		key string
+		dst *float64
+	}{{"tag_x", &loc.X}, {"tag_y", &loc.Y}, {"tag_z", &loc.Z}} {
+		v, ok := r.Metadata[f.key]
+		if !ok {
+			return Location{}, false
+		}
+		parsed, err := strconv.ParseFloat(v, 64)
+		if err != nil {
+			return Location{}, false
+		}
+		*f.dst = parsed
+	}
+	return loc, true
 }
 
 // StoredBeaconReading extends BeaconReading with database metadata.
 type StoredBeaconReading struct {
+	ID int64 `json:"id,omitempty"`
 	BeaconReading
 	RecordedAt time.Time `json:"recorded_at"`
 	ReceivedAt time.Time `json:"received_at"`
 }
 
 // IngestionError captures a payload that failed validation.
+// Failures are aggregated per source and class; Payload holds a sampled example.
 type IngestionError struct {
-	BeaconID string `json:"beacon_id"`
-	Payload  string `json:"payload"`
-	Error    string `json:"error"`
+	BeaconID    string    `json:"beacon_id"`
+	Payload     string    `json:"payload"`
+	Error       string    `json:"error"`
+	Class       string    `json:"class,omitempty"`
+	Occurrences int64     `json:"occurrences"`
+	FirstSeen   time.Time `json:"first_seen"`
+	LastSeen    time.Time `json:"last_seen"`
 }
 
 // TrainingCommand represents a labeling command emitted from the iOS app.
@@ -48,13 +92,25 @@ type AppConfigEntry struct {
 	Value string `json:"value"`
 }
 
-// RoomDefinition anchors a semantic room name to coordinates and radius.
+// RoomDefinition anchors a semantic room name to coordinates and radius. A room with a polygon
+// occupies that floor-plan outline between ZMin and ZMax instead of the sphere; X/Y/Z stay its
+// anchor point.
 type RoomDefinition struct {
-	Name   string  `json:"name"`
-	X      float64 `json:"x"`
-	Y      float64 `json:"y"`
-	Z      float64 `json:"z"`
-	Radius float64 `json:"radius"`
+	Name    string    `json:"name"`
+	X       float64   `json:"x"`
+	Y       float64   `json:"y"`
+	Z       float64   `json:"z"`
+	Radius  float64   `json:"radius"`
+	Floor   int       `json:"floor,omitempty"`
+	Polygon []Point2D `json:"polygon,omitempty"` // outline vertices in order; a box is four corners
+	ZMin    float64   `json:"z_min,omitempty"`   // elevation band of an outline room's floor (m)
+	ZMax    float64   `json:"z_max,omitempty"`
+}
+
+// Point2D is a floor-plan vertex in meters.
+type Point2D struct {
+	X float64 `json:"x"`
+	Y float64 `json:"y"`
 }
 
 // DiscoveredBeacon represents a beacon advertisement observed while a scanner is in discovery mode.
@@ -69,3 +125,69 @@ type DiscoveredBeacon struct {
 	EventType        string    `json:"event_type,omitempty"`
 	LastSeen         time.Time `json:"last_seen"`
 }
+
+// CalibrationSample pairs a reading with the tag's known position for path-loss fitting.
+type CalibrationSample struct {
+	BeaconID       string    `json:"beacon_id"`
+	TagID          string    `json:"tag_id"`
+	RSSI           int       `json:"rssi"`
+	BeaconLocation Location  `json:"beacon_location"`
+	TagLocation    Location  `json:"tag_location"`
+	RecordedAt     time.Time `json:"recorded_at"`
+}
+
+// PathLossParams are log-distance model parameters: RSSI = TxPower - 10*Exponent*log10(d).
+type PathLossParams struct {
+	TxPower  float64 `json:"tx_power"`
+	Exponent float64 `json:"exponent"`
+	Samples  int     `json:"samples,omitempty"`
+	RMSE     float64 `json:"rmse_db,omitempty"`
+}
+
+// PathLossCalibration is a versioned table of per-beacon path-loss parameters.
+type PathLossCalibration struct {
+	Version   int64                     `json:"version"`
+	CreatedAt time.Time                 `json:"created_at"`
+	Active    bool                      `json:"active"`
+	Default   PathLossParams            `json:"default"`
+	Beacons   map[string]PathLossParams `json:"beacons"`
+}
+
+// Fingerprint is a labelled RSSI vector captured while a tag sat in a known room.
+type Fingerprint struct {
+	ID        int64              `json:"id"`
+	TagID     string             `json:"tag_id"`
+	Room      string             `json:"room"`
+	Location  *Location          `json:"location,omitempty"` // room anchor, when the room has one
+	RSSI      map[string]float64 `json:"rssi"`               // beacon id -> mean RSSI
+	CreatedAt time.Time          `json:"created_at"`
+}
+
+// RoomModel is a registered room-classifier artifact.
+type RoomModel struct {
+	ID           int64     `json:"id"`
+	Version      string    `json:"version"`
+	ArtifactPath string    `json:"artifact_path"`
+	TrainedOn    string    `json:"trained_on"`
+	Accuracy     *float64  `json:"accuracy,omitempty"`
+	Notes        string    `json:"notes,omitempty"`
+	Active       bool      `json:"active"`
+	CreatedAt    time.Time `json:"created_at"`
+}
+
+// ModelEvaluation summarises a shadow run of a candidate room model against the active one on live data.
+// Accuracy counts only windows labelled by a running training session.
+type ModelEvaluation struct {
+	ID                 int64     `json:"id"`
+	ActiveModelID      int64     `json:"active_model_id"`
+	CandidateModelID   int64     `json:"candidate_model_id"`
+	StartedAt          time.Time `json:"started_at"`
+	EndedAt            time.Time `json:"ended_at"`
+	Predictions        int64     `json:"predictions"`
+	Agreements         int64     `json:"agreements"`
+	Labelled           int64     `json:"labelled"`
+	ActiveCorrect      int64     `json:"active_correct"`
+	CandidateCorrect   int64     `json:"candidate_correct"`
+	ActiveLatencyUS    float64   `json:"active_latency_us"`
+	CandidateLatencyUS float64   `json:"candidate_latency_us"`
+}
@@ -8,6 +8,7 @@ import (
 	"io"
 	"log/slog"
 	"net"
+	"strings"
 	"sync"
 	"sync/atomic"
 	"time"
@@ -18,16 +19,40 @@ type PublishMessage struct {
 	ClientID string
 	Topic    string
 	Payload  []byte
+	Retain   bool
+	// ReceivedAt is when the broker finished reading the packet off the connection.
+	ReceivedAt time.Time
 }
 
 // Handler is invoked for each received publish message.
 type Handler func(context.Context, PublishMessage)
 
+const (
+	// sessionQueueLen bounds the packets waiting to be written to one client. A publish to a client
+	// whose queue is full is dropped, as QoS 0 allows, so a slow subscriber never holds up the
+	// publisher or the other subscribers.
+	sessionQueueLen = 256
+	// writeTimeout disconnects a client whose socket accepts nothing for this long.
+	writeTimeout = 10 * time.Second
+	// maxRetainedTopics caps the retained messages kept in memory. Clients may set at most
+	// maxClientRetained of them; the rest are reserved for the server's own state topics.
+	maxRetainedTopics = 4096
+	maxClientRetained = 256
+	// dropWarnInterval rate-limits the warnings for dropped publishes and refused retains.
+	dropWarnInterval = time.Minute
+)
+
+// ErrRetainedFull is returned when a new retained topic would exceed the broker's cap.
+var ErrRetainedFull = errors.New("retained message limit reached")
+
 type clientSession struct {
 	conn          net.Conn
 	reader        *bufio.Reader
-	writeMu       sync.Mutex
-	subscriptions map[string]struct{}
+	out           chan []byte   // packets for the writer goroutine
+	quit          chan struct{} // closed when the connection handler exits
+	done          chan struct{} // closed when the writer goroutine exits
+	subMu         sync.RWMutex
+	subscriptions map[string]struct{} // topic filters, possibly with + and # wildcards
 	clientID      string
 	closed        atomic.Bool
 }
@@ -36,33 +61,107 @@ func newSession(conn net.Conn) *clientSession {
 	return &clientSession{
 		conn:          conn,
 		reader:        bufio.NewReader(conn),
+		out:           make(chan []byte, sessionQueueLen),
+		quit:          make(chan struct{}),
+		done:          make(chan struct{}),
 		subscriptions: make(map[string]struct{}),
 	}
 }
 
 func (c *clientSession) subscribed(topic string) bool {
-	_, ok := c.subscriptions[topic]
-	return ok
+	c.subMu.RLock()
+	defer c.subMu.RUnlock()
+	if _, ok := c.subscriptions[topic]; ok {
+		return true
+	}
+	for filter := range c.subscriptions {
+		if topicMatches(filter, topic) {
+			return true
+		}
+	}
+	return false
 }
 
 func (c *clientSession) addSubscription(topic string) {
+	c.subMu.Lock()
 	c.subscriptions[topic] = struct{}{}
+	c.subMu.Unlock()
 }
 
 func (c *clientSession) removeAllSubscriptions() {
-	for k := range c.subscriptions {
-		delete(c.subscriptions, k)
+	c.subMu.Lock()
+	clear(c.subscriptions)
+	c.subMu.Unlock()
+}
+
+// topicMatches reports whether topic matches an MQTT filter: "+" matches one level, a trailing "#"
+// matches the parent and everything below it.
+func topicMatches(filter, topic string) bool {
+	for {
+		if filter == "#" {
+			return true
+		}
+		fl, frest, fmore := strings.Cut(filter, "/")
+		tl, trest, tmore := strings.Cut(topic, "/")
+		if fl != "+" && fl != tl {
+			return false
+		}
+		switch {
+		case fmore && tmore:
+			filter, topic = frest, trest
+		case fmore:
+			return frest == "#" // "a/#" also matches "a"
+		default:
+			return !tmore
+		}
 	}
 }
 
+// writeLoop writes queued packets until the connection handler exits or a write fails or times
+// out. A failed write closes the connection, which ends the handler's read loop.
+func (c *clientSession) writeLoop(logger *slog.Logger) {
+	defer close(c.done)
+	for {
+		select {
+		case <-c.quit:
+			return
+		case packet := <-c.out:
+			_ = c.conn.SetWriteDeadline(time.Now().Add(writeTimeout))
+			if _, err := c.conn.Write(packet); err != nil {
+				logger.Debug("client write failed, disconnecting", "client", c.clientID, "error", err)
+				c.closed.Store(true)
+				_ = c.conn.Close()
+				return
+			}
+		}
+	}
+}
+
+// writePacket queues a packet the client must receive in order (acks, retained replays), waiting
+// for queue space. Only the client's own connection handler waits here.
 func (c *clientSession) writePacket(packet []byte) error {
 	if c.closed.Load() {
 		return net.ErrClosed
 	}
-	c.writeMu.Lock()
-	defer c.writeMu.Unlock()
-	_, err := c.conn.Write(packet)
-	return err
+	select {
+	case c.out <- packet:
+		return nil
+	case <-c.done:
+		return net.ErrClosed
+	}
+}
+
+// offer queues a publish without waiting and reports false when the client's queue is full.
+func (c *clientSession) offer(packet []byte) bool {
+	if c.closed.Load() {
+		return false
+	}
+	select {
+	case c.out <- packet:
+		return true
+	default:
+		return false
+	}
 }
 
 // Broker is a minimal MQTT v3.1.1 broker that supports QoS 0 publish and subscribe semantics.
@@ -76,11 +175,62 @@ type Broker struct {
 
 	clientsMu sync.RWMutex
 	clients   map[*clientSession]struct{}
+
+	retainedMu     sync.RWMutex
+	retained       map[string]retainedMessage // last retained payload per topic, replayed to new subscribers
+	clientRetained int                        // entries in retained set by clients
+
+	capture atomic.Pointer[CaptureWriter]
+
+	accepted      atomic.Uint64
+	received      atomic.Uint64
+	receivedBytes atomic.Uint64
+	forwarded     atomic.Uint64
+	dropped       atomic.Uint64
+	refused       atomic.Uint64
+	lastDropWarn  atomic.Int64 // unix nanos of the last dropped-publish warning
+}
+
+type retainedMessage struct {
+	payload []byte
+	client  bool // set by a client rather than by the server
+}
+
+// Stats is a snapshot of the broker's connection and traffic counters.
+type Stats struct {
+	Clients       int    // connections currently open
+	Accepted      uint64 // connections accepted since start
+	Received      uint64 // publishes received from clients
+	ReceivedBytes uint64 // payload bytes received
+	Forwarded     uint64 // publishes delivered to subscribers, including the server's own
+	Dropped       uint64 // publishes not delivered because the subscriber's send queue was full
+	Retained      int    // retained topics held
+	Refused       uint64 // retains refused because the retained-topic cap was reached
+}
+
+// Stats returns the broker's counters.
+func (b *Broker) Stats() Stats {
+	b.clientsMu.RLock()
+	clients := len(b.clients)
+	b.clientsMu.RUnlock()
+	b.retainedMu.RLock()
+	retained := len(b.retained)
+	b.retainedMu.RUnlock()
+	return Stats{
+		Clients:       clients,
+		Accepted:      b.accepted.Load(),
+		Received:      b.received.Load(),
+		ReceivedBytes: b.receivedBytes.Load(),
+		Forwarded:     b.forwarded.Load(),
+		Dropped:       b.dropped.Load(),
+		Retained:      retained,
+		Refused:       b.refused.Load(),
+	}
 }
 
 // New constructs a broker with the supplied logger.
 func New(logger *slog.Logger) *Broker {
-	b := &Broker{logger: logger, clients: make(map[*clientSession]struct{})}
+	b := &Broker{logger: logger, clients: make(map[*clientSession]struct{}), retained: make(map[string]retainedMessage)}
 	b.handler.Store(Handler(func(context.Context, PublishMessage) {}))
 	return b
 }
@@ -123,8 +273,13 @@ func (b *Broker) Start(bind string) (<-chan error, error) {
 
 			session := newSession(conn)
 			b.addClient(session)
+			b.accepted.Add(1)
 
-			b.wg.Add(1)
+			b.wg.Add(2)
+			go func() {
+				defer b.wg.Done()
+				session.writeLoop(b.logger)
+			}()
 			go func() {
 				defer b.wg.Done()
 				b.handleConn(session)
@@ -170,6 +325,12 @@ func (b *Broker) SetPublishHandler(h Handler) {
 	b.handler.Store(h)
 }
 
+// SetCapture records every publish received from clients to c, with its receive time; nil stops.
+// Messages the server publishes itself are not recorded.
+func (b *Broker) SetCapture(c *CaptureWriter) {
+	b.capture.Store(c)
+}
+
 // Addr returns the network address the broker is currently bound to.
 func (b *Broker) Addr() net.Addr {
 	b.mu.Lock()
@@ -180,24 +341,87 @@ func (b *Broker) Addr() net.Addr {
 	return b.listener.Addr()
 }
 
-// Publish sends a QoS 0 message to all clients subscribed to the topic.
+// PublishRetained publishes like Publish and also keeps the payload as the topic's retained message,
+// delivered to every later subscriber. An empty payload clears it. The message is published even when
+// the retained-topic cap refuses to keep it, in which case ErrRetainedFull is returned.
+func (b *Broker) PublishRetained(topic string, payload []byte) error {
+	retainErr := b.retain(topic, payload, false)
+	if err := b.Publish(topic, payload); err != nil {
+		return err
+	}
+	return retainErr
+}
+
+// retain stores or clears a topic's retained message. A new topic is refused once the broker holds
+// maxRetainedTopics, or for a client once clients hold maxClientRetained; replacing or clearing an
+// existing topic always succeeds.
+func (b *Broker) retain(topic string, payload []byte, client bool) error {
+	b.retainedMu.Lock()
+	defer b.retainedMu.Unlock()
+	old, exists := b.retained[topic]
+	if len(payload) == 0 {
+		if exists {
+			delete(b.retained, topic)
+			if old.client {
+				b.clientRetained--
+			}
+		}
+		return nil
+	}
+	if !exists && (len(b.retained) >= maxRetainedTopics || client && b.clientRetained >= maxClientRetained) {
+		refused := b.refused.Add(1)
+		b.warnDropped("retained message limit reached, not retaining", "topic", topic, "refused", refused)
+		return ErrRetainedFull
+	}
+	if old.client {
+		b.clientRetained--
+	}
+	if client {
+		b.clientRetained++
+	}
+	b.retained[topic] = retainedMessage{payload: append([]byte(nil), payload...), client: client}
+	return nil
+}
+
+// Publish queues a QoS 0 message for every client subscribed to the topic. It never waits on a
+// client's socket: subscribers whose send queue is full miss the message.
 func (b *Broker) Publish(topic string, payload []byte) error {
-	packet, err := buildPublishPacket(topic, payload)
+	packet, err := buildPublishPacket(topic, payload, false)
 	if err != nil {
 		return err
 	}
+	b.deliver(topic, packet, nil)
+	return nil
+}
 
+// deliver offers packet to every subscriber of topic except exclude.
+func (b *Broker) deliver(topic string, packet []byte, exclude *clientSession) {
 	b.clientsMu.RLock()
 	defer b.clientsMu.RUnlock()
 
 	for session := range b.clients {
-		if session.subscribed(topic) {
-			if err := session.writePacket(packet); err != nil {
-				b.logger.Warn("publish to subscriber failed", "client", session.clientID, "error", err)
-			}
+		if session == exclude || !session.subscribed(topic) {
+			continue
+		}
+		if session.offer(packet) {
+			b.forwarded.Add(1)
+			continue
+		}
+		if !session.closed.Load() {
+			dropped := b.dropped.Add(1)
+			b.warnDropped("subscriber send queue full, dropping publish", "client", session.clientID, "topic", topic, "dropped", dropped)
 		}
 	}
-	return nil
+}
+
+// warnDropped logs at most once per dropWarnInterval across the broker.
+func (b *Broker) warnDropped(msg string, args ...any) {
+	now := time.Now().UnixNano()
+	last := b.lastDropWarn.Load()
+	if now-last < int64(dropWarnInterval) || !b.lastDropWarn.CompareAndSwap(last, now) {
+		return
+	}
+	b.logger.Warn(msg, args...)
 }
 
 func (b *Broker) addClient(session *clientSession) {
@@ -216,6 +440,7 @@ func (b *Broker) handleConn(session *clientSession) {
 	defer func() {
 		session.closed.Store(true)
 		b.removeClient(session)
+		close(session.quit)
 		_ = session.conn.Close()
 	}()
 
@@ -257,6 +482,15 @@ func (b *Broker) handleConn(session *clientSession) {
 				return
 			}
 			msg.ClientID = session.clientID
+			msg.ReceivedAt = time.Now()
+			b.received.Add(1)
+			b.receivedBytes.Add(uint64(len(msg.Payload)))
+			if c := b.capture.Load(); c != nil {
+				c.Record(msg.ReceivedAt, msg)
+			}
+			if msg.Retain {
+				_ = b.retain(msg.Topic, msg.Payload, true)
+			}
 			if h, ok := b.handler.Load().(Handler); ok {
 				safeInvoke(h, ctx, msg, b.logger)
 			}
@@ -364,7 +598,34 @@ func (b *Broker) handleSubscribe(session *clientSession, payload []byte) error {
 	if err != nil {
 		return err
 	}
-	return session.writePacket(packet)
+	if err := session.writePacket(packet); err != nil {
+		return err
+	}
+	return b.sendRetained(session, topics)
+}
+
+// sendRetained delivers the retained messages matching newly subscribed filters, flagged as retained.
+func (b *Broker) sendRetained(session *clientSession, filters []string) error {
+	b.retainedMu.RLock()
+	var packets [][]byte
+	for topic, msg := range b.retained {
+		for _, filter := range filters {
+			if topicMatches(filter, topic) {
+				if packet, err := buildPublishPacket(topic, msg.payload, true); err == nil {
+					packets = append(packets, packet)
+				}
+				break
+			}
+		}
+	}
+	b.retainedMu.RUnlock()
+
+	for _, packet := range packets {
+		if err := session.writePacket(packet); err != nil {
+			return fmt.Errorf("write retained: %w", err)
+		}
+	}
+	return nil
 }
 
 func (b *Broker) writeUnsubAck(session *clientSession, payload []byte) error {
@@ -380,24 +641,11 @@ func (b *Broker) writeUnsubAck(session *clientSession, payload []byte) error {
 }
 
 func (b *Broker) forwardToSubscribers(topic string, payload []byte, exclude *clientSession) {
-	packet, err := buildPublishPacket(topic, payload)
+	packet, err := buildPublishPacket(topic, payload, false)
 	if err != nil {
 		return
 	}
-
-	b.clientsMu.RLock()
-	defer b.clientsMu.RUnlock()
-
-	for session := range b.clients {
-		if session == exclude {
-			continue
-		}
-		if session.subscribed(topic) {
-			if err := session.writePacket(packet); err != nil {
-				b.logger.Debug("forward publish failed", "client", session.clientID, "error", err)
-			}
-		}
-	}
+	b.deliver(topic, packet, exclude)
 }
 
 func safeInvoke(h Handler, ctx context.Context, msg PublishMessage, logger *slog.Logger) {
@@ -421,15 +669,16 @@ func parsePublish(header byte, payload []byte) (PublishMessage, error) {
 		return PublishMessage{}, fmt.Errorf("read topic: %w", err)
 	}
 
+	retain := header&0x01 != 0
 	if rd.remaining() == 0 {
-		return PublishMessage{Topic: topic, Payload: nil}, nil
+		return PublishMessage{Topic: topic, Payload: nil, Retain: retain}, nil
 	}
 
 	data := rd.readBytes(rd.remaining())
-	return PublishMessage{Topic: topic, Payload: data}, nil
+	return PublishMessage{Topic: topic, Payload: data, Retain: retain}, nil
 }
 
-func buildPublishPacket(topic string, payload []byte) ([]byte, error) {
+func buildPublishPacket(topic string, payload []byte, retain bool) ([]byte, error) {
 	topicLen := len(topic)
 	if topicLen > 65535 {
 		return nil, fmt.Errorf("topic too long")
@@ -439,7 +688,11 @@ func buildPublishPacket(topic string, payload []byte) ([]byte, error) {
 	remainingBytes := encodeRemainingLength(remaining)
 
 	packet := make([]byte, 0, 1+len(remainingBytes)+remaining)
-	packet = append(packet, 0x30)
+	header := byte(0x30)
+	if retain {
+		header |= 0x01
+	}
+	packet = append(packet, header)
 	packet = append(packet, remainingBytes...)
 	packet = append(packet, byte(topicLen>>8), byte(topicLen&0xFF))
 	packet = append(packet, topic...)
@@ -510,6 +763,9 @@ func (b *bytesReader) remaining() int {
 	return len(*b)
 }
 
+// maxPacketSize is the largest remaining length the 4-byte MQTT encoding, and so readVarInt, allows.
+const maxPacketSize = 1<<28 - 1
+
 func readVarInt(r *bufio.Reader) (int, error) {
 	multiplier := 1
 	value := 0
@@ -0,0 +1,288 @@
+package mqttbroker
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"os"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// Capture files hold received publishes in arrival order:
+//
+//	header:  "CLCAP1\n" | start time, int64 Unix nanos, big endian
+//	record:  uvarint nanos since the previous record | flags byte (bit 0 retain) |
+//	         client ref | topic ref | uvarint payload length | payload
+//
+// A ref is a uvarint: 0 is followed by a uvarint length and the string, which also joins the
+// dictionary while it has room; n > 0 refers to dictionary entry n-1. Topics and client IDs repeat
+// on every message, so a reading costs a few bytes beyond its payload.
+const (
+	captureMagic     = "CLCAP1\n"
+	captureDictLimit = 4096
+	captureFlushTick = time.Second
+	captureQueueLen  = 8192 // publishes waiting for the writer goroutine
+
+	// captureMaxString bounds a client ID or topic read back; MQTT encodes both with a 16-bit length.
+	captureMaxString = 1<<16 - 1
+)
+
+// CapturedMessage is one publish read back from a capture.
+type CapturedMessage struct {
+	At time.Time
+	PublishMessage
+}
+
+// CaptureWriter appends received publishes to a capture file. Record only queues the publish; one
+// goroutine encodes, writes and flushes every second, so connection goroutines never wait on disk
+// and at most a second of traffic is lost on a crash. It is safe for concurrent use.
+type CaptureWriter struct {
+	file    *os.File
+	buf     *bufio.Writer
+	last    int64
+	dict    map[string]uint64
+	err     error // owned by the writer goroutine until it exits
+	records chan capturedRecord
+	count   atomic.Uint64
+	dropped atomic.Uint64
+	done    chan struct{}
+	wg      sync.WaitGroup
+}
+
+type capturedRecord struct {
+	at  int64
+	msg PublishMessage
+}
+
+// CreateCapture creates a new capture file at path; an existing file is not overwritten.
+func CreateCapture(path string) (*CaptureWriter, error) {
+	f, err := os.OpenFile(path, os.O_WRONLY|os.O_CREATE|os.O_EXCL, 0o644)
+	if err != nil {
+		return nil, fmt.Errorf("create capture: %w", err)
+	}
+	start := time.Now().UnixNano()
+	c := &CaptureWriter{
+		file:    f,
+		buf:     bufio.NewWriterSize(f, 64<<10),
+		last:    start,
+		dict:    make(map[string]uint64),
+		records: make(chan capturedRecord, captureQueueLen),
+		done:    make(chan struct{}),
+	}
+	c.buf.WriteString(captureMagic)
+	binary.Write(c.buf, binary.BigEndian, start)
+
+	c.wg.Add(1)
+	go c.writeLoop()
+	return c, nil
+}
+
+// Record queues msg as received at at. When the writer has fallen a full queue behind the publish
+// is dropped and counted rather than stalling the connection. After a write error the capture stops
+// recording and the error is returned by Close.
+func (c *CaptureWriter) Record(at time.Time, msg PublishMessage) {
+	select {
+	case c.records <- capturedRecord{at: at.UnixNano(), msg: msg}:
+	default:
+		c.dropped.Add(1)
+	}
+}
+
+func (c *CaptureWriter) write(rec capturedRecord) {
+	if c.err != nil {
+		return
+	}
+	var scratch [binary.MaxVarintLen64]byte
+	delta := uint64(0)
+	if rec.at > c.last {
+		delta = uint64(rec.at - c.last)
+		c.last = rec.at
+	}
+	c.buf.Write(scratch[:binary.PutUvarint(scratch[:], delta)])
+	var flags byte
+	if rec.msg.Retain {
+		flags |= 1
+	}
+	c.buf.WriteByte(flags)
+	c.writeRef(rec.msg.ClientID)
+	c.writeRef(rec.msg.Topic)
+	c.buf.Write(scratch[:binary.PutUvarint(scratch[:], uint64(len(rec.msg.Payload)))])
+	_, c.err = c.buf.Write(rec.msg.Payload)
+	c.count.Add(1)
+}
+
+func (c *CaptureWriter) writeRef(s string) {
+	var scratch [binary.MaxVarintLen64]byte
+	if ref, ok := c.dict[s]; ok {
+		c.buf.Write(scratch[:binary.PutUvarint(scratch[:], ref)])
+		return
+	}
+	if len(c.dict) < captureDictLimit {
+		c.dict[s] = uint64(len(c.dict) + 1)
+	}
+	c.buf.WriteByte(0)
+	c.buf.Write(scratch[:binary.PutUvarint(scratch[:], uint64(len(s)))])
+	c.buf.WriteString(s)
+}
+
+// Count returns the number of publishes recorded.
+func (c *CaptureWriter) Count() uint64 {
+	return c.count.Load()
+}
+
+// Dropped returns the number of publishes dropped because the writer fell behind.
+func (c *CaptureWriter) Dropped() uint64 {
+	return c.dropped.Load()
+}
+
+func (c *CaptureWriter) writeLoop() {
+	defer c.wg.Done()
+	ticker := time.NewTicker(captureFlushTick)
+	defer ticker.Stop()
+	for {
+		select {
+		case rec := <-c.records:
+			c.write(rec)
+		case <-ticker.C:
+			if c.err == nil {
+				c.err = c.buf.Flush()
+			}
+		case <-c.done:
+			for {
+				select {
+				case rec := <-c.records:
+					c.write(rec)
+				default:
+					return
+				}
+			}
+		}
+	}
+}
+
+// Close writes the queued publishes, flushes and closes the file. Stop passing publishes to Record
+// first; any recorded after Close are discarded.
+func (c *CaptureWriter) Close() error {
+	close(c.done)
+	c.wg.Wait()
+	if c.err == nil {
+		c.err = c.buf.Flush()
+	}
+	if err := c.file.Close(); c.err == nil {
+		c.err = err
+	}
+	return c.err
+}
+
+// CaptureReader reads publishes back from a capture file.
+type CaptureReader struct {
+	r    *bufio.Reader
+	last int64
+	dict []string
+}
+
+// NewCaptureReader checks the capture header and returns a reader positioned at the first record.
+func NewCaptureReader(r io.Reader) (*CaptureReader, error) {
+	br := bufio.NewReaderSize(r, 64<<10)
+	magic := make([]byte, len(captureMagic))
+	if _, err := io.ReadFull(br, magic); err != nil || string(magic) != captureMagic {
+		return nil, fmt.Errorf("not a capture file")
+	}
+	var start int64
+	if err := binary.Read(br, binary.BigEndian, &start); err != nil {
+		return nil, fmt.Errorf("read capture header: %w", err)
+	}
+	return &CaptureReader{r: br, last: start}, nil
+}
+
+// Next returns the next publish, or io.EOF after the last one. A record cut short by a crash
+// mid-write is reported as io.ErrUnexpectedEOF.
+func (cr *CaptureReader) Next() (CapturedMessage, error) {
+	delta, err := binary.ReadUvarint(cr.r)
+	if err != nil {
+		return CapturedMessage{}, err
+	}
+	cr.last += int64(delta)
+	msg := CapturedMessage{At: time.Unix(0, cr.last)}
+	flags, err := cr.r.ReadByte()
+	if err != nil {
+		return CapturedMessage{}, truncated(err)
+	}
+	msg.Retain = flags&1 != 0
+	if msg.ClientID, err = cr.readRef(); err != nil {
+		return CapturedMessage{}, truncated(err)
+	}
+	if msg.Topic, err = cr.readRef(); err != nil {
+		return CapturedMessage{}, truncated(err)
+	}
+	n, err := binary.ReadUvarint(cr.r)
+	if err != nil {
+		return CapturedMessage{}, truncated(err)
+	}
+	if n > maxPacketSize {
+		return CapturedMessage{}, fmt.Errorf("capture: payload length %d exceeds the maximum packet size", n)
+	}
+	if n > 0 {
+		if msg.Payload, err = readCaptured(cr.r, n); err != nil {
+			return CapturedMessage{}, truncated(err)
+		}
+	}
+	return msg, nil
+}
+
+func (cr *CaptureReader) readRef() (string, error) {
+	ref, err := binary.ReadUvarint(cr.r)
+	if err != nil {
+		return "", err
+	}
+	if ref > 0 {
+		if ref > uint64(len(cr.dict)) {
+			return "", fmt.Errorf("capture: bad dictionary reference %d", ref)
+		}
+		return cr.dict[ref-1], nil
+	}
+	n, err := binary.ReadUvarint(cr.r)
+	if err != nil {
+		return "", err
+	}
+	if n > captureMaxString {
+		return "", fmt.Errorf("capture: string length %d exceeds %d", n, captureMaxString)
+	}
+	b, err := readCaptured(cr.r, n)
+	if err != nil {
+		return "", err
+	}
+	s := string(b)
+	if len(cr.dict) < captureDictLimit {
+		cr.dict = append(cr.dict, s)
+	}
+	return s, nil
+}
+
+// readCaptured reads n bytes. Large lengths are read in chunks, so a corrupt length in a short file
+// fails at the end of the input instead of allocating n bytes up front.
+func readCaptured(r io.Reader, n uint64) ([]byte, error) {
+	const chunk = 64 << 10
+	if n <= chunk {
+		b := make([]byte, n)
+		_, err := io.ReadFull(r, b)
+		return b, err
+	}
+	var buf bytes.Buffer
+	if _, err := io.CopyN(&buf, r, int64(n)); err != nil {
+		return nil, err
+	}
+	return buf.Bytes(), nil
+}
+
+func truncated(err error) error {
+	if errors.Is(err, io.EOF) {
+		return io.ErrUnexpectedEOF
+	}
+	return err
+}
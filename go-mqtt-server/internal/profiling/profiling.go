@@ -0,0 +1,161 @@
+// Package profiling runs continuous low-duty-cycle CPU profiling into a rolling in-memory buffer and
+// arbitrates the process-wide CPU profiler between it and on-demand captures.
+package profiling
+
+import (
+	"bytes"
+	"context"
+	"errors"
+	"log/slog"
+	"runtime/pprof"
+	"sort"
+	"sync"
+	"time"
+)
+
+// The runtime allows one CPU profile at a time. cpuSlot is held by whoever is profiling; continuous
+// profiling skips a window while an on-demand capture holds it.
+var cpuSlot = make(chan struct{}, 1)
+
+// AcquireCPU waits until no other CPU profile is running and returns the function that releases it.
+func AcquireCPU(ctx context.Context) (release func(), err error) {
+	select {
+	case cpuSlot <- struct{}{}:
+		return func() { <-cpuSlot }, nil
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+}
+
+func tryAcquireCPU() (release func(), ok bool) {
+	select {
+	case cpuSlot <- struct{}{}:
+		return func() { <-cpuSlot }, true
+	default:
+		return nil, false
+	}
+}
+
+// CPU profiles the process for d, or until ctx is cancelled, and returns the encoded profile. The
+// caller must hold the CPU slot.
+func CPU(ctx context.Context, d time.Duration) ([]byte, error) {
+	var buf bytes.Buffer
+	if err := pprof.StartCPUProfile(&buf); err != nil {
+		return nil, err
+	}
+	timer := time.NewTimer(d)
+	select {
+	case <-timer.C:
+	case <-ctx.Done():
+		timer.Stop()
+	}
+	pprof.StopCPUProfile()
+	return buf.Bytes(), nil
+}
+
+// Profile is one window of the continuous CPU profile.
+type Profile struct {
+	Start    time.Time
+	Duration time.Duration
+	Data     []byte // gzipped pprof protobuf
+}
+
+// Continuous profiles the CPU for Window out of every Period and keeps the profiles taken within
+// Retention. At the defaults that is 10 s a minute, so the profiler's own cost stays near 1/6 of
+// the usual 100 Hz sampling overhead.
+type Continuous struct {
+	Window    time.Duration
+	Period    time.Duration
+	Retention time.Duration
+	Logger    *slog.Logger
+
+	mu       sync.RWMutex
+	profiles []Profile // oldest first
+	skipped  int
+}
+
+// Default continuous profiling cadence.
+const (
+	DefaultWindow = 10 * time.Second
+	DefaultPeriod = time.Minute
+)
+
+// NewContinuous returns a profiler keeping retention worth of profiles at the default cadence.
+func NewContinuous(retention time.Duration, logger *slog.Logger) *Continuous {
+	return &Continuous{Window: DefaultWindow, Period: DefaultPeriod, Retention: retention, Logger: logger}
+}
+
+// Run profiles until ctx is cancelled.
+func (c *Continuous) Run(ctx context.Context) {
+	ticker := time.NewTicker(c.Period)
+	defer ticker.Stop()
+	for {
+		c.collect(ctx)
+		select {
+		case <-ctx.Done():
+			return
+		case <-ticker.C:
+		}
+	}
+}
+
+func (c *Continuous) collect(ctx context.Context) {
+	release, ok := tryAcquireCPU()
+	if !ok {
+		c.mu.Lock()
+		c.skipped++
+		c.mu.Unlock()
+		return
+	}
+	start := time.Now()
+	data, err := CPU(ctx, c.Window)
+	release()
+	if err != nil {
+		// Another profiler outside this package (e.g. a test harness) owns the CPU profile.
+		c.Logger.Debug("continuous cpu profile skipped", "error", err)
+		return
+	}
+	if ctx.Err() != nil {
+		return
+	}
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	cutoff := start.Add(-c.Retention)
+	drop := sort.Search(len(c.profiles), func(i int) bool { return c.profiles[i].Start.After(cutoff) })
+	c.profiles = append(c.profiles[:copy(c.profiles, c.profiles[drop:])], Profile{
+		Start:    start,
+		Duration: time.Since(start),
+		Data:     data,
+	})
+}
+
+// Profiles returns the retained profiles started at or after since, oldest first.
+func (c *Continuous) Profiles(since time.Time) []Profile {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	i := sort.Search(len(c.profiles), func(i int) bool { return !c.profiles[i].Start.Before(since) })
+	return append([]Profile(nil), c.profiles[i:]...)
+}
+
+// Skipped returns how many windows were skipped because an on-demand CPU profile was running.
+func (c *Continuous) Skipped() int {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	return c.skipped
+}
+
+// ErrNoProfile is returned by Lookup when no retained profile starts at the requested time.
+var ErrNoProfile = errors.New("no such profile")
+
+// Lookup returns the retained profile that started at the given Unix second.
+func (c *Continuous) Lookup(unix int64) (Profile, error) {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	for _, p := range c.profiles {
+		if p.Start.Unix() == unix {
+			return p, nil
+		}
+	}
+	return Profile{}, ErrNoProfile
+}
@@ -0,0 +1,65 @@
+package sim
+
+import (
+	"fmt"
+	"strconv"
+	"time"
+)
+
+// Scanner firmware timestamp layouts, UTC: readings carry milliseconds, inventory whole seconds.
+const (
+	firmwareReadingTime = "2006-01-02T15:04:05.000Z"
+	firmwareTime        = "2006-01-02T15:04:05Z"
+)
+
+// AppendFirmwareReading appends a beacons/<id>/readings payload formatted as the ESP32 scanner
+// firmware writes it: field order, millisecond timestamp, per-boot seq, two-decimal location and
+// the sent_at stamp added at publish time, here equal to the capture time.
+func AppendFirmwareReading(dst []byte, b Beacon, tagID string, rssi int, at time.Time, seq uint32) []byte {
+	dst = append(dst, `{"beacon_id":"`...)
+	dst = append(dst, b.ID...)
+	dst = append(dst, `","tag_id":"`...)
+	dst = append(dst, tagID...)
+	dst = append(dst, `","rssi":`...)
+	dst = strconv.AppendInt(dst, int64(rssi), 10)
+	dst = append(dst, `,"timestamp":"`...)
+	dst = at.UTC().AppendFormat(dst, firmwareReadingTime)
+	dst = append(dst, `","seq":`...)
+	dst = strconv.AppendUint(dst, uint64(seq), 10)
+	dst = append(dst, `,"beacon_location":{"x":`...)
+	dst = strconv.AppendFloat(dst, b.X, 'f', 2, 64)
+	dst = append(dst, `,"y":`...)
+	dst = strconv.AppendFloat(dst, b.Y, 'f', 2, 64)
+	dst = append(dst, `,"z":`...)
+	dst = strconv.AppendFloat(dst, b.Z, 'f', 2, 64)
+	dst = append(dst, `},"sent_at":"`...)
+	dst = at.UTC().AppendFormat(dst, firmwareReadingTime)
+	return append(dst, `"}`...)
+}
+
+// AppendFirmwareInventory appends the scanners/<id>/inventory payload an unassigned scanner (no
+// beacon ID configured) publishes for each advertisement it hears.
+func AppendFirmwareInventory(dst []byte, scannerID, tagAddress, tagName string, rssi int, at time.Time) []byte {
+	dst = append(dst, `{"scanner_id":"`...)
+	dst = append(dst, scannerID...)
+	dst = append(dst, `","tag_address":"`...)
+	dst = append(dst, tagAddress...)
+	dst = append(dst, `","tag_name":"`...)
+	dst = append(dst, tagName...)
+	dst = append(dst, `","rssi":`...)
+	dst = strconv.AppendInt(dst, int64(rssi), 10)
+	dst = append(dst, `,"timestamp":"`...)
+	dst = at.UTC().AppendFormat(dst, firmwareTime)
+	return append(dst, `","event_type":"ADV_IND"}`...)
+}
+
+// ScannerID returns the firmware's scanner identifier for the n-th simulated device, derived from a
+// synthetic MAC address as the firmware derives it from the real one.
+func ScannerID(n int) string {
+	return fmt.Sprintf("scanner-C0FFEE%06X", n&0xFFFFFF)
+}
+
+// TagAddress returns a synthetic BLE address for the n-th simulated tag.
+func TagAddress(n int) string {
+	return fmt.Sprintf("C4:A7:00:%02X:%02X:%02X", (n>>16)&0xFF, (n>>8)&0xFF, n&0xFF)
+}
@@ -0,0 +1,195 @@
+// Package sim generates synthetic beacon readings for a tag walking through a house. It is shared
+// by beacon-sim, which publishes the readings to a broker, and accuracy-bench, which scores the
+// server's positions against the ground truth the readings carry.
+package sim
+
+import (
+	"encoding/json"
+	"fmt"
+	"math"
+	"math/rand"
+	"os"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// Floors is the number of stories in the simulated house.
+const Floors = 3
+
+// Beacon is a fixed scanner position.
+type Beacon struct {
+	ID string  `json:"id"`
+	X  float64 `json:"x"`
+	Y  float64 `json:"y"`
+	Z  float64 `json:"z"`
+}
+
+// House is the box the tag walks in, in metres.
+type House struct {
+	Width, Depth, Height float64
+}
+
+// DefaultHouse is a 40 x 25 ft, three-story house.
+func DefaultHouse() House {
+	return House{Width: FeetToMeters(40), Depth: FeetToMeters(25), Height: FeetToMeters(30)}
+}
+
+// FloorHeight is the height of one story.
+func (h House) FloorHeight() float64 {
+	return h.Height / Floors
+}
+
+// DefaultBeacons places a beacon in each corner of every floor, at mid-story height.
+func (h House) DefaultBeacons() []Beacon {
+	floor := h.FloorHeight()
+	corners := [][2]float64{{0, 0}, {h.Width, 0}, {0, h.Depth}, {h.Width, h.Depth}}
+	var beacons []Beacon
+	id := 1
+	for f := 0; f < Floors; f++ {
+		z := (float64(f) + 0.5) * floor
+		for _, c := range corners {
+			beacons = append(beacons, Beacon{ID: fmt.Sprintf("sim-beacon-%d", id), X: c[0], Y: c[1], Z: z})
+			id++
+		}
+	}
+	return beacons
+}
+
+// Rooms splits every floor into a cols x rows grid of box rooms anchored at mid-story height.
+func (h House) Rooms(cols, rows int) []model.RoomDefinition {
+	floor := h.FloorHeight()
+	w, d := h.Width/float64(cols), h.Depth/float64(rows)
+	var rooms []model.RoomDefinition
+	for f := 0; f < Floors; f++ {
+		for r := 0; r < rows; r++ {
+			for c := 0; c < cols; c++ {
+				x0, y0 := float64(c)*w, float64(r)*d
+				rooms = append(rooms, model.RoomDefinition{
+					Name:  fmt.Sprintf("floor%d-room%d", f+1, r*cols+c+1),
+					X:     x0 + w/2,
+					Y:     y0 + d/2,
+					Z:     (float64(f) + 0.5) * floor,
+					Floor: f,
+					Polygon: []model.Point2D{
+						{X: x0, Y: y0}, {X: x0 + w, Y: y0}, {X: x0 + w, Y: y0 + d}, {X: x0, Y: y0 + d},
+					},
+					ZMin: float64(f) * floor,
+					ZMax: float64(f+1) * floor,
+				})
+			}
+		}
+	}
+	return rooms
+}
+
+// RandomPoint returns a uniform point inside the house.
+func (h House) RandomPoint(rng *rand.Rand) [3]float64 {
+	return [3]float64{rng.Float64() * h.Width, rng.Float64() * h.Depth, rng.Float64() * h.Height}
+}
+
+// Clamp moves pos back inside the house.
+func (h House) Clamp(pos *[3]float64) {
+	pos[0] = math.Min(math.Max(pos[0], 0), h.Width)
+	pos[1] = math.Min(math.Max(pos[1], 0), h.Depth)
+	pos[2] = math.Min(math.Max(pos[2], 0), h.Height)
+}
+
+// LoadBeacons reads a JSON array of {id,x,y,z} beacon definitions.
+func LoadBeacons(path string) ([]Beacon, error) {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return nil, fmt.Errorf("read beacon config: %w", err)
+	}
+	var beacons []Beacon
+	if err := json.Unmarshal(data, &beacons); err != nil {
+		return nil, fmt.Errorf("parse beacon config: %w", err)
+	}
+	return beacons, nil
+}
+
+// Radio is the log-distance path-loss model readings are drawn from.
+type Radio struct {
+	TxPower  float64 // expected RSSI at 1 m
+	PathLoss float64 // path-loss exponent
+	NoiseStd float64 // Gaussian RSSI noise in dB
+}
+
+// RSSI draws a noisy reading for a tag dist metres from the beacon.
+func (r Radio) RSSI(dist float64, rng *rand.Rand) float64 {
+	dist = math.Max(dist, 0.01)
+	return r.TxPower - 10*r.PathLoss*math.Log10(dist) + rng.NormFloat64()*r.NoiseStd
+}
+
+// Tag is a simulated collar doing a Gaussian random walk.
+type Tag struct {
+	ID         string
+	Pos        [3]float64
+	Step       float64 // per-axis standard deviation of one move, metres
+	Stationary bool
+}
+
+// Move advances the walk by one step, staying inside the house.
+func (t *Tag) Move(h House, rng *rand.Rand) {
+	if t.Stationary {
+		return
+	}
+	for i := range t.Pos {
+		t.Pos[i] += rng.NormFloat64() * t.Step
+	}
+	h.Clamp(&t.Pos)
+}
+
+// Location returns the tag's true position.
+func (t *Tag) Location() model.Location {
+	return model.Location{X: t.Pos[0], Y: t.Pos[1], Z: t.Pos[2]}
+}
+
+// Distance returns the tag's distance from b.
+func (t *Tag) Distance(b Beacon) float64 {
+	dx, dy, dz := b.X-t.Pos[0], b.Y-t.Pos[1], b.Z-t.Pos[2]
+	return math.Sqrt(dx*dx + dy*dy + dz*dz)
+}
+
+// Reading is the JSON published on beacons/<id>/readings. Metadata carries the tag's true position
+// (tag_x/tag_y/tag_z), which the server records as a calibration sample.
+type Reading struct {
+	BeaconID       string             `json:"beacon_id"`
+	TagID          string             `json:"tag_id"`
+	RSSI           int                `json:"rssi"`
+	Timestamp      string             `json:"timestamp"`
+	BeaconLocation map[string]float64 `json:"beacon_location"`
+	Metadata       map[string]string  `json:"metadata,omitempty"`
+}
+
+// NewReading builds the reading b reports for t at at.
+func NewReading(b Beacon, t *Tag, rssi float64, at time.Time) Reading {
+	return Reading{
+		BeaconID:  b.ID,
+		TagID:     t.ID,
+		RSSI:      int(math.Round(rssi)),
+		Timestamp: at.UTC().Format(time.RFC3339Nano),
+		BeaconLocation: map[string]float64{
+			"x": b.X,
+			"y": b.Y,
+			"z": b.Z,
+		},
+		Metadata: map[string]string{
+			"source":         "simulator",
+			"tag_x":          fmt.Sprintf("%.2f", t.Pos[0]),
+			"tag_y":          fmt.Sprintf("%.2f", t.Pos[1]),
+			"tag_z":          fmt.Sprintf("%.2f", t.Pos[2]),
+			"tag_stationary": fmt.Sprintf("%t", t.Stationary),
+		},
+	}
+}
+
+// Topic is the MQTT topic b publishes readings on.
+func (b Beacon) Topic() string {
+	return "beacons/" + b.ID + "/readings"
+}
+
+// FeetToMeters converts a length in feet to metres.
+func FeetToMeters(ft float64) float64 {
+	return ft * 0.3048
+}
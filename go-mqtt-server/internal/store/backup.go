@@ -0,0 +1,204 @@
+package store
+
+import (
+	"context"
+	"database/sql"
+	"errors"
+	"fmt"
+	"os"
+	"path/filepath"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+
+	sqlite "modernc.org/sqlite"
+)
+
+// BackupOptions controls how an online snapshot is throttled.
+type BackupOptions struct {
+	// PagesPerStep bounds how many database pages are copied while the connection is held.
+	PagesPerStep int
+	// Pause is the idle time between steps during which ingest can use the connection.
+	Pause time.Duration
+}
+
+// BackupResult summarises a completed snapshot.
+type BackupResult struct {
+	Path          string    `json:"path"`
+	Bytes         int64     `json:"bytes"`
+	Steps         int       `json:"steps"`
+	MaxReadingID  int64     `json:"max_reading_id"`
+	StartedAt     time.Time `json:"started_at"`
+	CompletedAt   time.Time `json:"completed_at"`
+	DurationMilli int64     `json:"duration_ms"`
+}
+
+type backuper interface {
+	NewBackup(dstURI string) (*sqlite.Backup, error)
+}
+
+// Snapshot writes a consistent copy of the live database to dst using the SQLite online backup API.
+//
+// The copy proceeds in PagesPerStep increments and releases the connection between steps, so
+// ingest keeps writing while the snapshot runs. Writes made through the same connection are
+// mirrored into the backup by SQLite, which keeps the result consistent without a global lock.
+func (s *Store) Snapshot(ctx context.Context, dst string, opts BackupOptions) (BackupResult, error) {
+	if s.db == nil {
+		return BackupResult{}, fmt.Errorf("store not initialized")
+	}
+
+	if opts.PagesPerStep <= 0 {
+		opts.PagesPerStep = 256
+	}
+
+	if err := os.MkdirAll(filepath.Dir(dst), 0o755); err != nil {
+		return BackupResult{}, fmt.Errorf("create backup directory: %w", err)
+	}
+
+	partial := dst + ".partial"
+	_ = os.Remove(partial)
+
+	result := BackupResult{Path: dst, StartedAt: time.Now().UTC()}
+
+	var (
+		bck       *sqlite.Backup
+		owner     any
+		finished  bool
+		finishErr error
+	)
+
+	finish := func() {
+		if bck != nil {
+			finishErr = bck.Finish()
+			bck = nil
+		}
+	}
+	defer finish()
+
+	for !finished {
+		conn, err := s.db.Conn(ctx)
+		if err != nil {
+			return BackupResult{}, fmt.Errorf("backup acquire connection: %w", err)
+		}
+
+		err = conn.Raw(func(driverConn any) error {
+			if bck == nil {
+				b, ok := driverConn.(backuper)
+				if !ok {
+					return fmt.Errorf("sqlite driver does not support online backup")
+				}
+				created, err := b.NewBackup(partial)
+				if err != nil {
+					return fmt.Errorf("start backup: %w", err)
+				}
+				bck = created
+				owner = driverConn
+			} else if owner != driverConn {
+				return errBackupConnChanged
+			}
+
+			more, err := bck.Step(int32(opts.PagesPerStep))
+			if err != nil {
+				return fmt.Errorf("backup step: %w", err)
+			}
+			result.Steps++
+			finished = !more
+			if finished {
+				finish()
+			}
+			return nil
+		})
+		_ = conn.Close()
+		if err != nil {
+			_ = os.Remove(partial)
+			return BackupResult{}, err
+		}
+
+		if finished {
+			break
+		}
+
+		select {
+		case <-ctx.Done():
+			_ = os.Remove(partial)
+			return BackupResult{}, ctx.Err()
+		case <-time.After(opts.Pause):
+		}
+	}
+
+	if finishErr != nil {
+		_ = os.Remove(partial)
+		return BackupResult{}, fmt.Errorf("finish backup: %w", finishErr)
+	}
+
+	// Readings written while the copy ran may or may not have made it in, so the replay point is
+	// read from the finished snapshot rather than from the live database.
+	maxID, err := snapshotMaxReadingID(ctx, partial)
+	if err != nil {
+		_ = os.Remove(partial)
+		return BackupResult{}, err
+	}
+	result.MaxReadingID = maxID
+
+	if err := os.Rename(partial, dst); err != nil {
+		return BackupResult{}, fmt.Errorf("publish backup: %w", err)
+	}
+
+	if info, err := os.Stat(dst); err == nil {
+		result.Bytes = info.Size()
+	}
+
+	result.CompletedAt = time.Now().UTC()
+	result.DurationMilli = result.CompletedAt.Sub(result.StartedAt).Milliseconds()
+	return result, nil
+}
+
+var errBackupConnChanged = errors.New("backup aborted: database connection was recycled")
+
+// snapshotMaxReadingID returns the highest reading id contained in the snapshot file at path.
+func snapshotMaxReadingID(ctx context.Context, path string) (int64, error) {
+	db, err := sql.Open("sqlite", fmt.Sprintf("file:%s?_pragma=query_only(ON)", path))
+	if err != nil {
+		return 0, fmt.Errorf("open snapshot: %w", err)
+	}
+	defer db.Close()
+
+	var id int64
+	if err := db.QueryRowContext(ctx, `SELECT COALESCE(MAX(id), 0) FROM beacon_readings;`).Scan(&id); err != nil {
+		return 0, fmt.Errorf("snapshot max reading id: %w", err)
+	}
+	return id, nil
+}
+
+// BeaconReadingsAfter returns up to limit readings with an id greater than afterID, ordered by id.
+// It is used to cut incremental backup segments without rescanning history.
+func (s *Store) BeaconReadingsAfter(ctx context.Context, afterID int64, limit int) ([]model.StoredBeaconReading, error) {
+	if s.db == nil {
+		return nil, fmt.Errorf("store not initialized")
+	}
+
+	if limit <= 0 {
+		limit = 5000
+	}
+
+	rows, err := s.read.QueryContext(
+		ctx,
+		`SELECT id, beacon_id, tag_id, rssi, x, y, z, recorded_at, received_at
+		 FROM beacon_readings
+		 WHERE id > ?
+		 ORDER BY id ASC
+		 LIMIT ?;`,
+		afterID,
+		limit,
+	)
+	if err != nil {
+		return nil, fmt.Errorf("query readings after id: %w", err)
+	}
+	defer rows.Close()
+
+	readings, err := scanStoredReadings(rows, true, limit)
+	if err != nil {
+		return nil, fmt.Errorf("iterate readings after id: %w", err)
+	}
+	return readings, nil
+}
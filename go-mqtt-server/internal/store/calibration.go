@@ -0,0 +1,200 @@
+package store
+
+import (
+	"context"
+	"database/sql"
+	"encoding/json"
+	"fmt"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const insertCalibrationSampleSQL = `INSERT INTO calibration_samples
+	(beacon_id, tag_id, rssi, beacon_x, beacon_y, beacon_z, tag_x, tag_y, tag_z, recorded_at)
+	VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);`
+
+func calibrationSampleArgs(r model.BeaconReading, truth model.Location, recordedAt time.Time) []interface{} {
+	return []interface{}{
+		r.BeaconID,
+		r.TagID,
+		r.RSSI,
+		r.BeaconLocation.X,
+		r.BeaconLocation.Y,
+		r.BeaconLocation.Z,
+		truth.X,
+		truth.Y,
+		truth.Z,
+		recordedAt.UTC().Format(time.RFC3339Nano),
+	}
+}
+
+// CalibrationSamples returns ground-truth samples recorded at or after since, newest first.
+func (s *Store) CalibrationSamples(ctx context.Context, since time.Time, limit int) ([]model.CalibrationSample, error) {
+	if s.db == nil {
+		return nil, fmt.Errorf("store not initialized")
+	}
+
+	if limit <= 0 {
+		limit = 100000
+	}
+
+	rows, err := s.read.QueryContext(
+		ctx,
+		`SELECT beacon_id, tag_id, rssi, beacon_x, beacon_y, beacon_z, tag_x, tag_y, tag_z, recorded_at
+		 FROM calibration_samples
+		 WHERE recorded_at >= ?
+		 ORDER BY recorded_at DESC
+		 LIMIT ?;`,
+		since.UTC().Format(time.RFC3339Nano),
+		limit,
+	)
+	if err != nil {
+		return nil, fmt.Errorf("query calibration samples: %w", err)
+	}
+	defer rows.Close()
+
+	var samples []model.CalibrationSample
+	for rows.Next() {
+		var (
+			sample        model.CalibrationSample
+			recordedAtStr string
+		)
+		if err := rows.Scan(
+			&sample.BeaconID,
+			&sample.TagID,
+			&sample.RSSI,
+			&sample.BeaconLocation.X,
+			&sample.BeaconLocation.Y,
+			&sample.BeaconLocation.Z,
+			&sample.TagLocation.X,
+			&sample.TagLocation.Y,
+			&sample.TagLocation.Z,
+			&recordedAtStr,
+		); err != nil {
+			return nil, fmt.Errorf("scan calibration sample: %w", err)
+		}
+		sample.RecordedAt, _ = time.Parse(time.RFC3339Nano, recordedAtStr)
+		samples = append(samples, sample)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("iterate calibration samples: %w", err)
+	}
+
+	return samples, nil
+}
+
+// SavePathLossCalibration stores a new calibration version, optionally making it the active one.
+func (s *Store) SavePathLossCalibration(ctx context.Context, cal model.PathLossCalibration, activate bool) (int64, error) {
+	if s.db == nil {
+		return 0, fmt.Errorf("store not initialized")
+	}
+
+	params, err := json.Marshal(struct {
+		Default model.PathLossParams            `json:"default"`
+		Beacons map[string]model.PathLossParams `json:"beacons"`
+	}{cal.Default, cal.Beacons})
+	if err != nil {
+		return 0, fmt.Errorf("encode path-loss calibration: %w", err)
+	}
+
+	tx, err := s.db.BeginTx(ctx, nil)
+	if err != nil {
+		return 0, fmt.Errorf("begin path-loss calibration: %w", err)
+	}
+	defer tx.Rollback()
+
+	res, err := tx.ExecContext(ctx, `INSERT INTO pathloss_calibrations (params) VALUES (?);`, string(params))
+	if err != nil {
+		return 0, fmt.Errorf("insert path-loss calibration: %w", err)
+	}
+	version, err := res.LastInsertId()
+	if err != nil {
+		return 0, fmt.Errorf("insert path-loss calibration: %w", err)
+	}
+
+	if activate {
+		if err := activatePathLossCalibration(ctx, tx, version); err != nil {
+			return 0, err
+		}
+	}
+
+	if err := tx.Commit(); err != nil {
+		return 0, fmt.Errorf("commit path-loss calibration: %w", err)
+	}
+	return version, nil
+}
+
+// ActivatePathLossCalibration marks version as the active calibration, e.g. to roll back.
+func (s *Store) ActivatePathLossCalibration(ctx context.Context, version int64) error {
+	if s.db == nil {
+		return fmt.Errorf("store not initialized")
+	}
+
+	tx, err := s.db.BeginTx(ctx, nil)
+	if err != nil {
+		return fmt.Errorf("begin path-loss activation: %w", err)
+	}
+	defer tx.Rollback()
+
+	if err := activatePathLossCalibration(ctx, tx, version); err != nil {
+		return err
+	}
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("commit path-loss activation: %w", err)
+	}
+	return nil
+}
+
+func activatePathLossCalibration(ctx context.Context, tx *sql.Tx, version int64) error {
+	var exists int
+	if err := tx.QueryRowContext(ctx, `SELECT COUNT(*) FROM pathloss_calibrations WHERE version = ?;`, version).Scan(&exists); err != nil {
+		return fmt.Errorf("activate path-loss calibration: %w", err)
+	}
+	if exists == 0 {
+		return fmt.Errorf("path-loss calibration %d: %w", version, sql.ErrNoRows)
+	}
+	if _, err := tx.ExecContext(ctx, `UPDATE pathloss_calibrations SET active = (version = ?);`, version); err != nil {
+		return fmt.Errorf("activate path-loss calibration: %w", err)
+	}
+	return nil
+}
+
+// PathLossCalibrations lists every stored calibration, newest first.
+func (s *Store) PathLossCalibrations(ctx context.Context) ([]model.PathLossCalibration, error) {
+	if s.db == nil {
+		return nil, fmt.Errorf("store not initialized")
+	}
+
+	rows, err := s.read.QueryContext(ctx, `SELECT version, params, active, created_at FROM pathloss_calibrations ORDER BY version DESC;`)
+	if err != nil {
+		return nil, fmt.Errorf("query path-loss calibrations: %w", err)
+	}
+	defer rows.Close()
+
+	var out []model.PathLossCalibration
+	for rows.Next() {
+		var (
+			cal          model.PathLossCalibration
+			params       string
+			active       int
+			createdAtStr string
+		)
+		if err := rows.Scan(&cal.Version, &params, &active, &createdAtStr); err != nil {
+			return nil, fmt.Errorf("scan path-loss calibration: %w", err)
+		}
+		if err := json.Unmarshal([]byte(params), &cal); err != nil {
+			return nil, fmt.Errorf("decode path-loss calibration %d: %w", cal.Version, err)
+		}
+		cal.Active = active != 0
+		cal.CreatedAt, _ = time.Parse(time.RFC3339Nano, createdAtStr)
+		out = append(out, cal)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("iterate path-loss calibrations: %w", err)
+	}
+
+	return out, nil
+}
@@ -0,0 +1,118 @@
+package store
+
+import (
+	"context"
+	"database/sql"
+	"encoding/json"
+	"fmt"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// InsertFingerprint stores a labelled RSSI vector and returns its id.
+func (s *Store) InsertFingerprint(ctx context.Context, fp model.Fingerprint) (int64, error) {
+	if s.db == nil {
+		return 0, fmt.Errorf("store not initialized")
+	}
+
+	rssi, err := json.Marshal(fp.RSSI)
+	if err != nil {
+		return 0, fmt.Errorf("encode fingerprint: %w", err)
+	}
+	var location interface{}
+	if fp.Location != nil {
+		bytes, err := json.Marshal(fp.Location)
+		if err != nil {
+			return 0, fmt.Errorf("encode fingerprint location: %w", err)
+		}
+		location = string(bytes)
+	}
+
+	res, err := s.db.ExecContext(
+		ctx,
+		`INSERT INTO fingerprints (tag_id, room, location, rssi, created_at) VALUES (?, ?, ?, ?, ?);`,
+		fp.TagID,
+		fp.Room,
+		location,
+		string(rssi),
+		fp.CreatedAt.UTC().Format(time.RFC3339Nano),
+	)
+	if err != nil {
+		return 0, fmt.Errorf("insert fingerprint: %w", err)
+	}
+	id, err := res.LastInsertId()
+	if err != nil {
+		return 0, fmt.Errorf("insert fingerprint: %w", err)
+	}
+	return id, nil
+}
+
+// Fingerprints returns every stored fingerprint, oldest first.
+func (s *Store) Fingerprints(ctx context.Context) ([]model.Fingerprint, error) {
+	if s.db == nil {
+		return nil, fmt.Errorf("store not initialized")
+	}
+
+	rows, err := s.read.QueryContext(ctx, `SELECT id, tag_id, room, location, rssi, created_at FROM fingerprints ORDER BY id ASC;`)
+	if err != nil {
+		return nil, fmt.Errorf("query fingerprints: %w", err)
+	}
+	defer rows.Close()
+
+	var out []model.Fingerprint
+	for rows.Next() {
+		var (
+			fp           model.Fingerprint
+			location     *string
+			rssi         string
+			createdAtStr string
+		)
+		if err := rows.Scan(&fp.ID, &fp.TagID, &fp.Room, &location, &rssi, &createdAtStr); err != nil {
+			return nil, fmt.Errorf("scan fingerprint: %w", err)
+		}
+		if err := json.Unmarshal([]byte(rssi), &fp.RSSI); err != nil {
+			return nil, fmt.Errorf("decode fingerprint %d: %w", fp.ID, err)
+		}
+		if location != nil {
+			var loc model.Location
+			if err := json.Unmarshal([]byte(*location), &loc); err != nil {
+				return nil, fmt.Errorf("decode fingerprint %d location: %w", fp.ID, err)
+			}
+			fp.Location = &loc
+		}
+		fp.CreatedAt, _ = time.Parse(time.RFC3339Nano, createdAtStr)
+		out = append(out, fp)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("iterate fingerprints: %w", err)
+	}
+
+	return out, nil
+}
+
+// DeleteFingerprints removes every fingerprint, or only those labelled room when room is non-empty.
+func (s *Store) DeleteFingerprints(ctx context.Context, room string) (int64, error) {
+	if s.db == nil {
+		return 0, fmt.Errorf("store not initialized")
+	}
+
+	var (
+		res sql.Result
+		err error
+	)
+	if room == "" {
+		res, err = s.db.ExecContext(ctx, `DELETE FROM fingerprints;`)
+	} else {
+		res, err = s.db.ExecContext(ctx, `DELETE FROM fingerprints WHERE room = ?;`, room)
+	}
+	if err != nil {
+		return 0, fmt.Errorf("delete fingerprints: %w", err)
+	}
+	n, err := res.RowsAffected()
+	if err != nil {
+		return 0, fmt.Errorf("delete fingerprints: %w", err)
+	}
+	return n, nil
+}
@@ -0,0 +1,223 @@
+package store
+
+import (
+	"context"
+	"database/sql"
+	"fmt"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// RoomModels lists every registered room-classifier artifact, newest first.
+func (s *Store) RoomModels(ctx context.Context) ([]model.RoomModel, error) {
+	if s.db == nil {
+		return nil, fmt.Errorf("store not initialized")
+	}
+
+	rows, err := s.read.QueryContext(ctx, `SELECT id, version, artifact_path, trained_on, accuracy, notes, active, created_at
+		FROM room_models ORDER BY id DESC;`)
+	if err != nil {
+		return nil, fmt.Errorf("query room models: %w", err)
+	}
+	defer rows.Close()
+
+	var out []model.RoomModel
+	for rows.Next() {
+		m, err := scanRoomModel(rows)
+		if err != nil {
+			return nil, err
+		}
+		out = append(out, m)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("iterate room models: %w", err)
+	}
+
+	return out, nil
+}
+
+// ActiveRoomModel returns the model marked active; the error wraps sql.ErrNoRows when there is none.
+func (s *Store) ActiveRoomModel(ctx context.Context) (model.RoomModel, error) {
+	if s.db == nil {
+		return model.RoomModel{}, fmt.Errorf("store not initialized")
+	}
+
+	row := s.read.QueryRowContext(ctx, `SELECT id, version, artifact_path, trained_on, accuracy, notes, active, created_at
+		FROM room_models WHERE active = 1 ORDER BY id DESC LIMIT 1;`)
+	m, err := scanRoomModel(row)
+	if err != nil {
+		return model.RoomModel{}, err
+	}
+	return m, nil
+}
+
+func scanRoomModel(row interface{ Scan(...any) error }) (model.RoomModel, error) {
+	var (
+		m            model.RoomModel
+		accuracy     sql.NullFloat64
+		notes        sql.NullString
+		active       int
+		createdAtStr string
+	)
+	if err := row.Scan(&m.ID, &m.Version, &m.ArtifactPath, &m.TrainedOn, &accuracy, &notes, &active, &createdAtStr); err != nil {
+		return model.RoomModel{}, fmt.Errorf("scan room model: %w", err)
+	}
+	if accuracy.Valid {
+		v := accuracy.Float64
+		m.Accuracy = &v
+	}
+	m.Notes = notes.String
+	m.Active = active != 0
+	m.CreatedAt, _ = time.Parse(time.RFC3339Nano, createdAtStr)
+	return m, nil
+}
+
+// RoomModel returns the registered model with the given id; the error wraps sql.ErrNoRows when unknown.
+func (s *Store) RoomModel(ctx context.Context, id int64) (model.RoomModel, error) {
+	if s.db == nil {
+		return model.RoomModel{}, fmt.Errorf("store not initialized")
+	}
+
+	row := s.read.QueryRowContext(ctx, `SELECT id, version, artifact_path, trained_on, accuracy, notes, active, created_at
+		FROM room_models WHERE id = ?;`, id)
+	return scanRoomModel(row)
+}
+
+// InsertRoomModel registers an artifact (inactive) and returns its id.
+func (s *Store) InsertRoomModel(ctx context.Context, m model.RoomModel) (int64, error) {
+	if s.db == nil {
+		return 0, fmt.Errorf("store not initialized")
+	}
+
+	var accuracy interface{}
+	if m.Accuracy != nil {
+		accuracy = *m.Accuracy
+	}
+	res, err := s.db.ExecContext(
+		ctx,
+		`INSERT INTO room_models (version, artifact_path, trained_on, accuracy, notes) VALUES (?, ?, ?, ?, ?);`,
+		m.Version,
+		m.ArtifactPath,
+		m.TrainedOn,
+		accuracy,
+		m.Notes,
+	)
+	if err != nil {
+		return 0, fmt.Errorf("insert room model: %w", err)
+	}
+	id, err := res.LastInsertId()
+	if err != nil {
+		return 0, fmt.Errorf("insert room model: %w", err)
+	}
+	return id, nil
+}
+
+// ActivateRoomModel marks id as the only active model; the error wraps sql.ErrNoRows when unknown.
+func (s *Store) ActivateRoomModel(ctx context.Context, id int64) error {
+	if s.db == nil {
+		return fmt.Errorf("store not initialized")
+	}
+
+	tx, err := s.db.BeginTx(ctx, nil)
+	if err != nil {
+		return fmt.Errorf("begin room model activation: %w", err)
+	}
+	defer tx.Rollback()
+
+	var exists int
+	if err := tx.QueryRowContext(ctx, `SELECT COUNT(*) FROM room_models WHERE id = ?;`, id).Scan(&exists); err != nil {
+		return fmt.Errorf("activate room model: %w", err)
+	}
+	if exists == 0 {
+		return fmt.Errorf("room model %d: %w", id, sql.ErrNoRows)
+	}
+	if _, err := tx.ExecContext(ctx, `UPDATE room_models SET active = (id = ?);`, id); err != nil {
+		return fmt.Errorf("activate room model: %w", err)
+	}
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("commit room model activation: %w", err)
+	}
+	return nil
+}
+
+// InsertModelEvaluation records the outcome of a shadow run.
+func (s *Store) InsertModelEvaluation(ctx context.Context, e model.ModelEvaluation) (int64, error) {
+	if s.db == nil {
+		return 0, fmt.Errorf("store not initialized")
+	}
+
+	var activeID interface{}
+	if e.ActiveModelID > 0 {
+		activeID = e.ActiveModelID
+	}
+	res, err := s.db.ExecContext(
+		ctx,
+		`INSERT INTO model_evaluations
+			(active_model_id, candidate_model_id, started_at, ended_at, predictions, agreements, labelled,
+			 active_correct, candidate_correct, active_latency_us, candidate_latency_us)
+			VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);`,
+		activeID,
+		e.CandidateModelID,
+		e.StartedAt.UTC().Format(time.RFC3339Nano),
+		e.EndedAt.UTC().Format(time.RFC3339Nano),
+		e.Predictions,
+		e.Agreements,
+		e.Labelled,
+		e.ActiveCorrect,
+		e.CandidateCorrect,
+		e.ActiveLatencyUS,
+		e.CandidateLatencyUS,
+	)
+	if err != nil {
+		return 0, fmt.Errorf("insert model evaluation: %w", err)
+	}
+	id, err := res.LastInsertId()
+	if err != nil {
+		return 0, fmt.Errorf("insert model evaluation: %w", err)
+	}
+	return id, nil
+}
+
+// ModelEvaluations returns the most recent shadow-run summaries, newest first.
+func (s *Store) ModelEvaluations(ctx context.Context, limit int) ([]model.ModelEvaluation, error) {
+	if s.db == nil {
+		return nil, fmt.Errorf("store not initialized")
+	}
+
+	if limit <= 0 {
+		limit = 20
+	}
+
+	rows, err := s.read.QueryContext(ctx, `SELECT id, active_model_id, candidate_model_id, started_at, ended_at, predictions,
+			agreements, labelled, active_correct, candidate_correct, active_latency_us, candidate_latency_us
+		FROM model_evaluations ORDER BY id DESC LIMIT ?;`, limit)
+	if err != nil {
+		return nil, fmt.Errorf("query model evaluations: %w", err)
+	}
+	defer rows.Close()
+
+	var out []model.ModelEvaluation
+	for rows.Next() {
+		var (
+			e                  model.ModelEvaluation
+			activeID           sql.NullInt64
+			startedAt, endedAt string
+		)
+		if err := rows.Scan(&e.ID, &activeID, &e.CandidateModelID, &startedAt, &endedAt, &e.Predictions,
+			&e.Agreements, &e.Labelled, &e.ActiveCorrect, &e.CandidateCorrect, &e.ActiveLatencyUS, &e.CandidateLatencyUS); err != nil {
+			return nil, fmt.Errorf("scan model evaluation: %w", err)
+		}
+		e.ActiveModelID = activeID.Int64
+		e.StartedAt, _ = time.Parse(time.RFC3339Nano, startedAt)
+		e.EndedAt, _ = time.Parse(time.RFC3339Nano, endedAt)
+		out = append(out, e)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("iterate model evaluations: %w", err)
+	}
+
+	return out, nil
+}
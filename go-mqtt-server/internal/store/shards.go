@@ -0,0 +1,315 @@
+package store
+
+import (
+	"context"
+	"fmt"
+	"os"
+	"path/filepath"
+	"sort"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+// DefaultSite names the shard backed by the primary database file.
+const DefaultSite = "default"
+
+// Shard is one site's reading store together with its dedicated writer goroutine.
+type Shard struct {
+	Site   string
+	Path   string
+	Store  *Store
+	Writer *Writer
+}
+
+// Shards partitions beacon readings by site. The primary database holds configuration, training
+// commands and the scanner catalog as well as the default site's readings; every other site lives in
+// its own SQLite file (and WAL) under <primary dir>/sites so one building's load or export never
+// touches another's data.
+type Shards struct {
+	primaryPath string
+	siteDir     string
+	onError     WriteErrorHandler
+	onCommit    atomic.Pointer[CommitHandler]
+
+	openMu sync.Mutex
+	mu     sync.RWMutex
+	shards map[string]*Shard
+}
+
+// OpenShards opens the primary database and any site shards already present on disk.
+func OpenShards(ctx context.Context, primaryPath string, onError WriteErrorHandler) (*Shards, error) {
+	s := &Shards{
+		primaryPath: primaryPath,
+		siteDir:     filepath.Join(filepath.Dir(primaryPath), "sites"),
+		onError:     onError,
+		shards:      make(map[string]*Shard),
+	}
+
+	if _, err := s.open(ctx, DefaultSite, primaryPath); err != nil {
+		return nil, err
+	}
+
+	entries, err := os.ReadDir(s.siteDir)
+	if err != nil && !os.IsNotExist(err) {
+		s.Close()
+		return nil, fmt.Errorf("list site shards: %w", err)
+	}
+	for _, e := range entries {
+		name := e.Name()
+		if e.IsDir() || !strings.HasSuffix(name, ".db") {
+			continue
+		}
+		site := strings.TrimSuffix(name, ".db")
+		if _, err := s.open(ctx, site, filepath.Join(s.siteDir, name)); err != nil {
+			s.Close()
+			return nil, err
+		}
+	}
+
+	return s, nil
+}
+
+func (s *Shards) open(ctx context.Context, site, path string) (*Shard, error) {
+	st, err := Open(path)
+	if err != nil {
+		return nil, fmt.Errorf("open shard %s: %w", site, err)
+	}
+	if err := st.InitSchema(ctx); err != nil {
+		_ = st.Close()
+		return nil, fmt.Errorf("init shard %s: %w", site, err)
+	}
+
+	shard := &Shard{Site: site, Path: path, Store: st, Writer: NewWriter(st, s.onError)}
+
+	s.mu.Lock()
+	if h := s.onCommit.Load(); h != nil {
+		shard.Writer.OnCommit(*h)
+	}
+	s.shards[site] = shard
+	s.mu.Unlock()
+	return shard, nil
+}
+
+// OnCommit installs h on every shard's writer, including shards opened later.
+func (s *Shards) OnCommit(h CommitHandler) {
+	s.onCommit.Store(&h)
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	for _, shard := range s.shards {
+		shard.Writer.OnCommit(h)
+	}
+}
+
+// Primary returns the store holding configuration and the default site's readings.
+func (s *Shards) Primary() *Store {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	return s.shards[DefaultSite].Store
+}
+
+// Site returns the shard for site, creating its database on first use.
+func (s *Shards) Site(ctx context.Context, site string) (*Shard, error) {
+	site = NormalizeSite(site)
+
+	if shard, ok := s.Lookup(site); ok {
+		return shard, nil
+	}
+
+	// Creation is serialised separately so opening a new site never blocks lookups for existing ones.
+	s.openMu.Lock()
+	defer s.openMu.Unlock()
+
+	if shard, ok := s.Lookup(site); ok {
+		return shard, nil
+	}
+	return s.open(ctx, site, filepath.Join(s.siteDir, site+".db"))
+}
+
+// Lookup returns an existing shard without creating one.
+func (s *Shards) Lookup(site string) (*Shard, bool) {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	shard, ok := s.shards[NormalizeSite(site)]
+	return shard, ok
+}
+
+// All returns every open shard ordered by site name.
+func (s *Shards) All() []*Shard {
+	s.mu.RLock()
+	out := make([]*Shard, 0, len(s.shards))
+	for _, shard := range s.shards {
+		out = append(out, shard)
+	}
+	s.mu.RUnlock()
+
+	sort.Slice(out, func(i, j int) bool {
+		return out[i].Site < out[j].Site
+	})
+	return out
+}
+
+// Close drains every writer and closes the databases.
+func (s *Shards) Close() error {
+	s.mu.Lock()
+	shards := s.shards
+	s.shards = make(map[string]*Shard)
+	s.mu.Unlock()
+
+	var firstErr error
+	for _, shard := range shards {
+		shard.Writer.Close()
+		if err := shard.Store.Close(); err != nil && firstErr == nil {
+			firstErr = fmt.Errorf("close shard %s: %w", shard.Site, err)
+		}
+	}
+	return firstErr
+}
+
+// NormalizeSite maps a user-supplied site name to a safe shard identifier.
+func NormalizeSite(site string) string {
+	site = strings.ToLower(strings.TrimSpace(site))
+	if site == "" {
+		return DefaultSite
+	}
+	var b strings.Builder
+	for _, r := range site {
+		switch {
+		case r >= 'a' && r <= 'z', r >= '0' && r <= '9', r == '-', r == '_':
+			b.WriteRune(r)
+		default:
+			b.WriteRune('-')
+		}
+	}
+	return b.String()
+}
+
+// fanOut runs fn against each shard concurrently and returns the first error.
+func fanOut(shards []*Shard, fn func(i int, shard *Shard) error) error {
+	var (
+		wg       sync.WaitGroup
+		errMu    sync.Mutex
+		firstErr error
+	)
+	for i, shard := range shards {
+		wg.Add(1)
+		go func(i int, shard *Shard) {
+			defer wg.Done()
+			if err := fn(i, shard); err != nil {
+				errMu.Lock()
+				if firstErr == nil {
+					firstErr = fmt.Errorf("site %s: %w", shard.Site, err)
+				}
+				errMu.Unlock()
+			}
+		}(i, shard)
+	}
+	wg.Wait()
+	return firstErr
+}
+
+// RecentBeaconReadings queries every shard in parallel and merges the newest limit readings.
+func (s *Shards) RecentBeaconReadings(ctx context.Context, limit int, since *time.Time) ([]model.StoredBeaconReading, error) {
+	shards := s.All()
+	results := make([][]model.StoredBeaconReading, len(shards))
+
+	err := fanOut(shards, func(i int, shard *Shard) error {
+		readings, err := shard.Store.RecentBeaconReadings(ctx, limit, since)
+		results[i] = readings
+		return err
+	})
+	if err != nil {
+		return nil, err
+	}
+
+	var merged []model.StoredBeaconReading
+	for _, r := range results {
+		merged = append(merged, r...)
+	}
+	sort.Slice(merged, func(i, j int) bool {
+		return merged[i].ReceivedAt.After(merged[j].ReceivedAt)
+	})
+	if limit > 0 && len(merged) > limit {
+		merged = merged[:limit]
+	}
+	return merged, nil
+}
+
+// AllBeaconReadings queries every shard in parallel and merges the results by recorded time.
+func (s *Shards) AllBeaconReadings(ctx context.Context) ([]model.StoredBeaconReading, error) {
+	shards := s.All()
+	results := make([][]model.StoredBeaconReading, len(shards))
+
+	err := fanOut(shards, func(i int, shard *Shard) error {
+		readings, err := shard.Store.AllBeaconReadings(ctx)
+		results[i] = readings
+		return err
+	})
+	if err != nil {
+		return nil, err
+	}
+
+	var merged []model.StoredBeaconReading
+	for _, r := range results {
+		merged = append(merged, r...)
+	}
+	sort.SliceStable(merged, func(i, j int) bool {
+		return merged[i].RecordedAt.Before(merged[j].RecordedAt)
+	})
+	return merged, nil
+}
+
+// BeaconReadingsReceivedSince queries every shard in parallel for readings received since the cutoff.
+func (s *Shards) BeaconReadingsReceivedSince(ctx context.Context, since time.Time, limit int) ([]model.StoredBeaconReading, error) {
+	shards := s.All()
+	results := make([][]model.StoredBeaconReading, len(shards))
+
+	err := fanOut(shards, func(i int, shard *Shard) error {
+		readings, err := shard.Store.BeaconReadingsReceivedSince(ctx, since, limit)
+		results[i] = readings
+		return err
+	})
+	if err != nil {
+		return nil, err
+	}
+
+	var merged []model.StoredBeaconReading
+	for _, r := range results {
+		merged = append(merged, r...)
+	}
+	sort.SliceStable(merged, func(i, j int) bool {
+		return merged[i].ReceivedAt.Before(merged[j].ReceivedAt)
+	})
+	return merged, nil
+}
+
+// CalibrationSamples gathers ground-truth samples from every shard in parallel.
+func (s *Shards) CalibrationSamples(ctx context.Context, since time.Time, limit int) ([]model.CalibrationSample, error) {
+	shards := s.All()
+	results := make([][]model.CalibrationSample, len(shards))
+
+	err := fanOut(shards, func(i int, shard *Shard) error {
+		samples, err := shard.Store.CalibrationSamples(ctx, since, limit)
+		results[i] = samples
+		return err
+	})
+	if err != nil {
+		return nil, err
+	}
+
+	var merged []model.CalibrationSample
+	for _, r := range results {
+		merged = append(merged, r...)
+	}
+	return merged, nil
+}
+
+// WipeData clears telemetry in every shard.
+func (s *Shards) WipeData(ctx context.Context) error {
+	return fanOut(s.All(), func(_ int, shard *Shard) error {
+		return shard.Store.WipeData(ctx)
+	})
+}
@@ -8,6 +8,8 @@ import (
 	"fmt"
 	"os"
 	"path/filepath"
+	"sync"
+	"sync/atomic"
 	"time"
 
 	"catlocator/go-mqtt-server/internal/model"
@@ -15,9 +17,17 @@ import (
 	_ "modernc.org/sqlite"
 )
 
-// Store wraps the SQLite database connection and schema lifecycle.
+// readConns bounds each store's pool of read-only connections.
+const readConns = 4
+
+// Store wraps the SQLite database connections and schema lifecycle.
 type Store struct {
-	db *sql.DB
+	db   *sql.DB // the single write connection; also schema setup and backups
+	read *sql.DB // query-only connections for API reads and exports
+
+	rooms    atomic.Pointer[[]model.RoomDefinition] // decoded room definitions, nil until first read
+	roomsMu  sync.Mutex                             // orders cache fills against saves
+	roomsGen uint64                                 // bumped on every save; a fill started before one is dropped
 }
 
 // Open initializes the database connection, creating directories as needed.
@@ -26,18 +36,29 @@ func Open(path string) (*Store, error) {
 		return nil, fmt.Errorf("create db directory: %w", err)
 	}
 
-	dsn := fmt.Sprintf("file:%s?_pragma=foreign_keys(ON)", path)
+	// Writes go through one connection; SQLite allows a single writer anyway. Reads use a separate
+	// pool, and under WAL those connections read the last commit without waiting for the writer.
+	// Backups stay on the write connection so SQLite can mirror concurrent writes into the snapshot.
+	dsn := fmt.Sprintf("file:%s?_pragma=foreign_keys(ON)&_pragma=journal_mode(WAL)&_pragma=synchronous(NORMAL)&_pragma=busy_timeout(5000)", path)
 
 	db, err := sql.Open("sqlite", dsn)
 	if err != nil {
 		return nil, fmt.Errorf("open sqlite: %w", err)
 	}
-
 	db.SetMaxOpenConns(1)
 	db.SetConnMaxLifetime(0)
 	db.SetConnMaxIdleTime(5 * time.Minute)
 
-	return &Store{db: db}, nil
+	read, err := sql.Open("sqlite", dsn+"&_pragma=query_only(ON)")
+	if err != nil {
+		_ = db.Close()
+		return nil, fmt.Errorf("open sqlite readers: %w", err)
+	}
+	read.SetMaxOpenConns(readConns)
+	read.SetMaxIdleConns(readConns)
+	read.SetConnMaxIdleTime(5 * time.Minute)
+
+	return &Store{db: db, read: read}, nil
 }
 
 // Close releases the underlying database handle.
@@ -45,7 +66,7 @@ func (s *Store) Close() error {
 	if s.db == nil {
 		return nil
 	}
-	return s.db.Close()
+	return errors.Join(s.read.Close(), s.db.Close())
 }
 
 // InitSchema ensures baseline tables exist.
@@ -63,6 +84,7 @@ func (s *Store) InitSchema(ctx context.Context) error {
 			received_at TEXT NOT NULL DEFAULT (strftime('%Y-%m-%dT%H:%M:%fZ', 'now'))
 		);`,
 		`CREATE INDEX IF NOT EXISTS idx_beacon_readings_tag_time ON beacon_readings(tag_id, recorded_at);`,
+		`CREATE INDEX IF NOT EXISTS idx_beacon_readings_received ON beacon_readings(received_at);`,
 		`CREATE TABLE IF NOT EXISTS room_labels (
 			id INTEGER PRIMARY KEY AUTOINCREMENT,
 			tag_id TEXT NOT NULL,
@@ -81,6 +103,20 @@ func (s *Store) InitSchema(ctx context.Context) error {
 			notes TEXT,
 			created_at TEXT NOT NULL DEFAULT (strftime('%Y-%m-%dT%H:%M:%fZ', 'now'))
 		);`,
+		`CREATE TABLE IF NOT EXISTS model_evaluations (
+			id INTEGER PRIMARY KEY AUTOINCREMENT,
+			active_model_id INTEGER,
+			candidate_model_id INTEGER NOT NULL,
+			started_at TEXT NOT NULL,
+			ended_at TEXT NOT NULL,
+			predictions INTEGER NOT NULL,
+			agreements INTEGER NOT NULL,
+			labelled INTEGER NOT NULL,
+			active_correct INTEGER NOT NULL,
+			candidate_correct INTEGER NOT NULL,
+			active_latency_us REAL NOT NULL,
+			candidate_latency_us REAL NOT NULL
+		);`,
 		`CREATE TABLE IF NOT EXISTS ingestion_errors (
 			id INTEGER PRIMARY KEY AUTOINCREMENT,
 			beacon_id TEXT,
@@ -96,6 +132,34 @@ func (s *Store) InitSchema(ctx context.Context) error {
 			source TEXT,
 			received_at TEXT NOT NULL DEFAULT (strftime('%Y-%m-%dT%H:%M:%fZ', 'now'))
 		);`,
+		`CREATE TABLE IF NOT EXISTS calibration_samples (
+			id INTEGER PRIMARY KEY AUTOINCREMENT,
+			beacon_id TEXT NOT NULL,
+			tag_id TEXT NOT NULL,
+			rssi INTEGER NOT NULL,
+			beacon_x REAL NOT NULL,
+			beacon_y REAL NOT NULL,
+			beacon_z REAL NOT NULL,
+			tag_x REAL NOT NULL,
+			tag_y REAL NOT NULL,
+			tag_z REAL NOT NULL,
+			recorded_at TEXT NOT NULL
+		);`,
+		`CREATE INDEX IF NOT EXISTS idx_calibration_samples_recorded ON calibration_samples(recorded_at);`,
+		`CREATE TABLE IF NOT EXISTS pathloss_calibrations (
+			version INTEGER PRIMARY KEY AUTOINCREMENT,
+			params TEXT NOT NULL,
+			active INTEGER NOT NULL DEFAULT 0,
+			created_at TEXT NOT NULL DEFAULT (strftime('%Y-%m-%dT%H:%M:%fZ', 'now'))
+		);`,
+		`CREATE TABLE IF NOT EXISTS fingerprints (
+			id INTEGER PRIMARY KEY AUTOINCREMENT,
+			tag_id TEXT NOT NULL,
+			room TEXT NOT NULL,
+			location TEXT,
+			rssi TEXT NOT NULL,
+			created_at TEXT NOT NULL
+		);`,
 		`CREATE TABLE IF NOT EXISTS app_config (
 			key TEXT PRIMARY KEY,
 			value TEXT NOT NULL,
@@ -121,6 +185,62 @@ func (s *Store) InitSchema(ctx context.Context) error {
 		}
 	}
 
+	columns := []struct {
+		table, column, decl string
+	}{
+		{"ingestion_errors", "error_class", "TEXT"},
+		{"ingestion_errors", "occurrences", "INTEGER NOT NULL DEFAULT 1"},
+		{"ingestion_errors", "first_seen", "TEXT"},
+		{"ingestion_errors", "last_seen", "TEXT"},
+		{"room_models", "active", "INTEGER NOT NULL DEFAULT 0"},
+	}
+	for _, c := range columns {
+		if err := s.ensureColumn(ctx, c.table, c.column, c.decl); err != nil {
+			return err
+		}
+	}
+
+	return nil
+}
+
+// ensureColumn adds a column to an existing table when it predates the current schema.
+func (s *Store) ensureColumn(ctx context.Context, table, column, decl string) error {
+	rows, err := s.db.QueryContext(ctx, fmt.Sprintf(`PRAGMA table_info(%s);`, table))
+	if err != nil {
+		return fmt.Errorf("inspect %s: %w", table, err)
+	}
+
+	found := false
+	for rows.Next() {
+		var (
+			cid       int
+			name      string
+			colType   string
+			notNull   int
+			dfltValue sql.NullString
+			pk        int
+		)
+		if err := rows.Scan(&cid, &name, &colType, &notNull, &dfltValue, &pk); err != nil {
+			rows.Close()
+			return fmt.Errorf("inspect %s: %w", table, err)
+		}
+		if name == column {
+			found = true
+		}
+	}
+	if err := rows.Err(); err != nil {
+		rows.Close()
+		return fmt.Errorf("inspect %s: %w", table, err)
+	}
+	rows.Close()
+
+	if found {
+		return nil
+	}
+
+	if _, err := s.db.ExecContext(ctx, fmt.Sprintf(`ALTER TABLE %s ADD COLUMN %s %s;`, table, column, decl)); err != nil {
+		return fmt.Errorf("add column %s.%s: %w", table, column, err)
+	}
 	return nil
 }
 
@@ -135,6 +255,12 @@ func (s *Store) InsertBeaconReading(ctx context.Context, r model.BeaconReading)
 		return fmt.Errorf("store not initialized")
 	}
 
+	// A ground-truth reading also writes a calibration sample; the batch path keeps both rows in one
+	// transaction.
+	if _, ok := r.GroundTruth(); ok {
+		return s.InsertBeaconReadings(ctx, []model.BeaconReading{r})
+	}
+
 	recordedAt := r.Timestamp
 	if recordedAt.IsZero() {
 		recordedAt = time.Now().UTC()
@@ -158,25 +284,190 @@ func (s *Store) InsertBeaconReading(ctx context.Context, r model.BeaconReading)
 	return nil
 }
 
-// InsertIngestionError records a payload that failed validation.
-func (s *Store) InsertIngestionError(ctx context.Context, e model.IngestionError) error {
+// InsertBeaconReadings persists a batch of readings in a single transaction.
+func (s *Store) InsertBeaconReadings(ctx context.Context, readings []model.BeaconReading) error {
 	if s.db == nil {
 		return fmt.Errorf("store not initialized")
 	}
+	if len(readings) == 0 {
+		return nil
+	}
 
-	_, err := s.db.ExecContext(
-		ctx,
-		`INSERT INTO ingestion_errors (beacon_id, payload, error) VALUES (?, ?, ?);`,
-		e.BeaconID,
-		e.Payload,
-		e.Error,
-	)
+	tx, err := s.db.BeginTx(ctx, nil)
+	if err != nil {
+		return fmt.Errorf("begin beacon readings: %w", err)
+	}
+	defer tx.Rollback()
+
+	stmt, err := tx.PrepareContext(ctx,
+		`INSERT INTO beacon_readings (beacon_id, tag_id, rssi, x, y, z, recorded_at) VALUES (?, ?, ?, ?, ?, ?, ?);`)
+	if err != nil {
+		return fmt.Errorf("prepare beacon readings: %w", err)
+	}
+	defer stmt.Close()
+
+	// Prepared lazily: ground-truth readings only arrive during calibration walks or simulation.
+	var calStmt *sql.Stmt
+	defer func() {
+		if calStmt != nil {
+			calStmt.Close()
+		}
+	}()
+
+	now := time.Now().UTC()
+	for _, r := range readings {
+		recordedAt := r.Timestamp
+		if recordedAt.IsZero() {
+			recordedAt = now
+		}
+		if _, err := stmt.ExecContext(ctx,
+			r.BeaconID,
+			r.TagID,
+			r.RSSI,
+			r.BeaconLocation.X,
+			r.BeaconLocation.Y,
+			r.BeaconLocation.Z,
+			recordedAt.UTC().Format(time.RFC3339Nano),
+		); err != nil {
+			return fmt.Errorf("insert beacon reading: %w", err)
+		}
+
+		truth, ok := r.GroundTruth()
+		if !ok {
+			continue
+		}
+		if calStmt == nil {
+			if calStmt, err = tx.PrepareContext(ctx, insertCalibrationSampleSQL); err != nil {
+				return fmt.Errorf("prepare calibration samples: %w", err)
+			}
+		}
+		if _, err := calStmt.ExecContext(ctx, calibrationSampleArgs(r, truth, recordedAt)...); err != nil {
+			return fmt.Errorf("insert calibration sample: %w", err)
+		}
+	}
+
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("commit beacon readings: %w", err)
+	}
+	return nil
+}
+
+// InsertIngestionErrors records aggregated ingestion failures in one transaction and trims the
+// table to the newest keep rows so it behaves as a bounded ring.
+func (s *Store) InsertIngestionErrors(ctx context.Context, entries []model.IngestionError, keep int) error {
+	if s.db == nil {
+		return fmt.Errorf("store not initialized")
+	}
+	if len(entries) == 0 {
+		return nil
+	}
+
+	tx, err := s.db.BeginTx(ctx, nil)
+	if err != nil {
+		return fmt.Errorf("begin ingestion errors: %w", err)
+	}
+	defer tx.Rollback()
+
+	stmt, err := tx.PrepareContext(ctx,
+		`INSERT INTO ingestion_errors (beacon_id, payload, error, error_class, occurrences, first_seen, last_seen)
+		 VALUES (?, ?, ?, ?, ?, ?, ?);`)
 	if err != nil {
-		return fmt.Errorf("insert ingestion error: %w", err)
+		return fmt.Errorf("prepare ingestion errors: %w", err)
+	}
+	defer stmt.Close()
+
+	for _, e := range entries {
+		occurrences := e.Occurrences
+		if occurrences <= 0 {
+			occurrences = 1
+		}
+		if _, err := stmt.ExecContext(ctx,
+			e.BeaconID,
+			e.Payload,
+			e.Error,
+			e.Class,
+			occurrences,
+			e.FirstSeen.UTC().Format(time.RFC3339Nano),
+			e.LastSeen.UTC().Format(time.RFC3339Nano),
+		); err != nil {
+			return fmt.Errorf("insert ingestion error: %w", err)
+		}
+	}
+
+	if keep > 0 {
+		if _, err := tx.ExecContext(ctx,
+			`DELETE FROM ingestion_errors WHERE id <= (SELECT MAX(id) FROM ingestion_errors) - ?;`, keep); err != nil {
+			return fmt.Errorf("trim ingestion errors: %w", err)
+		}
+	}
+
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("commit ingestion errors: %w", err)
 	}
 	return nil
 }
 
+// RecentIngestionErrors returns the newest persisted ingestion error samples.
+func (s *Store) RecentIngestionErrors(ctx context.Context, limit int) ([]model.IngestionError, error) {
+	if s.db == nil {
+		return nil, fmt.Errorf("store not initialized")
+	}
+
+	if limit <= 0 {
+		limit = 50
+	}
+
+	rows, err := s.read.QueryContext(ctx,
+		`SELECT beacon_id, payload, error, error_class, occurrences, first_seen, last_seen, created_at
+		 FROM ingestion_errors
+		 ORDER BY id DESC
+		 LIMIT ?;`, limit)
+	if err != nil {
+		return nil, fmt.Errorf("query ingestion errors: %w", err)
+	}
+	defer rows.Close()
+
+	var entries []model.IngestionError
+	for rows.Next() {
+		var (
+			beaconID, payload, class, firstSeen, lastSeen sql.NullString
+			errText, createdAt                            string
+			occurrences                                   int64
+		)
+		if err := rows.Scan(&beaconID, &payload, &errText, &class, &occurrences, &firstSeen, &lastSeen, &createdAt); err != nil {
+			return nil, fmt.Errorf("scan ingestion error: %w", err)
+		}
+
+		created, err := time.Parse(time.RFC3339Nano, createdAt)
+		if err != nil {
+			created, _ = time.Parse("2006-01-02T15:04:05Z07:00", createdAt)
+		}
+		first, _ := time.Parse(time.RFC3339Nano, firstSeen.String)
+		last, _ := time.Parse(time.RFC3339Nano, lastSeen.String)
+		if first.IsZero() {
+			first = created
+		}
+		if last.IsZero() {
+			last = created
+		}
+
+		entries = append(entries, model.IngestionError{
+			BeaconID:    beaconID.String,
+			Payload:     payload.String,
+			Error:       errText,
+			Class:       class.String,
+			Occurrences: occurrences,
+			FirstSeen:   first,
+			LastSeen:    last,
+		})
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("iterate ingestion errors: %w", err)
+	}
+	return entries, nil
+}
+
 // RecentBeaconReadings returns the most recent readings ordered by received time descending.
 func (s *Store) RecentBeaconReadings(ctx context.Context, limit int, since *time.Time) ([]model.StoredBeaconReading, error) {
 	if s.db == nil {
@@ -196,16 +487,26 @@ func (s *Store) RecentBeaconReadings(ctx context.Context, limit int, since *time
 	query += ` ORDER BY received_at DESC LIMIT ?`
 	args = append(args, limit)
 
-	rows, err := s.db.QueryContext(ctx, query+";", args...)
+	rows, err := s.read.QueryContext(ctx, query+";", args...)
 	if err != nil {
 		return nil, fmt.Errorf("query recent beacon readings: %w", err)
 	}
 	defer rows.Close()
 
-	readings := make([]model.StoredBeaconReading, 0, limit)
+	readings, err := scanStoredReadings(rows, false, limit)
+	if err != nil {
+		return nil, fmt.Errorf("iterate beacon readings: %w", err)
+	}
+	return readings, nil
+}
 
+// scanStoredReadings decodes beacon reading rows selected as (beacon_id, tag_id, rssi, x, y, z,
+// recorded_at, received_at), preceded by id when withID is set. capacity presizes the result.
+func scanStoredReadings(rows *sql.Rows, withID bool, capacity int) ([]model.StoredBeaconReading, error) {
+	readings := make([]model.StoredBeaconReading, 0, capacity)
 	for rows.Next() {
 		var (
+			id            int64
 			beaconID      string
 			tagID         string
 			rssi          int
@@ -213,8 +514,11 @@ func (s *Store) RecentBeaconReadings(ctx context.Context, limit int, since *time
 			recordedAtStr string
 			receivedAtStr string
 		)
-
-		if err := rows.Scan(&beaconID, &tagID, &rssi, &x, &y, &z, &recordedAtStr, &receivedAtStr); err != nil {
+		dest := []any{&beaconID, &tagID, &rssi, &x, &y, &z, &recordedAtStr, &receivedAtStr}
+		if withID {
+			dest = append([]any{&id}, dest...)
+		}
+		if err := rows.Scan(dest...); err != nil {
 			return nil, fmt.Errorf("scan beacon reading: %w", err)
 		}
 
@@ -222,13 +526,13 @@ func (s *Store) RecentBeaconReadings(ctx context.Context, limit int, since *time
 		if err != nil {
 			recordedAt, _ = time.Parse("2006-01-02T15:04:05Z07:00", recordedAtStr)
 		}
-
 		receivedAt, err := time.Parse(time.RFC3339Nano, receivedAtStr)
 		if err != nil {
 			receivedAt, _ = time.Parse("2006-01-02T15:04:05Z07:00", receivedAtStr)
 		}
 
 		readings = append(readings, model.StoredBeaconReading{
+			ID: id,
 			BeaconReading: model.BeaconReading{
 				BeaconID:  beaconID,
 				TagID:     tagID,
@@ -244,11 +548,49 @@ func (s *Store) RecentBeaconReadings(ctx context.Context, limit int, since *time
 			ReceivedAt: receivedAt,
 		})
 	}
-
 	if err := rows.Err(); err != nil {
-		return nil, fmt.Errorf("iterate beacon readings: %w", err)
+		return nil, err
+	}
+	return readings, nil
+}
+
+// receivedAtLayout matches the millisecond precision of the received_at column default so range
+// comparisons on the text column order correctly.
+const receivedAtLayout = "2006-01-02T15:04:05.000Z"
+
+// BeaconReadingsReceivedSince returns readings received at or after since, oldest first, using the
+// received_at index so the cost scales with the window rather than the table. At most limit rows
+// (the newest) are returned.
+func (s *Store) BeaconReadingsReceivedSince(ctx context.Context, since time.Time, limit int) ([]model.StoredBeaconReading, error) {
+	if s.db == nil {
+		return nil, fmt.Errorf("store not initialized")
 	}
 
+	if limit <= 0 {
+		limit = 50000
+	}
+
+	rows, err := s.read.QueryContext(
+		ctx,
+		`SELECT id, beacon_id, tag_id, rssi, x, y, z, recorded_at, received_at FROM (
+			SELECT id, beacon_id, tag_id, rssi, x, y, z, recorded_at, received_at
+			FROM beacon_readings
+			WHERE received_at >= ?
+			ORDER BY received_at DESC
+			LIMIT ?
+		 ) ORDER BY received_at ASC;`,
+		since.UTC().Format(receivedAtLayout),
+		limit,
+	)
+	if err != nil {
+		return nil, fmt.Errorf("query readings received since: %w", err)
+	}
+	defer rows.Close()
+
+	readings, err := scanStoredReadings(rows, true, 0)
+	if err != nil {
+		return nil, fmt.Errorf("iterate readings received since: %w", err)
+	}
 	return readings, nil
 }
 
@@ -306,7 +648,7 @@ func (s *Store) ListDiscoveredBeacons(ctx context.Context) ([]model.DiscoveredBe
 		return nil, fmt.Errorf("store not initialized")
 	}
 
-	rows, err := s.db.QueryContext(ctx, `SELECT scanner_id, tag_address, tag_name, rssi, manufacturer_id, manufacturer_data, tx_power, event_type, last_seen FROM discovered_beacons ORDER BY last_seen DESC;`)
+	rows, err := s.read.QueryContext(ctx, `SELECT scanner_id, tag_address, tag_name, rssi, manufacturer_id, manufacturer_data, tx_power, event_type, last_seen FROM discovered_beacons ORDER BY last_seen DESC;`)
 	if err != nil {
 		return nil, fmt.Errorf("query discovered beacons: %w", err)
 	}
@@ -382,6 +724,9 @@ func (s *Store) UpsertAppConfig(ctx context.Context, key, value string) error {
 	if err != nil {
 		return fmt.Errorf("upsert app config: %w", err)
 	}
+	if key == roomDefinitionsKey {
+		s.setRoomsCache(nil)
+	}
 	return nil
 }
 
@@ -391,7 +736,7 @@ func (s *Store) AppConfig(ctx context.Context) (map[string]string, error) {
 		return nil, fmt.Errorf("store not initialized")
 	}
 
-	rows, err := s.db.QueryContext(ctx, `SELECT key, value FROM app_config;`)
+	rows, err := s.read.QueryContext(ctx, `SELECT key, value FROM app_config;`)
 	if err != nil {
 		return nil, fmt.Errorf("query app config: %w", err)
 	}
@@ -415,29 +760,49 @@ func (s *Store) AppConfig(ctx context.Context) (map[string]string, error) {
 
 const roomDefinitionsKey = "room_definitions"
 
-// GetRoomDefinitions loads stored room definitions (may be empty).
+// GetRoomDefinitions loads stored room definitions (may be empty). The decoded list is cached until
+// the next SaveRoomDefinitions; callers get their own slice but share polygon vertices.
 func (s *Store) GetRoomDefinitions(ctx context.Context) ([]model.RoomDefinition, error) {
 	if s.db == nil {
 		return nil, fmt.Errorf("store not initialized")
 	}
+	if cached := s.rooms.Load(); cached != nil {
+		return append([]model.RoomDefinition(nil), (*cached)...), nil
+	}
+	s.roomsMu.Lock()
+	gen := s.roomsGen
+	s.roomsMu.Unlock()
 
 	var raw string
-	err := s.db.QueryRowContext(ctx, `SELECT value FROM app_config WHERE key = ?;`, roomDefinitionsKey).Scan(&raw)
-	if errors.Is(err, sql.ErrNoRows) {
-		return nil, nil
-	}
-	if err != nil {
+	err := s.read.QueryRowContext(ctx, `SELECT value FROM app_config WHERE key = ?;`, roomDefinitionsKey).Scan(&raw)
+	if err != nil && !errors.Is(err, sql.ErrNoRows) {
 		return nil, fmt.Errorf("get room definitions: %w", err)
 	}
 
 	var rooms []model.RoomDefinition
-	if err := json.Unmarshal([]byte(raw), &rooms); err != nil {
-		return nil, fmt.Errorf("decode room definitions: %w", err)
+	if raw != "" {
+		if err := json.Unmarshal([]byte(raw), &rooms); err != nil {
+			return nil, fmt.Errorf("decode room definitions: %w", err)
+		}
+	}
+	s.roomsMu.Lock()
+	if s.roomsGen == gen {
+		s.rooms.Store(&rooms)
 	}
-	return rooms, nil
+	s.roomsMu.Unlock()
+	return append([]model.RoomDefinition(nil), rooms...), nil
 }
 
-// SaveRoomDefinitions persists room definitions.
+// setRoomsCache replaces the cached room definitions after a write and invalidates fills that read
+// the database before it.
+func (s *Store) setRoomsCache(rooms *[]model.RoomDefinition) {
+	s.roomsMu.Lock()
+	s.roomsGen++
+	s.rooms.Store(rooms)
+	s.roomsMu.Unlock()
+}
+
+// SaveRoomDefinitions persists room definitions and refreshes the cache.
 func (s *Store) SaveRoomDefinitions(ctx context.Context, rooms []model.RoomDefinition) error {
 	if s.db == nil {
 		return fmt.Errorf("store not initialized")
@@ -452,8 +817,11 @@ func (s *Store) SaveRoomDefinitions(ctx context.Context, rooms []model.RoomDefin
 		`INSERT INTO app_config (key, value, updated_at) VALUES (?, ?, strftime('%Y-%m-%dT%H:%M:%fZ','now'))
 		 ON CONFLICT(key) DO UPDATE SET value = excluded.value, updated_at = excluded.updated_at;`,
 		roomDefinitionsKey, string(bytes)); err != nil {
+		s.setRoomsCache(nil)
 		return fmt.Errorf("save room definitions: %w", err)
 	}
+	copied := append([]model.RoomDefinition(nil), rooms...)
+	s.setRoomsCache(&copied)
 	return nil
 }
 
@@ -465,9 +833,12 @@ func (s *Store) WipeData(ctx context.Context) error {
 
 	stmts := []string{
 		`DELETE FROM beacon_readings;`,
+		`DELETE FROM calibration_samples;`,
 		`DELETE FROM ingestion_errors;`,
 		`DELETE FROM training_commands;`,
 		`DELETE FROM room_labels;`,
+		`DELETE FROM fingerprints;`,
+		`DELETE FROM model_evaluations;`,
 		`DELETE FROM room_models;`,
 		`DELETE FROM discovered_beacons;`,
 	}
@@ -487,7 +858,7 @@ func (s *Store) AllBeaconReadings(ctx context.Context) ([]model.StoredBeaconRead
 		return nil, fmt.Errorf("store not initialized")
 	}
 
-	rows, err := s.db.QueryContext(
+	rows, err := s.read.QueryContext(
 		ctx,
 		`SELECT beacon_id, tag_id, rssi, x, y, z, recorded_at, received_at
 		 FROM beacon_readings
@@ -497,51 +868,10 @@ func (s *Store) AllBeaconReadings(ctx context.Context) ([]model.StoredBeaconRead
 	}
 	defer rows.Close()
 
-	var readings []model.StoredBeaconReading
-	for rows.Next() {
-		var (
-			beaconID      string
-			tagID         string
-			rssi          int
-			x, y, z       float64
-			recordedAtStr string
-			receivedAtStr string
-		)
-		if err := rows.Scan(&beaconID, &tagID, &rssi, &x, &y, &z, &recordedAtStr, &receivedAtStr); err != nil {
-			return nil, fmt.Errorf("scan beacon reading: %w", err)
-		}
-
-		recordedAt, err := time.Parse(time.RFC3339Nano, recordedAtStr)
-		if err != nil {
-			recordedAt, _ = time.Parse("2006-01-02T15:04:05Z07:00", recordedAtStr)
-		}
-
-		receivedAt, err := time.Parse(time.RFC3339Nano, receivedAtStr)
-		if err != nil {
-			receivedAt, _ = time.Parse("2006-01-02T15:04:05Z07:00", receivedAtStr)
-		}
-
-		readings = append(readings, model.StoredBeaconReading{
-			BeaconReading: model.BeaconReading{
-				BeaconID:  beaconID,
-				TagID:     tagID,
-				RSSI:      rssi,
-				Timestamp: recordedAt,
-				BeaconLocation: model.Location{
-					X: x,
-					Y: y,
-					Z: z,
-				},
-			},
-			RecordedAt: recordedAt,
-			ReceivedAt: receivedAt,
-		})
-	}
-
-	if err := rows.Err(); err != nil {
+	readings, err := scanStoredReadings(rows, false, 0)
+	if err != nil {
 		return nil, fmt.Errorf("iterate beacon readings: %w", err)
 	}
-
 	return readings, nil
 }
 
@@ -551,7 +881,7 @@ func (s *Store) LatestBeaconReadings(ctx context.Context) ([]model.StoredBeaconR
 		return nil, fmt.Errorf("store not initialized")
 	}
 
-	rows, err := s.db.QueryContext(
+	rows, err := s.read.QueryContext(
 		ctx,
 		`SELECT br.beacon_id, br.tag_id, br.rssi, br.x, br.y, br.z, br.recorded_at, br.received_at
 		 FROM beacon_readings br
@@ -565,50 +895,10 @@ func (s *Store) LatestBeaconReadings(ctx context.Context) ([]model.StoredBeaconR
 	}
 	defer rows.Close()
 
-	var readings []model.StoredBeaconReading
-	for rows.Next() {
-		var (
-			beaconID      string
-			tagID         string
-			rssi          int
-			x, y, z       float64
-			recordedAtStr string
-			receivedAtStr string
-		)
-		if err := rows.Scan(&beaconID, &tagID, &rssi, &x, &y, &z, &recordedAtStr, &receivedAtStr); err != nil {
-			return nil, fmt.Errorf("scan latest reading: %w", err)
-		}
-
-		recordedAt, err := time.Parse(time.RFC3339Nano, recordedAtStr)
-		if err != nil {
-			recordedAt, _ = time.Parse("2006-01-02T15:04:05Z07:00", recordedAtStr)
-		}
-		receivedAt, err := time.Parse(time.RFC3339Nano, receivedAtStr)
-		if err != nil {
-			receivedAt, _ = time.Parse("2006-01-02T15:04:05Z07:00", receivedAtStr)
-		}
-
-		readings = append(readings, model.StoredBeaconReading{
-			BeaconReading: model.BeaconReading{
-				BeaconID:  beaconID,
-				TagID:     tagID,
-				RSSI:      rssi,
-				Timestamp: recordedAt,
-				BeaconLocation: model.Location{
-					X: x,
-					Y: y,
-					Z: z,
-				},
-			},
-			RecordedAt: recordedAt,
-			ReceivedAt: receivedAt,
-		})
-	}
-
-	if err := rows.Err(); err != nil {
+	readings, err := scanStoredReadings(rows, false, 0)
+	if err != nil {
 		return nil, fmt.Errorf("iterate latest readings: %w", err)
 	}
-
 	return readings, nil
 }
 
@@ -644,7 +934,7 @@ func (s *Store) RecentTrainingCommands(ctx context.Context, limit int) ([]model.
 		limit = 50
 	}
 
-	rows, err := s.db.QueryContext(
+	rows, err := s.read.QueryContext(
 		ctx,
 		`SELECT room, command, command_timestamp, source, received_at
 		 FROM training_commands
@@ -696,7 +986,7 @@ func (s *Store) AllTrainingCommands(ctx context.Context) ([]model.TrainingComman
 		return nil, fmt.Errorf("store not initialized")
 	}
 
-	rows, err := s.db.QueryContext(
+	rows, err := s.read.QueryContext(
 		ctx,
 		`SELECT room, command, command_timestamp, source, received_at
 		 FROM training_commands
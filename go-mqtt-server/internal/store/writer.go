@@ -0,0 +1,202 @@
+package store
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"catlocator/go-mqtt-server/internal/metrics"
+	"catlocator/go-mqtt-server/internal/model"
+)
+
+const (
+	writerQueueSize = 4096
+	writerMaxBatch  = 256
+	writerLinger    = 20 * time.Millisecond
+)
+
+// ErrWriterClosed is returned when enqueueing after the writer has shut down.
+var ErrWriterClosed = errors.New("store writer closed")
+
+// WriteErrorHandler is notified for each reading a batch failed to persist, with the fingerprint the
+// reading was enqueued under.
+type WriteErrorHandler func(r model.BeaconReading, fingerprint uint64, err error)
+
+// CommitHandler is notified after each batch commits. It runs on the writer goroutine and must not
+// retain batch, whose backing array is reused.
+type CommitHandler func(batch []model.BeaconReading, committedAt time.Time)
+
+// Writer owns the write side of one store: a single goroutine drains a queue of readings and commits
+// them in batched transactions, so concurrent publishers never contend on the SQLite write lock.
+type Writer struct {
+	store    *Store
+	queue    chan queuedReading
+	onError  WriteErrorHandler
+	onCommit atomic.Pointer[CommitHandler]
+
+	batches    metrics.SizeHistogram
+	commitTime metrics.Histogram
+	committed  atomic.Uint64
+	failed     atomic.Uint64
+
+	mu     sync.RWMutex
+	closed bool
+	done   chan struct{}
+}
+
+// queuedReading is a reading waiting for its batch, with the caller's dedup fingerprint.
+type queuedReading struct {
+	reading     model.BeaconReading
+	fingerprint uint64
+}
+
+// NewWriter starts the writer goroutine for store.
+func NewWriter(store *Store, onError WriteErrorHandler) *Writer {
+	w := &Writer{
+		store:   store,
+		queue:   make(chan queuedReading, writerQueueSize),
+		onError: onError,
+		done:    make(chan struct{}),
+	}
+	go w.run()
+	return w
+}
+
+// Enqueue hands a reading to the writer, blocking while the queue is full until ctx expires. The
+// fingerprint is passed back to the error handler if the reading's batch fails to commit.
+func (w *Writer) Enqueue(ctx context.Context, r model.BeaconReading, fingerprint uint64) error {
+	w.mu.RLock()
+	defer w.mu.RUnlock()
+
+	if w.closed {
+		return ErrWriterClosed
+	}
+
+	item := queuedReading{reading: r, fingerprint: fingerprint}
+	select {
+	case w.queue <- item:
+		return nil
+	default:
+	}
+
+	select {
+	case w.queue <- item:
+		return nil
+	case <-ctx.Done():
+		return fmt.Errorf("enqueue reading: %w", ctx.Err())
+	}
+}
+
+// OnCommit installs the handler invoked after each successful batch commit.
+func (w *Writer) OnCommit(h CommitHandler) {
+	w.onCommit.Store(&h)
+}
+
+// QueueDepth reports the number of readings waiting to be committed.
+func (w *Writer) QueueDepth() int {
+	return len(w.queue)
+}
+
+// WriterStats is a snapshot of a writer's batching and commit counters.
+type WriterStats struct {
+	QueueDepth int
+	Committed  uint64 // readings committed
+	Failed     uint64 // readings in batches that failed to commit
+	Batches    metrics.SizeSnapshot
+	CommitTime metrics.HistogramSnapshot
+}
+
+// Stats returns the writer's counters since it started.
+func (w *Writer) Stats() WriterStats {
+	return WriterStats{
+		QueueDepth: len(w.queue),
+		Committed:  w.committed.Load(),
+		Failed:     w.failed.Load(),
+		Batches:    w.batches.Snapshot(),
+		CommitTime: w.commitTime.Snapshot(),
+	}
+}
+
+// Close stops accepting readings, commits everything queued and waits for the goroutine to exit.
+func (w *Writer) Close() {
+	w.mu.Lock()
+	if w.closed {
+		w.mu.Unlock()
+		<-w.done
+		return
+	}
+	w.closed = true
+	close(w.queue)
+	w.mu.Unlock()
+	<-w.done
+}
+
+func (w *Writer) run() {
+	defer close(w.done)
+
+	batch := make([]model.BeaconReading, 0, writerMaxBatch)
+	fingerprints := make([]uint64, 0, writerMaxBatch)
+	timer := time.NewTimer(writerLinger)
+	timer.Stop()
+
+	for {
+		item, ok := <-w.queue
+		if !ok {
+			return
+		}
+		batch = append(batch[:0], item.reading)
+		fingerprints = append(fingerprints[:0], item.fingerprint)
+
+		// Linger briefly so bursts share one transaction, without delaying an idle stream by more
+		// than writerLinger.
+		timer.Reset(writerLinger)
+	collect:
+		for len(batch) < writerMaxBatch {
+			select {
+			case item, ok := <-w.queue:
+				if !ok {
+					break collect
+				}
+				batch = append(batch, item.reading)
+				fingerprints = append(fingerprints, item.fingerprint)
+			case <-timer.C:
+				break collect
+			}
+		}
+		if !timer.Stop() {
+			select {
+			case <-timer.C:
+			default:
+			}
+		}
+
+		w.commit(batch, fingerprints)
+	}
+}
+
+func (w *Writer) commit(batch []model.BeaconReading, fingerprints []uint64) {
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+
+	start := time.Now()
+	err := w.store.InsertBeaconReadings(ctx, batch)
+	committedAt := time.Now()
+	w.commitTime.Observe(committedAt.Sub(start))
+	w.batches.Observe(len(batch))
+	if err == nil {
+		w.committed.Add(uint64(len(batch)))
+		if h := w.onCommit.Load(); h != nil {
+			(*h)(batch, committedAt)
+		}
+		return
+	}
+	w.failed.Add(uint64(len(batch)))
+	if w.onError != nil {
+		for i, r := range batch {
+			w.onError(r, fingerprints[i], err)
+		}
+	}
+}
@@ -3,20 +3,25 @@
 from __future__ import annotations
 
 import argparse
+import datetime
 import json
 import pathlib
+import sqlite3
 from dataclasses import dataclass
 
 import joblib
 import numpy as np
 import pandas as pd
 from sklearn.ensemble import RandomForestClassifier
-from sklearn.metrics import classification_report
+from sklearn.metrics import accuracy_score, classification_report
 from sklearn.model_selection import train_test_split
 from sklearn.pipeline import Pipeline
 from sklearn.preprocessing import OneHotEncoder, StandardScaler
 from sklearn.compose import ColumnTransformer
 
+# Portable artifact format read by the Go server (internal/classifier).
+FOREST_FORMAT = 'catlocator-room-forest/v1'
+
 
 @dataclass
 class TrainingArtifacts:
@@ -63,7 +68,71 @@ def build_model() -> Pipeline:
     return pipeline
 
 
-def train(csv_path: pathlib.Path, output_dir: pathlib.Path) -> None:
+def export_forest(pipeline: Pipeline) -> dict:
+    """Dump the fitted preprocessing and forest as plain arrays the server can load without Python.
+
+    Tree thresholds stay in the scaled feature space; the scaler parameters are exported alongside so
+    the loader can fold them back. Leaf values are normalised to class probabilities.
+    """
+    preprocessor: ColumnTransformer = pipeline.named_steps['preprocess']
+    forest: RandomForestClassifier = pipeline.named_steps['model']
+    encoder: OneHotEncoder = preprocessor.named_transformers_['cat']
+    scaler: StandardScaler = preprocessor.named_transformers_['num']
+
+    categorical_columns = next(cols for name, _, cols in preprocessor.transformers_ if name == 'cat')
+    numeric_columns = next(cols for name, _, cols in preprocessor.transformers_ if name == 'num')
+
+    trees = []
+    for estimator in forest.estimators_:
+        tree = estimator.tree_
+        values = tree.value[:, 0, :]
+        leaves = []
+        for node in range(tree.node_count):
+            if tree.children_left[node] == -1:
+                total = values[node].sum()
+                leaves.append([round(float(v / total), 6) for v in values[node]] if total > 0 else [])
+            else:
+                leaves.append([])
+        trees.append({
+            'children_left': tree.children_left.tolist(),
+            'children_right': tree.children_right.tolist(),
+            'feature': tree.feature.tolist(),
+            'threshold': [round(float(t), 6) for t in tree.threshold],
+            'value': leaves,
+        })
+
+    return {
+        'format': FOREST_FORMAT,
+        'classes': [str(c) for c in forest.classes_],
+        'categorical': [
+            {'name': name, 'categories': [str(c) for c in cats]}
+            for name, cats in zip(categorical_columns, encoder.categories_)
+        ],
+        'numeric': [
+            {'name': name, 'mean': float(mean), 'scale': float(scale)}
+            for name, mean, scale in zip(numeric_columns, scaler.mean_, scaler.scale_)
+        ],
+        'trees': trees,
+    }
+
+
+def register_model(db_path: pathlib.Path, version: str, artifact: pathlib.Path, trained_on: str,
+                   accuracy: float, activate: bool) -> None:
+    """Record the artifact in the server's room_models table, optionally making it the active model."""
+    with sqlite3.connect(db_path) as conn:
+        columns = {row[1] for row in conn.execute('PRAGMA table_info(room_models);')}
+        if 'active' not in columns:
+            conn.execute('ALTER TABLE room_models ADD COLUMN active INTEGER NOT NULL DEFAULT 0;')
+        cursor = conn.execute(
+            'INSERT INTO room_models (version, artifact_path, trained_on, accuracy, notes) VALUES (?, ?, ?, ?, ?);',
+            (version, str(artifact.resolve()), trained_on, accuracy, 'train.py'),
+        )
+        if activate:
+            conn.execute('UPDATE room_models SET active = (id = ?);', (cursor.lastrowid,))
+
+
+def train(csv_path: pathlib.Path, output_dir: pathlib.Path, db_path: pathlib.Path | None = None,
+          activate: bool = True) -> None:
     print(f"Loading dataset from {csv_path}")
     df = load_dataset(csv_path)
     X, y = feature_engineering(df)
@@ -79,31 +148,44 @@ def train(csv_path: pathlib.Path, output_dir: pathlib.Path) -> None:
     print("Evaluating…")
     y_pred = pipeline.predict(X_test)
     report = classification_report(y_test, y_pred)
+    accuracy = float(accuracy_score(y_test, y_pred))
     print(report)
 
     output_dir.mkdir(parents=True, exist_ok=True)
     model_path = output_dir / 'room_classifier.joblib'
     metadata_path = output_dir / 'metadata.json'
+    forest_path = output_dir / 'room_classifier.forest.json'
+    version = datetime.datetime.now(datetime.timezone.utc).strftime('%Y%m%dT%H%M%SZ')
 
     joblib.dump(pipeline, model_path)
+    forest_path.write_text(json.dumps(export_forest(pipeline), separators=(',', ':')))
     metadata = {
+        'version': version,
         'feature_columns': list(X.columns),
         'label_column': 'room',
+        'accuracy': accuracy,
         'classification_report': report,
     }
     metadata_path.write_text(json.dumps(metadata, indent=2))
 
     print(f"Saved model to {model_path}")
+    print(f"Saved portable forest to {forest_path}")
     print(f"Saved metadata to {metadata_path}")
 
+    if db_path is not None:
+        register_model(db_path, version, forest_path, csv_path.name, accuracy, activate)
+        print(f"Registered model {version} in {db_path}" + (" (active)" if activate else ""))
+
 
 def main() -> None:
     parser = argparse.ArgumentParser(description=__doc__)
     parser.add_argument('csv', type=pathlib.Path, help='CSV file exported from the Go server')
     parser.add_argument('--out', type=pathlib.Path, default=pathlib.Path('artifacts'), help='Output directory')
+    parser.add_argument('--db', type=pathlib.Path, help='Server SQLite database to register the model in')
+    parser.add_argument('--no-activate', action='store_true', help='Register without making the model active')
     args = parser.parse_args()
 
-    train(args.csv, args.out)
+    train(args.csv, args.out, args.db, not args.no_activate)
 
 
 if __name__ == '__main__':